@@ -0,0 +1,32 @@
+import taichi as ti
+
+# Roughly the number of launches in one timestep of a typical simulation.
+num_launches = 40
+
+
+def make_step():
+    a = ti.field(dtype=ti.f32, shape=())
+
+    @ti.kernel
+    def add(k: ti.f32):
+        a[None] += k
+
+    def step():
+        for _ in range(num_launches):
+            add(1.0)
+
+    return step
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_launch_step_directly():
+    return ti.benchmark(make_step(), repeat=1000)
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_launch_step_replay():
+    step = make_step()
+    graph = ti.LaunchGraph()
+    with graph:
+        step()
+    return ti.benchmark(graph.replay, repeat=1000)
@@ -1,3 +1,5 @@
+import time
+
 from taichi.lang import impl
 
 import taichi as ti
@@ -26,3 +28,21 @@ for i in range(1000):
     foo()
 
 impl.get_runtime().prog.benchmark_rebuild_graph()
+
+# The per-launch overhead of growing the graph should not depend on how many
+# tasks are already pending, now that it is maintained incrementally.
+impl.current_cfg().async_flush_every = 0
+ti.sync()
+num_timed_launches = 100
+for graph_size in [250, 500, 1000, 2000, 4000]:
+    for i in range(graph_size - num_timed_launches):
+        foo()
+    t = time.time()
+    for i in range(num_timed_launches):
+        foo()
+    per_launch = (time.time() - t) / num_timed_launches * 1e6
+    t = time.time()
+    ti.sync()
+    per_task_sync = (time.time() - t) / graph_size * 1e6
+    print(f'{graph_size} pending tasks: {per_launch:.2f} us per launch, '
+          f'{per_task_sync:.2f} us per task to optimize and run')
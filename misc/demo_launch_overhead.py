@@ -1,3 +1,4 @@
+import struct
 import time
 
 import taichi as ti
@@ -16,4 +17,14 @@ t = time.time()
 for i in range(100000):
     compute_div(0)
 print((time.time() - t) * 10, 'us')
+
+# The same launches with a preallocated context and packed args
+t_kernel = compute_div._primal.kernel_cpp
+launch_ctx = t_kernel.make_launch_context()
+packed_args = struct.pack('@i', 0)
+assert len(packed_args) == t_kernel.get_packed_args_size()
+t = time.time()
+for i in range(100000):
+    t_kernel.launch_prepared(launch_ctx, packed_args)
+print((time.time() - t) * 10, 'us (prepared)')
 exit(0)
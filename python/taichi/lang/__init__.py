@@ -8,6 +8,7 @@ from taichi.lang.enums import Layout
 from taichi.lang.exception import *
 from taichi.lang.impl import *
 from taichi.lang.kernel_impl import *
+from taichi.lang.launch_graph import LaunchGraph
 from taichi.lang.matrix import *
 from taichi.lang.mesh import *
 from taichi.lang.misc import *  # pylint: disable=W0622
@@ -31,8 +32,9 @@ from taichi import _logging, _snode
 __all__ = [
     s for s in dir() if not s.startswith('_') and s not in [
         'any_array', 'ast', 'common_ops', 'enums', 'exception', 'expr', 'impl',
-        'inspect', 'kernel_arguments', 'kernel_impl', 'matrix', 'mesh', 'misc',
-        'ops', 'platform', 'quant_impl', 'runtime_ops', 'shell', 'snode',
-        'source_builder', 'struct', 'type_factory_impl', 'util'
+        'inspect', 'kernel_arguments', 'kernel_future', 'kernel_impl',
+        'launch_graph', 'matrix', 'mesh', 'misc', 'ops', 'platform',
+        'quant_impl', 'runtime_ops', 'shell', 'snode', 'source_builder',
+        'struct', 'type_factory_impl', 'util'
     ]
 ]
@@ -267,6 +267,7 @@ class PyTaichi:
         self.default_fp = f32
         self.default_ip = i32
         self.target_tape = None
+        self.target_launch_graph = None
         self.grad_replaced = False
         self.kernels = kernels or []
         self._signal_handler_registry = None
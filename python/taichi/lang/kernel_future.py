@@ -0,0 +1,40 @@
+from taichi.types import primitive_types
+
+
+class KernelFuture:
+    """The return value of a kernel launched with ``launch_async()``.
+
+    Reading the value only waits for that launch to complete, instead of
+    synchronizing the whole program, so that kernels that do not depend on
+    the value can be launched in the meantime. Only the CPU and CUDA backends
+    are supported. In async mode, reading the value still synchronizes,
+    unless the program has synchronized (e.g. with ``ti.sync()``) since the
+    launch, and ``done()`` only returns True after such a synchronization.
+
+    Example::
+
+        >>> @ti.kernel
+        >>> def compute_norm() -> ti.f32:
+        >>>     ...
+        >>>
+        >>> residual = compute_norm.launch_async()
+        >>> substep()  # Launched without waiting for compute_norm()
+        >>> if residual.result() < 1e-6:
+        >>>     ...
+    """
+    def __init__(self, future, return_type):
+        self.future = future
+        self.return_type = return_type
+
+    def done(self):
+        """Returns True if the launch has completed, without blocking."""
+        return self.future.done()
+
+    def result(self):
+        """Waits for the launch to complete and returns its return value."""
+        if id(self.return_type) in primitive_types.integer_type_ids:
+            return self.future.get_ret_int()
+        return self.future.get_ret_float()
+
+
+__all__ = ['KernelFuture']
@@ -12,9 +12,10 @@ from taichi.lang import impl, runtime_ops
 from taichi.lang.ast import (ASTTransformerContext, KernelSimplicityASTChecker,
                              transform_tree)
 from taichi.lang.enums import Layout
-from taichi.lang.exception import (TaichiCompilationError,
+from taichi.lang.exception import (TaichiCompilationError, TaichiRuntimeError,
                                    TaichiRuntimeTypeError, TaichiSyntaxError)
 from taichi.lang.expr import Expr
+from taichi.lang.kernel_future import KernelFuture
 from taichi.lang.matrix import MatrixType
 from taichi.lang.shell import _shell_pop_print, oinspect
 from taichi.lang.util import has_pytorch, to_taichi_type
@@ -346,7 +347,7 @@ def _get_global_vars(_func):
 class Kernel:
     counter = 0
 
-    def __init__(self, _func, is_grad, _classkernel=False):
+    def __init__(self, _func, is_grad, _classkernel=False, memoized=False):
         self.func = _func
         self.kernel_counter = Kernel.counter
         Kernel.counter += 1
@@ -356,6 +357,9 @@ class Kernel:
         self.argument_names = []
         self.return_type = None
         self.classkernel = _classkernel
+        self.memoized = memoized
+        # Set by launch_async() for the duration of the call.
+        self.launching_async = False
         self.extract_arguments()
         self.template_slot_locations = []
         for i, anno in enumerate(self.argument_annotations):
@@ -471,6 +475,7 @@ class Kernel:
         taichi_kernel = _ti_core.create_kernel(taichi_ast_generator,
                                                kernel_name, self.is_grad)
 
+        taichi_kernel.memoized = self.memoized
         self.kernel_cpp = taichi_kernel
 
         assert key not in self.compiled_functions
@@ -549,6 +554,9 @@ class Kernel:
                 elif isinstance(needed, any_arr) and isinstance(
                         v, taichi.lang._ndarray.Ndarray):
                     has_external_arrays = True
+                    # Keeps the memory alive as long as the launch context,
+                    # which a launch graph may hold on to.
+                    tmps.append(v)
                     v = v.arr
                     if ndarray_use_torch:
                         is_ndarray = True
@@ -616,6 +624,22 @@ class Kernel:
             if not self.is_grad and self.runtime.target_tape and not self.runtime.grad_replaced:
                 self.runtime.target_tape.insert(self, args)
 
+            if self.runtime.target_launch_graph is not None:
+                if self.return_type is not None or callbacks:
+                    raise TaichiRuntimeError(
+                        'Kernels returning values or taking torch tensors '
+                        'cannot be recorded into a launch graph.')
+                return self.runtime.target_launch_graph.insert(
+                    t_kernel, launch_ctx, tmps)
+
+            if self.launching_async:
+                if self.return_type is None or callbacks:
+                    raise TaichiRuntimeError(
+                        'Only kernels returning values and not taking torch '
+                        'tensors can be launched with futures.')
+                return KernelFuture(t_kernel.launch_with_future(launch_ctx),
+                                    self.return_type)
+
             t_kernel(launch_ctx)
 
             ret = None
@@ -666,6 +690,15 @@ class Kernel:
         key = self.ensure_compiled(*args)
         return self.compiled_functions[key](*args)
 
+    def launch_async(self, *args):
+        """Launches the kernel and returns a :class:`KernelFuture` of its return
+        value instead of waiting for it."""
+        self.launching_async = True
+        try:
+            return self(*args)
+        finally:
+            self.launching_async = False
+
 
 # For a Taichi class definition like below:
 #
@@ -699,14 +732,20 @@ def _inside_class(level_of_class_stackframe):
     return False
 
 
-def _kernel_impl(_func, level_of_class_stackframe, verbose=False):
+def _kernel_impl(_func,
+                 level_of_class_stackframe,
+                 verbose=False,
+                 memoized=False):
     # Can decorators determine if a function is being defined inside a class?
     # https://stackoverflow.com/a/8793684/12003165
     is_classkernel = _inside_class(level_of_class_stackframe + 1)
 
     if verbose:
         print(f'kernel={_func.__name__} is_classkernel={is_classkernel}')
-    primal = Kernel(_func, is_grad=False, _classkernel=is_classkernel)
+    primal = Kernel(_func,
+                    is_grad=False,
+                    _classkernel=is_classkernel,
+                    memoized=memoized)
     adjoint = Kernel(_func, is_grad=True, _classkernel=is_classkernel)
     # Having |primal| contains |grad| makes the tape work.
     primal.grad = adjoint
@@ -738,6 +777,7 @@ def _kernel_impl(_func, level_of_class_stackframe, verbose=False):
                 raise type(e)('\n' + str(e)) from None
 
         wrapped.grad = adjoint
+        wrapped.launch_async = primal.launch_async
 
     wrapped._is_wrapped_kernel = True
     wrapped._is_classkernel = is_classkernel
@@ -777,6 +817,37 @@ def kernel(fn):
     return _kernel_impl(fn, level_of_class_stackframe=3)
 
 
+def memoized_kernel(fn):
+    """Marks a function as a Taichi kernel whose redundant launches are skipped.
+
+    A launch of a memoized kernel is skipped if its arguments are the same as
+    in its last launch, and none of the fields and ndarrays it accesses has
+    been written since, either by other kernels or from the Python scope.
+    Kernels that return values, use random numbers, print, or access external
+    arrays other than Taichi ndarrays always run.
+
+    Args:
+        fn (Callable): the Python function to be decorated
+
+    Returns:
+        Callable: The decorated function
+
+    Example::
+
+        >>> x = ti.field(ti.f32, shape=1024)
+        >>> y = ti.field(ti.f32, shape=1024)
+        >>>
+        >>> @ti.memoized_kernel
+        >>> def square():
+        >>>     for i in x:
+        >>>         y[i] = x[i] * x[i]
+        >>>
+        >>> square()
+        >>> square()  # Skipped, since |x| has not changed.
+    """
+    return _kernel_impl(fn, level_of_class_stackframe=3, memoized=True)
+
+
 class _BoundedDifferentiableMethod:
     def __init__(self, kernel_owner, wrapped_kernel_func):
         clsobj = type(kernel_owner)
@@ -798,6 +869,11 @@ class _BoundedDifferentiableMethod:
     def grad(self, *args, **kwargs):
         return self._adjoint(self._kernel_owner, *args, **kwargs)
 
+    def launch_async(self, *args):
+        if self._is_staticmethod:
+            return self._primal.launch_async(*args)
+        return self._primal.launch_async(self._kernel_owner, *args)
+
 
 def data_oriented(cls):
     """Marks a class as Taichi compatible.
@@ -859,4 +935,4 @@ def data_oriented(cls):
     return cls
 
 
-__all__ = ["data_oriented", "func", "kernel"]
+__all__ = ["data_oriented", "func", "kernel", "memoized_kernel"]
@@ -0,0 +1,71 @@
+from taichi._lib import core as _ti_core
+from taichi.lang import impl
+from taichi.lang.exception import TaichiRuntimeError
+
+
+class LaunchGraph:
+    """Records kernel launches and replays them without going through Python.
+
+    Kernels called inside the `with` statement are recorded together with
+    their arguments instead of being launched. Calling :meth:`replay` then
+    launches all of them in order from C++. Only the CPU backends in sync mode
+    are supported, and recorded kernels must not return values.
+
+    Example::
+
+        >>> graph = ti.LaunchGraph()
+        >>> with graph:
+        >>>     substep_id = substep(0.1)
+        >>>     advect()
+        >>> for _ in range(100):
+        >>>     graph.replay()
+        >>> graph.set_arg(substep_id, 0, 0.2)
+        >>> graph.replay()
+    """
+    def __init__(self):
+        impl.get_runtime().materialize()
+        self.runtime = impl.get_runtime()
+        self.graph = _ti_core.LaunchGraph(self.runtime.prog)
+        # Keeps the numpy arrays and ndarrays passed to recorded kernels alive.
+        self.tmps = []
+
+    def __enter__(self):
+        assert self.runtime.target_launch_graph is None, \
+            "Launch graphs cannot be nested."
+        self.runtime.target_launch_graph = self
+        return self
+
+    def __exit__(self, _type, value, tb):
+        self.runtime.target_launch_graph = None
+
+    def insert(self, t_kernel, launch_ctx, tmps):
+        """Records a launch of `t_kernel` and returns its launch id."""
+        self.tmps += tmps
+        return self.graph.add_launch(t_kernel, launch_ctx)
+
+    def set_arg(self, launch_id, arg_id, value):
+        """Patches a scalar argument of a recorded launch.
+
+        Args:
+            launch_id (int): The value returned by the recorded kernel call.
+            arg_id (int): The index of the argument, not counting the
+                `ti.template()` ones.
+            value (Union[int, float]): The new value of the argument.
+        """
+        if isinstance(value, int):
+            self.graph.set_arg_int(launch_id, arg_id, value)
+        elif isinstance(value, float):
+            self.graph.set_arg_float(launch_id, arg_id, value)
+        else:
+            raise TaichiRuntimeError(
+                f'Only scalar arguments can be patched, got {type(value)}.')
+
+    def replay(self):
+        """Launches all the recorded kernels in order."""
+        self.graph.replay()
+
+    def __len__(self):
+        return self.graph.num_launches()
+
+
+__all__ = ['LaunchGraph']
@@ -123,6 +123,16 @@ class KernelProfiler:
         # TODO : query self.StatisticalResult in python scope
         return impl.get_runtime().prog.query_kernel_profile_info(name)
 
+    def get_skipped_launches(self):
+        """Get the number of skipped launches of memoized kernels.
+
+        Returns:
+            skipped_launches (dict): the number of skipped launches by kernel name.
+        """
+        if self._check_not_turned_on_with_warning_message():
+            return {}
+        return impl.get_runtime().prog.get_kernel_profiler_skipped_launches()
+
     def set_metrics(self, metric_list=default_cupti_metrics):
         """For docsting of this function, see :func:`~taichi.lang.set_kernel_profile_metrics`."""
         if self._check_not_turned_on_with_warning_message():
@@ -265,6 +275,9 @@ class KernelProfiler:
         summary_line = '[100.00%] Total execution time: '
         summary_line += f'{self._total_time_ms/1000:7.3f} s   '
         summary_line += f'number of results: {len(self._statistical_results)}'
+        num_skipped = sum(self.get_skipped_launches().values())
+        if num_skipped > 0:
+            summary_line += f', skipped memoized launches: {num_skipped}'
 
         # print
         print(outer_partition_line)
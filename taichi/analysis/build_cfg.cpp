@@ -1,3 +1,4 @@
+#include "taichi/analysis/build_cfg.h"
 #include "taichi/ir/control_flow_graph.h"
 #include "taichi/ir/ir.h"
 #include "taichi/ir/statements.h"
@@ -489,6 +490,8 @@ class CFGBuilder : public IRVisitor {
   std::unordered_map<CFGFuncKey, CFGNode *> node_func_end_;
 };
 
+const PassID BuildCFGPass::id = "BuildCFGPass";
+
 namespace irpass::analysis {
 std::unique_ptr<ControlFlowGraph> build_cfg(IRNode *root) {
   return CFGBuilder::run(root);
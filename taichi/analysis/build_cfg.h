@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+
+#include "taichi/ir/control_flow_graph.h"
+#include "taichi/ir/pass.h"
+
+namespace taichi {
+namespace lang {
+
+// The control-flow graph of the whole IR, cached between the passes that
+// keep it valid.
+class BuildCFGPass : public Pass {
+ public:
+  static const PassID id;
+
+  struct Result {
+    std::unique_ptr<ControlFlowGraph> cfg;
+  };
+};
+
+}  // namespace lang
+}  // namespace taichi
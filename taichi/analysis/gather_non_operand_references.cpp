@@ -0,0 +1,41 @@
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/visitors.h"
+
+TLANG_NAMESPACE_BEGIN
+
+class GatherNonOperandReferences : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  std::unordered_set<Stmt *> stmts;
+
+  void visit(Block *block) override {
+    if (block->mask_var)
+      stmts.insert(block->mask_var);
+    BasicStmtVisitor::visit(block);
+  }
+
+  void visit(OffloadedStmt *stmt) override {
+    if (stmt->end_stmt)
+      stmts.insert(stmt->end_stmt);
+    for (auto *local_map :
+         {&stmt->owned_offset_local, &stmt->total_offset_local,
+          &stmt->owned_num_local, &stmt->total_num_local}) {
+      for (auto &it : *local_map)
+        stmts.insert(it.second);
+    }
+    BasicStmtVisitor::visit(stmt);
+  }
+};
+
+namespace irpass::analysis {
+std::unordered_set<Stmt *> gather_non_operand_references(IRNode *root) {
+  GatherNonOperandReferences gather;
+  root->accept(&gather);
+  return std::move(gather.stmts);
+}
+}  // namespace irpass::analysis
+
+TLANG_NAMESPACE_END
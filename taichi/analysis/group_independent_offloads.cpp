@@ -0,0 +1,161 @@
+// Group consecutive offloaded tasks that can run concurrently
+
+#include <unordered_set>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// Stands for all the external arrays, which may alias each other.
+SNode *const kExternalArrays = nullptr;
+
+struct TaskAccesses {
+  std::unordered_set<SNode *> reads;
+  std::unordered_set<SNode *> writes;
+
+  bool conflicts_with(const TaskAccesses &other) const {
+    auto intersects = [](const std::unordered_set<SNode *> &a,
+                         const std::unordered_set<SNode *> &b) {
+      for (auto snode : a) {
+        if (b.count(snode))
+          return true;
+      }
+      return false;
+    };
+    return intersects(writes, other.reads) ||
+           intersects(writes, other.writes) || intersects(reads, other.writes);
+  }
+};
+
+// Bits of the same physical word must not be written concurrently.
+SNode *physical_snode(SNode *snode) {
+  if (snode->parent && (snode->parent->type == SNodeType::bit_struct ||
+                        snode->parent->type == SNodeType::bit_array)) {
+    return snode->parent;
+  }
+  return snode;
+}
+
+// Adds the SNodes |ptr| may point to into |snodes|. Returns false if |ptr|
+// might point to anything else than SNodes, external arrays or task-local
+// buffers.
+bool gather_pointees(Stmt *ptr, std::unordered_set<SNode *> &snodes) {
+  if (auto global_ptr = ptr->cast<GlobalPtrStmt>()) {
+    for (auto snode : global_ptr->snodes.data)
+      snodes.insert(physical_snode(snode));
+    return true;
+  } else if (auto get_ch = ptr->cast<GetChStmt>()) {
+    snodes.insert(physical_snode(get_ch->output_snode));
+    return true;
+  } else if (auto offset = ptr->cast<IntegerOffsetStmt>()) {
+    return gather_pointees(offset->input, snodes);
+  } else if (ptr->is<ExternalPtrStmt>()) {
+    snodes.insert(kExternalArrays);
+    return true;
+  } else if (auto ptr_offset = ptr->cast<PtrOffsetStmt>()) {
+    return ptr_offset->origin->is<AllocaStmt>();
+  }
+  return ptr->is<AllocaStmt>() || ptr->is<ThreadLocalPtrStmt>() ||
+         ptr->is<BlockLocalPtrStmt>();
+}
+
+bool activates_sparse_snodes(Stmt *stmt) {
+  if (auto global_ptr = stmt->cast<GlobalPtrStmt>()) {
+    if (!global_ptr->activate)
+      return false;
+    for (auto snode : global_ptr->snodes.data) {
+      if (!snode->is_path_all_dense)
+        return true;
+    }
+  } else if (auto lookup = stmt->cast<SNodeLookupStmt>()) {
+    return lookup->activate && lookup->snode->type != SNodeType::dense &&
+           lookup->snode->type != SNodeType::root;
+  }
+  return false;
+}
+
+// Returns std::nullopt if the task touches states other than its SNodes and
+// external arrays, e.g., global temporaries, lists, or the runtime. Serial
+// tasks all read random states of thread 0, so RandStmt counts as well.
+std::optional<TaskAccesses> gather_task_accesses(OffloadedStmt *offload) {
+  TaskAccesses accesses;
+  bool exclusive = false;
+  irpass::analysis::gather_statements(offload, [&](Stmt *stmt) {
+    if (stmt->is<GlobalTemporaryStmt>() || stmt->is<SNodeOpStmt>() ||
+        stmt->is<ClearListStmt>() || stmt->is<InternalFuncStmt>() ||
+        stmt->is<RandStmt>() || stmt->is<ExternalFuncCallStmt>() ||
+        stmt->is<FuncCallStmt>() || stmt->is<PrintStmt>() ||
+        stmt->is<AssertStmt>() || stmt->is<ReturnStmt>() ||
+        activates_sparse_snodes(stmt)) {
+      exclusive = true;
+    } else if (auto load = stmt->cast<GlobalLoadStmt>()) {
+      exclusive |= !gather_pointees(load->src, accesses.reads);
+    } else if (auto store = stmt->cast<GlobalStoreStmt>()) {
+      exclusive |= !gather_pointees(store->dest, accesses.writes);
+    } else if (auto atomic = stmt->cast<AtomicOpStmt>()) {
+      exclusive |= !gather_pointees(atomic->dest, accesses.reads);
+      gather_pointees(atomic->dest, accesses.writes);
+    } else if (auto bit_struct_store = stmt->cast<BitStructStoreStmt>()) {
+      exclusive |= !gather_pointees(bit_struct_store->ptr, accesses.writes);
+    }
+    return false;
+  });
+  if (exclusive)
+    return std::nullopt;
+  return accesses;
+}
+
+}  // namespace
+
+namespace irpass::analysis {
+
+bool can_run_concurrently(OffloadedStmt *offload) {
+  return gather_task_accesses(offload).has_value();
+}
+
+bool is_small_offload(OffloadedStmt *offload, int64 max_range_for_cost) {
+  if (offload->task_type == OffloadedStmt::TaskType::serial)
+    return true;
+  if (offload->task_type != OffloadedStmt::TaskType::range_for ||
+      !offload->const_begin || !offload->const_end) {
+    return false;
+  }
+  int64 num_iterations = (int64)offload->end_value - offload->begin_value;
+  int64 num_statements =
+      irpass::analysis::count_statements(offload->body.get());
+  return num_iterations * num_statements <= max_range_for_cost;
+}
+
+std::vector<int> group_independent_offloads(Block *root,
+                                            int64 max_range_for_cost) {
+  std::vector<int> group_begins;
+  std::vector<TaskAccesses> group;
+  for (int i = 0; i < (int)root->statements.size(); i++) {
+    auto offload = root->statements[i]->as<OffloadedStmt>();
+    std::optional<TaskAccesses> accesses;
+    if (is_small_offload(offload, max_range_for_cost))
+      accesses = gather_task_accesses(offload);
+    bool joins = accesses.has_value() && !group.empty();
+    for (int j = 0; joins && j < (int)group.size(); j++) {
+      joins = !group[j].conflicts_with(*accesses);
+    }
+    if (!joins) {
+      group_begins.push_back(i);
+      group.clear();
+    }
+    // A task that must run alone leaves |group| empty, so that the next task
+    // starts a new group.
+    if (accesses.has_value())
+      group.push_back(std::move(*accesses));
+  }
+  return group_begins;
+}
+
+}  // namespace irpass::analysis
+
+TLANG_NAMESPACE_END
@@ -0,0 +1,225 @@
+// This pass computes intervals of the values of integral statements.
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+
+namespace taichi {
+namespace lang {
+
+namespace {
+
+// Bounds beyond which intermediate results might overflow int64.
+constexpr int64 kMaxAddend = 1LL << 62;
+constexpr int64 kMaxFactor = 1LL << 31;
+
+ValueRange range_of_type(DataType dt) {
+  if (!is_integral(dt) || data_type_bits(dt) >= 64) {
+    return {std::numeric_limits<int64>::min(),
+            std::numeric_limits<int64>::max()};
+  }
+  const int bits = data_type_bits(dt);
+  if (is_signed(dt))
+    return {-(1LL << (bits - 1)), (1LL << (bits - 1)) - 1};
+  return {0, (1LL << bits) - 1};
+}
+
+class ValueRangeAnalysis {
+ public:
+  ValueRange get(Stmt *stmt) {
+    auto it = cache_.find(stmt);
+    if (it != cache_.end())
+      return it->second;
+    auto type_range = range_of_type(stmt->ret_type);
+    ValueRange result = type_range;
+    if (stmt->width() == 1 && is_integral(stmt->ret_type)) {
+      result = compute(stmt);
+      // The operation might have wrapped around.
+      if (!result.within(type_range.low, type_range.high))
+        result = type_range;
+    }
+    cache_[stmt] = result;
+    return result;
+  }
+
+ private:
+  std::unordered_map<Stmt *, ValueRange> cache_;
+
+  static ValueRange unknown() {
+    return range_of_type(PrimitiveType::i64);
+  }
+
+  static bool non_negative(const ValueRange &r) {
+    return r.low >= 0;
+  }
+
+  static std::optional<int64> constant(const ValueRange &r) {
+    if (r.low == r.high)
+      return r.low;
+    return std::nullopt;
+  }
+
+  ValueRange loop_index_range(LoopIndexStmt *stmt) {
+    if (auto range_for = stmt->loop->cast<RangeForStmt>()) {
+      auto begin = get(range_for->begin);
+      auto end = get(range_for->end);
+      if (!begin.within(-kMaxAddend, kMaxAddend) ||
+          !end.within(-kMaxAddend, kMaxAddend)) {
+        return unknown();
+      }
+      return {begin.low, std::max(begin.low, end.high - 1)};
+    } else if (auto struct_for = stmt->loop->cast<StructForStmt>()) {
+      // Coordinates out of the shape are skipped by the struct-for. The index
+      // of a struct-for is a physical axis.
+      const auto &extractor = struct_for->snode->extractors[stmt->index];
+      return {0, extractor.num_elements_from_root - 1};
+    } else if (auto offload = stmt->loop->cast<OffloadedStmt>()) {
+      if (offload->task_type == OffloadedStmt::TaskType::range_for &&
+          offload->const_begin && offload->const_end) {
+        return {offload->begin_value,
+                std::max(offload->begin_value, offload->end_value - 1)};
+      }
+    }
+    return unknown();
+  }
+
+  ValueRange binary_op_range(BinaryOpStmt *stmt) {
+    auto lhs = get(stmt->lhs);
+    auto rhs = get(stmt->rhs);
+    const auto op = stmt->op_type;
+    if (is_comparison(op))
+      return {-1, 1};
+    if (op == BinaryOpType::add || op == BinaryOpType::sub) {
+      if (!lhs.within(-kMaxAddend, kMaxAddend) ||
+          !rhs.within(-kMaxAddend, kMaxAddend)) {
+        return unknown();
+      }
+      if (op == BinaryOpType::add)
+        return {lhs.low + rhs.low, lhs.high + rhs.high};
+      return {lhs.low - rhs.high, lhs.high - rhs.low};
+    }
+    if (op == BinaryOpType::mul) {
+      if (!lhs.within(-kMaxFactor, kMaxFactor) ||
+          !rhs.within(-kMaxFactor, kMaxFactor)) {
+        return unknown();
+      }
+      const int64 products[] = {lhs.low * rhs.low, lhs.low * rhs.high,
+                                lhs.high * rhs.low, lhs.high * rhs.high};
+      return {*std::min_element(std::begin(products), std::end(products)),
+              *std::max_element(std::begin(products), std::end(products))};
+    }
+    if (op == BinaryOpType::min)
+      return {std::min(lhs.low, rhs.low), std::min(lhs.high, rhs.high)};
+    if (op == BinaryOpType::max)
+      return {std::max(lhs.low, rhs.low), std::max(lhs.high, rhs.high)};
+    if (op == BinaryOpType::bit_and) {
+      if (non_negative(lhs) && non_negative(rhs))
+        return {0, std::min(lhs.high, rhs.high)};
+      if (non_negative(lhs) || non_negative(rhs))
+        return {0, non_negative(lhs) ? lhs.high : rhs.high};
+      return unknown();
+    }
+    if (op == BinaryOpType::bit_or || op == BinaryOpType::bit_xor) {
+      if (!non_negative(lhs) || !non_negative(rhs))
+        return unknown();
+      int64 high = std::max(lhs.high, rhs.high);
+      int64 mask = 0;
+      while (mask < high)
+        mask = mask * 2 + 1;
+      return {op == BinaryOpType::bit_or ? std::max(lhs.low, rhs.low) : 0,
+              mask};
+    }
+    auto shift = constant(rhs);
+    if (op == BinaryOpType::bit_shr || op == BinaryOpType::bit_sar) {
+      if (!non_negative(lhs) || !shift || *shift < 0 || *shift >= 63)
+        return unknown();
+      return {lhs.low >> *shift, lhs.high >> *shift};
+    }
+    if (op == BinaryOpType::bit_shl) {
+      if (!lhs.within(-kMaxFactor, kMaxFactor) || !shift || *shift < 0 ||
+          *shift > 31) {
+        return unknown();
+      }
+      return {lhs.low * (1LL << *shift), lhs.high * (1LL << *shift)};
+    }
+    auto divisor = constant(rhs);
+    if (!non_negative(lhs) || !divisor || *divisor <= 0)
+      return unknown();
+    if (op == BinaryOpType::div || op == BinaryOpType::floordiv)
+      return {lhs.low / *divisor, lhs.high / *divisor};
+    if (op == BinaryOpType::mod) {
+      if (lhs.high < *divisor)
+        return lhs;
+      return {0, *divisor - 1};
+    }
+    return unknown();
+  }
+
+  ValueRange compute(Stmt *stmt) {
+    if (auto const_stmt = stmt->cast<ConstStmt>()) {
+      auto val = const_stmt->val[0].val_as_int64();
+      return {val, val};
+    } else if (auto loop_index = stmt->cast<LoopIndexStmt>()) {
+      return loop_index_range(loop_index);
+    } else if (auto loop_unique = stmt->cast<LoopUniqueStmt>()) {
+      return get(loop_unique->input);
+    } else if (auto assumption = stmt->cast<RangeAssumptionStmt>()) {
+      auto input = get(assumption->input);
+      auto base = get(assumption->base);
+      if (!base.within(-kMaxAddend, kMaxAddend))
+        return input;
+      return {std::max(input.low, base.low + assumption->low),
+              std::min(input.high, base.high + assumption->high - 1)};
+    } else if (auto bit_extract = stmt->cast<BitExtractStmt>()) {
+      const int num_bits = bit_extract->bit_end - bit_extract->bit_begin;
+      if (num_bits >= 63)
+        return unknown();
+      ValueRange result{0, (1LL << num_bits) - 1};
+      auto input = get(bit_extract->input);
+      if (bit_extract->bit_begin == 0 && non_negative(input))
+        result.high = std::min(result.high, input.high);
+      return result;
+    } else if (auto binary = stmt->cast<BinaryOpStmt>()) {
+      return binary_op_range(binary);
+    } else if (auto unary = stmt->cast<UnaryOpStmt>()) {
+      if (unary->op_type == UnaryOpType::cast_value &&
+          is_integral(unary->operand->ret_type)) {
+        return get(unary->operand);
+      }
+      if (unary->op_type == UnaryOpType::neg) {
+        auto operand = get(unary->operand);
+        if (operand.within(-kMaxAddend, kMaxAddend))
+          return {-operand.high, -operand.low};
+      }
+      return unknown();
+    } else if (auto ternary = stmt->cast<TernaryOpStmt>()) {
+      if (ternary->op_type != TernaryOpType::select)
+        return unknown();
+      auto a = get(ternary->op2);
+      auto b = get(ternary->op3);
+      return {std::min(a.low, b.low), std::max(a.high, b.high)};
+    } else if (stmt->is<ExternalTensorShapeAlongAxisStmt>()) {
+      return {0, std::numeric_limits<int32>::max()};
+    }
+    return unknown();
+  }
+};
+
+}  // namespace
+
+namespace irpass::analysis {
+
+ValueRange value_range(Stmt *stmt) {
+  ValueRangeAnalysis analysis;
+  return analysis.get(stmt);
+}
+
+}  // namespace irpass::analysis
+
+}  // namespace lang
+}  // namespace taichi
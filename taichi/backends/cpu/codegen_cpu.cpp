@@ -1,6 +1,8 @@
 #include "taichi/backends/cpu/codegen_cpu.h"
 
+#include "taichi/backends/cpu/cpu_device.h"
 #include "taichi/codegen/codegen_llvm.h"
+#include "taichi/ir/analysis.h"
 #include "taichi/llvm/llvm_program.h"
 #include "taichi/common/core.h"
 #include "taichi/util/io.h"
@@ -10,6 +12,8 @@
 #include "taichi/ir/statements.h"
 #include "taichi/util/statistics.h"
 
+#include "llvm/IR/Operator.h"
+
 TLANG_NAMESPACE_BEGIN
 
 class CodeGenLLVMCPU : public CodeGenLLVM {
@@ -34,7 +38,10 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
 
     // The loop body
     llvm::Function *body;
-    {
+    const bool vectorize = prog->config.vectorize_range_for && step == 1;
+    if (vectorize) {
+      body = create_vectorized_range_for_body(stmt);
+    } else {
       auto guard = get_function_creation_guard(
           {llvm::PointerType::get(get_runtime_type("RuntimeContext"), 0),
            llvm::Type::getInt8PtrTy(*llvm_context),
@@ -51,11 +58,166 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
     llvm::Value *epilogue = create_xlogue(stmt->tls_epilogue);
 
     auto [begin, end] = get_range_for_bounds(stmt);
-    create_call(
-        "cpu_parallel_range_for",
-        {get_arg(0), tlctx->get_constant(stmt->num_cpu_threads), begin, end,
-         tlctx->get_constant(step), tlctx->get_constant(stmt->block_dim),
-         tls_prologue, body, epilogue, tlctx->get_constant(stmt->tls_size)});
+    if (vectorize) {
+      create_call("cpu_parallel_range_for_chunked",
+                  {get_arg(0), tlctx->get_constant(stmt->num_cpu_threads),
+                   begin, end, tlctx->get_constant(stmt->block_dim),
+                   tls_prologue, body, epilogue,
+                   tlctx->get_constant(stmt->tls_size),
+                   tlctx->get_constant(prog->config.simd_width)});
+    } else {
+      create_call(
+          "cpu_parallel_range_for",
+          {get_arg(0), tlctx->get_constant(stmt->num_cpu_threads), begin, end,
+           tlctx->get_constant(step), tlctx->get_constant(stmt->block_dim),
+           tls_prologue, body, epilogue, tlctx->get_constant(stmt->tls_size)});
+    }
+  }
+
+  // Creates body(context, tls, begin, end), which runs the iterations in
+  // [begin, end) in a loop that the LLVM loop vectorizer is asked to
+  // vectorize |simd_width| iterations at a time, with a masked remainder.
+  // Memory accesses that are not private to the iteration (TLS, allocas)
+  // are marked parallel, so that field accesses with computed indices become
+  // gathers and scatters. Reductions demoted to TLS become vector
+  // accumulators once LICM promotes them to registers.
+  llvm::Function *create_vectorized_range_for_body(OffloadedStmt *stmt) {
+    auto guard = get_function_creation_guard(
+        {llvm::PointerType::get(get_runtime_type("RuntimeContext"), 0),
+         llvm::Type::getInt8PtrTy(*llvm_context), tlctx->get_data_type<int>(),
+         tlctx->get_data_type<int>()});
+    // The TLS buffer is only accessed by this thread.
+    func->addParamAttr(1, llvm::Attribute::NoAlias);
+
+    auto loop_var = create_entry_block_alloca(PrimitiveType::i32);
+    loop_vars_llvm[stmt].push_back(loop_var);
+    builder->CreateStore(get_arg(2), loop_var);
+
+    auto loop_test =
+        llvm::BasicBlock::Create(*llvm_context, "chunk_loop_test", func);
+    auto loop_body =
+        llvm::BasicBlock::Create(*llvm_context, "chunk_loop_body", func);
+    auto loop_latch =
+        llvm::BasicBlock::Create(*llvm_context, "chunk_loop_latch", func);
+    auto loop_exit =
+        llvm::BasicBlock::Create(*llvm_context, "chunk_loop_exit", func);
+    builder->CreateBr(loop_test);
+
+    builder->SetInsertPoint(loop_test);
+    auto cond = builder->CreateICmp(llvm::CmpInst::Predicate::ICMP_SLT,
+                                    builder->CreateLoad(loop_var), get_arg(3));
+    builder->CreateCondBr(cond, loop_body, loop_exit);
+
+    builder->SetInsertPoint(loop_body);
+    offloaded_loop_reentry = loop_latch;
+    stmt->body->accept(this);
+    offloaded_loop_reentry = nullptr;
+    builder->CreateBr(loop_latch);
+
+    builder->SetInsertPoint(loop_latch);
+    builder->CreateStore(builder->CreateAdd(builder->CreateLoad(loop_var),
+                                            tlctx->get_constant(1)),
+                         loop_var);
+    auto back_edge = builder->CreateBr(loop_test);
+
+    auto access_group = llvm::MDNode::getDistinct(*llvm_context, {});
+    mark_parallel_accesses(access_group);
+    back_edge->setMetadata(llvm::LLVMContext::MD_loop,
+                           create_vectorize_loop_id(access_group));
+
+    builder->SetInsertPoint(loop_exit);
+    return guard.body;
+  }
+
+  // Follows address arithmetic, including the inttoptr(ptrtoint(p) + offset)
+  // pattern, back to the object |ptr| points into.
+  static llvm::Value *get_base_object(llvm::Value *ptr) {
+    while (true) {
+      ptr = ptr->stripPointerCasts();
+      if (auto gep = llvm::dyn_cast<llvm::GEPOperator>(ptr)) {
+        ptr = gep->getPointerOperand();
+        continue;
+      }
+      if (auto int_to_ptr = llvm::dyn_cast<llvm::IntToPtrInst>(ptr)) {
+        auto add =
+            llvm::dyn_cast<llvm::BinaryOperator>(int_to_ptr->getOperand(0));
+        if (add && add->getOpcode() == llvm::Instruction::Add) {
+          if (auto ptr_to_int =
+                  llvm::dyn_cast<llvm::PtrToIntInst>(add->getOperand(0))) {
+            ptr = ptr_to_int->getOperand(0);
+            continue;
+          }
+        }
+      }
+      return ptr;
+    }
+  }
+
+  // Puts the memory accesses of the current function that may be shared
+  // between iterations into |access_group|. Since iterations of a range-for
+  // are independent, these accesses carry no dependence across iterations.
+  // Global temporaries are the exception, as they might hold per-thread
+  // copies of fields that the iterations add to.
+  void mark_parallel_accesses(llvm::MDNode *access_group) {
+    auto tls = func->getArg(1);
+    auto carries_dependence = [&](llvm::Value *ptr) {
+      auto base = get_base_object(ptr);
+      if (auto call = llvm::dyn_cast<llvm::CallInst>(base)) {
+        auto callee = call->getCalledFunction();
+        if (callee && callee->getName() == "get_temporary_pointer")
+          return true;
+      }
+      return base == tls || llvm::isa<llvm::AllocaInst>(base) ||
+             llvm::isa<llvm::GlobalVariable>(base);
+    };
+    for (auto &bb : *func) {
+      for (auto &inst : bb) {
+        bool parallel = false;
+        if (auto load = llvm::dyn_cast<llvm::LoadInst>(&inst)) {
+          parallel = !carries_dependence(load->getPointerOperand());
+        } else if (auto store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+          parallel = !carries_dependence(store->getPointerOperand());
+        } else if (auto call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+          // Runtime functions accessing fields are inlined later, and the
+          // access group is propagated to their accesses. Random number
+          // generators carry state across iterations.
+          auto callee = call->getCalledFunction();
+          parallel = call->mayReadOrWriteMemory() && callee &&
+                     !callee->getName().startswith("rand") &&
+                     std::none_of(call->arg_begin(), call->arg_end(),
+                                  [&](llvm::Value *arg) {
+                                    return arg->getType()->isPointerTy() &&
+                                           carries_dependence(arg);
+                                  });
+        }
+        if (parallel) {
+          inst.setMetadata(llvm::LLVMContext::MD_access_group, access_group);
+        }
+      }
+    }
+  }
+
+  llvm::MDNode *create_vectorize_loop_id(llvm::MDNode *access_group) {
+    auto &ctx = *llvm_context;
+    auto hint = [&](const char *name, llvm::Constant *value) {
+      return llvm::MDNode::get(ctx, {llvm::MDString::get(ctx, name),
+                                     llvm::ConstantAsMetadata::get(value)});
+    };
+    auto true_value = llvm::ConstantInt::getTrue(ctx);
+    llvm::SmallVector<llvm::Metadata *, 5> ops;
+    // Placeholder for the self reference
+    ops.push_back(nullptr);
+    ops.push_back(hint("llvm.loop.vectorize.enable", true_value));
+    ops.push_back(hint("llvm.loop.vectorize.width",
+                       llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx),
+                                              prog->config.simd_width)));
+    ops.push_back(hint("llvm.loop.vectorize.predicate.enable", true_value));
+    ops.push_back(llvm::MDNode::get(
+        ctx, {llvm::MDString::get(ctx, "llvm.loop.parallel_accesses"),
+              access_group}));
+    auto loop_id = llvm::MDNode::getDistinct(ctx, ops);
+    loop_id->replaceOperandWith(0, loop_id);
+    return loop_id;
   }
 
   void create_offload_mesh_for(OffloadedStmt *stmt) override {
@@ -127,24 +289,28 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
                  epilogue, tlctx->get_constant(stmt->tls_size)});
   }
 
-  void create_bls_buffer(OffloadedStmt *stmt) {
-    auto type = llvm::ArrayType::get(llvm::Type::getInt8Ty(*llvm_context),
-                                     stmt->bls_size);
-    bls_buffer = new llvm::GlobalVariable(
-        *module, type, false, llvm::GlobalValue::ExternalLinkage, nullptr,
-        "bls_buffer", nullptr, llvm::GlobalVariable::LocalExecTLSModel, 0);
-    bls_buffer->setAlignment(llvm::MaybeAlign(8));
-    // initialize the variable with an undef value to ensure it is added to the
-    // symbol table
-    bls_buffer->setInitializer(llvm::UndefValue::get(type));
+  llvm::Value *emit_linear_thread_idx() override {
+    using Type = OffloadedStmt::TaskType;
+    // The bodies and xlogues of parallel loops take the TLS buffer as their
+    // second argument, right after which the runtime stores the id of the
+    // worker thread running them. Everything else runs on a single thread.
+    if (!current_offload ||
+        (current_offload->task_type != Type::range_for &&
+         current_offload->task_type != Type::struct_for &&
+         current_offload->task_type != Type::mesh_for) ||
+        func->arg_size() < 2) {
+      return tlctx->get_constant(0);
+    }
+    auto ptr = builder->CreateGEP(
+        get_tls_base_ptr(), tlctx->get_constant(-taichi_cpu_thread_id_size));
+    return builder->CreateLoad(builder->CreatePointerCast(
+        ptr, llvm::Type::getInt32PtrTy(*llvm_context)));
   }
 
   void visit(OffloadedStmt *stmt) override {
     stat.add("codegen_offloaded_tasks");
     TI_ASSERT(current_offload == nullptr);
     current_offload = stmt;
-    if (stmt->bls_size > 0)
-      create_bls_buffer(stmt);
     using Type = OffloadedStmt::TaskType;
     auto offloaded_task_name = init_offloaded_task_function(stmt);
     if (prog->config.kernel_profiler && arch_is_cpu(prog->config.arch)) {
@@ -187,6 +353,44 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
       TI_NOT_IMPLEMENTED
     }
   }
+
+  FunctionType compile_module_to_executable() override {
+    auto run_sequentially = CodeGenLLVM::compile_module_to_executable();
+    auto block = ir->cast<Block>();
+    if (!prog->config.cpu_concurrent_tasks || prog->config.kernel_profiler ||
+        !block) {
+      return run_sequentially;
+    }
+    TI_ASSERT(block->size() == offloaded_tasks.size());
+    auto group_begins = irpass::analysis::group_independent_offloads(
+        block, cpu::CpuCommandList::kMaxConcurrentTaskCost);
+    if (group_begins.size() == offloaded_tasks.size()) {
+      return run_sequentially;
+    }
+    std::vector<bool> begins_group(offloaded_tasks.size(), false);
+    for (auto i : group_begins) {
+      begins_group[i] = true;
+    }
+    std::vector<OffloadedTask::task_fp_type> funcs;
+    for (auto &task : offloaded_tasks) {
+      funcs.push_back(task.func);
+    }
+    auto stream = prog->get_compute_device()->get_compute_stream();
+    return [funcs, begins_group, stream,
+            kernel = this->kernel](RuntimeContext &context) {
+      resolve_ndarray_args(kernel, context);
+      auto cmdlist = stream->new_command_list();
+      auto cpu_cmdlist = static_cast<cpu::CpuCommandList *>(cmdlist.get());
+      for (int i = 0; i < (int)funcs.size(); i++) {
+        if (begins_group[i]) {
+          cmdlist->memory_barrier();
+        }
+        cpu_cmdlist->launch_task(
+            [func = funcs[i], ctx = &context]() { func(ctx); });
+      }
+      stream->submit_synced(cmdlist.get());
+    };
+  }
 };
 
 FunctionType CodeGenCPU::codegen() {
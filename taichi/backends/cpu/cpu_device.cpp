@@ -1,10 +1,79 @@
 #include "taichi/backends/cpu/cpu_device.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace taichi {
 namespace lang {
 
 namespace cpu {
 
+CpuCommandList::CpuCommandList(CpuDevice *device)
+    : device_(device), task_groups_(1) {
+}
+
+void CpuCommandList::buffer_barrier(DevicePtr ptr, size_t size) {
+  memory_barrier();
+}
+
+void CpuCommandList::buffer_barrier(DeviceAllocation alloc) {
+  memory_barrier();
+}
+
+void CpuCommandList::memory_barrier() {
+  if (!task_groups_.back().empty()) {
+    task_groups_.emplace_back();
+  }
+}
+
+void CpuCommandList::buffer_copy(DevicePtr dst, DevicePtr src, size_t size) {
+  auto dst_ptr = (char *)device_->get_alloc_info(dst).ptr + dst.offset;
+  auto src_ptr = (char *)device_->get_alloc_info(src).ptr + src.offset;
+  launch_task([=]() { std::memcpy(dst_ptr, src_ptr, size); });
+}
+
+void CpuCommandList::buffer_fill(DevicePtr ptr, size_t size, uint32_t data) {
+  auto dst =
+      (uint32_t *)((char *)device_->get_alloc_info(ptr).ptr + ptr.offset);
+  launch_task([=]() { std::fill(dst, dst + size / sizeof(uint32_t), data); });
+}
+
+void CpuCommandList::launch_task(std::function<void()> task) {
+  task_groups_.back().push_back(std::move(task));
+}
+
+CpuStream::CpuStream(CpuDevice *device, ThreadPool *thread_pool)
+    : device_(device), thread_pool_(thread_pool) {
+}
+
+std::unique_ptr<CommandList> CpuStream::new_command_list() {
+  return std::make_unique<CpuCommandList>(device_);
+}
+
+void CpuStream::submit(CommandList *cmdlist) {
+  for (auto &group : static_cast<CpuCommandList *>(cmdlist)->task_groups()) {
+    if (group.size() == 1) {
+      group[0]();
+    } else if (!group.empty()) {
+      // Each task runs on its own worker, and so do the parallel-fors it
+      // launches.
+      thread_pool_->run(
+          (int)group.size(), (int)group.size(), (void *)&group,
+          [](void *tasks, int thread_id, int i) {
+            (*(const std::vector<std::function<void()>> *)tasks)[i]();
+          });
+    }
+  }
+}
+
+void CpuStream::submit_synced(CommandList *cmdlist) {
+  submit(cmdlist);
+}
+
+CpuDevice::CpuDevice(ThreadPool *thread_pool)
+    : stream_(std::make_unique<CpuStream>(this, thread_pool)) {
+}
+
 CpuDevice::AllocInfo CpuDevice::get_alloc_info(const DeviceAllocation handle) {
   validate_device_alloc(handle);
   return allocations_[handle.alloc_id];
@@ -68,6 +137,10 @@ DeviceAllocation CpuDevice::import_memory(void *ptr, size_t size) {
   return alloc;
 }
 
+Stream *CpuDevice::get_compute_stream() {
+  return stream_.get();
+}
+
 uint64 CpuDevice::fetch_result_uint64(int i, uint64 *result_buffer) {
   uint64 ret = result_buffer[i];
   return ret;
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <functional>
 #include <set>
 #include <unordered_map>
 #include <vector>
 
 #include "taichi/common/core.h"
 #include "taichi/backends/device.h"
+#include "taichi/system/threading.h"
 #include "taichi/system/virtual_memory.h"
 
 namespace taichi {
@@ -43,8 +45,18 @@ class CpuPipeline : public Pipeline {
   ResourceBinder *resource_binder() override{TI_NOT_IMPLEMENTED};
 };
 
+class CpuDevice;
+
+// Records host tasks, which run on the thread pool when submitted to a
+// CpuStream. Tasks between two barriers may run concurrently.
 class CpuCommandList : public CommandList {
  public:
+  // Small tasks run serially on one thread when grouped, so this bounds their
+  // iterations times statements to keep that cheaper than a parallel launch.
+  static constexpr int64 kMaxConcurrentTaskCost = 1 << 16;
+
+  explicit CpuCommandList(CpuDevice *device);
+
   ~CpuCommandList() override {
   }
 
@@ -53,26 +65,42 @@ class CpuCommandList : public CommandList {
   void bind_resources(ResourceBinder *binder,
                       ResourceBinder::Bindings *bindings) override{
       TI_NOT_IMPLEMENTED};
-  void buffer_barrier(DevicePtr ptr, size_t size) override{TI_NOT_IMPLEMENTED};
-  void buffer_barrier(DeviceAllocation alloc) override{TI_NOT_IMPLEMENTED};
-  void memory_barrier() override{TI_NOT_IMPLEMENTED};
-  void buffer_copy(DevicePtr dst, DevicePtr src, size_t size) override{
-      TI_NOT_IMPLEMENTED};
-  void buffer_fill(DevicePtr ptr, size_t size, uint32_t data) override{
-      TI_NOT_IMPLEMENTED};
+  void buffer_barrier(DevicePtr ptr, size_t size) override;
+  void buffer_barrier(DeviceAllocation alloc) override;
+  void memory_barrier() override;
+  void buffer_copy(DevicePtr dst, DevicePtr src, size_t size) override;
+  void buffer_fill(DevicePtr ptr, size_t size, uint32_t data) override;
   void dispatch(uint32_t x, uint32_t y = 1, uint32_t z = 1) override{
       TI_NOT_IMPLEMENTED};
+
+  void launch_task(std::function<void()> task);
+
+  const std::vector<std::vector<std::function<void()>>> &task_groups() const {
+    return task_groups_;
+  }
+
+ private:
+  CpuDevice *device_;
+  std::vector<std::vector<std::function<void()>>> task_groups_;
 };
 
+// Runs the tasks of submitted command lists on the thread pool. Submissions
+// complete before returning, so command_sync() has nothing to wait for.
 class CpuStream : public Stream {
  public:
+  CpuStream(CpuDevice *device, ThreadPool *thread_pool);
+
   ~CpuStream() override{};
 
-  std::unique_ptr<CommandList> new_command_list() override{TI_NOT_IMPLEMENTED};
-  void submit(CommandList *cmdlist) override{TI_NOT_IMPLEMENTED};
-  void submit_synced(CommandList *cmdlist) override{TI_NOT_IMPLEMENTED};
+  std::unique_ptr<CommandList> new_command_list() override;
+  void submit(CommandList *cmdlist) override;
+  void submit_synced(CommandList *cmdlist) override;
 
-  void command_sync() override{TI_NOT_IMPLEMENTED};
+  void command_sync() override{};
+
+ private:
+  CpuDevice *device_;
+  ThreadPool *thread_pool_;
 };
 
 class CpuDevice : public Device {
@@ -83,6 +111,8 @@ class CpuDevice : public Device {
     bool use_cached{false};
   };
 
+  explicit CpuDevice(ThreadPool *thread_pool);
+
   AllocInfo get_alloc_info(const DeviceAllocation handle);
 
   ~CpuDevice() override{};
@@ -109,9 +139,10 @@ class CpuDevice : public Device {
   void memcpy_internal(DevicePtr dst, DevicePtr src, uint64_t size) override{
       TI_NOT_IMPLEMENTED};
 
-  Stream *get_compute_stream() override{TI_NOT_IMPLEMENTED};
+  Stream *get_compute_stream() override;
 
  private:
+  std::unique_ptr<CpuStream> stream_;
   std::vector<AllocInfo> allocations_;
   std::unordered_map<int, std::unique_ptr<VirtualMemoryAllocator>>
       virtual_memories_;
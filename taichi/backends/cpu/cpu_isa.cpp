@@ -0,0 +1,119 @@
+#include "taichi/backends/cpu/cpu_isa.h"
+
+#ifdef TI_WITH_LLVM
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
+#endif
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// Features each level adds to the previous one, in LLVM's naming.
+const std::vector<std::string> &added_features(CpuIsaLevel level) {
+  static const std::vector<std::string> x86_64 = {"cx8", "fxsr", "mmx", "sse",
+                                                  "sse2"};
+  static const std::vector<std::string> v2 = {
+      "cx16", "sahf", "popcnt", "sse3", "sse4.1", "sse4.2", "ssse3"};
+  static const std::vector<std::string> v3 = {
+      "avx", "avx2", "bmi", "bmi2", "f16c", "fma", "lzcnt", "movbe", "xsave"};
+  static const std::vector<std::string> v4 = {"avx512f", "avx512bw",
+                                              "avx512cd", "avx512dq",
+                                              "avx512vl"};
+  switch (level) {
+    case CpuIsaLevel::x86_64:
+      return x86_64;
+    case CpuIsaLevel::x86_64_v2:
+      return v2;
+    case CpuIsaLevel::x86_64_v3:
+      return v3;
+    default:
+      return v4;
+  }
+}
+
+}  // namespace
+
+std::string cpu_isa_level_name(CpuIsaLevel level) {
+  switch (level) {
+    case CpuIsaLevel::x86_64:
+      return "x86-64";
+    case CpuIsaLevel::x86_64_v2:
+      return "x86-64-v2";
+    case CpuIsaLevel::x86_64_v3:
+      return "x86-64-v3";
+    case CpuIsaLevel::x86_64_v4:
+      return "x86-64-v4";
+  }
+  TI_NOT_IMPLEMENTED
+}
+
+std::optional<CpuIsaLevel> cpu_isa_level_from_name(const std::string &name) {
+  for (auto level : {CpuIsaLevel::x86_64, CpuIsaLevel::x86_64_v2,
+                     CpuIsaLevel::x86_64_v3, CpuIsaLevel::x86_64_v4}) {
+    if (cpu_isa_level_name(level) == name) {
+      return level;
+    }
+  }
+  return std::nullopt;
+}
+
+std::vector<std::string> cpu_isa_level_features(CpuIsaLevel level) {
+  std::vector<std::string> features;
+  for (int i = 0; i <= (int)level; i++) {
+    auto &added = added_features(CpuIsaLevel(i));
+    features.insert(features.end(), added.begin(), added.end());
+  }
+  return features;
+}
+
+CpuFeatures get_host_cpu_features() {
+  CpuFeatures features;
+#ifdef TI_WITH_LLVM
+  llvm::StringMap<bool> host_features;
+  if (llvm::sys::getHostCPUFeatures(host_features)) {
+    for (auto &feature : host_features) {
+      features[feature.getKey().str()] = feature.getValue();
+    }
+  }
+#endif
+  return features;
+}
+
+bool cpu_isa_level_supported(CpuIsaLevel level, const CpuFeatures &features) {
+  if (level == CpuIsaLevel::x86_64) {
+    // Every x86-64 CPU
+    return true;
+  }
+  for (auto &feature : cpu_isa_level_features(level)) {
+    if (auto it = features.find(feature); it == features.end() || !it->second)
+      return false;
+  }
+  return true;
+}
+
+CpuIsaLevel select_cpu_isa_level(const std::string &candidates,
+                                 const CpuFeatures &features) {
+  std::optional<CpuIsaLevel> selected;
+  std::size_t begin = 0;
+  while (begin <= candidates.size()) {
+    auto end = std::min(candidates.find(',', begin), candidates.size());
+    auto name = candidates.substr(begin, end - begin);
+    auto level = cpu_isa_level_from_name(name);
+    if (!level) {
+      TI_ERROR("Unknown CPU ISA level \"{}\"", name);
+    }
+    if (cpu_isa_level_supported(*level, features) &&
+        (!selected || *level > *selected)) {
+      selected = level;
+    }
+    begin = end + 1;
+  }
+  if (!selected) {
+    TI_ERROR("The host CPU supports none of the CPU ISA levels \"{}\"",
+             candidates);
+  }
+  return *selected;
+}
+
+TLANG_NAMESPACE_END
@@ -0,0 +1,38 @@
+// Instruction set levels of CPU code
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/lang_util.h"
+
+TLANG_NAMESPACE_BEGIN
+
+// The x86-64 microarchitecture levels. x86-64-v2 adds SSE4.2 and POPCNT,
+// x86-64-v3 adds AVX2 and FMA (Haswell and later), and x86-64-v4 adds
+// AVX-512 (Skylake-SP and later).
+enum class CpuIsaLevel { x86_64, x86_64_v2, x86_64_v3, x86_64_v4 };
+
+using CpuFeatures = std::unordered_map<std::string, bool>;
+
+std::string cpu_isa_level_name(CpuIsaLevel level);
+
+std::optional<CpuIsaLevel> cpu_isa_level_from_name(const std::string &name);
+
+// The LLVM subtarget features that code for |level| may use.
+std::vector<std::string> cpu_isa_level_features(CpuIsaLevel level);
+
+// The features of the host CPU, detected with CPUID.
+CpuFeatures get_host_cpu_features();
+
+bool cpu_isa_level_supported(CpuIsaLevel level, const CpuFeatures &features);
+
+// Picks the highest of the comma-separated levels in |candidates| that a CPU
+// with |features| supports.
+CpuIsaLevel select_cpu_isa_level(const std::string &candidates,
+                                 const CpuFeatures &features);
+
+TLANG_NAMESPACE_END
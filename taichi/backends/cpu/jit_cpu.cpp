@@ -36,6 +36,7 @@
 #include "llvm/Transforms/IPO.h"
 #endif
 
+#include "taichi/backends/cpu/cpu_isa.h"
 #include "taichi/lang_util.h"
 #include "taichi/program/program.h"
 #include "taichi/jit/jit_session.h"
@@ -100,6 +101,9 @@ class JITSessionCPU : public JITSession {
   std::vector<llvm::orc::JITDylib *> all_libs_;
   int module_counter_;
   SectionMemoryManager *memory_manager_;
+  // The CPU and subtarget features of the generated code
+  std::string cpu_;
+  std::string features_;
 
  public:
   JITSessionCPU(LlvmProgramImpl *llvm_prog,
@@ -118,7 +122,9 @@ class JITSessionCPU : public JITSession {
         dl_(DL),
         mangle_(es_, this->dl_),
         module_counter_(0),
-        memory_manager_(nullptr) {
+        memory_manager_(nullptr),
+        cpu_(JTMB.getCPU()),
+        features_(JTMB.getFeatures().getString()) {
     if (JTMB.getTargetTriple().isOSBinFormatCOFF()) {
       object_layer_.setOverrideObjectFlagsWithResponsibilityFlags(true);
       object_layer_.setAutoClaimResponsibilityForObjectSymbols(true);
@@ -229,9 +235,8 @@ void JITSessionCPU::global_optimize_module_cpu(llvm::Module *module) {
   legacy::FunctionPassManager function_pass_manager(module);
   legacy::PassManager module_pass_manager;
 
-  llvm::StringRef mcpu = llvm::sys::getHostCPUName();
   std::unique_ptr<TargetMachine> target_machine(target->createTargetMachine(
-      triple.str(), mcpu.str(), "", options, llvm::Reloc::PIC_,
+      triple.str(), cpu_, features_, options, llvm::Reloc::PIC_,
       llvm::CodeModel::Small, CodeGenOpt::Aggressive));
 
   TI_ERROR_UNLESS(target_machine.get(), "Could not allocate target machine!");
@@ -285,6 +290,18 @@ std::unique_ptr<JITSession> create_llvm_jit_session_cpu(
     Arch arch) {
   TI_ASSERT(arch_is_cpu(arch));
   auto target_info = get_host_target_info();
+  const auto &cpu_isa = llvm_prog->config->cpu_isa;
+  if (cpu_isa != "native") {
+    TI_ERROR_IF(arch != Arch::x64, "cpu_isa \"{}\" requires x64", cpu_isa);
+    // Select the level from CPUID, and keep LLVM from using features of the
+    // host beyond it.
+    auto level = select_cpu_isa_level(cpu_isa, get_host_cpu_features());
+    TI_TRACE("Generating CPU code for {}", cpu_isa_level_name(level));
+    auto &jtmb = target_info.first;
+    jtmb.setCPU("x86-64");
+    jtmb.getFeatures() = llvm::SubtargetFeatures();
+    jtmb.addFeatures(cpu_isa_level_features(level));
+  }
   return std::make_unique<JITSessionCPU>(llvm_prog, target_info.first,
                                          target_info.second);
 }
@@ -25,6 +25,7 @@ TLANG_NAMESPACE_BEGIN
 // Driver constants from cuda.h
 
 constexpr uint32 CU_EVENT_DEFAULT = 0x0;
+constexpr uint32 CU_EVENT_DISABLE_TIMING = 0x2;
 constexpr uint32 CU_STREAM_DEFAULT = 0x0;
 constexpr uint32 CU_STREAM_NON_BLOCKING = 0x1;
 constexpr uint32 CU_MEM_ATTACH_GLOBAL = 0x1;
@@ -39,6 +40,7 @@ constexpr uint32 CU_JIT_MAX_REGISTERS = 0;
 constexpr uint32 CU_POINTER_ATTRIBUTE_MEMORY_TYPE = 2;
 constexpr uint32 CU_DEVICE_ATTRIBUTE_UNIFIED_ADDRESSING = 41;
 constexpr uint32 CUDA_SUCCESS = 0;
+constexpr uint32 CUDA_ERROR_NOT_READY = 600;
 constexpr uint32 CU_MEMORYTYPE_DEVICE = 2;
 
 std::string get_cuda_error_message(uint32 err);
@@ -17,6 +17,7 @@ PER_CUDA_FUNCTION(context_get_current, cuCtxGetCurrent, void **);
 
 // Stream management
 PER_CUDA_FUNCTION(stream_create, cuStreamCreate, void **, uint32);
+PER_CUDA_FUNCTION(stream_destroy, cuStreamDestroy_v2, void *);
 
 // Memory management
 PER_CUDA_FUNCTION(memcpy_host_to_device, cuMemcpyHtoD_v2, void *, void *, std::size_t);
@@ -50,6 +51,7 @@ PER_CUDA_FUNCTION(event_create, cuEventCreate, void **, uint32)
 PER_CUDA_FUNCTION(event_destroy, cuEventDestroy, void *)
 PER_CUDA_FUNCTION(event_record, cuEventRecord, void *, void *)
 PER_CUDA_FUNCTION(event_synchronize, cuEventSynchronize, void *);
+PER_CUDA_FUNCTION(event_query, cuEventQuery, void *);
 PER_CUDA_FUNCTION(event_elapsed_time, cuEventElapsedTime, float *, void *, void *);
 
 // Vulkan interop
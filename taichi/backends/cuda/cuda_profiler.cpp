@@ -177,6 +177,7 @@ void KernelProfilerCUDA::clear() {
   records_size_after_sync_ = 0;
   traced_records_.clear();
   statistical_results_.clear();
+  skipped_launch_counts_.clear();
 }
 
 // must be called immediately after KernelProfilerCUDA::trace()
@@ -5,9 +5,11 @@
 #include "taichi/struct/struct_llvm.h"
 #include "taichi/util/file_sequence_writer.h"
 
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
 
 TLANG_NAMESPACE_BEGIN
 
@@ -86,6 +88,10 @@ FunctionCreationGuard::~FunctionCreationGuard() {
 
 namespace {
 
+// At most this many bytes of the next element's data block are prefetched by
+// a CPU struct-for.
+constexpr int kMaxStructForPrefetchBytes = 1024;
+
 class CodeGenStmtGuard {
  public:
   using Getter = std::function<llvm::BasicBlock *(void)>;
@@ -166,13 +172,14 @@ void CodeGenLLVM::visit(AllocaStmt *stmt) {
 void CodeGenLLVM::visit(RandStmt *stmt) {
   if (stmt->ret_type->is_primitive(PrimitiveTypeID::f16)) {
     // Promoting to f32 since there's no rand_f16 support in runtime.cpp.
-    auto val_f32 = create_call("rand_f32", {get_context()});
+    auto val_f32 =
+        create_call("rand_f32", {get_context(), emit_linear_thread_idx()});
     llvm_val[stmt] =
         builder->CreateFPTrunc(val_f32, llvm::Type::getHalfTy(*llvm_context));
   } else {
     llvm_val[stmt] =
         create_call(fmt::format("rand_{}", data_type_name(stmt->ret_type)),
-                    {get_context()});
+                    {get_context(), emit_linear_thread_idx()});
   }
 }
 
@@ -192,9 +199,9 @@ void CodeGenLLVM::emit_extra_unary(UnaryOpStmt *stmt) {
 #define UNARY_STD(x)                                                    \
   else if (op == UnaryOpType::x) {                                      \
     if (input_taichi_type->is_primitive(PrimitiveTypeID::f32)) {        \
-      llvm_val[stmt] = create_call(#x "_f32", input);                   \
+      llvm_val[stmt] = create_math_call(#x "_f32", input);              \
     } else if (input_taichi_type->is_primitive(PrimitiveTypeID::f64)) { \
-      llvm_val[stmt] = create_call(#x "_f64", input);                   \
+      llvm_val[stmt] = create_math_call(#x "_f64", input);              \
     } else if (input_taichi_type->is_primitive(PrimitiveTypeID::i32)) { \
       llvm_val[stmt] = create_call(#x "_i32", input);                   \
     } else {                                                            \
@@ -435,7 +442,7 @@ void CodeGenLLVM::visit(UnaryOpStmt *stmt) {
   } else if (op == UnaryOpType::bit_not) {
     llvm_val[stmt] = builder->CreateNot(input);
   } else if (op == UnaryOpType::neg) {
-    if (is_real(stmt->operand->ret_type)) {
+    if (input_type->isFPOrFPVectorTy()) {
       llvm_val[stmt] = builder->CreateFNeg(input, "neg");
     } else {
       llvm_val[stmt] = builder->CreateNeg(input, "neg");
@@ -453,9 +460,13 @@ void CodeGenLLVM::visit(UnaryOpStmt *stmt) {
 void CodeGenLLVM::visit(BinaryOpStmt *stmt) {
   auto op = stmt->op_type;
   auto ret_type = stmt->ret_type;
+  // Vector operations from slp_vectorize() dispatch on the element type.
+  if (auto tensor_type = ret_type->cast<TensorType>()) {
+    ret_type = tensor_type->get_element_type();
+  }
 
   if (op == BinaryOpType::add) {
-    if (is_real(stmt->ret_type)) {
+    if (is_real(ret_type)) {
       llvm_val[stmt] =
           builder->CreateFAdd(llvm_val[stmt->lhs], llvm_val[stmt->rhs]);
     } else {
@@ -463,7 +474,7 @@ void CodeGenLLVM::visit(BinaryOpStmt *stmt) {
           builder->CreateAdd(llvm_val[stmt->lhs], llvm_val[stmt->rhs]);
     }
   } else if (op == BinaryOpType::sub) {
-    if (is_real(stmt->ret_type)) {
+    if (is_real(ret_type)) {
       llvm_val[stmt] =
           builder->CreateFSub(llvm_val[stmt->lhs], llvm_val[stmt->rhs]);
     } else {
@@ -471,7 +482,7 @@ void CodeGenLLVM::visit(BinaryOpStmt *stmt) {
           builder->CreateSub(llvm_val[stmt->lhs], llvm_val[stmt->rhs]);
     }
   } else if (op == BinaryOpType::mul) {
-    if (is_real(stmt->ret_type)) {
+    if (is_real(ret_type)) {
       llvm_val[stmt] =
           builder->CreateFMul(llvm_val[stmt->lhs], llvm_val[stmt->rhs]);
     } else {
@@ -489,7 +500,7 @@ void CodeGenLLVM::visit(BinaryOpStmt *stmt) {
           llvm::Intrinsic::floor, {tlctx->get_data_type(ret_type)}, {div});
     }
   } else if (op == BinaryOpType::div) {
-    if (is_real(stmt->ret_type)) {
+    if (is_real(ret_type)) {
       llvm_val[stmt] =
           builder->CreateFDiv(llvm_val[stmt->lhs], llvm_val[stmt->rhs]);
     } else {
@@ -660,9 +671,9 @@ void CodeGenLLVM::visit(BinaryOpStmt *stmt) {
     } else if (op == BinaryOpType::pow) {
       if (arch_is_cpu(current_arch())) {
         if (ret_type->is_primitive(PrimitiveTypeID::f32)) {
-          llvm_val[stmt] = create_call("pow_f32", {lhs, rhs});
+          llvm_val[stmt] = create_math_call("pow_f32", {lhs, rhs});
         } else if (ret_type->is_primitive(PrimitiveTypeID::f64)) {
-          llvm_val[stmt] = create_call("pow_f64", {lhs, rhs});
+          llvm_val[stmt] = create_math_call("pow_f64", {lhs, rhs});
         } else if (ret_type->is_primitive(PrimitiveTypeID::i32)) {
           llvm_val[stmt] = create_call("pow_i32", {lhs, rhs});
         } else if (ret_type->is_primitive(PrimitiveTypeID::i64)) {
@@ -889,7 +900,11 @@ void CodeGenLLVM::visit(ContinueStmt *stmt) {
     return false;
   };
   if (stmt_in_off_range_for()) {
-    builder->CreateRetVoid();
+    if (offloaded_loop_reentry != nullptr) {
+      builder->CreateBr(offloaded_loop_reentry);
+    } else {
+      builder->CreateRetVoid();
+    }
   } else {
     TI_ASSERT(current_loop_reentry != nullptr);
     builder->CreateBr(current_loop_reentry);
@@ -959,6 +974,99 @@ llvm::Value *CodeGenLLVM::create_call(std::string func_name,
   return create_call(func, args);
 }
 
+llvm::Value *CodeGenLLVM::create_math_call(const std::string &func_name,
+                                           llvm::ArrayRef<llvm::Value *> args) {
+#if LLVM_VERSION_MAJOR >= 11
+  // Only the bodies of the chunked range-fors are loop-vectorized, and only
+  // LLVM 11+ vectorizes calls with vector-function-abi-variant.
+  if (!prog->config.vector_math || !arch_is_cpu(current_arch()) ||
+      !offloaded_loop_reentry || !module->getFunction(func_name + "_x4")) {
+    return create_call(func_name, args);
+  }
+  // The call must survive until loop vectorization, which runs after
+  // inlining. It goes through a copy of the scalar function, so that the
+  // calls outside of vectorized loops are still inlined.
+  auto scalar_func = get_runtime_function(func_name);
+  auto name = func_name + "_vectorizable";
+  auto func = module->getFunction(name);
+  if (!func) {
+    func = llvm::Function::Create(scalar_func->getFunctionType(),
+                                  llvm::Function::InternalLinkage, name,
+                                  module.get());
+    func->addFnAttr(llvm::Attribute::NoInline);
+    llvm::IRBuilder<> b(llvm::BasicBlock::Create(*llvm_context, "entry", func));
+    std::vector<llvm::Value *> func_args;
+    for (auto &arg : func->args())
+      func_args.push_back(&arg);
+    b.CreateRet(b.CreateCall(scalar_func, func_args));
+  }
+  auto elem_bits = func->getReturnType()->getPrimitiveSizeInBits();
+  std::string variants;
+  for (int lanes : {4, 8, 16}) {
+    // The ISA tokens of the vector function ABI for x86-64 are b (SSE),
+    // c (AVX), d (AVX2) and e (AVX-512), and n (Advanced SIMD) for AArch64.
+    char isa = 'n';
+    if (current_arch() == Arch::x64) {
+      auto bits = lanes * elem_bits;
+      isa = bits <= 128 ? 'b' : bits <= 256 ? 'd' : 'e';
+    }
+    if (!variants.empty()) {
+      variants += ",";
+    }
+    auto vector_func = get_vector_math_function(func_name, lanes);
+    variants += fmt::format("_ZGV{}N{}{}_{}({})", isa, lanes,
+                            std::string(args.size(), 'v'), name,
+                            vector_func->getName().str());
+  }
+  check_func_call_signature(func, args);
+  auto call = builder->CreateCall(func, args);
+  call->addAttribute(
+      llvm::AttributeList::FunctionIndex,
+      llvm::Attribute::get(*llvm_context, "vector-function-abi-variant",
+                           variants));
+  return call;
+#else
+  return create_call(func_name, args);
+#endif
+}
+
+llvm::Function *CodeGenLLVM::get_vector_math_function(
+    const std::string &func_name,
+    int lanes) {
+  // e.g. exp_f32_x8(f32 *ret, const f32 *x) in runtime.cpp
+  auto runtime_func_name =
+      fmt::format("{}_x{}{}", func_name, lanes,
+                  prog->config.fast_vector_math ? "_fast" : "");
+  auto name = runtime_func_name + "_vec";
+  if (auto f = module->getFunction(name)) {
+    return f;
+  }
+  auto scalar_func = module->getFunction(func_name);
+  auto scalar_type = scalar_func->getReturnType();
+  auto vector_type = llvm::VectorType::get(scalar_type, lanes, false);
+  std::vector<llvm::Type *> arg_types(scalar_func->arg_size(), vector_type);
+  auto f = llvm::Function::Create(
+      llvm::FunctionType::get(vector_type, arg_types, false),
+      llvm::Function::InternalLinkage, name, module.get());
+  llvm::IRBuilder<> b(llvm::BasicBlock::Create(*llvm_context, "entry", f));
+  // Pass the lanes through memory, like the runtime function expects.
+  std::vector<llvm::Value *> runtime_args;
+  auto ret = b.CreateAlloca(vector_type);
+  runtime_args.push_back(
+      b.CreatePointerCast(ret, llvm::PointerType::get(scalar_type, 0)));
+  for (auto &arg : f->args()) {
+    auto ptr = b.CreateAlloca(vector_type);
+    b.CreateStore(&arg, ptr);
+    runtime_args.push_back(
+        b.CreatePointerCast(ptr, llvm::PointerType::get(scalar_type, 0)));
+  }
+  call(&b, runtime_func_name, runtime_args);
+  b.CreateRet(b.CreateLoad(ret));
+  // Only the vectorizer will call it, so keep it alive until then.
+  llvm::appendToCompilerUsed(*module, {f});
+  return f;
+}
+
 void CodeGenLLVM::create_increment(llvm::Value *ptr, llvm::Value *value) {
   builder->CreateStore(builder->CreateAdd(builder->CreateLoad(ptr), value),
                        ptr);
@@ -1097,7 +1205,7 @@ void CodeGenLLVM::visit(ReturnStmt *stmt) {
       auto extended = builder->CreateZExt(
           builder->CreateBitCast(llvm_val[stmt->values[0]], intermediate_type),
           dest_ty);
-      create_call("LLVMRuntime_store_result", {get_runtime(), extended});
+      create_call("RuntimeContext_store_result", {get_context(), extended});
     } else {
       TI_NOT_IMPLEMENTED;
     }
@@ -1127,7 +1235,7 @@ void CodeGenLLVM::visit(AssertStmt *stmt) {
   auto arguments = create_entry_block_alloca(argument_buffer_size);
 
   std::vector<llvm::Value *> args;
-  args.emplace_back(get_runtime());
+  args.emplace_back(get_context());
   args.emplace_back(llvm_val[stmt->cond]);
   args.emplace_back(builder->CreateGlobalStringPtr(stmt->text));
 
@@ -1155,7 +1263,8 @@ void CodeGenLLVM::visit(AssertStmt *stmt) {
   args.emplace_back(builder->CreateGEP(
       arguments, {tlctx->get_constant(0), tlctx->get_constant(0)}));
 
-  llvm_val[stmt] = create_call("taichi_assert_format", args);
+  // Tags the failure with the launch id in the context.
+  llvm_val[stmt] = create_call("taichi_assert_format_in_launch", args);
 }
 
 void CodeGenLLVM::visit(SNodeOpStmt *stmt) {
@@ -1353,11 +1462,29 @@ void CodeGenLLVM::visit(GlobalStoreStmt *stmt) {
     auto *cit = pointee_type->as<CustomIntType>();
     store_value = llvm_val[stmt->val];
     store_custom_int(llvm_val[stmt->dest], cit, store_value, /*atomic=*/true);
+  } else if (auto tensor_type = stmt->val->ret_type->cast<TensorType>()) {
+    // A vector store from slp_vectorize() to adjacent components starting at
+    // |dest|.
+    auto vector_ptr = builder->CreatePointerCast(
+        llvm_val[stmt->dest],
+        llvm::PointerType::get(tlctx->get_data_type(tensor_type), 0));
+    builder->CreateAlignedStore(
+        llvm_val[stmt->val], vector_ptr,
+        llvm::MaybeAlign(data_type_size(tensor_type->get_element_type())));
   } else {
     builder->CreateStore(llvm_val[stmt->val], llvm_val[stmt->dest]);
   }
 }
 
+void CodeGenLLVM::visit(PrefetchStmt *stmt) {
+  // Prefetches are hints and are dropped on GPUs.
+  if (!arch_is_cpu(current_arch()))
+    return;
+  auto ptr = builder->CreatePointerCast(
+      llvm_val[stmt->ptr], llvm::Type::getInt8PtrTy(*llvm_context));
+  create_call("prefetch_read", {ptr});
+}
+
 void CodeGenLLVM::visit(GlobalLoadStmt *stmt) {
   int width = stmt->width();
   TI_ASSERT(width == 1);
@@ -1372,28 +1499,41 @@ void CodeGenLLVM::visit(GlobalLoadStmt *stmt) {
     } else {
       TI_NOT_IMPLEMENTED
     }
+  } else if (auto tensor_type = stmt->ret_type->cast<TensorType>()) {
+    // A vector load from slp_vectorize() of adjacent components starting at
+    // |src|.
+    auto vector_type = tlctx->get_data_type(tensor_type);
+    auto vector_ptr = builder->CreatePointerCast(
+        llvm_val[stmt->src], llvm::PointerType::get(vector_type, 0));
+    llvm_val[stmt] = builder->CreateAlignedLoad(
+        vector_type, vector_ptr,
+        llvm::MaybeAlign(data_type_size(tensor_type->get_element_type())));
   } else {
     llvm_val[stmt] = builder->CreateLoad(tlctx->get_data_type(stmt->ret_type),
                                          llvm_val[stmt->src]);
   }
 }
 
-void CodeGenLLVM::visit(ElementShuffleStmt *stmt){
-    TI_NOT_IMPLEMENTED
-    /*
-    auto init = stmt->elements.serialize(
-        [](const VectorElement &elem) {
-          return fmt::format("{}[{}]", elem.stmt->raw_name(), elem.index);
-        },
-        "{");
-    if (stmt->pointer) {
-      emit("{} * const {} [{}] {};", data_type_name(stmt->ret_type),
-           stmt->raw_name(), stmt->width(), init);
-    } else {
-      emit("const {} {} ({});", stmt->ret_data_type_name(), stmt->raw_name(),
-           init);
+void CodeGenLLVM::visit(ElementShuffleStmt *stmt) {
+  TI_ASSERT(!stmt->pointer);
+  auto get_element = [&](const VectorElement &elem) {
+    if (elem.stmt->ret_type->is<TensorType>()) {
+      return builder->CreateExtractElement(llvm_val[elem.stmt], elem.index);
     }
-    */
+    TI_ASSERT(elem.index == 0);
+    return llvm_val[elem.stmt];
+  };
+  if (!stmt->ret_type->is<TensorType>()) {
+    llvm_val[stmt] = get_element(stmt->elements[0]);
+    return;
+  }
+  // Pack the elements into a vector.
+  llvm::Value *vec =
+      llvm::UndefValue::get(tlctx->get_data_type(stmt->ret_type));
+  for (int i = 0; i < (int)stmt->elements.size(); i++) {
+    vec = builder->CreateInsertElement(vec, get_element(stmt->elements[i]), i);
+  }
+  llvm_val[stmt] = vec;
 }
 
 std::string CodeGenLLVM::get_runtime_snode_name(SNode *snode) {
@@ -1520,8 +1660,20 @@ void CodeGenLLVM::visit(SNodeLookupStmt *stmt) {
   parent = llvm_val[stmt->input_snode];
   TI_ASSERT(parent);
   auto snode = stmt->snode;
+  auto offset_index = stmt->input_index->cast<BinaryOpStmt>();
   if (snode->type == SNodeType::root) {
     llvm_val[stmt] = builder->CreateGEP(parent, llvm_val[stmt->input_index]);
+  } else if (snode->type == SNodeType::dense && !stmt->activate &&
+             prog->config.strength_reduce_addresses && !prog->config.debug &&
+             offset_index && offset_index->op_type == BinaryOpType::add &&
+             offset_index->rhs->is<ConstStmt>()) {
+    // Cells of dense SNodes are contiguous, so x[i + c] is c cells after
+    // x[i], which is shared by the neighbors of x[i] in a stencil.
+    auto base = call(snode, parent, "lookup_element",
+                     {llvm_val[offset_index->lhs]});
+    auto offset = offset_index->rhs->as<ConstStmt>()->val[0].val_int() *
+                  (int64)snode->cell_size_bytes;
+    llvm_val[stmt] = builder->CreateGEP(base, tlctx->get_constant(offset));
   } else if (snode->type == SNodeType::dense ||
              snode->type == SNodeType::pointer ||
              snode->type == SNodeType::dynamic ||
@@ -1785,6 +1937,15 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
       stmt->tls_prologue->accept(this);
     }
 
+    if (stmt->bls_size > 0 && arch_is_cpu(current_arch())) {
+      // The BLS buffer lives on the stack of the body. It stays in the L1
+      // cache across the loop, and LLVM knows it does not alias any field.
+      bls_buffer = create_entry_block_alloca(
+          llvm::ArrayType::get(llvm::Type::getInt8Ty(*llvm_context),
+                               stmt->bls_size),
+          /*alignment=*/64);
+    }
+
     if (stmt->bls_prologue) {
       call("block_barrier");  // "__syncthreads()"
       stmt->bls_prologue->accept(this);
@@ -1935,6 +2096,9 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
     if (stmt->tls_epilogue) {
       stmt->tls_epilogue->accept(this);
     }
+
+    if (arch_is_cpu(current_arch()))
+      bls_buffer = nullptr;
   }
 
   int list_element_size = std::min(leaf_block->max_num_elements(),
@@ -1981,13 +2145,27 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
 
     struct_for_func = patched_struct_for_func;
   }
+  // The data blocks of pointer and dynamic SNodes are scattered in memory, so
+  // the hardware prefetcher cannot fetch the next element's block in time.
+  int prefetch_bytes = 0;
+  if (prog->config.software_prefetch && arch_is_cpu(current_arch())) {
+    for (auto s = leaf_block; s; s = s->parent) {
+      if (s->type == SNodeType::pointer || s->type == SNodeType::dynamic) {
+        prefetch_bytes = (int)std::min(
+            leaf_block->cell_size_bytes * leaf_block->max_num_elements(),
+            (std::size_t)kMaxStructForPrefetchBytes);
+        break;
+      }
+    }
+  }
   // Loop over nodes in the element list, in parallel
   create_call(
       struct_for_func,
       {get_context(), tlctx->get_constant(leaf_block->id),
        tlctx->get_constant(list_element_size), tlctx->get_constant(num_splits),
        body, tlctx->get_constant(stmt->tls_size),
-       tlctx->get_constant(stmt->num_cpu_threads)});
+       tlctx->get_constant(stmt->num_cpu_threads),
+       tlctx->get_constant(prefetch_bytes)});
   // TODO: why do we need num_cpu_threads on GPUs?
 
   current_coordinates = nullptr;
@@ -2078,10 +2256,19 @@ void CodeGenLLVM::visit(ClearListStmt *stmt) {
   auto snode_parent = stmt->snode->parent;
   auto meta_child = cast_pointer(emit_struct_meta(snode_child), "StructMeta");
   auto meta_parent = cast_pointer(emit_struct_meta(snode_parent), "StructMeta");
-  call("clear_list", get_runtime(), meta_parent, meta_child);
+  // In async mode, the state flow graph may drop listgen tasks, so their
+  // lists cannot be kept based on activation versions.
+  const bool reuse =
+      prog->config.reuse_element_lists && !prog->config.async_mode;
+  call("clear_list", get_runtime(), meta_parent, meta_child,
+       tlctx->get_constant((int)reuse));
 }
 
 void CodeGenLLVM::visit(InternalFuncStmt *stmt) {
+  if (stmt->func_name == "linear_thread_idx") {
+    llvm_val[stmt] = emit_linear_thread_idx();
+    return;
+  }
   std::vector<llvm::Value *> args{get_context()};
   for (auto s : stmt->args) {
     args.push_back(llvm_val[s]);
@@ -2251,26 +2438,31 @@ FunctionType CodeGenLLVM::compile_module_to_executable() {
   return [offloaded_tasks_local, kernel_name_,
           kernel = this->kernel](RuntimeContext &context) {
     TI_TRACE("Launching kernel {}", kernel_name_);
-    auto args = kernel->args;
-    // For taichi ndarrays, context.args saves pointer to its
-    // |DeviceAllocation|, CPU backend actually want to use the raw ptr here.
-    for (int i = 0; i < (int)args.size(); i++) {
-      if (args[i].is_array && context.is_device_allocation[i] &&
-          args[i].size > 0) {
-        DeviceAllocation *ptr =
-            static_cast<DeviceAllocation *>(context.get_arg<void *>(i));
-        uint64 host_ptr = (uint64)kernel->program->get_llvm_program_impl()
-                              ->get_ndarray_alloc_info_ptr(*ptr);
-        context.set_arg(i, host_ptr);
-        context.set_device_allocation(i, false);
-      }
-    }
+    resolve_ndarray_args(kernel, context);
     for (auto task : offloaded_tasks_local) {
       task(&context);
     }
   };
 }
 
+void CodeGenLLVM::resolve_ndarray_args(Kernel *kernel,
+                                       RuntimeContext &context) {
+  auto &args = kernel->args;
+  // For taichi ndarrays, context.args saves pointer to its
+  // |DeviceAllocation|, CPU backend actually want to use the raw ptr here.
+  for (int i = 0; i < (int)args.size(); i++) {
+    if (args[i].is_array && context.is_device_allocation[i] &&
+        args[i].size > 0) {
+      DeviceAllocation *ptr =
+          static_cast<DeviceAllocation *>(context.get_arg<void *>(i));
+      uint64 host_ptr = (uint64)kernel->program->get_llvm_program_impl()
+                            ->get_ndarray_alloc_info_ptr(*ptr);
+      context.set_arg(i, host_ptr);
+      context.set_device_allocation(i, false);
+    }
+  }
+}
+
 FunctionCreationGuard CodeGenLLVM::get_function_creation_guard(
     std::vector<llvm::Type *> argument_types) {
   return FunctionCreationGuard(this, argument_types);
@@ -2298,6 +2490,10 @@ llvm::Value *CodeGenLLVM::get_tls_base_ptr() {
   return get_arg(1);
 }
 
+llvm::Value *CodeGenLLVM::emit_linear_thread_idx() {
+  return create_call("linear_thread_idx", {get_context()});
+}
+
 llvm::Type *CodeGenLLVM::get_tls_buffer_type() {
   return llvm::Type::getInt8PtrTy(*llvm_context);
 }
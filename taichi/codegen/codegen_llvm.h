@@ -61,9 +61,13 @@ class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
   llvm::Value *current_coordinates;
   llvm::Value *parent_coordinates{nullptr};
   llvm::Value *block_corner_coordinates{nullptr};
-  llvm::GlobalVariable *bls_buffer{nullptr};
+  // Shared memory on GPUs and a stack buffer of the struct-for body on CPUs
+  llvm::Value *bls_buffer{nullptr};
   // Mainly for supporting continue stmt
   llvm::BasicBlock *current_loop_reentry;
+  // For continue stmts in offloaded range-for bodies that iterate over a
+  // chunk of indices, instead of returning from the body
+  llvm::BasicBlock *offloaded_loop_reentry{nullptr};
   // Mainly for supporting break stmt
   llvm::BasicBlock *current_while_after_loop;
   llvm::FunctionType *task_function_type;
@@ -96,6 +100,9 @@ class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
 
   llvm::Value *get_tls_base_ptr();
 
+  // Returns the index of the current thread, e.g., to pick its random state.
+  virtual llvm::Value *emit_linear_thread_idx();
+
   llvm::Type *get_tls_buffer_type();
 
   std::vector<llvm::Type *> get_xlogue_argument_types();
@@ -124,6 +131,10 @@ class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
 
   virtual FunctionType compile_module_to_executable();
 
+  // Replaces the DeviceAllocation pointers of the ndarray args in |context|
+  // with the host pointers of the allocations.
+  static void resolve_ndarray_args(Kernel *kernel, RuntimeContext &context);
+
   virtual FunctionType gen();
 
   // For debugging only
@@ -146,6 +157,15 @@ class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
 
   llvm::Value *create_call(std::string func_name,
                            llvm::ArrayRef<llvm::Value *> args = {});
+
+  // Calls a math function of the runtime, mapping it to its vector variants
+  // if there are any, vector_math is on, and the call is in a loop that gets
+  // vectorized.
+  llvm::Value *create_math_call(const std::string &func_name,
+                                llvm::ArrayRef<llvm::Value *> args);
+
+  llvm::Function *get_vector_math_function(const std::string &func_name,
+                                           int lanes);
   llvm::Value *call(SNode *snode,
                     llvm::Value *node_ptr,
                     const std::string &method,
@@ -272,6 +292,8 @@ class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
 
   void visit(GlobalLoadStmt *stmt) override;
 
+  void visit(PrefetchStmt *stmt) override;
+
   void visit(ElementShuffleStmt *stmt) override;
 
   void visit(GetRootStmt *stmt) override;
@@ -17,6 +17,7 @@ constexpr int taichi_max_num_mem_requests = 1024 * 64;
 constexpr std::size_t taichi_page_size = 4096;
 constexpr std::size_t taichi_error_message_max_length = 2048;
 constexpr std::size_t taichi_error_message_max_num_arguments = 32;
+constexpr int taichi_max_num_error_records = 16;
 constexpr std::size_t taichi_result_buffer_entries = 32;
 constexpr std::size_t taichi_max_num_ret_value = 30;
 // slot for kernel return value
@@ -27,6 +28,9 @@ constexpr std::size_t taichi_result_buffer_runtime_query_id = 2;
 
 constexpr int taichi_listgen_max_element_size = 1024;
 
+// bytes right before the TLS buffer of a CPU task, holding its thread id
+constexpr int taichi_cpu_thread_id_size = 8;
+
 // use for auto mesh_local to determine shared-mem size per block (in bytes)
 // TODO: get this at runtime
 constexpr std::size_t default_shared_mem_size = 65536;
@@ -40,6 +40,7 @@ PER_STATEMENT(PrintStmt)
 PER_STATEMENT(RandStmt)
 PER_STATEMENT(GlobalLoadStmt)
 PER_STATEMENT(GlobalStoreStmt)
+PER_STATEMENT(PrefetchStmt)
 PER_STATEMENT(AtomicOpStmt)
 PER_STATEMENT(LocalStoreStmt)
 PER_STATEMENT(SNodeOpStmt)
@@ -3,6 +3,7 @@
 #include "taichi/ir/ir.h"
 #include "taichi/ir/mesh.h"
 #include "taichi/ir/pass.h"
+#include "taichi/analysis/build_cfg.h"
 #include "taichi/analysis/gather_uniquely_accessed_pointers.h"
 #include "taichi/analysis/mesh_bls_analyzer.h"
 #include <atomic>
@@ -53,6 +54,18 @@ class DiffRange {
   }
 };
 
+/**
+ * An interval [low, high] containing all values of an integral statement.
+ */
+struct ValueRange {
+  int64 low;
+  int64 high;
+
+  bool within(int64 min_value, int64 max_value) const {
+    return min_value <= low && high <= max_value;
+  }
+};
+
 enum AliasResult { same, uncertain, different };
 
 class ControlFlowGraph;
@@ -105,6 +118,13 @@ std::pair<std::unordered_set<SNode *>, std::unordered_set<SNode *>>
 gather_snode_read_writes(IRNode *root);
 std::vector<Stmt *> gather_statements(IRNode *root,
                                       const std::function<bool(Stmt *)> &test);
+/**
+ * Gather the statements referenced by fields other than operands, e.g.
+ * OffloadedStmt::end_stmt and Block::mask_var. Rewriting the operands of
+ * their users does not update these references, so passes must not erase
+ * such statements when replacing them.
+ */
+std::unordered_set<Stmt *> gather_non_operand_references(IRNode *root);
 void gather_uniquely_accessed_bit_structs(IRNode *root, AnalysisManager *amgr);
 std::unordered_map<const SNode *, GlobalPtrStmt *>
 gather_uniquely_accessed_pointers(IRNode *root);
@@ -127,6 +147,37 @@ std::vector<Stmt *> get_load_pointers(Stmt *load_stmt);
 void get_meta_input_value_states(IRNode *root, TaskMeta *meta, IRBank *ir_bank);
 Stmt *get_store_data(Stmt *store_stmt);
 std::vector<Stmt *> get_store_destination(Stmt *store_stmt);
+
+/**
+ * Splits the offloaded tasks in |root| into groups of consecutive tasks that
+ * can run concurrently. Tasks in a group access disjoint SNodes, or only read
+ * the shared ones, and touch neither global temporaries, lists nor the
+ * runtime. Range-for tasks can be grouped only if their constant number of
+ * iterations times their number of statements is at most
+ * |max_range_for_cost|.
+ *
+ * @param root
+ *   The kernel body consisting of offloaded tasks.
+ *
+ * @return
+ *   The index of the first task of each group.
+ */
+std::vector<int> group_independent_offloads(Block *root,
+                                            int64 max_range_for_cost);
+/**
+ * Checks if |offload| is cheap enough to run serially on one thread next to
+ * other tasks, i.e., it is a serial task, or a range-for whose constant number
+ * of iterations times its number of statements is at most
+ * |max_range_for_cost|.
+ */
+bool is_small_offload(OffloadedStmt *offload, int64 max_range_for_cost);
+/**
+ * Checks if |offload| only touches its SNodes and external arrays, so that it
+ * may run next to tasks accessing other ones. Tasks using global temporaries,
+ * lists, the runtime, prints, asserts, returns or sparse activation must run
+ * alone.
+ */
+bool can_run_concurrently(OffloadedStmt *offload);
 bool has_store_or_atomic(IRNode *root, const std::vector<Stmt *> &vars);
 std::pair<bool, Stmt *> last_store_or_atomic(IRNode *root, Stmt *var);
 
@@ -230,6 +281,16 @@ struct DiffPtrResult {
  */
 DiffPtrResult value_diff_ptr_index(Stmt *val1, Stmt *val2);
 
+/**
+ * Computes an interval of the values of an integral statement from loop
+ * bounds, range assumptions, constants and the operations in between.
+ * Returns the range of the type of |stmt| if nothing better is known.
+ *
+ * @param stmt
+ *   The statement to analyze, of width 1.
+ */
+ValueRange value_range(Stmt *stmt);
+
 std::unordered_set<Stmt *> constexpr_prop(
     Block *block,
     std::function<bool(Stmt *)> is_const_seed);
@@ -1,11 +1,14 @@
 #include "taichi/ir/control_flow_graph.h"
 
+#include <algorithm>
+#include <functional>
 #include <queue>
 #include <unordered_set>
 
 #include "taichi/ir/analysis.h"
 #include "taichi/ir/statements.h"
 #include "taichi/system/profiler.h"
+#include "taichi/util/bit.h"
 
 namespace taichi {
 namespace lang {
@@ -613,11 +616,8 @@ void ControlFlowGraph::print_graph_structure() const {
   }
 }
 
-void ControlFlowGraph::reaching_definition_analysis(bool after_lower_access) {
-  TI_AUTO_PROF;
+void ControlFlowGraph::reaching_definition_gen_kill(bool after_lower_access) {
   const int num_nodes = size();
-  std::queue<CFGNode *> to_visit;
-  std::unordered_map<CFGNode *, bool> in_queue;
   TI_ASSERT(nodes[start_node]->empty());
   nodes[start_node]->reach_gen.clear();
   nodes[start_node]->reach_kill.clear();
@@ -640,6 +640,270 @@ void ControlFlowGraph::reaching_definition_analysis(bool after_lower_access) {
     if (i != start_node) {
       nodes[i]->reaching_definition_analysis(after_lower_access);
     }
+  }
+}
+
+void ControlFlowGraph::live_variable_gen_kill(
+    bool after_lower_access,
+    const std::optional<LiveVarAnalysisConfig> &config_opt) {
+  const int num_nodes = size();
+  TI_ASSERT(nodes[final_node]->empty());
+  nodes[final_node]->live_gen.clear();
+  nodes[final_node]->live_kill.clear();
+
+  auto in_final_node_live_gen = [&config_opt](const Stmt *stmt) -> bool {
+    if (stmt->is<AllocaStmt>() || stmt->is<AdStackAllocaStmt>()) {
+      return false;
+    }
+    if (stmt->is<PtrOffsetStmt>() &&
+        stmt->cast<PtrOffsetStmt>()->origin->is<AllocaStmt>()) {
+      return false;
+    }
+    if (auto *gptr = stmt->cast<GlobalPtrStmt>();
+        gptr && config_opt.has_value()) {
+      TI_ASSERT(gptr->snodes.size() == 1);
+      const bool res =
+          (config_opt->eliminable_snodes.count(gptr->snodes[0]) == 0);
+      return res;
+    }
+    // A global pointer that may be loaded after this kernel.
+    return true;
+  };
+  if (!after_lower_access) {
+    for (int i = 0; i < num_nodes; i++) {
+      for (int j = nodes[i]->begin_location; j < nodes[i]->end_location; j++) {
+        auto stmt = nodes[i]->block->statements[j].get();
+        for (auto store_ptr : irpass::analysis::get_store_destination(stmt)) {
+          if (in_final_node_live_gen(store_ptr)) {
+            nodes[final_node]->live_gen.insert(store_ptr);
+          }
+        }
+      }
+    }
+  }
+  for (int i = 0; i < num_nodes; i++) {
+    if (i != final_node) {
+      nodes[i]->live_variable_analysis(after_lower_access);
+    }
+  }
+}
+
+std::vector<int> ControlFlowGraph::reverse_post_order(bool backward) const {
+  const int num_nodes = size();
+  std::unordered_map<CFGNode *, int> node_ids;
+  for (int i = 0; i < num_nodes; i++)
+    node_ids[nodes[i].get()] = i;
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  std::vector<bool> visited(num_nodes, false);
+  // Iterative depth-first search. Each entry is a node and the index of the
+  // next successor to visit.
+  std::vector<std::pair<int, int>> stack;
+  const int root = backward ? final_node : start_node;
+  stack.emplace_back(root, 0);
+  visited[root] = true;
+  while (!stack.empty()) {
+    auto &[node_id, next_index] = stack.back();
+    const auto &successors =
+        backward ? nodes[node_id]->prev : nodes[node_id]->next;
+    if (next_index < (int)successors.size()) {
+      int successor = node_ids[successors[next_index++]];
+      if (!visited[successor]) {
+        visited[successor] = true;
+        stack.emplace_back(successor, 0);
+      }
+    } else {
+      order.push_back(node_id);
+      stack.pop_back();
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  for (int i = 0; i < num_nodes; i++) {
+    if (!visited[i])
+      order.push_back(i);
+  }
+  return order;
+}
+
+namespace {
+
+/**
+ * The per-CFG state of a gen/kill dataflow analysis over dense bitvectors.
+ *
+ * Facts (definitions or variables) are numbered densely in |facts|. Whether
+ * a fact is killed by a node is decided by |killed| at most once per
+ * (node, fact) pair, the first time the fact flows into the node, because it
+ * is the expensive part of the transfer function for global pointers.
+ */
+class BitVectorDataflow {
+ public:
+  using Killed = std::function<bool(CFGNode *, Stmt *)>;
+
+  // |backward| selects live variables instead of reaching definitions.
+  BitVectorDataflow(const std::vector<std::unique_ptr<CFGNode>> &nodes,
+                    bool backward,
+                    const Killed &killed)
+      : nodes_(nodes), backward_(backward), killed_(killed) {
+    const int num_nodes = nodes.size();
+    for (int i = 0; i < num_nodes; i++) {
+      node_ids_[nodes[i].get()] = i;
+      for (auto stmt : gen(i)) {
+        if (fact_ids_.emplace(stmt, (int)facts_.size()).second)
+          facts_.push_back(stmt);
+      }
+    }
+    const int num_facts = facts_.size();
+    in_.resize(num_nodes, bit::Bitset(num_facts));
+    out_.resize(num_nodes, bit::Bitset(num_facts));
+    checked_.resize(num_nodes, bit::Bitset(num_facts));
+    survive_.resize(num_nodes, bit::Bitset(num_facts));
+    for (int i = 0; i < num_nodes; i++) {
+      for (auto stmt : gen(i)) {
+        out_[i][fact_ids_[stmt]] = true;
+      }
+    }
+  }
+
+  // The worklist algorithm, which visits the pending nodes in |order|.
+  void run(const std::vector<int> &order) {
+    const int num_nodes = nodes_.size();
+    std::vector<int> position(num_nodes);
+    for (int i = 0; i < num_nodes; i++)
+      position[order[i]] = i;
+    bit::Bitset pending(num_nodes);
+    for (int i = 0; i < num_nodes; i++)
+      pending[i] = true;
+    // Sweep the pending nodes in |order| until none is left.
+    int p = pending.find_first_one();
+    while (p != -1) {
+      pending[p] = false;
+      const int i = order[p];
+      CFGNode *now = nodes_[i].get();
+      bit::Bitset in(facts_.size());
+      for (auto pred : predecessors(now)) {
+        in |= out_[node_ids_[pred]];
+      }
+      for (int fact : checked_[i].or_eq_get_update_list(in)) {
+        if (!killed_(now, facts_[fact]))
+          survive_[i][fact] = true;
+      }
+      in_[i] = in;
+      in &= survive_[i];
+      // |in| only grows, so |out| changes iff it gains a fact.
+      if (!out_[i].or_eq_get_update_list(in).empty()) {
+        for (auto succ : successors(now)) {
+          pending[position[node_ids_[succ]]] = true;
+        }
+      }
+      p = pending.lower_bound(p + 1);
+      if (p == -1)
+        p = pending.find_first_one();
+    }
+  }
+
+  // Convert the results back to the sets stored in CFGNodes.
+  std::unordered_set<Stmt *> get_in(int node_id) {
+    return to_set(in_[node_id]);
+  }
+
+  std::unordered_set<Stmt *> get_out(int node_id) {
+    return to_set(out_[node_id]);
+  }
+
+ private:
+  const std::unordered_set<Stmt *> &gen(int node_id) const {
+    return backward_ ? nodes_[node_id]->live_gen : nodes_[node_id]->reach_gen;
+  }
+
+  const std::vector<CFGNode *> &predecessors(CFGNode *node) const {
+    return backward_ ? node->next : node->prev;
+  }
+
+  const std::vector<CFGNode *> &successors(CFGNode *node) const {
+    return backward_ ? node->prev : node->next;
+  }
+
+  std::unordered_set<Stmt *> to_set(const bit::Bitset &bits) const {
+    std::unordered_set<Stmt *> result;
+    for (int i = bits.find_first_one(); i != -1; i = bits.lower_bound(i + 1)) {
+      result.insert(facts_[i]);
+    }
+    return result;
+  }
+
+  const std::vector<std::unique_ptr<CFGNode>> &nodes_;
+  bool backward_;
+  Killed killed_;
+  std::unordered_map<CFGNode *, int> node_ids_;
+  std::vector<Stmt *> facts_;
+  std::unordered_map<Stmt *, int> fact_ids_;
+  // For backward analyses |in_| and |out_| hold live_out and live_in.
+  std::vector<bit::Bitset> in_, out_;
+  // Facts whose survival through the node has been decided, and the ones
+  // which survive.
+  std::vector<bit::Bitset> checked_, survive_;
+};
+
+}  // namespace
+
+void ControlFlowGraph::reaching_definition_analysis(bool after_lower_access) {
+  TI_AUTO_PROF;
+  reaching_definition_gen_kill(after_lower_access);
+  // The store destinations of each definition are looked up once.
+  std::unordered_map<Stmt *, std::vector<Stmt *>> store_ptrs_cache;
+  auto killed = [&](CFGNode *node, Stmt *stmt) {
+    if (node->reach_kill.empty())
+      return false;
+    auto it = store_ptrs_cache.find(stmt);
+    if (it == store_ptrs_cache.end()) {
+      it = store_ptrs_cache
+               .emplace(stmt, irpass::analysis::get_store_destination(stmt))
+               .first;
+    }
+    const auto &store_ptrs = it->second;
+    if (store_ptrs.empty()) {  // the case of a global pointer
+      return node->reach_kill_variable(stmt);
+    }
+    for (auto store_ptr : store_ptrs) {
+      if (!node->reach_kill_variable(store_ptr))
+        return false;
+    }
+    return true;
+  };
+  BitVectorDataflow dataflow(nodes, /*backward=*/false, killed);
+  dataflow.run(reverse_post_order(/*backward=*/false));
+  const int num_nodes = size();
+  for (int i = 0; i < num_nodes; i++) {
+    nodes[i]->reach_in = dataflow.get_in(i);
+    nodes[i]->reach_out = dataflow.get_out(i);
+  }
+}
+
+void ControlFlowGraph::live_variable_analysis(
+    bool after_lower_access,
+    const std::optional<LiveVarAnalysisConfig> &config_opt) {
+  TI_AUTO_PROF;
+  live_variable_gen_kill(after_lower_access, config_opt);
+  auto killed = [](CFGNode *node, Stmt *stmt) {
+    return CFGNode::contain_variable(node->live_kill, stmt);
+  };
+  BitVectorDataflow dataflow(nodes, /*backward=*/true, killed);
+  dataflow.run(reverse_post_order(/*backward=*/true));
+  const int num_nodes = size();
+  for (int i = 0; i < num_nodes; i++) {
+    nodes[i]->live_out = dataflow.get_in(i);
+    nodes[i]->live_in = dataflow.get_out(i);
+  }
+}
+
+void ControlFlowGraph::reaching_definition_analysis_reference(
+    bool after_lower_access) {
+  TI_AUTO_PROF;
+  const int num_nodes = size();
+  std::queue<CFGNode *> to_visit;
+  std::unordered_map<CFGNode *, bool> in_queue;
+  reaching_definition_gen_kill(after_lower_access);
+  for (int i = 0; i < num_nodes; i++) {
     nodes[i]->reach_in.clear();
     nodes[i]->reach_out = nodes[i]->reach_gen;
     to_visit.push(nodes[i].get());
@@ -689,52 +953,16 @@ void ControlFlowGraph::reaching_definition_analysis(bool after_lower_access) {
   }
 }
 
-void ControlFlowGraph::live_variable_analysis(
+void ControlFlowGraph::live_variable_analysis_reference(
     bool after_lower_access,
     const std::optional<LiveVarAnalysisConfig> &config_opt) {
   TI_AUTO_PROF;
   const int num_nodes = size();
   std::queue<CFGNode *> to_visit;
   std::unordered_map<CFGNode *, bool> in_queue;
-  TI_ASSERT(nodes[final_node]->empty());
-  nodes[final_node]->live_gen.clear();
-  nodes[final_node]->live_kill.clear();
-
-  auto in_final_node_live_gen = [&config_opt](const Stmt *stmt) -> bool {
-    if (stmt->is<AllocaStmt>() || stmt->is<AdStackAllocaStmt>()) {
-      return false;
-    }
-    if (stmt->is<PtrOffsetStmt>() &&
-        stmt->cast<PtrOffsetStmt>()->origin->is<AllocaStmt>()) {
-      return false;
-    }
-    if (auto *gptr = stmt->cast<GlobalPtrStmt>();
-        gptr && config_opt.has_value()) {
-      TI_ASSERT(gptr->snodes.size() == 1);
-      const bool res =
-          (config_opt->eliminable_snodes.count(gptr->snodes[0]) == 0);
-      return res;
-    }
-    // A global pointer that may be loaded after this kernel.
-    return true;
-  };
-  if (!after_lower_access) {
-    for (int i = 0; i < num_nodes; i++) {
-      for (int j = nodes[i]->begin_location; j < nodes[i]->end_location; j++) {
-        auto stmt = nodes[i]->block->statements[j].get();
-        for (auto store_ptr : irpass::analysis::get_store_destination(stmt)) {
-          if (in_final_node_live_gen(store_ptr)) {
-            nodes[final_node]->live_gen.insert(store_ptr);
-          }
-        }
-      }
-    }
-  }
+  live_variable_gen_kill(after_lower_access, config_opt);
   for (int i = num_nodes - 1; i >= 0; i--) {
     // push into the queue in reversed order to make it slightly faster
-    if (i != final_node) {
-      nodes[i]->live_variable_analysis(after_lower_access);
-    }
     nodes[i]->live_out.clear();
     nodes[i]->live_in = nodes[i]->live_gen;
     to_visit.push(nodes[i].get());
@@ -110,8 +110,8 @@ class ControlFlowGraph {
   void print_graph_structure() const;
 
   /**
-   * Perform reaching definition analysis using the worklist algorithm,
-   * and store the results in CFGNodes.
+   * Perform reaching definition analysis using the worklist algorithm over
+   * bitvectors in reverse postorder, and store the results in CFGNodes.
    * https://en.wikipedia.org/wiki/Reaching_definition
    *
    * @param after_lower_access
@@ -120,8 +120,9 @@ class ControlFlowGraph {
   void reaching_definition_analysis(bool after_lower_access);
 
   /**
-   * Perform live variable analysis using the worklist algorithm,
-   * and store the results in CFGNodes.
+   * Perform live variable analysis using the worklist algorithm over
+   * bitvectors in reverse postorder of the reversed graph, and store the
+   * results in CFGNodes.
    * https://en.wikipedia.org/wiki/Live_variable_analysis
    *
    * @param after_lower_access
@@ -133,6 +134,16 @@ class ControlFlowGraph {
       bool after_lower_access,
       const std::optional<LiveVarAnalysisConfig> &config_opt);
 
+  /**
+   * The previous implementations of the two analyses above, which iterate
+   * over hash sets in FIFO order. They produce the same results and are kept
+   * for cross-checking.
+   */
+  void reaching_definition_analysis_reference(bool after_lower_access);
+  void live_variable_analysis_reference(
+      bool after_lower_access,
+      const std::optional<LiveVarAnalysisConfig> &config_opt);
+
   /**
    * Simplify the graph structure to accelerate other analyses and
    * optimizations. The IR is not modified.
@@ -166,6 +177,23 @@ class ControlFlowGraph {
    * unable to determine some AD-stack's size.
    */
   void determine_ad_stack_size(int default_ad_stack_size);
+
+ private:
+  // Compute |reach_gen| and |reach_kill| of all nodes.
+  void reaching_definition_gen_kill(bool after_lower_access);
+
+  // Compute |live_gen| and |live_kill| of all nodes.
+  void live_variable_gen_kill(
+      bool after_lower_access,
+      const std::optional<LiveVarAnalysisConfig> &config_opt);
+
+  /**
+   * Order the nodes for the worklist algorithm: reverse postorder from the
+   * start node for forward analyses, or reverse postorder on the reversed
+   * graph from the final node for backward analyses. Unreachable nodes are
+   * appended at the end.
+   */
+  std::vector<int> reverse_post_order(bool backward) const;
 };
 
 }  // namespace lang
@@ -10,6 +10,7 @@
 
 #include "taichi/common/core.h"
 #include "taichi/common/exceptions.h"
+#include "taichi/ir/ir_arena.h"
 #include "taichi/ir/snode.h"
 #include "taichi/ir/mesh.h"
 #include "taichi/ir/type_factory.h"
@@ -384,6 +385,8 @@ struct LaneAttribute {
 
 class StmtField {
  public:
+  TI_IR_ARENA_ALLOCATED
+
   StmtField() = default;
 
   virtual bool equal(const StmtField *other) const = 0;
@@ -483,9 +486,11 @@ class StmtFieldManager {
 
 class Stmt : public IRNode {
  protected:
-  std::vector<Stmt **> operands;
+  std::vector<Stmt **, IRArenaAllocator<Stmt **>> operands;
 
  public:
+  TI_IR_ARENA_ALLOCATED
+
   StmtFieldManager field_manager;
   static std::atomic<int> instance_id_counter;
   int instance_id;
@@ -610,6 +615,8 @@ class Block : public IRNode {
   // variables, and AllocaStmt for other variables.
   std::map<Identifier, Stmt *> local_var_to_stmt;
 
+  TI_IR_ARENA_ALLOCATED
+
   Block() {
     mask_var = nullptr;
     parent_stmt = nullptr;
@@ -667,6 +674,13 @@ class Block : public IRNode {
 
   std::unique_ptr<Block> clone() const;
 
+  // Frees the statements erased from this block. Only call this when nothing
+  // refers to erased statements anymore, e.g. at the end of a compilation
+  // stage.
+  void clear_trash_bin() {
+    trash_bin.clear();
+  }
+
   TI_DEFINE_ACCEPT
 };
 
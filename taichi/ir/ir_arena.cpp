@@ -0,0 +1,194 @@
+#include "taichi/ir/ir_arena.h"
+
+#include <algorithm>
+
+namespace taichi {
+namespace lang {
+
+namespace {
+
+// Prepended to every allocation so that deallocate() can find its origin.
+struct alignas(IRArena::kAlignment) AllocationHeader {
+  IRArena *arena;  // nullptr for heap allocations
+  std::size_t size;
+};
+
+static_assert(sizeof(AllocationHeader) == IRArena::kAlignment);
+
+// The cache of a Scope is refilled with blocks worth about this many bytes
+// at once, so that most allocations do not take the arena lock.
+constexpr std::size_t kRefillBytes = 16 << 10;
+
+std::size_t round_up(std::size_t size) {
+  return (size + IRArena::kAlignment - 1) / IRArena::kAlignment *
+         IRArena::kAlignment;
+}
+
+std::size_t get_size_class(std::size_t rounded_size) {
+  if (rounded_size <= IRArena::kMaxSmallSize)
+    return rounded_size / IRArena::kAlignment - 1;
+  std::size_t size_class = IRArena::kNumSmallSizeClasses;
+  for (auto size = IRArena::kMaxSmallSize * 2; size < rounded_size;
+       size *= 2) {
+    size_class++;
+  }
+  TI_ASSERT(size_class < IRArena::kNumSizeClasses);
+  return size_class;
+}
+
+constexpr std::size_t get_class_size(std::size_t size_class) {
+  if (size_class < IRArena::kNumSmallSizeClasses)
+    return (size_class + 1) * IRArena::kAlignment;
+  return IRArena::kMaxSmallSize * 2
+         << (size_class - IRArena::kNumSmallSizeClasses);
+}
+
+static_assert(get_class_size(IRArena::kNumSizeClasses - 1) ==
+              IRArena::kMaxChunkAllocationSize);
+
+void *&next_free_block(void *block) {
+  return *static_cast<void **>(block);
+}
+
+}  // namespace
+
+thread_local IRArena::Scope *IRArena::current_scope_ = nullptr;
+
+IRArena::Scope::Scope(IRArena *arena) : arena_(arena), old_(current_scope_) {
+  if (arena_ != nullptr)
+    arena_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+  current_scope_ = this;
+}
+
+IRArena::Scope::~Scope() {
+  current_scope_ = old_;
+  if (arena_ != nullptr) {
+    arena_->flush(this);
+    arena_->unref();
+  }
+}
+
+IRArena::IRArena() = default;
+
+IRArena::~IRArena() {
+  TI_ASSERT(num_live_allocations_ == 0);
+}
+
+IRArena::Ref IRArena::create() {
+  return Ref(new IRArena());
+}
+
+void *IRArena::allocate(std::size_t size) {
+  auto total_size = round_up(size + sizeof(AllocationHeader));
+  auto *scope = current_scope_;
+  if (scope == nullptr || scope->arena_ == nullptr ||
+      total_size > kMaxChunkAllocationSize) {
+    auto header = static_cast<AllocationHeader *>(::operator new(total_size));
+    header->arena = nullptr;
+    header->size = total_size;
+    return header + 1;
+  }
+  auto *arena = scope->arena_;
+  auto size_class = get_size_class(total_size);
+  auto &cached = scope->cache_[size_class];
+  if (cached == nullptr)
+    arena->refill(scope, size_class);
+  void *mem = cached;
+  cached = next_free_block(mem);
+  auto class_size = get_class_size(size_class);
+  arena->live_bytes_.fetch_add(class_size, std::memory_order_relaxed);
+  arena->num_live_allocations_.fetch_add(1, std::memory_order_relaxed);
+  arena->ref_count_.fetch_add(1, std::memory_order_relaxed);
+  auto header = static_cast<AllocationHeader *>(mem);
+  header->arena = arena;
+  header->size = class_size;
+  return header + 1;
+}
+
+void IRArena::deallocate(void *ptr) noexcept {
+  if (ptr == nullptr)
+    return;
+  auto header = static_cast<AllocationHeader *>(ptr) - 1;
+  auto *arena = header->arena;
+  if (arena == nullptr) {
+    ::operator delete(header);
+    return;
+  }
+  auto size_class = get_size_class(header->size);
+  arena->live_bytes_.fetch_sub(header->size, std::memory_order_relaxed);
+  arena->num_live_allocations_.fetch_sub(1, std::memory_order_relaxed);
+  auto *scope = current_scope_;
+  if (scope != nullptr && scope->arena_ == arena) {
+    // The Scope holds a reference, so this never frees the arena.
+    next_free_block(header) = scope->cache_[size_class];
+    scope->cache_[size_class] = header;
+  } else {
+    std::lock_guard<std::mutex> _(arena->mut_);
+    arena->free_lists_[size_class].push_back(header);
+  }
+  arena->unref();
+}
+
+void IRArena::refill(Scope *scope, std::size_t size_class) {
+  auto size = get_class_size(size_class);
+  auto count = std::max<std::size_t>(1, kRefillBytes / size);
+  auto &cached = scope->cache_[size_class];
+  auto &free_list = free_lists_[size_class];
+  std::lock_guard<std::mutex> _(mut_);
+  for (std::size_t i = 0; i < count; i++) {
+    void *mem = nullptr;
+    if (!free_list.empty()) {
+      mem = free_list.back();
+      free_list.pop_back();
+    } else if ((std::size_t)(tail_ - head_) >= size) {
+      mem = head_;
+      head_ += size;
+    } else if (i == 0) {
+      // Only start a new chunk for the block that is needed right away.
+      chunks_.emplace_back(new char[kChunkSize]);
+      head_ = chunks_.back().get();
+      tail_ = head_ + kChunkSize;
+      mem = head_;
+      head_ += size;
+    } else {
+      break;
+    }
+    next_free_block(mem) = cached;
+    cached = mem;
+  }
+}
+
+void IRArena::flush(Scope *scope) {
+  std::lock_guard<std::mutex> _(mut_);
+  for (std::size_t i = 0; i < kNumSizeClasses; i++) {
+    for (void *block = scope->cache_[i]; block != nullptr;) {
+      auto next = next_free_block(block);
+      free_lists_[i].push_back(block);
+      block = next;
+    }
+    scope->cache_[i] = nullptr;
+  }
+}
+
+void IRArena::unref() {
+  if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // Bulk free: all chunks go back at once.
+    delete this;
+  }
+}
+
+std::size_t IRArena::reserved_bytes() const {
+  std::lock_guard<std::mutex> _(mut_);
+  return chunks_.size() * kChunkSize;
+}
+
+std::size_t IRArena::live_bytes() const {
+  return live_bytes_.load(std::memory_order_relaxed);
+}
+
+std::size_t IRArena::num_live_allocations() const {
+  return num_live_allocations_.load(std::memory_order_relaxed);
+}
+
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "taichi/common/core.h"
+
+namespace taichi {
+namespace lang {
+
+/**
+ * A per-callable bump allocator for CHI IR nodes (statements, blocks, operand
+ * lists and statement fields).
+ *
+ * IR nodes are still owned by std::unique_ptr, so VecStatement,
+ * DelayedIRModifier and Block::trash_bin keep their semantics. Only the
+ * storage differs: when an IRArena is installed on the current thread via
+ * IRArena::Scope, `new` on these classes carves memory out of large chunks
+ * instead of calling malloc, and `delete` pushes the memory onto a size-class
+ * free list for reuse by later passes.
+ *
+ * Each Scope caches free blocks of its arena per size class, so that the
+ * allocations and deallocations on the installing thread do not take the
+ * arena lock. The cache is refilled in batches, and handed back to the arena
+ * when the Scope ends.
+ *
+ * Every allocation holds a reference to its arena, so IR that is moved out
+ * of its kernel (e.g. cloned offloads in the async engine) stays valid. The
+ * chunks are returned to the system all at once when the owner and every
+ * allocation have released the arena.
+ */
+class IRArena {
+ public:
+  static constexpr std::size_t kChunkSize = 1 << 20;
+  static constexpr std::size_t kAlignment = 16;
+  // Allocations up to this size are rounded up to a multiple of kAlignment.
+  static constexpr std::size_t kMaxSmallSize = 1024;
+  // Larger allocations are rounded up to a power of two, up to this size.
+  // Beyond it, they bypass the chunks to bound internal waste.
+  static constexpr std::size_t kMaxChunkAllocationSize = kChunkSize / 4;
+  static constexpr std::size_t kNumSmallSizeClasses =
+      kMaxSmallSize / kAlignment;
+  // 2 KB, 4 KB, ..., 256 KB.
+  static constexpr std::size_t kNumLargeSizeClasses = 8;
+  static constexpr std::size_t kNumSizeClasses =
+      kNumSmallSizeClasses + kNumLargeSizeClasses;
+
+  struct Deleter {
+    void operator()(IRArena *arena) const {
+      arena->unref();
+    }
+  };
+  // The owner reference held by a Callable.
+  using Ref = std::unique_ptr<IRArena, Deleter>;
+
+  static Ref create();
+
+  // Allocate from the arena installed on this thread, or from the heap if
+  // there is none.
+  static void *allocate(std::size_t size);
+
+  // Release memory returned by allocate(), regardless of the thread and of
+  // which arena (if any) is currently installed.
+  static void deallocate(void *ptr) noexcept;
+
+  static IRArena *current() {
+    return current_scope_ ? current_scope_->arena_ : nullptr;
+  }
+
+  // Installs |arena| as the allocation target of the current thread, and
+  // keeps it alive until the Scope ends.
+  class Scope {
+   public:
+    explicit Scope(IRArena *arena);
+
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    friend class IRArena;
+
+    IRArena *arena_;
+    Scope *old_;
+    // Intrusive lists of the free blocks cached by this Scope, one per size
+    // class. Only accessed on the installing thread.
+    void *cache_[kNumSizeClasses]{};
+  };
+
+  std::size_t reserved_bytes() const;
+  std::size_t live_bytes() const;
+  std::size_t num_live_allocations() const;
+
+  IRArena(const IRArena &) = delete;
+  IRArena &operator=(const IRArena &) = delete;
+
+ private:
+  IRArena();
+  ~IRArena();
+
+  // Moves a batch of free blocks of |size_class| into the cache of |scope|.
+  void refill(Scope *scope, std::size_t size_class);
+  // Hands the blocks cached by |scope| back to the shared free lists.
+  void flush(Scope *scope);
+  void unref();
+
+  static thread_local Scope *current_scope_;
+
+  // Guards the chunks and the shared free lists.
+  mutable std::mutex mut_;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  char *head_{nullptr};
+  char *tail_{nullptr};
+  std::vector<void *> free_lists_[kNumSizeClasses];
+  std::atomic<std::size_t> live_bytes_{0};
+  std::atomic<std::size_t> num_live_allocations_{0};
+  // One reference for the owner plus one per live allocation.
+  std::atomic<std::size_t> ref_count_{1};
+};
+
+// A stateless std::allocator replacement backed by IRArena, used for
+// containers owned by IR nodes such as Stmt::operands.
+template <typename T>
+class IRArenaAllocator {
+ public:
+  using value_type = T;
+
+  IRArenaAllocator() noexcept = default;
+
+  template <typename U>
+  IRArenaAllocator(const IRArenaAllocator<U> &) noexcept {
+  }
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(IRArena::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *ptr, std::size_t) noexcept {
+    IRArena::deallocate(ptr);
+  }
+
+  template <typename U>
+  bool operator==(const IRArenaAllocator<U> &) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const IRArenaAllocator<U> &) const noexcept {
+    return false;
+  }
+};
+
+// Routes class-level new/delete of an IR node class through IRArena.
+#define TI_IR_ARENA_ALLOCATED                       \
+  static void *operator new(std::size_t size) {     \
+    return ::taichi::lang::IRArena::allocate(size); \
+  }                                                 \
+  static void operator delete(void *ptr) noexcept { \
+    ::taichi::lang::IRArena::deallocate(ptr);       \
+  }
+
+}  // namespace lang
+}  // namespace taichi
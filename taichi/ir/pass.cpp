@@ -1,9 +1,123 @@
 #include "taichi/ir/pass.h"
 
+#include <sstream>
+
+#include "taichi/ir/analysis.h"
+#include "taichi/system/timer.h"
+
 namespace taichi {
 namespace lang {
 
 const PassID Pass::id = "undefined";
 
+namespace {
+
+// The statement count of the IR, cached between transforms so that the IR
+// delta of a transform costs a single traversal.
+class CountStatementsPass : public Pass {
+ public:
+  static const PassID id;
+
+  struct Result {
+    int num_statements;
+  };
+};
+
+const PassID CountStatementsPass::id = "CountStatementsPass";
+
+int count_statements_cached(IRNode *root, AnalysisManager *amgr) {
+  if (auto *res = amgr->get_cached_analysis<CountStatementsPass>()) {
+    return res->num_statements;
+  }
+  int num_statements = irpass::analysis::count_statements(root);
+  amgr->cache_analysis<CountStatementsPass>({num_statements});
+  return num_statements;
+}
+
+}  // namespace
+
+void PassInstrumentation::record(const PassID &id,
+                                 double time,
+                                 bool modified,
+                                 int64 stmt_delta) {
+  auto &rec = records_[id];
+  rec.num_runs++;
+  if (modified)
+    rec.num_modified++;
+  rec.total_time += time;
+  rec.stmt_delta += stmt_delta;
+}
+
+void PassInstrumentation::record_skipped(const PassID &id) {
+  records_[id].num_skipped++;
+}
+
+void PassInstrumentation::print(const std::string &title) const {
+  std::stringstream ss;
+  ss << fmt::format("{:36} {:>6} {:>8} {:>7} {:>10} {:>10}\n", title, "runs",
+                    "modified", "skipped", "time(ms)", "stmt delta");
+  double total_time = 0;
+  for (auto const &[id, rec] : records_) {
+    ss << fmt::format("{:36} {:6} {:8} {:7} {:10.3f} {:>10}\n", id,
+                      rec.num_runs, rec.num_modified, rec.num_skipped,
+                      rec.total_time * 1000,
+                      track_ir_delta_ ? std::to_string(rec.stmt_delta) : "-");
+    total_time += rec.total_time;
+  }
+  ss << fmt::format("{:36} {:>6} {:>8} {:>7} {:10.3f}\n", "total", "", "", "",
+                    total_time * 1000);
+  fmt::print(ss.str());
+}
+
+void AnalysisManager::invalidate(const PreservedAnalyses &preserved) {
+  for (auto it = cached_.begin(); it != cached_.end();) {
+    if (preserved.is_preserved(it->first)) {
+      ++it;
+    } else {
+      it = cached_.erase(it);
+    }
+  }
+  for (auto it = fixpoints_.begin(); it != fixpoints_.end();) {
+    if (preserved.is_preserved(*it)) {
+      ++it;
+    } else {
+      it = fixpoints_.erase(it);
+    }
+  }
+}
+
+bool AnalysisManager::run_transform(IRNode *root,
+                                    const PassID &id,
+                                    const std::function<bool()> &transform,
+                                    const PreservedAnalyses &preserved) {
+  if (is_at_fixpoint(id)) {
+    if (instrumentation_)
+      instrumentation_->record_skipped(id);
+    return false;
+  }
+
+  bool track_ir_delta = instrumentation_ && instrumentation_->track_ir_delta();
+  int num_statements_before =
+      track_ir_delta ? count_statements_cached(root, this) : 0;
+  auto start = Time::get_time();
+
+  bool modified = transform();
+
+  auto time = Time::get_time() - start;
+  if (modified) {
+    invalidate(preserved);
+  } else {
+    mark_at_fixpoint(id);
+  }
+  if (instrumentation_) {
+    int64 stmt_delta = 0;
+    if (track_ir_delta) {
+      stmt_delta = count_statements_cached(root, this) - num_statements_before;
+    }
+    instrumentation_->record(id, time, modified, stmt_delta);
+  }
+  return modified;
+}
+
 }  // namespace lang
 }  // namespace taichi
@@ -3,7 +3,10 @@
 #include "taichi/ir/ir.h"
 #include "taichi/program/compile_config.h"
 
+#include <functional>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <typeindex>
 #include <utility>
 
@@ -63,8 +66,83 @@ class Pass {
   virtual ~Pass() = default;
 };
 
+// The set of cached analyses a transform keeps valid even if it modifies the
+// IR. Transforms preserve nothing by default.
+class PreservedAnalyses {
+ public:
+  static PreservedAnalyses none() {
+    return PreservedAnalyses();
+  }
+
+  static PreservedAnalyses all() {
+    PreservedAnalyses result;
+    result.all_ = true;
+    return result;
+  }
+
+  template <typename PassT>
+  PreservedAnalyses &preserve() {
+    ids_.insert(PassT::id);
+    return *this;
+  }
+
+  bool is_preserved(const PassID &id) const {
+    return all_ || ids_.count(id) != 0;
+  }
+
+ private:
+  bool all_{false};
+  std::unordered_set<PassID> ids_;
+};
+
+// Records how much time each pass takes and how it changes the IR.
+class PassInstrumentation {
+ public:
+  struct Record {
+    int num_runs{0};
+    int num_modified{0};
+    // Runs skipped because the pass was known to be at a fixpoint.
+    int num_skipped{0};
+    double total_time{0};
+    // The change of the number of statements. Only tracked if
+    // |track_ir_delta| is true.
+    int64 stmt_delta{0};
+  };
+
+  explicit PassInstrumentation(bool track_ir_delta = false)
+      : track_ir_delta_(track_ir_delta) {
+  }
+
+  bool track_ir_delta() const {
+    return track_ir_delta_;
+  }
+
+  void record(const PassID &id,
+              double time,
+              bool modified,
+              int64 stmt_delta = 0);
+
+  void record_skipped(const PassID &id);
+
+  const std::map<PassID, Record> &get_records() const {
+    return records_;
+  }
+
+  void print(const std::string &title) const;
+
+ private:
+  bool track_ir_delta_;
+  std::map<PassID, Record> records_;
+};
+
 class AnalysisManager {
  public:
+  explicit AnalysisManager(PassInstrumentation *instrumentation = nullptr)
+      : instrumentation_(instrumentation) {
+  }
+
+  // Pass results are kept until explicitly overwritten, even if the IR is
+  // modified afterwards.
   template <typename PassT>
   typename PassT::Result *get_pass_result() {
     auto result = result_.find(PassT::id);
@@ -81,8 +159,70 @@ class AnalysisManager {
     result_[PassT::id] = std::make_unique<ResultModelT>(std::move(result));
   }
 
+  // Cached analyses describe the current IR. They are dropped by
+  // invalidate() unless preserved by the transform that modified the IR.
+  template <typename PassT>
+  typename PassT::Result *get_cached_analysis() {
+    auto result = cached_.find(PassT::id);
+    if (result == cached_.end()) {
+      return nullptr;
+    }
+    using ResultModelT = AnalysisResultModel<typename PassT::Result>;
+    return &(static_cast<ResultModelT *>(result->second.get())->result);
+  }
+
+  template <typename PassT>
+  void cache_analysis(typename PassT::Result &&result) {
+    using ResultModelT = AnalysisResultModel<typename PassT::Result>;
+    cached_[PassT::id] = std::make_unique<ResultModelT>(std::move(result));
+  }
+
+  template <typename PassT>
+  void invalidate() {
+    cached_.erase(PassT::id);
+    fixpoints_.erase(PassT::id);
+  }
+
+  // Must be called whenever the IR is modified outside of run_transform().
+  void invalidate(
+      const PreservedAnalyses &preserved = PreservedAnalyses::none());
+
+  // Whether running the transform |id| again is known to leave the IR
+  // unchanged, i.e. its last run did not modify the IR and nothing has
+  // modified the IR since.
+  bool is_at_fixpoint(const PassID &id) const {
+    return fixpoints_.count(id) != 0;
+  }
+
+  void mark_at_fixpoint(const PassID &id) {
+    fixpoints_.insert(id);
+  }
+
+  /**
+   * Runs a transform that returns whether it modified the IR.
+   *
+   * The run is skipped if the transform is known to be at a fixpoint. If the
+   * IR is modified, all cached analyses except |preserved| are invalidated.
+   *
+   * @param root The IR the transform works on, used for the IR delta.
+   * @param id An identifier of the transform and all its arguments.
+   * @return Whether the IR is modified.
+   */
+  bool run_transform(IRNode *root,
+                     const PassID &id,
+                     const std::function<bool()> &transform,
+                     const PreservedAnalyses &preserved =
+                         PreservedAnalyses::none());
+
+  PassInstrumentation *get_instrumentation() const {
+    return instrumentation_;
+  }
+
  private:
   std::unordered_map<PassID, std::unique_ptr<AnalysisResultConcept>> result_;
+  std::unordered_map<PassID, std::unique_ptr<AnalysisResultConcept>> cached_;
+  std::unordered_set<PassID> fixpoints_;
+  PassInstrumentation *instrumentation_;
 };
 
 }  // namespace lang
@@ -529,6 +529,30 @@ class GlobalLoadStmt : public Stmt {
   TI_DEFINE_ACCEPT_AND_CLONE;
 };
 
+/**
+ * A hint that the global address |ptr| will be loaded soon. Unlike a load, it
+ * never faults.
+ */
+class PrefetchStmt : public Stmt {
+ public:
+  Stmt *ptr;
+
+  explicit PrefetchStmt(Stmt *ptr) : ptr(ptr) {
+    TI_STMT_REG_FIELDS;
+  }
+
+  bool has_global_side_effect() const override {
+    return false;
+  }
+
+  bool dead_instruction_eliminable() const override {
+    return false;
+  }
+
+  TI_STMT_DEF_FIELDS(ptr);
+  TI_DEFINE_ACCEPT_AND_CLONE;
+};
+
 /**
  * A store to a global address, including SNodes, external arrays, TLS, BLS,
  * and global temporary variables.
@@ -910,7 +934,11 @@ class WhileStmt : public Stmt {
   TI_DEFINE_ACCEPT
 };
 
-// TODO: document for this
+/**
+ * Gathers elements of other statements. With a single element, it extracts a
+ * lane of a vector (or forwards a scalar). With more elements, it packs them
+ * into a vector of tensor type, which is only produced by slp_vectorize().
+ */
 class ElementShuffleStmt : public Stmt {
  public:
   LaneAttribute<VectorElement> elements;
@@ -919,11 +947,23 @@ class ElementShuffleStmt : public Stmt {
   explicit ElementShuffleStmt(const LaneAttribute<VectorElement> &elements,
                               bool pointer = false)
       : elements(elements), pointer(pointer) {
-    TI_ASSERT(elements.size() == 1);  // TODO: support vectorized cases
-    ret_type = elements[0].stmt->element_type();
+    TI_ASSERT(elements.size() == 1 || !pointer);
+    ret_type = infer_ret_type();
     TI_STMT_REG_FIELDS;
   }
 
+  DataType infer_ret_type() const {
+    DataType element_type = elements[0].stmt->ret_type;
+    if (auto tensor_type = element_type->cast<TensorType>()) {
+      element_type = tensor_type->get_element_type();
+    }
+    if (elements.size() == 1) {
+      return element_type;
+    }
+    return TypeFactory::create_tensor_type({(int)elements.size()},
+                                           element_type);
+  }
+
   bool has_global_side_effect() const override {
     return false;
   }
@@ -28,21 +28,29 @@ class Function;
 namespace irpass {
 
 void re_id(IRNode *root);
-void flag_access(IRNode *root);
+// Frees erased statements. The IR must not refer to any of them, which is
+// guaranteed whenever analysis::verify() passes.
+void clear_trash_bins(IRNode *root);
+// Returns whether the activation flag of any access is changed.
+bool flag_access(IRNode *root);
 bool die(IRNode *root);
 bool simplify(IRNode *root, const CompileConfig &config);
+// Reuses the CFG cached in |amgr| if there is one, and caches it again if it
+// is still valid afterwards. Preserves BuildCFGPass when run as a transform.
 bool cfg_optimization(
     IRNode *root,
     bool after_lower_access,
     const std::optional<ControlFlowGraph::LiveVarAnalysisConfig>
-        &lva_config_opt = std::nullopt);
+        &lva_config_opt = std::nullopt,
+    AnalysisManager *amgr = nullptr);
 bool alg_simp(IRNode *root, const CompileConfig &config);
 bool demote_operations(IRNode *root, const CompileConfig &config);
 bool binary_op_simplify(IRNode *root, const CompileConfig &config);
-bool whole_kernel_cse(IRNode *root);
+bool global_value_numbering(IRNode *root);
 bool extract_constant(IRNode *root, const CompileConfig &config);
 bool unreachable_code_elimination(IRNode *root);
 bool loop_invariant_code_motion(IRNode *root, const CompileConfig &config);
+bool worklist_simplify(IRNode *root, const CompileConfig &config);
 void full_simplify(IRNode *root,
                    const CompileConfig &config,
                    const FullSimplifyPass::Args &args);
@@ -54,7 +62,12 @@ bool inlining(IRNode *root,
               const CompileConfig &config,
               const InliningPass::Args &args);
 void bit_loop_vectorize(IRNode *root);
-void slp_vectorize(IRNode *root);
+bool slp_vectorize(IRNode *root, const CompileConfig &config);
+bool insert_prefetches(IRNode *root, const CompileConfig &config);
+bool share_stencil_bases(IRNode *root, const CompileConfig &config);
+bool privatize_scatter_adds(IRNode *root, const CompileConfig &config);
+bool narrow_indices(IRNode *root, const CompileConfig &config);
+bool fuse_range_fors(IRNode *root, const CompileConfig &config);
 void replace_all_usages_with(IRNode *root, Stmt *old_stmt, Stmt *new_stmt);
 bool check_out_of_bound(IRNode *root,
                         const CompileConfig &config,
@@ -85,9 +98,11 @@ void auto_diff(IRNode *root,
  * Determine all adaptive AD-stacks' size. This pass is idempotent, i.e.,
  * there are no side effects if called more than once or called when not needed.
  * @return Whether the IR is modified, i.e., whether there exists adaptive
- * AD-stacks before this pass.
+ * AD-stacks before this pass. The CFG cached in |amgr|, if any, is reused.
  */
-bool determine_ad_stack_size(IRNode *root, const CompileConfig &config);
+bool determine_ad_stack_size(IRNode *root,
+                             const CompileConfig &config,
+                             AnalysisManager *amgr = nullptr);
 bool constant_fold(IRNode *root,
                    const CompileConfig &config,
                    const ConstantFoldPass::Args &args);
@@ -124,6 +124,12 @@ llvm::Type *TaichiLLVMContext::get_data_type(DataType dt) {
     return llvm::Type::getInt64Ty(*ctx);
   } else if (dt->is_primitive(PrimitiveTypeID::f16)) {
     return llvm::Type::getHalfTy(*ctx);
+  } else if (auto tensor_type = dt->cast<TensorType>()) {
+    // Only vector values from slp_vectorize() are represented by LLVM values
+    // of tensor types.
+    return llvm::VectorType::get(get_data_type(tensor_type->get_element_type()),
+                                 tensor_type->get_num_elements(),
+                                 /*Scalable=*/false);
   } else {
     TI_INFO(data_type_name(dt));
     TI_NOT_IMPLEMENTED
@@ -96,7 +96,7 @@ LlvmProgramImpl::LlvmProgramImpl(CompileConfig &config_,
 
   if (arch_is_cpu(config->arch)) {
     config_.max_block_dim = 1024;
-    device_ = std::make_shared<cpu::CpuDevice>();
+    device_ = std::make_shared<cpu::CpuDevice>(thread_pool_.get());
   }
 
   if (config->kernel_profiler && runtime_mem_info_) {
@@ -479,6 +479,44 @@ void LlvmProgramImpl::check_runtime_error(uint64 *result_buffer) {
   }
 }
 
+std::vector<LlvmProgramImpl::RuntimeError>
+LlvmProgramImpl::collect_runtime_errors(uint64 *result_buffer,
+                                        int *num_errors) {
+  synchronize();
+  std::vector<RuntimeError> errors;
+  *num_errors = runtime_query<int32>("get_num_error_records", result_buffer);
+  if (*num_errors == 0) {
+    return errors;
+  }
+  for (int i = 0; i < std::min(*num_errors, taichi_max_num_error_records);
+       i++) {
+    RuntimeError error;
+    error.launch_id = runtime_query<uint64>("get_error_record_launch_id",
+                                            result_buffer, i);
+    std::string message_template;
+    for (int j = 0;; j++) {
+      auto c = runtime_query<char>("get_error_record_message", result_buffer,
+                                   i, j);
+      if (c == '\0') {
+        break;
+      }
+      message_template += c;
+    }
+    error.message =
+        format_error_message(message_template, [&](int argument_id) {
+          return runtime_query<uint64>("get_error_record_argument",
+                                       result_buffer, i, argument_id);
+        });
+    errors.push_back(std::move(error));
+  }
+  // Resets the records as well.
+  auto tlctx = llvm_context_device_ ? llvm_context_device_.get()
+                                    : llvm_context_host_.get();
+  tlctx->runtime_jit_module->call<void *>(
+      "runtime_retrieve_and_reset_error_code", llvm_runtime_);
+  return errors;
+}
+
 void LlvmProgramImpl::finalize() {
   if (runtime_mem_info_)
     runtime_mem_info_->set_profiler(nullptr);
@@ -98,6 +98,20 @@ class LlvmProgramImpl : public ProgramImpl {
 
   void check_runtime_error(uint64 *result_buffer);
 
+  struct RuntimeError {
+    // See RuntimeContext::launch_id.
+    uint64 launch_id;
+    std::string message;
+  };
+
+  /**
+   * Returns the assertion failures recorded since the last check, in no
+   * particular order, and resets them. Only the first few failures are
+   * recorded, while |num_errors| receives the total.
+   */
+  std::vector<RuntimeError> collect_runtime_errors(uint64 *result_buffer,
+                                                   int *num_errors);
+
   void finalize();
 
   DeviceAllocation allocate_memory_ndarray(std::size_t alloc_size,
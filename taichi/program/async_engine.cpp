@@ -1,7 +1,9 @@
 #include "taichi/program/async_engine.h"
 
 #include <memory>
+#include <numeric>
 
+#include "taichi/backends/cpu/cpu_device.h"
 #include "taichi/program/kernel.h"
 #include "taichi/system/timeline.h"
 #include "taichi/backends/cpu/codegen_cpu.h"
@@ -20,8 +22,8 @@ TLANG_NAMESPACE_BEGIN
 ParallelExecutor::ParallelExecutor(const std::string &name, int num_threads)
     : name_(name),
       num_threads_(num_threads),
-      status_(ExecutorStatus::uninitialized),
-      running_threads_(0) {
+      task_queue_(kQueueCapacity),
+      status_(ExecutorStatus::uninitialized) {
   {
     auto _ = std::lock_guard<std::mutex>(mut_);
 
@@ -50,22 +52,24 @@ ParallelExecutor::~ParallelExecutor() {
 }
 
 void ParallelExecutor::enqueue(const TaskType &func) {
-  {
+  num_unfinished_tasks_++;
+  while (!task_queue_.try_push(func)) {
+    // The queue is full. Let the workers catch up.
+    std::this_thread::yield();
+  }
+  num_queued_tasks_++;
+  // A worker increments |num_sleeping_workers| before checking
+  // |num_queued_tasks| under |mut|, so it either sees this task or gets
+  // notified.
+  if (num_sleeping_workers_ > 0) {
     std::lock_guard<std::mutex> _(mut_);
-    task_queue_.push_back(func);
+    worker_cv_.notify_one();
   }
-  worker_cv_.notify_all();
 }
 
 void ParallelExecutor::flush() {
   std::unique_lock<std::mutex> lock(mut_);
-  while (!flush_cv_cond()) {
-    flush_cv_.wait(lock);
-  }
-}
-
-bool ParallelExecutor::flush_cv_cond() {
-  return (task_queue_.empty() && running_threads_ == 0);
+  flush_cv_.wait(lock, [this] { return num_unfinished_tasks_ == 0; });
 }
 
 void ParallelExecutor::worker_loop() {
@@ -85,40 +89,33 @@ void ParallelExecutor::worker_loop() {
   }
 
   TI_DEBUG("Worker thread initialized and running.");
-  bool done = false;
-  while (!done) {
-    bool notify_flush_cv = false;
-    {
-      std::unique_lock<std::mutex> lock(mut_);
-      while (task_queue_.empty() && status_ == ExecutorStatus::initialized) {
-        worker_cv_.wait(lock);
-      }
-      // So long as |task_queue| is not empty, we keep running.
-      if (!task_queue_.empty()) {
-        auto task = task_queue_.front();
-        running_threads_++;
-        task_queue_.pop_front();
-        lock.unlock();
-
-        // Run the task
-        task();
-
-        lock.lock();
-        running_threads_--;
-      }
-      notify_flush_cv = flush_cv_cond();
-      if (status_ == ExecutorStatus::finalized && task_queue_.empty()) {
-        done = true;
+  TaskType task;
+  while (true) {
+    // So long as |task_queue| is not empty, we keep running.
+    if (task_queue_.try_pop(task)) {
+      num_queued_tasks_--;
+      task();
+      task = nullptr;
+      if (--num_unfinished_tasks_ == 0) {
+        std::lock_guard<std::mutex> _(mut_);
+        flush_cv_.notify_all();
       }
+      continue;
     }
-    if (notify_flush_cv) {
-      // It is fine to notify |flush_cv_| while nobody is waiting on it.
-      flush_cv_.notify_one();
+    std::unique_lock<std::mutex> lock(mut_);
+    if (status_ == ExecutorStatus::finalized) {
+      break;
     }
+    num_sleeping_workers_++;
+    worker_cv_.wait(lock, [this] {
+      return num_queued_tasks_ > 0 || status_ == ExecutorStatus::finalized;
+    });
+    num_sleeping_workers_--;
   }
 }
 
-void ExecutionQueue::enqueue(const TaskLaunchRecord &ker) {
+ExecutionQueue::AsyncCompiledFunc *ExecutionQueue::compile(
+    const TaskLaunchRecord &ker) {
   auto h = ker.ir_handle.hash();
   auto *stmt = ker.stmt();
   auto kernel = ker.kernel;
@@ -164,7 +161,12 @@ void ExecutionQueue::enqueue(const TaskLaunchRecord &ker) {
         });
     ir_bank_->insert_to_trash_bin(std::move(cloned_stmt));
   }
+  return async_func;
+}
 
+void ExecutionQueue::enqueue(const TaskLaunchRecord &ker) {
+  auto kernel_name = ker.kernel->name;
+  auto async_func = compile(ker);
   launch_worker.enqueue(
       [kernel_name, async_func, context = ker.context]() mutable {
         TI_TIMELINE(kernel_name);
@@ -173,6 +175,79 @@ void ExecutionQueue::enqueue(const TaskLaunchRecord &ker) {
       });
 }
 
+void ExecutionQueue::enqueue_concurrently(
+    const std::vector<TaskLaunchRecord> &tasks,
+    const std::vector<int> &levels) {
+  TI_ASSERT(tasks.size() == levels.size());
+  if (tasks.empty())
+    return;
+  struct Launch {
+    std::string kernel_name;
+    AsyncCompiledFunc *func;
+    RuntimeContext context;
+    bool begins_group;
+  };
+  std::vector<int> order(tasks.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return levels[a] < levels[b]; });
+  // Within a level, the small tasks share a group and every other task runs
+  // alone, so that it keeps the whole thread pool. The state flow graph keys
+  // global temporaries per kernel, while all kernels share the same buffer, so
+  // the tasks touching states outside of it must run alone as well.
+  std::vector<Launch> launches;
+  launches.reserve(tasks.size());
+  int num_groups = 0;
+  for (int begin = 0, end = 0; begin < (int)order.size(); begin = end) {
+    while (end < (int)order.size() &&
+           levels[order[end]] == levels[order[begin]]) {
+      end++;
+    }
+    std::vector<int> large;
+    bool has_small = false;
+    for (int k = begin; k < end; k++) {
+      auto &ker = tasks[order[k]];
+      if (irpass::analysis::is_small_offload(
+              ker.stmt(), cpu::CpuCommandList::kMaxConcurrentTaskCost) &&
+          irpass::analysis::can_run_concurrently(ker.stmt())) {
+        launches.push_back(
+            {ker.kernel->name, compile(ker), ker.context, !has_small});
+        num_groups += !has_small;
+        has_small = true;
+      } else {
+        large.push_back(order[k]);
+      }
+    }
+    for (auto i : large) {
+      auto &ker = tasks[i];
+      launches.push_back({ker.kernel->name, compile(ker), ker.context, true});
+      num_groups++;
+    }
+  }
+  stat.add("async_launch_groups", num_groups);
+  stat.add("async_launched_tasks", (double)launches.size());
+  TI_TRACE("Launching {} tasks in {} groups", launches.size(), num_groups);
+
+  auto stream = tasks[0]
+                    .kernel->program->get_compute_device()
+                    ->get_compute_stream();
+  launch_worker.enqueue([launches = std::move(launches), stream]() mutable {
+    auto cmdlist = stream->new_command_list();
+    auto cpu_cmdlist = static_cast<cpu::CpuCommandList *>(cmdlist.get());
+    for (auto &launch : launches) {
+      if (launch.begins_group) {
+        cmdlist->memory_barrier();
+      }
+      cpu_cmdlist->launch_task([launch = &launch]() {
+        TI_TIMELINE(launch->kernel_name);
+        auto func = launch->func->get();
+        func(launch->context);
+      });
+    }
+    stream->submit_synced(cmdlist.get());
+  });
+}
+
 void ExecutionQueue::synchronize() {
   TI_AUTO_PROF;
   launch_worker.flush();
@@ -293,10 +368,18 @@ void AsyncEngine::flush() {
   debug_sfg("final");
   {
     TI_TIMELINE("enqueue");
-    auto tasks = sfg->extract_to_execute();
-    TI_TRACE("Ended up with {} nodes", tasks.size());
-    for (auto &task : tasks) {
-      queue.enqueue(task);
+    if (config_->async_concurrent_launch && arch_is_cpu(config_->arch) &&
+        !config_->kernel_profiler) {
+      std::vector<int> levels;
+      auto tasks = sfg->extract_to_execute(&levels);
+      TI_TRACE("Ended up with {} nodes", tasks.size());
+      queue.enqueue_concurrently(tasks, levels);
+    } else {
+      auto tasks = sfg->extract_to_execute();
+      TI_TRACE("Ended up with {} nodes", tasks.size());
+      for (auto &task : tasks) {
+        queue.enqueue(task);
+      }
     }
   }
   flush_counter_++;
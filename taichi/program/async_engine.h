@@ -1,6 +1,5 @@
 #include <atomic>
 #include <condition_variable>
-#include <deque>
 #include <functional>
 #include <future>
 #include <mutex>
@@ -15,6 +14,7 @@
 #include "taichi/program/async_utils.h"
 #include "taichi/program/ir_bank.h"
 #include "taichi/program/state_flow_graph.h"
+#include "taichi/util/mpmc_queue.h"
 
 TLANG_NAMESPACE_BEGIN
 
@@ -44,31 +44,36 @@ class ParallelExecutor {
 
   void worker_loop();
 
-  // Must be called while holding |mut|.
-  bool flush_cv_cond();
+  // Enqueuing blocks while this many tasks are waiting to run.
+  static constexpr std::size_t kQueueCapacity = 1 << 12;
 
   std::string name_;
   int num_threads_;
   std::atomic<int> thread_counter_{0};
+
+  // Tasks waiting to run. Enqueuing and dequeuing do not take |mut|.
+  MPMCQueue<TaskType> task_queue_;
+  // Number of tasks in |task_queue|, counted after they are pushed.
+  std::atomic<int> num_queued_tasks_{0};
+  // Number of tasks enqueued but not finished yet.
+  std::atomic<int> num_unfinished_tasks_{0};
+  // Number of workers waiting on |worker_cv|.
+  std::atomic<int> num_sleeping_workers_{0};
+
+  // Only taken to block or wake up threads.
   std::mutex mut_;
 
   // All guarded by |mut|
   ExecutorStatus status_;
   std::vector<std::thread> threads_;
-  std::deque<TaskType> task_queue_;
-  int running_threads_;
 
   // Used to signal the workers that they can start polling from |task_queue|.
   std::condition_variable init_cv_;
-  // Used by |this| to instruct the worker thread that there is an event:
+  // Used by |this| to wake up sleeping workers upon an event:
   // * task being enqueued
   // * shutting down
   std::condition_variable worker_cv_;
   // Used by a worker thread to unblock the caller from waiting for a flush.
-  //
-  // TODO: Instead of having this as a member variable, we can enqueue a
-  // callback upon flush(). The flush() will then block waiting for that
-  // callback to be executed?
   std::condition_variable flush_cv_;
 };
 
@@ -89,6 +94,12 @@ class ExecutionQueue {
 
   void enqueue(const TaskLaunchRecord &ker);
 
+  // Launches |tasks| as one batch on CPU. Tasks of the same level, as computed
+  // by StateFlowGraph::extract_to_execute(), may run concurrently on the
+  // thread pool if they are small, and each level waits for the previous one.
+  void enqueue_concurrently(const std::vector<TaskLaunchRecord> &tasks,
+                            const std::vector<int> &levels);
+
   void compile_task() {
   }
 
@@ -123,6 +134,9 @@ class ExecutionQueue {
   };
   std::unordered_map<uint64, AsyncCompiledFunc> compiled_funcs_;
 
+  // Accounts for |ker| and starts compiling it unless it is cached.
+  AsyncCompiledFunc *compile(const TaskLaunchRecord &ker);
+
   IRBank *ir_bank_;  // not owned
   BackendExecCompilationFunc compile_to_backend_;
 };
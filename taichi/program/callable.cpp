@@ -26,6 +26,11 @@ Callable::CurrentCallableGuard::CurrentCallableGuard(Program *program,
     : program_(program) {
   old_callable_ = program->current_callable;
   program->current_callable = callable;
+  if (callable && program->config.ir_arena) {
+    if (!callable->ir_arena)
+      callable->ir_arena = IRArena::create();
+    arena_scope_.emplace(callable->ir_arena.get());
+  }
 }
 
 Callable::CurrentCallableGuard::~CurrentCallableGuard() {
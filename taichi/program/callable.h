@@ -1,6 +1,9 @@
 #pragma once
 
+#include <optional>
+
 #include "taichi/lang_util.h"
+#include "taichi/ir/ir_arena.h"
 
 namespace taichi {
 namespace lang {
@@ -14,6 +17,8 @@ class Callable {
   Program *program;
   std::unique_ptr<IRNode> ir;
   std::unique_ptr<FrontendContext> context;
+  // Backs the IR nodes created while this callable is current. See IRArena.
+  IRArena::Ref ir_arena;
 
   struct Arg {
     DataType dt;
@@ -61,6 +66,7 @@ class Callable {
   class CurrentCallableGuard {
     Callable *old_callable_;
     Program *program_;
+    std::optional<IRArena::Scope> arena_scope_;
 
    public:
     CurrentCallableGuard(Program *program, Callable *callable);
@@ -19,20 +19,35 @@ CompileConfig::CompileConfig() {
   demote_dense_struct_fors = true;
   advanced_optimization = true;
   constant_folding = true;
+  worklist_simplify = true;
+  check_worklist_simplify = false;
+  slp_vectorize = false;
+  vectorize_range_for = false;
+  vector_math = false;
+  fast_vector_math = false;
+  software_prefetch = false;
+  prefetch_distance = 0;
   max_vector_width = 8;
   debug = false;
   cfg_optimization = true;
   check_out_of_bound = false;
+  lazy_runtime_error_check = false;
   lazy_compilation = true;
   serial_schedule = false;
   simplify_before_lower_access = true;
   lower_access = true;
   simplify_after_lower_access = true;
   move_loop_invariant_outside_if = false;
+  promote_loop_invariant_global_accesses = true;
+  strength_reduce_addresses = true;
+  privatize_scatter_adds = true;
+  fuse_range_fors = true;
+  reuse_element_lists = true;
   default_fp = PrimitiveType::f32;
   default_ip = PrimitiveType::i32;
   verbose_kernel_launches = false;
   kernel_profiler = false;
+  cpu_isa = "native";
   default_cpu_block_dim = 32;
   default_gpu_block_dim = 128;
   gpu_max_reg = 0;  // 0 means using the default value from the CUDA driver.
@@ -45,10 +60,12 @@ CompileConfig::CompileConfig() {
   make_block_local = true;
   detect_read_only = true;
   ndarray_use_cached_allocator = true;
+  ir_arena = true;
 
   saturating_grid_dim = 0;
   max_block_dim = 0;
   cpu_max_num_threads = std::thread::hardware_concurrency();
+  cpu_concurrent_tasks = true;
   random_seed = 0;
 
   // LLVM backend options:
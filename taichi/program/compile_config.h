@@ -10,6 +10,10 @@ struct CompileConfig {
   bool debug;
   bool cfg_optimization;
   bool check_out_of_bound;
+  // In debug mode on the LLVM backends, check for runtime errors at sync
+  // points instead of after each launch. Errors are reported with the launch
+  // that raised them.
+  bool lazy_runtime_error_check;
   int simd_width;
   bool lazy_compilation;
   int opt_level;
@@ -21,14 +25,60 @@ struct CompileConfig {
   bool print_accessor_ir;
   bool print_evaluator_ir;
   bool print_benchmark_stat;
+  // Print the time and the IR delta of each pass when compiling a kernel.
+  bool print_pass_stats{false};
   bool serial_schedule;
   bool simplify_before_lower_access;
   bool lower_access;
   bool simplify_after_lower_access;
   bool move_loop_invariant_outside_if;
+  // Replace global loads, stores and atomic adds to a loop-invariant address
+  // inside serial loops with accesses to a local variable.
+  bool promote_loop_invariant_global_accesses;
+  // Assume in-bound field indices outside debug mode to keep SNode addresses
+  // affine, and address neighboring cells of dense SNodes by constant
+  // offsets from a shared base pointer.
+  bool strength_reduce_addresses;
+  // Replace atomic adds to small dense fields in parallel range-fors on CPU
+  // with adds to per-thread copies, which are summed up after the loop.
+  bool privatize_scatter_adds;
+  // Outside async mode, fuse adjacent range-for tasks over the same range
+  // whose iterations only depend on the same iteration of the previous task.
+  bool fuse_range_fors;
+  // Outside async mode, keep the element list of an SNode across struct-for
+  // launches while no SNode it is generated from has been (de)activated.
+  bool reuse_element_lists;
   bool demote_dense_struct_fors;
   bool advanced_optimization;
   bool constant_folding;
+  // Propagate the rewrites of each pass in full_simplify() with the
+  // worklist-driven simplifier, instead of rescanning the IR with simplify()
+  // in further rounds.
+  bool worklist_simplify;
+  // Also simplify a copy of the IR with the fixpoint driver, and warn if the
+  // results differ.
+  bool check_worklist_simplify;
+  // Pack isomorphic operations on adjacent components of vector and matrix
+  // fields into vector operations of at most |max_vector_width| lanes. Only
+  // supported on CPU.
+  bool slp_vectorize;
+  // Vectorize the bodies of offloaded range-for loops on CPU over
+  // |simd_width| consecutive iterations, assuming that iterations only
+  // communicate through atomics.
+  bool vectorize_range_for;
+  // Let the loop vectorizer replace exp, log, sin, cos, and f32 tanh and pow
+  // with polynomial approximations on vectors (within 2.5 ULP) on CPU.
+  bool vector_math;
+  // Use lower-degree approximations of exp and log in vector math (within
+  // 6 ULP).
+  bool fast_vector_math;
+  // Prefetch the targets of indirect accesses like x[idx[i]] for a later
+  // iteration, and the data blocks of struct-fors over pointer and dynamic
+  // SNodes, on CPU.
+  bool software_prefetch;
+  // The number of iterations ahead to prefetch. 0 means choosing it from the
+  // size of the loop body.
+  int prefetch_distance;
   bool use_llvm;
   bool verbose_kernel_launches;
   bool kernel_profiler;
@@ -42,9 +92,15 @@ struct CompileConfig {
   bool make_block_local;
   bool detect_read_only;
   bool ndarray_use_cached_allocator;
+  // Allocate the CHI IR of each kernel from a per-kernel arena.
+  bool ir_arena;
   DataType default_fp;
   DataType default_ip;
   std::string extra_flags;
+  // "native" to generate CPU code for the host, or comma-separated x86-64
+  // microarchitecture levels (x86-64, x86-64-v2, x86-64-v3, x86-64-v4), of
+  // which the highest that the host CPU supports is used.
+  std::string cpu_isa;
   int default_cpu_block_dim;
   int default_gpu_block_dim;
   int gpu_max_reg;
@@ -56,6 +112,9 @@ struct CompileConfig {
   int saturating_grid_dim;
   int max_block_dim;
   int cpu_max_num_threads;
+  // Run small offloaded tasks of a kernel that access disjoint fields
+  // concurrently on the CPU thread pool.
+  bool cpu_concurrent_tasks;
   int random_seed;
 
   // LLVM backend options:
@@ -89,6 +148,9 @@ struct CompileConfig {
   int async_flush_every{50};
   // Setting 0 effectively means unlimited
   int async_max_fuse_per_task{1};
+  // On CPU, launch flushed tasks that have no path between them in the state
+  // flow graph concurrently
+  bool async_concurrent_launch{true};
 
   bool quant_opt_store_fusion{true};
   bool quant_opt_atomic_demotion{true};
@@ -11,8 +11,8 @@ namespace lang {
 struct LLVMRuntime;
 
 // "RuntimeContext" holds necessary data for kernel body execution, such as a
-// pointer to the LLVMRuntime struct, kernel arguments, and the thread id (if on
-// CPU).
+// pointer to the LLVMRuntime struct and kernel arguments. It is shared by all
+// the CPU threads running the kernel.
 struct RuntimeContext {
   LLVMRuntime *runtime;
   // args can contain:
@@ -21,9 +21,12 @@ struct RuntimeContext {
   // - DeviceAllocation*: for taichi ndaray
   uint64 args[taichi_max_num_args_total];
   int32 extra_args[taichi_max_num_args_extra][taichi_max_num_indices];
-  int32 cpu_thread_id;
   // |is_device_allocation| is true iff args[i] is a DeviceAllocation*.
   bool is_device_allocation[taichi_max_num_args_total]{false};
+  // Identifies the launch in the runtime errors it raises. Zero if unknown.
+  uint64 launch_id{0};
+  // Where the return values go, if not to the result buffer of the runtime.
+  uint64 *result_buffer{nullptr};
 
   static constexpr size_t extra_args_size = sizeof(extra_args);
 
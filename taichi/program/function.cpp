@@ -11,13 +11,11 @@ Function::Function(Program *program, const FunctionKey &func_key)
 }
 
 void Function::set_function_body(const std::function<void()> &func) {
+  // Note: this is not a mutex
+  CurrentCallableGuard _(program, this);
   context = std::make_unique<FrontendContext>();
   ir = context->get_root();
-  {
-    // Note: this is not a mutex
-    CurrentCallableGuard _(program, this);
-    func();
-  }
+  func();
   irpass::compile_inline_function(ir.get(), program->config, this,
                                   /*grad=*/false,
                                   /*verbose=*/program->config.print_ir,
@@ -25,6 +23,7 @@ void Function::set_function_body(const std::function<void()> &func) {
 }
 
 void Function::set_function_body(std::unique_ptr<IRNode> func_body) {
+  CurrentCallableGuard _(program, this);
   ir = std::move(func_body);
   irpass::compile_inline_function(ir.get(), program->config, this,
                                   /*grad=*/false,
@@ -1,5 +1,7 @@
 #include "taichi/program/kernel.h"
 
+#include <cstring>
+
 #include "taichi/backends/cuda/cuda_driver.h"
 #include "taichi/codegen/codegen.h"
 #include "taichi/common/task.h"
@@ -7,6 +9,7 @@
 #include "taichi/ir/transforms.h"
 #include "taichi/program/async_engine.h"
 #include "taichi/program/extension.h"
+#include "taichi/program/kernel_future.h"
 #include "taichi/program/program.h"
 #include "taichi/util/action_recorder.h"
 #include "taichi/util/statistics.h"
@@ -105,34 +108,125 @@ void Kernel::operator()(LaunchContextBuilder &ctx_builder) {
     if (!compiled_) {
       compile();
     }
+    if (skip_memoized_launch(ctx_builder.get_context()))
+      return;
 
     for (auto &offloaded : ir->as<Block>()->statements) {
       account_for_offloaded(offloaded->as<OffloadedStmt>());
     }
 
-    compiled_(ctx_builder.get_context());
+    auto &ctx = ctx_builder.get_context();
+    ctx.launch_id = program->register_launch(this);
+    compiled_(ctx);
 
     program->sync = (program->sync && arch_is_cpu(arch));
     // Note that Kernel::arch may be different from program.config.arch
-    if (program->config.debug && (arch_is_cpu(program->config.arch) ||
-                                  program->config.arch == Arch::cuda)) {
+    if (program->checks_runtime_error_per_launch() &&
+        (arch_is_cpu(program->config.arch) ||
+         program->config.arch == Arch::cuda)) {
       program->check_runtime_error();
     }
   } else {
+    if (!lowered()) {
+      lower(/*to_executable=*/false);
+    }
+    if (skip_memoized_launch(ctx_builder.get_context()))
+      return;
     program->sync = false;
-    program->async_engine->launch(this, ctx_builder.get_context());
+    auto &ctx = ctx_builder.get_context();
+    ctx.launch_id = program->register_launch(this);
+    program->async_engine->launch(this, ctx);
     // Note that Kernel::arch may be different from program.config.arch
-    if (program->config.debug && arch_is_cpu(arch) &&
+    if (program->checks_runtime_error_per_launch() && arch_is_cpu(arch) &&
         arch_is_cpu(program->config.arch)) {
       program->check_runtime_error();
     }
   }
 }
 
+const FunctionType &Kernel::get_compiled_function() {
+  if (!compiled_) {
+    compile();
+  }
+  return compiled_;
+}
+
 Kernel::LaunchContextBuilder Kernel::make_launch_context() {
   return LaunchContextBuilder(this);
 }
 
+void Kernel::pack_args() {
+  if (args_packed_)
+    return;
+  std::size_t offset = 0;
+  for (int i = 0; i < (int)args.size(); i++) {
+    if (args[i].is_array)
+      continue;
+    auto dt = args[i].dt;
+    // Python passes f16 args as f32.
+    int size = dt->is_primitive(PrimitiveTypeID::f16) ? sizeof(float32)
+                                                       : data_type_size(dt);
+    TI_ASSERT(size > 0 && size <= (int)sizeof(uint64));
+    offset = (offset + size - 1) / size * size;
+    packed_args_.push_back(PackedArg{i, (int)offset, size});
+    offset += size;
+  }
+  packed_args_size_ = offset;
+  args_packed_ = true;
+}
+
+std::size_t Kernel::get_packed_args_size() {
+  pack_args();
+  return packed_args_size_;
+}
+
+int Kernel::get_packed_arg_offset(int arg_id) {
+  TI_ASSERT(0 <= arg_id && arg_id < (int)args.size());
+  pack_args();
+  for (const auto &arg : packed_args_) {
+    if (arg.arg_id == arg_id)
+      return arg.offset;
+  }
+  return -1;
+}
+
+void Kernel::launch_prepared(RuntimeContext &ctx, const void *packed_args) {
+  TI_ERROR_IF(program->config.async_mode,
+              "Prepared launches are not supported in async mode");
+  if (!compiled_) {
+    compile();
+  }
+  pack_args();
+  auto bytes = (const char *)packed_args;
+  for (const auto &arg : packed_args_) {
+    // Same as RuntimeContext::set_arg() on little-endian targets.
+    uint64 bits = 0;
+    std::memcpy(&bits, bytes + arg.offset, arg.size);
+    ctx.args[arg.arg_id] = bits;
+    ctx.is_device_allocation[arg.arg_id] = false;
+  }
+  if (skip_memoized_launch(ctx))
+    return;
+  ctx.launch_id = program->register_launch(this);
+  compiled_(LaunchContextBuilder(this, &ctx).get_context());
+  program->sync = (program->sync && arch_is_cpu(arch));
+  if (program->checks_runtime_error_per_launch() &&
+      (arch_is_cpu(program->config.arch) ||
+       program->config.arch == Arch::cuda)) {
+    program->check_runtime_error();
+  }
+}
+
+bool Kernel::skip_memoized_launch(const RuntimeContext &ctx) {
+  if (!program->kernel_memoizer.skip_launch(this, ctx))
+    return false;
+  stat.add("memoized_launches_skipped", 1.0);
+  if (program->profiler) {
+    program->profiler->count_skipped_launch(name);
+  }
+  return true;
+}
+
 Kernel::LaunchContextBuilder::LaunchContextBuilder(Kernel *kernel,
                                                    RuntimeContext *ctx)
     : kernel_(kernel), owned_ctx_(nullptr), ctx_(ctx) {
@@ -288,58 +382,86 @@ RuntimeContext &Kernel::LaunchContextBuilder::get_context() {
   return *ctx_;
 }
 
+std::shared_ptr<KernelFuture> Kernel::launch_with_future(
+    LaunchContextBuilder &ctx_builder) {
+  TI_ERROR_IF(rets.empty(), "Kernel {} does not return a value", get_name());
+  const auto prog_arch = program->config.arch;
+  TI_ERROR_IF(!arch_is_cpu(prog_arch) && prog_arch != Arch::cuda,
+              "Kernel futures are not supported on {}", arch_name(prog_arch));
+  if (!program->kernel_result_slots) {
+    program->kernel_result_slots =
+        std::make_shared<KernelResultSlots>(prog_arch);
+  }
+  auto future =
+      std::make_shared<KernelFuture>(this, program->kernel_result_slots);
+  auto &ctx = ctx_builder.get_context();
+  ctx.result_buffer = future->get_result_buffer();
+  (*this)(ctx_builder);
+  ctx.result_buffer = nullptr;
+  future->record_launch();
+  return future;
+}
+
 float64 Kernel::get_ret_float(int i) {
+  return ret_bits_to_float(i, program->fetch_result_uint64(i));
+}
+
+float64 Kernel::ret_bits_to_float(int i, uint64 bits) const {
   auto dt = rets[i].dt->get_compute_type();
   if (dt->is_primitive(PrimitiveTypeID::f32)) {
-    return (float64)program->fetch_result<float32>(i);
+    return (float64)taichi_union_cast_with_different_sizes<float32>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::f64)) {
-    return (float64)program->fetch_result<float64>(i);
+    return (float64)taichi_union_cast_with_different_sizes<float64>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i32)) {
-    return (float64)program->fetch_result<int32>(i);
+    return (float64)taichi_union_cast_with_different_sizes<int32>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i64)) {
-    return (float64)program->fetch_result<int64>(i);
+    return (float64)taichi_union_cast_with_different_sizes<int64>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i8)) {
-    return (float64)program->fetch_result<int8>(i);
+    return (float64)taichi_union_cast_with_different_sizes<int8>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i16)) {
-    return (float64)program->fetch_result<int16>(i);
+    return (float64)taichi_union_cast_with_different_sizes<int16>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u8)) {
-    return (float64)program->fetch_result<uint8>(i);
+    return (float64)taichi_union_cast_with_different_sizes<uint8>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u16)) {
-    return (float64)program->fetch_result<uint16>(i);
+    return (float64)taichi_union_cast_with_different_sizes<uint16>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u32)) {
-    return (float64)program->fetch_result<uint32>(i);
+    return (float64)taichi_union_cast_with_different_sizes<uint32>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u64)) {
-    return (float64)program->fetch_result<uint64>(i);
+    return (float64)taichi_union_cast_with_different_sizes<uint64>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::f16)) {
     // use f32 to interact with python
-    return (float64)program->fetch_result<float32>(i);
+    return (float64)taichi_union_cast_with_different_sizes<float32>(bits);
   } else {
     TI_NOT_IMPLEMENTED
   }
 }
 
 int64 Kernel::get_ret_int(int i) {
+  return ret_bits_to_int(i, program->fetch_result_uint64(i));
+}
+
+int64 Kernel::ret_bits_to_int(int i, uint64 bits) const {
   auto dt = rets[i].dt->get_compute_type();
   if (dt->is_primitive(PrimitiveTypeID::i32)) {
-    return (int64)program->fetch_result<int32>(i);
+    return (int64)taichi_union_cast_with_different_sizes<int32>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i64)) {
-    return (int64)program->fetch_result<int64>(i);
+    return (int64)taichi_union_cast_with_different_sizes<int64>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i8)) {
-    return (int64)program->fetch_result<int8>(i);
+    return (int64)taichi_union_cast_with_different_sizes<int8>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::i16)) {
-    return (int64)program->fetch_result<int16>(i);
+    return (int64)taichi_union_cast_with_different_sizes<int16>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u8)) {
-    return (int64)program->fetch_result<uint8>(i);
+    return (int64)taichi_union_cast_with_different_sizes<uint8>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u16)) {
-    return (int64)program->fetch_result<uint16>(i);
+    return (int64)taichi_union_cast_with_different_sizes<uint16>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u32)) {
-    return (int64)program->fetch_result<uint32>(i);
+    return (int64)taichi_union_cast_with_different_sizes<uint32>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::u64)) {
-    return (int64)program->fetch_result<uint64>(i);
+    return (int64)taichi_union_cast_with_different_sizes<uint64>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::f32)) {
-    return (int64)program->fetch_result<float32>(i);
+    return (int64)taichi_union_cast_with_different_sizes<float32>(bits);
   } else if (dt->is_primitive(PrimitiveTypeID::f64)) {
-    return (int64)program->fetch_result<float64>(i);
+    return (int64)taichi_union_cast_with_different_sizes<float64>(bits);
   } else {
     TI_NOT_IMPLEMENTED
   }
@@ -10,6 +10,7 @@
 TLANG_NAMESPACE_BEGIN
 
 class Program;
+class KernelFuture;
 
 class Kernel : public Callable {
  public:
@@ -20,6 +21,9 @@ class Kernel : public Callable {
   bool is_accessor{false};
   bool is_evaluator{false};
   bool grad{false};
+  // Launches are skipped while the args and the memory the kernel reads stay
+  // unchanged. See KernelMemoizer.
+  bool memoized{false};
 
   class LaunchContextBuilder {
    public:
@@ -96,12 +100,65 @@ class Kernel : public Callable {
 
   void operator()(LaunchContextBuilder &ctx_builder);
 
+  /**
+   * Returns the closure that launches the compiled kernel, compiling it first
+   * if necessary. Unlike operator(), invoking the closure neither accounts for
+   * the launched tasks nor checks for runtime errors.
+   */
+  const FunctionType &get_compiled_function();
+
   LaunchContextBuilder make_launch_context();
 
+  /**
+   * Returns the size of the packed argument buffer of launch_prepared().
+   *
+   * Scalar args are packed in the order of declaration with their natural
+   * size and alignment, i.e., the layout of a C struct without trailing
+   * padding. f16 args take 4 bytes and are passed as f32. Array args take no
+   * space, as they stay in the prepared RuntimeContext.
+   */
+  std::size_t get_packed_args_size();
+
+  /**
+   * Returns the offset of the |arg_id|-th arg in the packed argument buffer,
+   * or -1 if it is an array.
+   */
+  int get_packed_arg_offset(int arg_id);
+
+  /**
+   * Launches the kernel with a preallocated |ctx|, after copying the scalar
+   * args in |packed_args| into it. Array args must have been set in |ctx|,
+   * e.g., through a LaunchContextBuilder, and are kept across launches.
+   *
+   * This does not allocate, and skips the task accounting of operator().
+   */
+  void launch_prepared(RuntimeContext &ctx, const void *packed_args);
+
+  /**
+   * Returns true if the launch with |ctx| can be skipped as the kernel is
+   * memoized. Every launch path must call this, as the launches of kernels
+   * that are not memoized may invalidate the memoized ones.
+   */
+  bool skip_memoized_launch(const RuntimeContext &ctx);
+
+  /**
+   * Launches the kernel, whose return value is written to storage of its own
+   * instead of the result buffer shared by all launches. Reading the value
+   * from the returned future only waits for this launch, so other launches
+   * can be issued in the meantime. Only the LLVM backends are supported.
+   */
+  std::shared_ptr<KernelFuture> launch_with_future(
+      LaunchContextBuilder &ctx_builder);
+
   float64 get_ret_float(int i);
 
   int64 get_ret_int(int i);
 
+  // Converts the raw |bits| of the |i|-th return value.
+  float64 ret_bits_to_float(int i, uint64 bits) const;
+
+  int64 ret_bits_to_int(int i, uint64 bits) const;
+
   void set_arch(Arch arch);
 
   void account_for_offloaded(OffloadedStmt *stmt);
@@ -129,6 +186,17 @@ class Kernel : public Callable {
   // lower inital AST all the way down to a bunch of
   // OffloadedStmt for async execution
   bool lowered_{false};
+
+  struct PackedArg {
+    int arg_id;
+    int offset;
+    int size;
+  };
+  void pack_args();
+  // The scalar args in a packed argument buffer. Empty until pack_args().
+  std::vector<PackedArg> packed_args_;
+  std::size_t packed_args_size_{0};
+  bool args_packed_{false};
 };
 
 TLANG_NAMESPACE_END
@@ -0,0 +1,196 @@
+#include "taichi/program/kernel_future.h"
+
+#include "taichi/program/kernel.h"
+#include "taichi/program/program.h"
+
+#if defined(TI_WITH_CUDA)
+#include "taichi/backends/cuda/cuda_context.h"
+#include "taichi/backends/cuda/cuda_driver.h"
+#endif
+
+TLANG_NAMESPACE_BEGIN
+
+KernelResultSlots::KernelResultSlots(Arch arch) : arch_(arch) {
+  if (arch_ == Arch::cuda) {
+#if defined(TI_WITH_CUDA)
+    auto _ = CUDAContext::get_instance().get_guard();
+    CUDADriver::get_instance().malloc((void **)&slots_,
+                                      kNumSlots * sizeof(uint64));
+    CUDADriver::get_instance().stream_create(&copy_stream_,
+                                             CU_STREAM_NON_BLOCKING);
+#else
+    TI_NOT_IMPLEMENTED
+#endif
+  } else {
+    TI_ASSERT(arch_is_cpu(arch_));
+    slots_ = new uint64[kNumSlots];
+  }
+  for (int i = kNumSlots - 1; i >= 0; i--) {
+    free_slots_.push_back(i);
+  }
+}
+
+KernelResultSlots::~KernelResultSlots() {
+  if (arch_ == Arch::cuda) {
+#if defined(TI_WITH_CUDA)
+    CUDADriver::get_instance().stream_destroy(copy_stream_);
+    CUDADriver::get_instance().mem_free(slots_);
+#endif
+  } else {
+    delete[] slots_;
+  }
+}
+
+int KernelResultSlots::acquire() {
+  std::lock_guard<std::mutex> _(mut_);
+  TI_ERROR_IF(free_slots_.empty(),
+              "Too many pending kernel futures (more than {})", kNumSlots);
+  auto slot = free_slots_.back();
+  free_slots_.pop_back();
+  return slot;
+}
+
+void KernelResultSlots::release(int slot) {
+  std::lock_guard<std::mutex> _(mut_);
+  free_slots_.push_back(slot);
+}
+
+void KernelResultSlots::release_after_sync(int slot) {
+  std::lock_guard<std::mutex> _(mut_);
+  pending_slots_.push_back(slot);
+}
+
+void KernelResultSlots::on_synchronized() {
+  std::lock_guard<std::mutex> _(mut_);
+  free_slots_.insert(free_slots_.end(), pending_slots_.begin(),
+                     pending_slots_.end());
+  pending_slots_.clear();
+  generation_++;
+}
+
+uint64 *KernelResultSlots::get_slot_ptr(int slot) {
+  return slots_ + slot;
+}
+
+uint64 KernelResultSlots::fetch(int slot) {
+  uint64 ret;
+  if (arch_ == Arch::cuda) {
+#if defined(TI_WITH_CUDA)
+    auto _ = CUDAContext::get_instance().get_guard();
+    // A blocking copy would wait for all the kernels launched so far.
+    CUDADriver::get_instance().memcpy_device_to_host_async(
+        &ret, slots_ + slot, sizeof(uint64), copy_stream_);
+    CUDADriver::get_instance().stream_synchronize(copy_stream_);
+#else
+    TI_NOT_IMPLEMENTED
+#endif
+  } else {
+    ret = slots_[slot];
+  }
+  return ret;
+}
+
+KernelFuture::KernelFuture(Kernel *kernel,
+                           std::shared_ptr<KernelResultSlots> slots)
+    : kernel_(kernel),
+      slots_(std::move(slots)),
+      async_mode_(kernel->program->config.async_mode) {
+  slot_ = slots_->acquire();
+}
+
+KernelFuture::~KernelFuture() {
+#if defined(TI_WITH_CUDA)
+  if (event_) {
+    CUDADriver::get_instance().event_destroy(event_);
+  }
+#endif
+  if (!resolved_ && async_mode_ && !synchronized_since_launch()) {
+    // The engine may not have issued the tasks of the launch yet, and may
+    // reorder them with the tasks of later launches, so the slot can only be
+    // reused once the engine has synchronized past this launch.
+    slots_->release_after_sync(slot_);
+  } else {
+    // Outside async mode, launches run in order (on the default stream on
+    // CUDA), so a launch that is still writing to the slot completes before
+    // any later launch that reuses it.
+    slots_->release(slot_);
+  }
+}
+
+uint64 *KernelFuture::get_result_buffer() {
+  return slots_->get_slot_ptr(slot_);
+}
+
+void KernelFuture::record_launch() {
+  launch_generation_ = slots_->generation();
+  if (kernel_->program->config.async_mode ||
+      kernel_->program->config.arch != Arch::cuda) {
+    // CPU launches complete before returning outside async mode.
+    return;
+  }
+#if defined(TI_WITH_CUDA)
+  auto _ = CUDAContext::get_instance().get_guard();
+  CUDADriver::get_instance().event_create(&event_, CU_EVENT_DISABLE_TIMING);
+  CUDADriver::get_instance().event_record(event_, nullptr);
+#else
+  TI_NOT_IMPLEMENTED
+#endif
+}
+
+bool KernelFuture::done() {
+  if (resolved_) {
+    return true;
+  }
+  if (kernel_->program->config.async_mode) {
+    // The tasks of the launch may not even have been issued yet, unless the
+    // program has synchronized since.
+    return synchronized_since_launch();
+  }
+#if defined(TI_WITH_CUDA)
+  if (event_) {
+    auto _ = CUDAContext::get_instance().get_guard();
+    auto status = CUDADriver::get_instance().event_query.call(event_);
+    TI_ERROR_IF(status != CUDA_SUCCESS && status != CUDA_ERROR_NOT_READY,
+                CUDADriver::get_instance().event_query.get_error_message(
+                    status));
+    return status == CUDA_SUCCESS;
+  }
+#endif
+  return true;
+}
+
+void KernelFuture::wait() {
+  if (resolved_) {
+    return;
+  }
+  if (kernel_->program->config.async_mode && !synchronized_since_launch()) {
+    kernel_->program->synchronize();
+  }
+#if defined(TI_WITH_CUDA)
+  if (event_) {
+    auto _ = CUDAContext::get_instance().get_guard();
+    CUDADriver::get_instance().event_synchronize(event_);
+  }
+#endif
+  ret_bits_ = slots_->fetch(slot_);
+  resolved_ = true;
+}
+
+bool KernelFuture::synchronized_since_launch() const {
+  return slots_->generation() > launch_generation_;
+}
+
+uint64 KernelFuture::get_ret_bits() {
+  wait();
+  return ret_bits_;
+}
+
+float64 KernelFuture::get_ret_float() {
+  return kernel_->ret_bits_to_float(0, get_ret_bits());
+}
+
+int64 KernelFuture::get_ret_int() {
+  return kernel_->ret_bits_to_int(0, get_ret_bits());
+}
+
+TLANG_NAMESPACE_END
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "taichi/lang_util.h"
+#include "taichi/program/arch.h"
+
+TLANG_NAMESPACE_BEGIN
+
+class Kernel;
+
+/**
+ * Device memory for the return values of the launches with futures, so that
+ * they do not overwrite each other in the result buffer.
+ */
+class KernelResultSlots {
+ public:
+  explicit KernelResultSlots(Arch arch);
+
+  KernelResultSlots(const KernelResultSlots &) = delete;
+  KernelResultSlots &operator=(const KernelResultSlots &) = delete;
+
+  ~KernelResultSlots();
+
+  // Returns the index of a free slot.
+  int acquire();
+
+  void release(int slot);
+
+  // Releases |slot| at the next Program::synchronize(), after which the launch
+  // writing it has completed.
+  void release_after_sync(int slot);
+
+  // Called by Program::synchronize().
+  void on_synchronized();
+
+  // The number of Program::synchronize() calls so far. A launch issued before
+  // the generation was bumped has completed.
+  uint64 generation() const {
+    return generation_;
+  }
+
+  uint64 *get_slot_ptr(int slot);
+
+  // Copies the value in |slot| to the host, without waiting for the launches
+  // that are still running. The launch writing |slot| must have completed.
+  uint64 fetch(int slot);
+
+ private:
+  static constexpr int kNumSlots = 1024;
+
+  Arch arch_;
+  uint64 *slots_{nullptr};
+  // A stream that does not wait for the kernels on the default stream.
+  void *copy_stream_{nullptr};
+  std::vector<int> free_slots_;
+  std::vector<int> pending_slots_;
+  std::atomic<uint64> generation_{0};
+  std::mutex mut_;
+};
+
+/**
+ * The return value of a kernel launch, which resolves when the launch
+ * completes. See Kernel::launch_with_future().
+ */
+class KernelFuture {
+ public:
+  KernelFuture(Kernel *kernel, std::shared_ptr<KernelResultSlots> slots);
+
+  KernelFuture(const KernelFuture &) = delete;
+  KernelFuture &operator=(const KernelFuture &) = delete;
+
+  ~KernelFuture();
+
+  // To be set as RuntimeContext::result_buffer of the launch.
+  uint64 *get_result_buffer();
+
+  // Called right after the launch has been issued.
+  void record_launch();
+
+  // Returns true if the launch has completed. Never blocks.
+  bool done();
+
+  // Blocks until the launch has completed.
+  void wait();
+
+  float64 get_ret_float();
+
+  int64 get_ret_int();
+
+ private:
+  uint64 get_ret_bits();
+
+  Kernel *kernel_;
+  std::shared_ptr<KernelResultSlots> slots_;
+  int slot_;
+  // Copied from the config, since the program may be gone by the time the
+  // future is destroyed.
+  bool async_mode_;
+  // The CUDA event recorded after the launch.
+  void *event_{nullptr};
+  // KernelResultSlots::generation() when the launch was issued in async mode.
+  uint64 launch_generation_{0};
+  bool resolved_{false};
+  uint64 ret_bits_{0};
+
+  // Returns true if the program has synchronized since the launch.
+  bool synchronized_since_launch() const;
+};
+
+TLANG_NAMESPACE_END
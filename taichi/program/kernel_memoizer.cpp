@@ -0,0 +1,233 @@
+#include "taichi/program/kernel_memoizer.h"
+
+#include <functional>
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/program/kernel.h"
+#include "taichi/program/program.h"
+
+#ifdef TI_WITH_LLVM
+#include "taichi/llvm/llvm_program.h"
+#endif
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+int snode_tree_id(SNode *snode) {
+  while (snode->parent)
+    snode = snode->parent;
+  return snode->get_snode_tree_id();
+}
+
+// Identifies the memory of the |arg_id|-th arg of |ctx|, whether it is passed
+// as the DeviceAllocation of an ndarray or as a raw pointer.
+uint64 array_key(Kernel *kernel, const RuntimeContext &ctx, int arg_id) {
+  auto bits = ctx.args[arg_id];
+#ifdef TI_WITH_LLVM
+  if (ctx.is_device_allocation[arg_id] && arch_uses_llvm(kernel->arch)) {
+    auto alloc = (DeviceAllocation *)bits;
+    return (uint64)kernel->program->get_llvm_program_impl()
+        ->get_ndarray_alloc_info_ptr(*alloc);
+  }
+#endif
+  return bits;
+}
+
+}  // namespace
+
+KernelMemoizer::Accesses KernelMemoizer::gather_accesses(Kernel *kernel) {
+  Accesses accesses;
+  // Some backends lower the IR during compilation without flagging the kernel
+  // as lowered. An AST, however, cannot be analyzed.
+  bool offloaded = true;
+  for (auto &stmt : kernel->ir->as<Block>()->statements)
+    offloaded &= stmt->is<OffloadedStmt>();
+  if (!offloaded || !kernel->rets.empty()) {
+    accesses.memoizable = false;
+    accesses.writes_anything = !offloaded;
+    return accesses;
+  }
+  // Returns false if |ptr| may point to anything else than SNode trees,
+  // array args or task-local buffers.
+  std::function<bool(Stmt *, bool)> gather_pointee = [&](Stmt *ptr,
+                                                         bool write) {
+    auto &snodes = write ? accesses.written_snodes : accesses.read_snodes;
+    if (auto global_ptr = ptr->cast<GlobalPtrStmt>()) {
+      for (auto snode : global_ptr->snodes.data) {
+        snodes.insert(snode->id);
+        if (snode->is_path_all_dense)
+          continue;
+        // Inactive cells read as zero, and may get activated by a store.
+        accesses.read_trees.insert(snode_tree_id(snode));
+        if (write && global_ptr->activate)
+          accesses.written_trees.insert(snode_tree_id(snode));
+      }
+      return true;
+    } else if (auto get_ch = ptr->cast<GetChStmt>()) {
+      // The lookups leading to |get_ch| account for the structure.
+      snodes.insert(get_ch->output_snode->id);
+      return true;
+    } else if (auto offset = ptr->cast<IntegerOffsetStmt>()) {
+      return gather_pointee(offset->input, write);
+    } else if (auto ptr_offset = ptr->cast<PtrOffsetStmt>()) {
+      return gather_pointee(ptr_offset->origin, write);
+    } else if (auto external_ptr = ptr->cast<ExternalPtrStmt>()) {
+      auto arg = external_ptr->base_ptrs[0]->cast<ArgLoadStmt>();
+      if (!arg)
+        return false;
+      (write ? accesses.written_array_args : accesses.read_array_args)
+          .insert(arg->arg_id);
+      return true;
+    }
+    return ptr->is<AllocaStmt>() || ptr->is<ThreadLocalPtrStmt>() ||
+           ptr->is<BlockLocalPtrStmt>() || ptr->is<GlobalTemporaryStmt>();
+  };
+  irpass::analysis::gather_statements(kernel->ir.get(), [&](Stmt *stmt) {
+    if (stmt->is<RandStmt>() || stmt->is<PrintStmt>() ||
+        stmt->is<InternalFuncStmt>()) {
+      accesses.memoizable = false;
+    } else if (stmt->is<ExternalFuncCallStmt>() || stmt->is<FuncCallStmt>()) {
+      accesses.memoizable = false;
+      accesses.writes_anything = true;
+    } else if (auto load = stmt->cast<GlobalLoadStmt>()) {
+      if (!gather_pointee(load->src, /*write=*/false))
+        accesses.memoizable = false;
+    } else if (auto store = stmt->cast<GlobalStoreStmt>()) {
+      if (!gather_pointee(store->dest, /*write=*/true))
+        accesses.writes_anything = true;
+    } else if (auto atomic = stmt->cast<AtomicOpStmt>()) {
+      gather_pointee(atomic->dest, /*write=*/false);
+      if (!gather_pointee(atomic->dest, /*write=*/true))
+        accesses.writes_anything = true;
+    } else if (auto bit_struct_store = stmt->cast<BitStructStoreStmt>()) {
+      if (!gather_pointee(bit_struct_store->ptr, /*write=*/true))
+        accesses.writes_anything = true;
+      // The loads of the members are keyed by their place SNodes.
+      auto bit_struct = bit_struct_store->get_bit_struct_snode();
+      for (auto ch_id : bit_struct_store->ch_ids)
+        accesses.written_snodes.insert(bit_struct->ch[ch_id]->id);
+    } else if (auto snode_op = stmt->cast<SNodeOpStmt>()) {
+      auto tree = snode_tree_id(snode_op->snode);
+      accesses.read_trees.insert(tree);
+      if (snode_op->op_type != SNodeOpType::is_active &&
+          snode_op->op_type != SNodeOpType::length &&
+          snode_op->op_type != SNodeOpType::get_addr) {
+        accesses.written_trees.insert(tree);
+      }
+    } else if (auto lookup = stmt->cast<SNodeLookupStmt>()) {
+      auto tree = snode_tree_id(lookup->snode);
+      accesses.read_trees.insert(tree);
+      if (lookup->activate)
+        accesses.written_trees.insert(tree);
+    } else if (auto offload = stmt->cast<OffloadedStmt>()) {
+      if (offload->mesh)
+        accesses.memoizable = false;
+      // Struct-fors and listgens read the structure of the tree.
+      if (offload->snode)
+        accesses.read_trees.insert(snode_tree_id(offload->snode));
+    } else if (auto struct_for = stmt->cast<StructForStmt>()) {
+      accesses.read_trees.insert(snode_tree_id(struct_for->snode));
+    } else if (stmt->is<MeshForStmt>()) {
+      accesses.memoizable = false;
+    }
+    return false;
+  });
+  if (accesses.writes_anything)
+    accesses.memoizable = false;
+  return accesses;
+}
+
+const KernelMemoizer::Accesses &KernelMemoizer::get_accesses(Kernel *kernel) {
+  auto it = accesses_.find(kernel);
+  if (it == accesses_.end()) {
+    it = accesses_.emplace(kernel, gather_accesses(kernel)).first;
+  }
+  return it->second;
+}
+
+bool KernelMemoizer::unchanged_since(Kernel *kernel,
+                                     const Accesses &accesses,
+                                     const RuntimeContext &ctx,
+                                     uint64 version) {
+  auto get_version = [](const auto &versions, auto key) -> uint64 {
+    auto it = versions.find(key);
+    return it == versions.end() ? 0 : it->second;
+  };
+  // What the last launch wrote itself has |version|, so that kernels reading
+  // what they write are never skipped.
+  auto unchanged = [&](const auto &versions,
+                       const std::unordered_set<int> &read,
+                       const std::unordered_set<int> &written, auto to_key) {
+    for (auto x : read) {
+      if (get_version(versions, to_key(x)) >= version)
+        return false;
+    }
+    for (auto x : written) {
+      if (get_version(versions, to_key(x)) > version)
+        return false;
+    }
+    return true;
+  };
+  auto identity = [](int x) { return x; };
+  auto to_array_key = [&](int arg_id) {
+    return array_key(kernel, ctx, arg_id);
+  };
+  return anything_version_ <= version &&
+         unchanged(snode_versions_, accesses.read_snodes,
+                   accesses.written_snodes, identity) &&
+         unchanged(tree_versions_, accesses.read_trees, accesses.written_trees,
+                   identity) &&
+         unchanged(array_versions_, accesses.read_array_args,
+                   accesses.written_array_args, to_array_key);
+}
+
+bool KernelMemoizer::skip_launch(Kernel *kernel, const RuntimeContext &ctx) {
+  enabled_ |= kernel->memoized;
+  if (!enabled_)
+    return false;
+  const auto &accesses = get_accesses(kernel);
+  bool memoizable = kernel->memoized && accesses.memoizable;
+  // Ndarrays are written only by kernels and ndarray methods, unlike the
+  // external arrays passed as raw pointers.
+  for (auto &arg_ids : {accesses.read_array_args, accesses.written_array_args})
+    for (auto arg_id : arg_ids)
+      memoizable &= ctx.is_device_allocation[arg_id];
+  std::vector<uint64> args;
+  if (memoizable) {
+    args.assign(ctx.args, ctx.args + kernel->args.size());
+    auto it = last_launches_.find(kernel);
+    if (it != last_launches_.end() && it->second.args == args &&
+        unchanged_since(kernel, accesses, ctx, it->second.version)) {
+      return true;
+    }
+  }
+
+  const uint64 version = ++version_;
+  if (accesses.writes_anything)
+    anything_version_ = version;
+  for (auto snode : accesses.written_snodes)
+    snode_versions_[snode] = version;
+  for (auto tree : accesses.written_trees)
+    tree_versions_[tree] = version;
+  for (auto arg_id : accesses.written_array_args)
+    array_versions_[array_key(kernel, ctx, arg_id)] = version;
+  if (memoizable) {
+    last_launches_[kernel] = LastLaunch{version, std::move(args)};
+  } else {
+    last_launches_.erase(kernel);
+  }
+  return false;
+}
+
+void KernelMemoizer::bump_snode_tree_structure(int tree_id) {
+  tree_versions_[tree_id] = ++version_;
+}
+
+void KernelMemoizer::bump_array(uint64 array) {
+  array_versions_[array] = ++version_;
+}
+
+TLANG_NAMESPACE_END
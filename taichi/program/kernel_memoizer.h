@@ -0,0 +1,81 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "taichi/lang_util.h"
+
+TLANG_NAMESPACE_BEGIN
+
+class Kernel;
+struct RuntimeContext;
+
+/**
+ * Skips the launches of memoized kernels whose inputs are unchanged.
+ *
+ * Once a memoized kernel has been launched, every kernel launch bumps the
+ * write version of what it may write to: the data of SNodes, the structure,
+ * i.e., the active cells, of SNode trees, and ndarrays. A launch of a memoized
+ * kernel is skipped if its args equal those of its last launch, nothing it
+ * reads has been written since, and nothing it writes has been written by
+ * other launches since.
+ */
+class KernelMemoizer {
+ public:
+  /**
+   * Returns true if the launch of |kernel| with |ctx| can be skipped.
+   * Otherwise, accounts for the writes of the launch, which is assumed to run.
+   * |kernel| must have been lowered or compiled.
+   */
+  bool skip_launch(Kernel *kernel, const RuntimeContext &ctx);
+
+  // Accounts for writes outside kernel launches.
+  void bump_snode_tree_structure(int tree_id);
+  // |array| is the data pointer of an ndarray on the LLVM backends, and its
+  // DeviceAllocation* otherwise.
+  void bump_array(uint64 array);
+
+ private:
+  struct Accesses {
+    // False if the kernel has effects other than writing to SNode trees and
+    // array args, or depends on anything else than them and its args.
+    bool memoizable{true};
+    // True if the kernel may write to memory it is not known to point to.
+    bool writes_anything{false};
+    // By SNode id.
+    std::unordered_set<int> read_snodes;
+    std::unordered_set<int> written_snodes;
+    // The structure of SNode trees, by tree id.
+    std::unordered_set<int> read_trees;
+    std::unordered_set<int> written_trees;
+    std::unordered_set<int> read_array_args;
+    std::unordered_set<int> written_array_args;
+  };
+
+  struct LastLaunch {
+    uint64 version;
+    std::vector<uint64> args;
+  };
+
+  static Accesses gather_accesses(Kernel *kernel);
+  const Accesses &get_accesses(Kernel *kernel);
+  bool unchanged_since(Kernel *kernel,
+                       const Accesses &accesses,
+                       const RuntimeContext &ctx,
+                       uint64 version);
+
+  // Nothing is tracked until the first launch of a memoized kernel, which
+  // always runs.
+  bool enabled_{false};
+  uint64 version_{0};
+  // The last version an unknown address was written at.
+  uint64 anything_version_{0};
+  std::unordered_map<int, uint64> snode_versions_;
+  std::unordered_map<int, uint64> tree_versions_;
+  std::unordered_map<uint64, uint64> array_versions_;
+  std::unordered_map<Kernel *, Accesses> accesses_;
+  std::unordered_map<Kernel *, LastLaunch> last_launches_;
+};
+
+TLANG_NAMESPACE_END
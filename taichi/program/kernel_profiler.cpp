@@ -77,6 +77,7 @@ class DefaultProfiler : public KernelProfilerBase {
     total_time_ms_ = 0;
     traced_records_.clear();
     statistical_results_.clear();
+    skipped_launch_counts_.clear();
   }
 
   void start(const std::string &kernel_name) override {
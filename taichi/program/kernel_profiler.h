@@ -48,6 +48,8 @@ class KernelProfilerBase {
   std::vector<KernelProfileTracedRecord> traced_records_;
   std::vector<KernelProfileStatisticalResult> statistical_results_;
   double total_time_ms_{0};
+  // The launches of memoized kernels that were skipped, by kernel name.
+  std::map<std::string, int> skipped_launch_counts_;
 
  public:
   // Needed for the CUDA backend since we need to know which task to "stop"
@@ -92,6 +94,14 @@ class KernelProfilerBase {
 
   double get_total_time() const;
 
+  void count_skipped_launch(const std::string &kernel_name) {
+    skipped_launch_counts_[kernel_name]++;
+  }
+
+  const std::map<std::string, int> &get_skipped_launch_counts() const {
+    return skipped_launch_counts_;
+  }
+
   virtual std::string get_device_name() {
     std::string str(" ");
     return str;
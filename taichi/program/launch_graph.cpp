@@ -0,0 +1,73 @@
+#include "taichi/program/launch_graph.h"
+
+#include "taichi/program/program.h"
+
+TLANG_NAMESPACE_BEGIN
+
+LaunchGraph::LaunchGraph(Program *program) : program_(program) {
+}
+
+int LaunchGraph::add_launch(Kernel *kernel,
+                            Kernel::LaunchContextBuilder &ctx_builder) {
+  TI_ERROR_IF(program_->config.async_mode,
+              "Launch graphs are not supported in async mode");
+  TI_ERROR_IF(!arch_is_cpu(kernel->arch),
+              "Launch graphs are only supported on CPU, but kernel {} "
+              "targets {}",
+              kernel->get_name(), arch_name(kernel->arch));
+  TI_ERROR_IF(!kernel->rets.empty(),
+              "Kernel {} returns a value and cannot be added to a launch "
+              "graph",
+              kernel->get_name());
+  auto new_ctx_builder = kernel->make_launch_context();
+  auto &ctx = new_ctx_builder.get_context();
+  ctx = ctx_builder.get_context();
+  launches_.push_back(Launch{kernel, std::move(new_ctx_builder), &ctx,
+                             kernel->get_compiled_function()});
+  return num_launches() - 1;
+}
+
+Kernel::LaunchContextBuilder &LaunchGraph::get_ctx_builder(int launch_id,
+                                                           int arg_id) {
+  TI_ASSERT(0 <= launch_id && launch_id < num_launches());
+  auto &launch = launches_[launch_id];
+  TI_ASSERT(0 <= arg_id && arg_id < (int)launch.kernel->args.size());
+  // The recorded pointer would be overwritten with the patched value.
+  TI_ERROR_IF(launch.kernel->args[arg_id].is_array,
+              "Arg {} of kernel {} is an array and cannot be patched", arg_id,
+              launch.kernel->get_name());
+  return launch.ctx_builder;
+}
+
+void LaunchGraph::set_arg_int(int launch_id, int arg_id, int64 d) {
+  auto &ctx_builder = get_ctx_builder(launch_id, arg_id);
+  // Integers may also be assigned to real args, as in Python.
+  if (is_real(launches_[launch_id].kernel->args[arg_id].dt)) {
+    ctx_builder.set_arg_float(arg_id, (float64)d);
+  } else {
+    ctx_builder.set_arg_int(arg_id, d);
+  }
+}
+
+void LaunchGraph::set_arg_float(int launch_id, int arg_id, float64 d) {
+  auto &ctx_builder = get_ctx_builder(launch_id, arg_id);
+  TI_ERROR_IF(!is_real(launches_[launch_id].kernel->args[arg_id].dt),
+              "Arg {} of kernel {} is not real", arg_id,
+              launches_[launch_id].kernel->get_name());
+  ctx_builder.set_arg_float(arg_id, d);
+}
+
+void LaunchGraph::replay() {
+  const bool check_errors = program_->checks_runtime_error_per_launch();
+  for (auto &launch : launches_) {
+    if (launch.kernel->skip_memoized_launch(*launch.ctx))
+      continue;
+    launch.ctx->launch_id = program_->register_launch(launch.kernel);
+    launch.compiled(*launch.ctx);
+    if (check_errors) {
+      program_->check_runtime_error();
+    }
+  }
+}
+
+TLANG_NAMESPACE_END
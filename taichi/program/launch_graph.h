@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "taichi/program/kernel.h"
+
+TLANG_NAMESPACE_BEGIN
+
+class Program;
+
+/**
+ * A recorded sequence of kernel launches that can be replayed in one call.
+ *
+ * Each launch keeps its own copy of the RuntimeContext it was captured with,
+ * so the Python round-trip and the per-launch argument setup are paid only once
+ * at capture time. Replays skip the task accounting of Kernel::operator(),
+ * hence they do not show up in the "launched_tasks" statistics. Only the
+ * synchronous CPU backends are supported.
+ */
+class LaunchGraph {
+ public:
+  explicit LaunchGraph(Program *program);
+
+  LaunchGraph(const LaunchGraph &) = delete;
+  LaunchGraph &operator=(const LaunchGraph &) = delete;
+
+  /**
+   * Appends a launch of |kernel| with the arguments set in |ctx_builder|.
+   *
+   * @return: The id of the launch, to be used by set_arg_*().
+   */
+  int add_launch(Kernel *kernel, Kernel::LaunchContextBuilder &ctx_builder);
+
+  /**
+   * Patches the |arg_id|-th scalar arg of the |launch_id|-th launch. The new
+   * value takes effect from the next replay().
+   */
+  void set_arg_int(int launch_id, int arg_id, int64 d);
+
+  void set_arg_float(int launch_id, int arg_id, float64 d);
+
+  /**
+   * Runs all the recorded launches in order.
+   */
+  void replay();
+
+  int num_launches() const {
+    return (int)launches_.size();
+  }
+
+ private:
+  struct Launch {
+    Kernel *kernel;
+    Kernel::LaunchContextBuilder ctx_builder;
+    RuntimeContext *ctx;
+    FunctionType compiled;
+  };
+
+  Kernel::LaunchContextBuilder &get_ctx_builder(int launch_id, int arg_id);
+
+  Program *program_;
+  std::vector<Launch> launches_;
+};
+
+TLANG_NAMESPACE_END
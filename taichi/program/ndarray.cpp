@@ -16,6 +16,7 @@ Ndarray::Ndarray(Program *prog,
                  const std::vector<int> &shape)
     : dtype(type),
       shape(shape),
+      prog_(prog),
       prog_impl_(prog->get_llvm_program_impl()),
       num_active_indices(shape.size()),
       nelement_(std::accumulate(std::begin(shape),
@@ -35,6 +36,8 @@ Ndarray::Ndarray(Program *prog,
 #else
   TI_ERROR("Llvm disabled");
 #endif
+  // The allocation may reuse the memory of a destroyed ndarray.
+  bump_memoizer_version();
 }
 
 Ndarray::~Ndarray() {
@@ -82,6 +85,13 @@ void Ndarray::buffer_fill(uint32_t val) {
 #else
   TI_ERROR("Llvm disabled");
 #endif
+  bump_memoizer_version();
+}
+
+void Ndarray::bump_memoizer_version() {
+  // See KernelMemoizer::bump_array().
+  prog_->kernel_memoizer.bump_array(
+      data_ptr_ ? (uint64)data_ptr_ : (uint64)&ndarray_alloc_);
 }
 }  // namespace lang
 }  // namespace taichi
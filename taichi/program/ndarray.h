@@ -50,6 +50,9 @@ class Ndarray {
   // dynamic tensor rematerialization.
   std::shared_ptr<Device> device_{nullptr};
   void buffer_fill(uint32_t val);
+  // Tells the kernel memoizer that the data has been written outside kernels.
+  void bump_memoizer_version();
+  Program *prog_{nullptr};
   LlvmProgramImpl *prog_impl_{nullptr};
 };
 
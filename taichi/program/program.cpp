@@ -194,6 +194,7 @@ void Program::materialize_runtime() {
 void Program::destroy_snode_tree(SNodeTree *snode_tree) {
   TI_ASSERT(arch_uses_llvm(config.arch) || config.arch == Arch::vulkan);
   program_impl_->destroy_snode_tree(snode_tree);
+  kernel_memoizer.bump_snode_tree_structure(snode_tree->id());
   free_snode_tree_ids_.push(snode_tree->id());
 }
 
@@ -208,6 +209,7 @@ SNodeTree *Program::add_snode_tree(std::unique_ptr<SNode> root,
     program_impl_->materialize_snode_tree(tree.get(), snode_trees_,
                                           result_buffer);
   }
+  kernel_memoizer.bump_snode_tree_structure(id);
   if (id < snode_trees_.size()) {
     snode_trees_[id] = std::move(tree);
   } else {
@@ -231,6 +233,55 @@ void Program::check_runtime_error() {
 #endif
 }
 
+uint64 Program::register_launch(Kernel *kernel) {
+  if (!config.debug || !config.lazy_runtime_error_check ||
+      !arch_uses_llvm(config.arch)) {
+    return 0;
+  }
+  // Bounds the memory taken by the launches between sync points.
+  constexpr std::size_t kMaxNumLazyLaunches = 1 << 16;
+  if (lazy_launches_.size() >= kMaxNumLazyLaunches) {
+    synchronize();
+  }
+  lazy_launches_.push_back(kernel);
+  return first_lazy_launch_id_ + lazy_launches_.size() - 1;
+}
+
+void Program::check_lazy_runtime_errors() {
+#ifdef TI_WITH_LLVM
+  auto launches = std::move(lazy_launches_);
+  lazy_launches_.clear();
+  const uint64 first_launch_id = first_lazy_launch_id_;
+  first_lazy_launch_id_ += launches.size();
+
+  int num_errors = 0;
+  auto errors = get_llvm_program_impl()->collect_runtime_errors(result_buffer,
+                                                                &num_errors);
+  if (errors.empty()) {
+    return;
+  }
+  // Reports the earliest launch that failed.
+  auto error = *std::min_element(
+      errors.begin(), errors.end(), [](const auto &a, const auto &b) {
+        return a.launch_id < b.launch_id;
+      });
+  std::string kernel_name = "<unknown>";
+  if (error.launch_id >= first_launch_id &&
+      error.launch_id - first_launch_id < launches.size()) {
+    kernel_name = launches[error.launch_id - first_launch_id]->get_name();
+  }
+  auto message = fmt::format(
+      "Assertion failure in launch {} of kernel {}: {} ({} failure(s) since "
+      "the last check)",
+      error.launch_id, kernel_name, error.message, num_errors);
+  if (finalizing_) {
+    TI_WARN("{}", message);
+  } else {
+    TI_ERROR("{}", message);
+  }
+#endif
+}
+
 void Program::synchronize() {
   if (!sync) {
     if (config.async_mode) {
@@ -242,6 +293,12 @@ void Program::synchronize() {
     }
     sync = true;
   }
+  if (kernel_result_slots) {
+    kernel_result_slots->on_synchronized();
+  }
+  if (!lazy_launches_.empty()) {
+    check_lazy_runtime_errors();
+  }
 }
 
 void Program::async_flush() {
@@ -462,6 +519,7 @@ uint64 Program::fetch_result_uint64(int i) {
 }
 
 void Program::finalize() {
+  finalizing_ = true;
   synchronize();
   if (async_engine)
     async_engine = nullptr;  // Finalize the async engine threads before
@@ -17,6 +17,8 @@
 #include "taichi/program/aot_module.h"
 #include "taichi/program/function.h"
 #include "taichi/program/kernel.h"
+#include "taichi/program/kernel_future.h"
+#include "taichi/program/kernel_memoizer.h"
 #include "taichi/program/kernel_profiler.h"
 #include "taichi/program/snode_expr_utils.h"
 #include "taichi/program/snode_rw_accessors_bank.h"
@@ -113,6 +115,12 @@ class Program {
 
   std::unique_ptr<KernelProfilerBase> profiler{nullptr};
 
+  KernelMemoizer kernel_memoizer;
+
+  // Created on the first launch with a future. Shared with the futures, so
+  // that they can release their slots in any order with the program.
+  std::shared_ptr<KernelResultSlots> kernel_result_slots{nullptr};
+
   std::unordered_map<JITEvaluatorId, std::unique_ptr<Kernel>>
       jit_evaluator_cache;
   std::mutex jit_evaluator_cache_mut;
@@ -204,6 +212,18 @@ class Program {
 
   void check_runtime_error();
 
+  // True if runtime errors are checked right after each launch.
+  bool checks_runtime_error_per_launch() const {
+    return config.debug && !config.lazy_runtime_error_check;
+  }
+
+  /**
+   * Returns the id of a new launch of |kernel|, to be set in its
+   * RuntimeContext::launch_id. Runtime errors that are checked lazily are
+   * reported with the launch that raised them. Zero otherwise.
+   */
+  uint64 register_launch(Kernel *kernel);
+
   Kernel &get_snode_reader(SNode *snode);
 
   Kernel &get_snode_writer(SNode *snode);
@@ -346,6 +366,18 @@ class Program {
   bool finalized_{false};
 
   std::unique_ptr<MemoryPool> memory_pool_{nullptr};
+
+  // Reports the runtime errors raised by the launches registered since the
+  // last check. Must be called after synchronizing.
+  void check_lazy_runtime_errors();
+
+  // The kernels of the launches registered since the last lazy check for
+  // runtime errors, starting from the launch |first_lazy_launch_id_|.
+  std::vector<Kernel *> lazy_launches_;
+  uint64 first_lazy_launch_id_{1};
+  // Set during finalize(), which reports pending runtime errors as warnings,
+  // so that it always tears the program down completely.
+  bool finalizing_{false};
 };
 
 }  // namespace lang
@@ -294,6 +294,8 @@ void StateFlowGraph::clear() {
             initial_node_);
   latest_state_readers_.clear();
   first_pending_task_index_ = 1;
+  reset_transitive_closure();
+  topo_order_valid_ = true;
 
   // Do not clear task_name_to_launch_ids_.
 }
@@ -313,6 +315,7 @@ void StateFlowGraph::mark_pending_tasks_as_executed() {
   nodes_ = std::move(new_nodes);
   first_pending_task_index_ = nodes_.size();
   reid_nodes();
+  reset_transitive_closure();
 }
 
 void StateFlowGraph::insert_tasks(const std::vector<TaskLaunchRecord> &records,
@@ -375,16 +378,24 @@ void StateFlowGraph::insert_tasks(const std::vector<TaskLaunchRecord> &records,
 }
 
 void StateFlowGraph::insert_node(std::unique_ptr<StateFlowGraph::Node> &&node) {
+  // The node is appended, so all its edges come from earlier nodes and the
+  // topological order is kept.
+  node->pending_node_id = (int)nodes_.size() - first_pending_task_index_;
+  std::vector<Node *> predecessors;
+  auto insert_input_edge = [&](Node *from, AsyncState state) {
+    insert_edge(from, node.get(), state);
+    if (from->pending())
+      predecessors.push_back(from);
+  };
   for (auto input_state : node->meta->input_states) {
-    insert_edge(latest_state_owner_[input_state.unique_id], node.get(),
-                input_state);
+    insert_input_edge(latest_state_owner_[input_state.unique_id], input_state);
   }
   for (auto output_state : node->meta->output_states) {
     if (get_or_insert(latest_state_readers_, output_state).empty()) {
       if (latest_state_owner_[output_state.unique_id] != initial_node_) {
         // insert a WAW dependency edge
-        insert_edge(latest_state_owner_[output_state.unique_id], node.get(),
-                    output_state);
+        insert_input_edge(latest_state_owner_[output_state.unique_id],
+                          output_state);
       } else {
         insert(latest_state_readers_, output_state, initial_node_);
       }
@@ -392,7 +403,7 @@ void StateFlowGraph::insert_node(std::unique_ptr<StateFlowGraph::Node> &&node) {
     latest_state_owner_[output_state.unique_id] = node.get();
     for (auto *d : get_or_insert(latest_state_readers_, output_state)) {
       // insert a WAR dependency edge
-      insert_edge(d, node.get(), output_state);
+      insert_input_edge(d, output_state);
     }
     get_or_insert(latest_state_readers_, output_state).clear();
   }
@@ -400,6 +411,7 @@ void StateFlowGraph::insert_node(std::unique_ptr<StateFlowGraph::Node> &&node) {
   for (auto input_state : node->meta->input_states) {
     insert(latest_state_readers_, input_state, node.get());
   }
+  extend_transitive_closure(node.get(), predecessors);
   nodes_.push_back(std::move(node));
 }
 
@@ -582,7 +594,21 @@ std::unordered_set<int> StateFlowGraph::fuse_range(int begin, int end) {
   auto nodes = get_pending_tasks(begin, end);
 
   std::vector<Bitset> has_path, has_path_reverse;
-  std::tie(has_path, has_path_reverse) = compute_transitive_closure(begin, end);
+  const bool all_pending_tasks = begin == 0 && end == num_pending_tasks();
+  if (all_pending_tasks && transitive_closure_valid_) {
+    has_path = std::move(has_path_);
+    has_path_reverse = std::move(has_path_reverse_);
+    TI_ASSERT(has_path.size() == n);
+    // The cached bitsets may have spare capacity.
+    for (int i = 0; i < n; i++) {
+      has_path[i].resize(n);
+      has_path_reverse[i].resize(n);
+    }
+    transitive_closure_valid_ = false;
+  } else {
+    std::tie(has_path, has_path_reverse) =
+        compute_transitive_closure(begin, end);
+  }
 
   // Classify tasks by TaskFusionMeta.
   std::vector<TaskFusionMeta> fusion_meta(n);
@@ -628,6 +654,9 @@ std::unordered_set<int> StateFlowGraph::fuse_range(int begin, int end) {
 
     // Convert to the index in nodes_.
     indices_to_delete.insert(b + begin + first_pending_task_index_);
+    fused_into_[node_b] = node_a;
+    // Nodes between |node_a| and |node_b| may now precede |node_a|.
+    topo_order_valid_ = false;
 
     const bool already_had_a_to_b_edge = has_path[a][b];
     if (already_had_a_to_b_edge) {
@@ -807,6 +836,12 @@ std::unordered_set<int> StateFlowGraph::fuse_range(int begin, int end) {
     }
   }
 
+  if (all_pending_tasks && indices_to_delete.empty()) {
+    // The closure is still up-to-date.
+    has_path_ = std::move(has_path);
+    has_path_reverse_ = std::move(has_path_reverse);
+    transitive_closure_valid_ = true;
+  }
   return indices_to_delete;
 }
 
@@ -841,10 +876,37 @@ bool StateFlowGraph::fuse() {
   bool modified = !indices_to_delete.empty();
   // TODO: Do we need a trash bin here?
   if (modified) {
-    // Rebuild the graph in topological order.
-    // The original order may not be a correct topological order.
+    // Instead of rebuilding the graph, hand the states of the fused tasks over
+    // to the tasks they are fused into, whose edges already include theirs.
+    auto fused_into = [&](Node *node) {
+      for (auto it = fused_into_.find(node); it != fused_into_.end();
+           it = fused_into_.find(node)) {
+        node = it->second;
+      }
+      return node;
+    };
+    for (auto &owner : latest_state_owner_) {
+      owner = fused_into(owner);
+    }
+    for (auto &readers : latest_state_readers_) {
+      std::vector<Node *> fused_readers;
+      for (auto *reader : readers.second) {
+        if (fused_into_.count(reader))
+          fused_readers.push_back(reader);
+      }
+      for (auto *reader : fused_readers) {
+        readers.second.erase(reader);
+        readers.second.insert(fused_into(reader));
+      }
+    }
+    for (auto &fused : fused_into_) {
+      auto *node = fused_into(fused.second);
+      node->meta = get_task_meta(ir_bank_, node->rec);
+    }
+    fused_into_.clear();
     delete_nodes(indices_to_delete);
-    rebuild_graph(/*sort=*/true);
+    // The original order may not be a correct topological order.
+    topo_sort_nodes();
   }
 
   return modified;
@@ -873,18 +935,36 @@ void StateFlowGraph::rebuild_graph(bool sort) {
   first_pending_task_index_ = num_executed_tasks + 1;
   reid_nodes();
   reid_pending_nodes();
+  if (num_executed_tasks > 0) {
+    // The closure was extended with the executed tasks counted as pending.
+    reset_transitive_closure();
+  }
 
   sort_node_edges();
 }
 
-std::vector<TaskLaunchRecord> StateFlowGraph::extract_to_execute() {
+std::vector<TaskLaunchRecord> StateFlowGraph::extract_to_execute(
+    std::vector<int> *levels) {
   TI_AUTO_PROF;
   auto nodes = get_pending_tasks();
   std::vector<TaskLaunchRecord> tasks;
   tasks.reserve(nodes.size());
-  for (auto &node : nodes) {
+  // The pending tasks are in topological order.
+  std::vector<int> node_levels(nodes.size(), 0);
+  for (int i = 0; i < (int)nodes.size(); i++) {
+    auto node = nodes[i];
+    if (levels) {
+      for (auto &edge : node->input_edges.get_all_edges()) {
+        if (edge.second->pending()) {
+          node_levels[i] = std::max(
+              node_levels[i], node_levels[edge.second->pending_node_id] + 1);
+        }
+      }
+    }
     if (!node->rec.empty()) {
       tasks.push_back(node->rec);
+      if (levels)
+        levels->push_back(node_levels[i]);
     }
   }
   mark_pending_tasks_as_executed();
@@ -1064,6 +1144,11 @@ std::string StateFlowGraph::dump_dot(const std::optional<std::string> &rankdir,
 
 void StateFlowGraph::topo_sort_nodes() {
   TI_AUTO_PROF
+  if (topo_order_valid_) {
+    reid_nodes();
+    reid_pending_nodes();
+    return;
+  }
   // Only sort pending tasks.
   const auto previous_size = nodes_.size();
   std::deque<std::unique_ptr<Node>> queue;
@@ -1123,6 +1208,8 @@ void StateFlowGraph::topo_sort_nodes() {
   }
   reid_nodes();
   reid_pending_nodes();
+  reset_transitive_closure();
+  topo_order_valid_ = true;
 }
 
 void StateFlowGraph::sort_node_edges() {
@@ -1233,6 +1320,7 @@ void StateFlowGraph::delete_nodes(
   nodes_ = std::move(new_nodes_);
   reid_nodes();
   reid_pending_nodes();
+  reset_transitive_closure();
 }
 
 bool StateFlowGraph::optimize_dead_store() {
@@ -1505,6 +1593,45 @@ bool StateFlowGraph::demote_activation() {
   return modified;
 }
 
+void StateFlowGraph::extend_transitive_closure(
+    Node *node,
+    const std::vector<Node *> &predecessors) {
+  if (!transitive_closure_valid_)
+    return;
+  using bit::Bitset;
+  const int id = node->pending_node_id;
+  TI_ASSERT(id == (int)has_path_.size());
+  int capacity = has_path_.empty() ? 0 : has_path_[0].size();
+  if (id >= capacity) {
+    // Grow geometrically to keep insertions amortized O(n / 64).
+    capacity = std::max(2 * capacity, (int)Bitset::kBits);
+    for (int i = 0; i < id; i++) {
+      has_path_[i].resize(capacity);
+      has_path_reverse_[i].resize(capacity);
+    }
+  }
+  has_path_.emplace_back(capacity);
+  has_path_reverse_.emplace_back(capacity);
+  has_path_[id][id] = true;
+  auto &ancestors = has_path_reverse_[id];
+  ancestors[id] = true;
+  for (auto *predecessor : predecessors) {
+    TI_ASSERT(predecessor->pending_node_id < id);
+    ancestors |= has_path_reverse_[predecessor->pending_node_id];
+  }
+  for (int i = ancestors.find_first_one(); i != -1;
+       i = ancestors.lower_bound(i + 1)) {
+    has_path_[i][id] = true;
+  }
+}
+
+void StateFlowGraph::reset_transitive_closure() {
+  has_path_.clear();
+  has_path_reverse_.clear();
+  // An empty closure is trivially up-to-date.
+  transitive_closure_valid_ = num_pending_tasks() == 0;
+}
+
 void StateFlowGraph::mark_list_as_dirty(SNode *snode) {
   list_up_to_date_[snode] = false;
   for (auto &ch : snode->ch) {
@@ -296,6 +296,8 @@ class StateFlowGraph {
                          Node *node_b,
                          bool only_output_edges = false);
 
+  // Sorts the pending tasks topologically. This is a no-op unless fusion has
+  // broken the order since the last sort.
   void topo_sort_nodes();
 
   void sort_node_edges();
@@ -305,8 +307,11 @@ class StateFlowGraph {
   // Extract all pending tasks and insert them in topological/original order.
   void rebuild_graph(bool sort);
 
-  // Extract all tasks to execute.
-  std::vector<TaskLaunchRecord> extract_to_execute();
+  // Extract all tasks to execute. If |levels| is not null, it receives the
+  // length of the longest path of pending tasks ending at each extracted task,
+  // so that tasks of the same level do not depend on each other.
+  std::vector<TaskLaunchRecord> extract_to_execute(
+      std::vector<int> *levels = nullptr);
 
   std::size_t size() const {
     return nodes_.size();
@@ -335,6 +340,15 @@ class StateFlowGraph {
 #endif
 
  private:
+  // Extends the cached transitive closure with the newly appended pending
+  // |node|, given its pending predecessors.
+  void extend_transitive_closure(Node *node,
+                                 const std::vector<Node *> &predecessors);
+
+  // Drops the cached transitive closure. It is recomputed by the next
+  // fuse_range() over all the pending tasks.
+  void reset_transitive_closure();
+
   std::vector<std::unique_ptr<Node>> nodes_;
   Node *initial_node_;  // The initial node holds all the initial states.
   int first_pending_task_index_;
@@ -346,6 +360,16 @@ class StateFlowGraph {
   std::unordered_map<SNode *, bool> list_up_to_date_;
   [[maybe_unused]] AsyncEngine *engine_;
   const CompileConfig *const config_;
+
+  // has_path_[i][j] denotes if there is a path from the i-th to the j-th
+  // pending task, and has_path_reverse_[j][i] the same. Maintained across
+  // insertions so that fusion does not recompute it in each flush.
+  std::vector<bit::Bitset> has_path_, has_path_reverse_;
+  bool transitive_closure_valid_{true};
+  // Whether |nodes_| is in topological order. Insertions keep it so.
+  bool topo_order_valid_{true};
+  // Maps each task fused in the current fuse() to the task it is fused into.
+  std::unordered_map<Node *, Node *> fused_into_;
 };
 
 TLANG_NAMESPACE_END
@@ -17,6 +17,8 @@
 #include "taichi/ir/statements.h"
 #include "taichi/program/extension.h"
 #include "taichi/program/async_engine.h"
+#include "taichi/program/kernel_future.h"
+#include "taichi/program/launch_graph.h"
 #include "taichi/program/snode_expr_utils.h"
 #include "taichi/program/snode_rw_accessors_bank.h"
 #include "taichi/program/ndarray.h"
@@ -141,11 +143,14 @@ void export_lang(py::module &m) {
       .def_readwrite("debug", &CompileConfig::debug)
       .def_readwrite("cfg_optimization", &CompileConfig::cfg_optimization)
       .def_readwrite("check_out_of_bound", &CompileConfig::check_out_of_bound)
+      .def_readwrite("lazy_runtime_error_check",
+                     &CompileConfig::lazy_runtime_error_check)
       .def_readwrite("print_accessor_ir", &CompileConfig::print_accessor_ir)
       .def_readwrite("print_evaluator_ir", &CompileConfig::print_evaluator_ir)
       .def_readwrite("use_llvm", &CompileConfig::use_llvm)
       .def_readwrite("print_benchmark_stat",
                      &CompileConfig::print_benchmark_stat)
+      .def_readwrite("print_pass_stats", &CompileConfig::print_pass_stats)
       .def_readwrite("print_struct_llvm_ir",
                      &CompileConfig::print_struct_llvm_ir)
       .def_readwrite("print_kernel_llvm_ir",
@@ -160,6 +165,16 @@ void export_lang(py::module &m) {
       .def_readwrite("lower_access", &CompileConfig::lower_access)
       .def_readwrite("move_loop_invariant_outside_if",
                      &CompileConfig::move_loop_invariant_outside_if)
+      .def_readwrite("promote_loop_invariant_global_accesses",
+                     &CompileConfig::promote_loop_invariant_global_accesses)
+      .def_readwrite("strength_reduce_addresses",
+                     &CompileConfig::strength_reduce_addresses)
+      .def_readwrite("privatize_scatter_adds",
+                     &CompileConfig::privatize_scatter_adds)
+      .def_readwrite("fuse_range_fors", &CompileConfig::fuse_range_fors)
+      .def_readwrite("reuse_element_lists",
+                     &CompileConfig::reuse_element_lists)
+      .def_readwrite("cpu_isa", &CompileConfig::cpu_isa)
       .def_readwrite("default_cpu_block_dim",
                      &CompileConfig::default_cpu_block_dim)
       .def_readwrite("default_gpu_block_dim",
@@ -168,6 +183,8 @@ void export_lang(py::module &m) {
       .def_readwrite("saturating_grid_dim", &CompileConfig::saturating_grid_dim)
       .def_readwrite("max_block_dim", &CompileConfig::max_block_dim)
       .def_readwrite("cpu_max_num_threads", &CompileConfig::cpu_max_num_threads)
+      .def_readwrite("cpu_concurrent_tasks",
+                     &CompileConfig::cpu_concurrent_tasks)
       .def_readwrite("random_seed", &CompileConfig::random_seed)
       .def_readwrite("verbose_kernel_launches",
                      &CompileConfig::verbose_kernel_launches)
@@ -184,6 +201,17 @@ void export_lang(py::module &m) {
       .def_readwrite("fast_math", &CompileConfig::fast_math)
       .def_readwrite("advanced_optimization",
                      &CompileConfig::advanced_optimization)
+      .def_readwrite("worklist_simplify", &CompileConfig::worklist_simplify)
+      .def_readwrite("check_worklist_simplify",
+                     &CompileConfig::check_worklist_simplify)
+      .def_readwrite("slp_vectorize", &CompileConfig::slp_vectorize)
+      .def_readwrite("vectorize_range_for",
+                     &CompileConfig::vectorize_range_for)
+      .def_readwrite("vector_math", &CompileConfig::vector_math)
+      .def_readwrite("fast_vector_math", &CompileConfig::fast_vector_math)
+      .def_readwrite("software_prefetch", &CompileConfig::software_prefetch)
+      .def_readwrite("prefetch_distance", &CompileConfig::prefetch_distance)
+      .def_readwrite("max_vector_width", &CompileConfig::max_vector_width)
       .def_readwrite("ad_stack_size", &CompileConfig::ad_stack_size)
       .def_readwrite("async_mode", &CompileConfig::async_mode)
       .def_readwrite("dynamic_index", &CompileConfig::dynamic_index)
@@ -193,6 +221,7 @@ void export_lang(py::module &m) {
       .def_readwrite("detect_read_only", &CompileConfig::detect_read_only)
       .def_readwrite("ndarray_use_cached_allocator",
                      &CompileConfig::ndarray_use_cached_allocator)
+      .def_readwrite("ir_arena", &CompileConfig::ir_arena)
       .def_readwrite("cc_compile_cmd", &CompileConfig::cc_compile_cmd)
       .def_readwrite("cc_link_cmd", &CompileConfig::cc_link_cmd)
       .def_readwrite("async_opt_passes", &CompileConfig::async_opt_passes)
@@ -210,6 +239,8 @@ void export_lang(py::module &m) {
       .def_readwrite("async_flush_every", &CompileConfig::async_flush_every)
       .def_readwrite("async_max_fuse_per_task",
                      &CompileConfig::async_max_fuse_per_task)
+      .def_readwrite("async_concurrent_launch",
+                     &CompileConfig::async_concurrent_launch)
       .def_readwrite("quant_opt_store_fusion",
                      &CompileConfig::quant_opt_store_fusion)
       .def_readwrite("quant_opt_atomic_demotion",
@@ -379,6 +410,10 @@ void export_lang(py::module &m) {
            [](Program *program, const std::vector<std::string> metrics) {
              return program->profiler->reinit_with_metrics(metrics);
            })
+      .def("get_kernel_profiler_skipped_launches",
+           [](Program *program) {
+             return program->profiler->get_skipped_launch_counts();
+           })
       .def("kernel_profiler_total_time",
            [](Program *program) { return program->profiler->get_total_time(); })
       .def("set_kernel_profiler_toolkit",
@@ -553,6 +588,7 @@ void export_lang(py::module &m) {
       .def_readonly("shape", &Ndarray::shape);
 
   py::class_<Kernel>(m, "Kernel")
+      .def_readwrite("memoized", &Kernel::memoized)
       .def("get_ret_int", &Kernel::get_ret_int)
       .def("get_ret_float", &Kernel::get_ret_float)
       .def("make_launch_context", &Kernel::make_launch_context)
@@ -566,8 +602,41 @@ void export_lang(py::module &m) {
            [](Kernel *kernel, Kernel::LaunchContextBuilder &launch_ctx) {
              py::gil_scoped_release release;
              kernel->operator()(launch_ctx);
+           })
+      .def("launch_with_future",
+           [](Kernel *kernel, Kernel::LaunchContextBuilder &launch_ctx) {
+             py::gil_scoped_release release;
+             return kernel->launch_with_future(launch_ctx);
+           })
+      .def("get_packed_args_size", &Kernel::get_packed_args_size)
+      .def("get_packed_arg_offset", &Kernel::get_packed_arg_offset)
+      .def("launch_prepared",
+           [](Kernel *kernel, Kernel::LaunchContextBuilder &launch_ctx,
+              py::buffer packed_args) {
+             auto info = packed_args.request();
+             TI_ERROR_IF(info.size * info.itemsize <
+                             (py::ssize_t)kernel->get_packed_args_size(),
+                         "Packed args of kernel {} take {} bytes, but only "
+                         "{} are provided",
+                         kernel->get_name(), kernel->get_packed_args_size(),
+                         info.size * info.itemsize);
+             auto &ctx = launch_ctx.get_context();
+             py::gil_scoped_release release;
+             kernel->launch_prepared(ctx, info.ptr);
            });
 
+  py::class_<KernelFuture, std::shared_ptr<KernelFuture>>(m, "KernelFuture")
+      .def("done", &KernelFuture::done)
+      .def("get_ret_int",
+           [](KernelFuture *future) {
+             py::gil_scoped_release release;
+             return future->get_ret_int();
+           })
+      .def("get_ret_float", [](KernelFuture *future) {
+        py::gil_scoped_release release;
+        return future->get_ret_float();
+      });
+
   py::class_<Kernel::LaunchContextBuilder>(m, "KernelLaunchContext")
       .def("set_arg_int", &Kernel::LaunchContextBuilder::set_arg_int)
       .def("set_arg_float", &Kernel::LaunchContextBuilder::set_arg_float)
@@ -579,6 +648,18 @@ void export_lang(py::module &m) {
       .def("set_extra_arg_int",
            &Kernel::LaunchContextBuilder::set_extra_arg_int);
 
+  py::class_<LaunchGraph>(m, "LaunchGraph")
+      .def(py::init<Program *>())
+      .def("add_launch", &LaunchGraph::add_launch)
+      .def("set_arg_int", &LaunchGraph::set_arg_int)
+      .def("set_arg_float", &LaunchGraph::set_arg_float)
+      .def("replay",
+           [](LaunchGraph *graph) {
+             py::gil_scoped_release release;
+             graph->replay();
+           })
+      .def("num_launches", &LaunchGraph::num_launches);
+
   py::class_<Function>(m, "Function")
       .def("set_function_body",
            py::overload_cast<const std::function<void()> &>(
@@ -18,7 +18,8 @@ void Dynamic_activate(Ptr meta_, Ptr node_, int i) {
   auto node = (DynamicNode *)(node_);
   // We need to not only update node->n, but also make sure the chunk containing
   // element i is allocated.
-  atomic_max_i32(&node->n, i + 1);
+  if (atomic_max_i32(&node->n, i + 1) < i + 1)
+    mark_activation_changed(meta->context->runtime, meta->snode_id);
   int chunk_start = 0;
   auto p_chunk_ptr = &node->ptr;
   auto chunk_size = meta->chunk_size;
@@ -54,6 +55,7 @@ void Dynamic_deactivate(Ptr meta_, Ptr node_) {
         p_chunk_ptr = (Ptr *)*p_chunk_ptr;
       }
       node->ptr = nullptr;
+      mark_activation_changed(rt, meta->snode_id);
     });
   }
 }
@@ -63,6 +65,7 @@ i32 Dynamic_append(Ptr meta_, Ptr node_, i32 data) {
   auto node = (DynamicNode *)(node_);
   auto chunk_size = meta->chunk_size;
   auto i = atomic_add_i32(&node->n, 1);
+  mark_activation_changed(meta->context->runtime, meta->snode_id);
   int chunk_start = 0;
   auto p_chunk_ptr = &node->ptr;
   while (true) {
@@ -25,6 +25,7 @@
 #include "taichi/inc/constants.h"
 #include "taichi/inc/cuda_kernel_utils.inc.h"
 #include "taichi/math/arithmetic.h"
+#include "taichi/runtime/llvm/vector_math.h"
 
 struct RuntimeContext;
 using assert_failed_type = void (*)(const char *);
@@ -35,6 +36,10 @@ using host_vsnprintf_type = int (*)(char *,
                                     std::va_list);
 using vm_allocator_type = void *(*)(void *, std::size_t, std::size_t);
 using RangeForTaskFunc = void(RuntimeContext *, const char *tls, int i);
+using RangeForChunkFunc = void(RuntimeContext *,
+                               const char *tls,
+                               int begin,
+                               int end);
 using MeshForTaskFunc = void(RuntimeContext *, const char *tls, uint32_t i);
 using parallel_for_type = void (*)(void *thread_pool,
                                    int splits,
@@ -149,6 +154,15 @@ T ifloordiv(T a, T b) {
   return r;
 }
 
+#if !ARCH_cuda
+template <int N, bool fast = false>
+using VectorMathF64 = vector_math::VectorMath<f64, N, fast>;
+template <int N, bool fast = false>
+using VectorMathF32 = vector_math::VectorMath<f32, N, fast>;
+template <int N, bool fast = false>
+using WideVectorMathF32 = vector_math::VectorMathF32<N, fast>;
+#endif
+
 struct LLVMRuntime;
 template <typename... Args>
 void taichi_printf(LLVMRuntime *runtime, const char *format, Args &&... args);
@@ -329,6 +343,56 @@ f64 pow_f64(f64 a, f64 b) {
   return std::pow(a, b);
 }
 
+#if !ARCH_cuda
+// Vector variants of the functions above, which codegen maps to the scalar
+// ones through the vector function ABI. The lanes are passed through memory,
+// since the runtime is not compiled with the wider vector registers.
+#define DEFINE_VECTOR_MATH_FUNC(F, IMPL, T, N)             \
+  void F##_##T##_x##N(T *ret, const T *x) {                \
+    typename IMPL<N>::V v;                                 \
+    std::memcpy(&v, x, sizeof(v));                         \
+    v = IMPL<N>::F(v);                                     \
+    std::memcpy(ret, &v, sizeof(v));                       \
+  }                                                        \
+  void F##_##T##_x##N##_fast(T *ret, const T *x) {         \
+    typename IMPL<N, true>::V v;                           \
+    std::memcpy(&v, x, sizeof(v));                         \
+    v = IMPL<N, true>::F(v);                               \
+    std::memcpy(ret, &v, sizeof(v));                       \
+  }
+
+#define DEFINE_VECTOR_MATH_FUNC_LANES(F, IMPL, T) \
+  DEFINE_VECTOR_MATH_FUNC(F, IMPL, T, 4)          \
+  DEFINE_VECTOR_MATH_FUNC(F, IMPL, T, 8)          \
+  DEFINE_VECTOR_MATH_FUNC(F, IMPL, T, 16)
+
+#define DEFINE_VECTOR_MATH_REAL_FUNC(F)                 \
+  DEFINE_VECTOR_MATH_FUNC_LANES(F, VectorMathF32, f32) \
+  DEFINE_VECTOR_MATH_FUNC_LANES(F, VectorMathF64, f64)
+
+DEFINE_VECTOR_MATH_REAL_FUNC(exp)
+DEFINE_VECTOR_MATH_REAL_FUNC(log)
+DEFINE_VECTOR_MATH_REAL_FUNC(sin)
+DEFINE_VECTOR_MATH_REAL_FUNC(cos)
+DEFINE_VECTOR_MATH_FUNC_LANES(tanh, WideVectorMathF32, f32)
+
+#define DEFINE_VECTOR_POW_F32(N)                                    \
+  void pow_f32_x##N(f32 *ret, const f32 *x, const f32 *y) {         \
+    typename WideVectorMathF32<N>::V a, b;                          \
+    std::memcpy(&a, x, sizeof(a));                                  \
+    std::memcpy(&b, y, sizeof(b));                                  \
+    a = WideVectorMathF32<N>::pow(a, b);                            \
+    std::memcpy(ret, &a, sizeof(a));                                \
+  }                                                                 \
+  void pow_f32_x##N##_fast(f32 *ret, const f32 *x, const f32 *y) { \
+    pow_f32_x##N(ret, x, y);                                        \
+  }
+
+DEFINE_VECTOR_POW_F32(4)
+DEFINE_VECTOR_POW_F32(8)
+DEFINE_VECTOR_POW_F32(16)
+#endif
+
 f32 __nv_sgnf(f32 x) {
   return sgn_f32(x);
 }
@@ -539,6 +603,12 @@ void initialize_rand_state(RandState *state, u32 i) {
 
 struct NodeManager;
 
+struct ErrorRecord {
+  u64 launch_id;
+  char message_template[taichi_error_message_max_length];
+  u64 message_arguments[taichi_error_message_max_num_arguments];
+};
+
 struct LLVMRuntime {
   bool preallocated;
   std::size_t preallocated_size;
@@ -560,6 +630,15 @@ struct LLVMRuntime {
   ListManager *element_lists[taichi_max_num_snodes];
   NodeManager *node_allocators[taichi_max_num_snodes];
   Ptr ambient_elements[taichi_max_num_snodes];
+  // Set when cells of an SNode get activated or deactivated, and folded into
+  // |activation_versions| when an element list is about to be regenerated.
+  i32 activation_changed[taichi_max_num_snodes];
+  u64 activation_versions[taichi_max_num_snodes];
+  // The activation versions each element list was generated from. Zero means
+  // the list has never been generated.
+  u64 element_list_stamps[taichi_max_num_snodes];
+  // Set by clear_list() if the element list is up to date and kept.
+  i32 element_list_reused[taichi_max_num_snodes];
   Ptr temporaries;
   RandState *rand_states;
   MemRequestQueue *mem_req_queue;
@@ -575,6 +654,10 @@ struct LLVMRuntime {
   uint64 error_message_arguments[taichi_error_message_max_num_arguments];
   i32 error_message_lock = 0;
   i64 error_code = 0;
+  // Every assertion failure since the last reset, unlike |error_code| which
+  // only keeps the first one. The count keeps growing past the capacity.
+  ErrorRecord error_records[taichi_max_num_error_records];
+  i32 num_error_records = 0;
 
   Ptr result_buffer;
   i32 allocator_lock;
@@ -696,8 +779,12 @@ struct NodeManager {
 
 extern "C" {
 
-void LLVMRuntime_store_result(LLVMRuntime *runtime, u64 ret) {
-  runtime->set_result(taichi_result_buffer_ret_value_id, ret);
+void RuntimeContext_store_result(RuntimeContext *context, u64 ret) {
+  if (context->result_buffer) {
+    context->result_buffer[taichi_result_buffer_ret_value_id] = ret;
+  } else {
+    context->runtime->set_result(taichi_result_buffer_ret_value_id, ret);
+  }
 }
 
 void LLVMRuntime_profiler_start(LLVMRuntime *runtime, Ptr kernel_name) {
@@ -715,6 +802,7 @@ Ptr get_temporary_pointer(LLVMRuntime *runtime, u64 offset) {
 void runtime_retrieve_and_reset_error_code(LLVMRuntime *runtime) {
   runtime->set_result(taichi_result_buffer_error_id, runtime->error_code);
   runtime->error_code = 0;
+  runtime->num_error_records = 0;
 }
 
 void runtime_retrieve_error_message(LLVMRuntime *runtime, int i) {
@@ -728,6 +816,28 @@ void runtime_retrieve_error_message_argument(LLVMRuntime *runtime,
                       runtime->error_message_arguments[argument_id]);
 }
 
+void runtime_get_num_error_records(LLVMRuntime *runtime) {
+  runtime->set_result(taichi_result_buffer_runtime_query_id,
+                      runtime->num_error_records);
+}
+
+void runtime_get_error_record_launch_id(LLVMRuntime *runtime, int i) {
+  runtime->set_result(taichi_result_buffer_runtime_query_id,
+                      runtime->error_records[i].launch_id);
+}
+
+void runtime_get_error_record_message(LLVMRuntime *runtime, int i, int j) {
+  runtime->set_result(taichi_result_buffer_runtime_query_id,
+                      runtime->error_records[i].message_template[j]);
+}
+
+void runtime_get_error_record_argument(LLVMRuntime *runtime,
+                                       int i,
+                                       int argument_id) {
+  runtime->set_result(taichi_result_buffer_runtime_query_id,
+                      runtime->error_records[i].message_arguments[argument_id]);
+}
+
 void runtime_ListManager_get_num_active_chunks(LLVMRuntime *runtime,
                                                ListManager *list_manager) {
   runtime->set_result(taichi_result_buffer_runtime_query_id,
@@ -751,15 +861,38 @@ void taichi_assert(RuntimeContext *context, i32 test, const char *msg) {
   taichi_assert_runtime(context->runtime, test, msg);
 }
 
-void taichi_assert_format(LLVMRuntime *runtime,
-                          i32 test,
-                          const char *format,
-                          int num_arguments,
-                          uint64 *arguments) {
+void record_error(LLVMRuntime *runtime,
+                  u64 launch_id,
+                  const char *format,
+                  int num_arguments,
+                  uint64 *arguments) {
+  // Checked first so that the count cannot overflow.
+  if (runtime->num_error_records >= taichi_max_num_error_records)
+    return;
+  auto i = atomic_add_i32(&runtime->num_error_records, 1);
+  if (i >= taichi_max_num_error_records)
+    return;
+  auto &record = runtime->error_records[i];
+  record.launch_id = launch_id;
+  memset(record.message_template, 0, taichi_error_message_max_length);
+  memcpy(record.message_template, format,
+         std::min(taichi_strlen(format), taichi_error_message_max_length - 1));
+  for (int j = 0; j < num_arguments; j++) {
+    record.message_arguments[j] = arguments[j];
+  }
+}
+
+void taichi_assert_format_with_launch_id(LLVMRuntime *runtime,
+                                         u64 launch_id,
+                                         i32 test,
+                                         const char *format,
+                                         int num_arguments,
+                                         uint64 *arguments) {
   mark_force_no_inline();
 
   if (!enable_assert || test != 0)
     return;
+  record_error(runtime, launch_id, format, num_arguments, arguments);
   if (!runtime->error_code) {
     locked_task(&runtime->error_message_lock, [&] {
       if (!runtime->error_code) {
@@ -794,6 +927,24 @@ void taichi_assert_format(LLVMRuntime *runtime,
 #endif
 }
 
+void taichi_assert_format(LLVMRuntime *runtime,
+                          i32 test,
+                          const char *format,
+                          int num_arguments,
+                          uint64 *arguments) {
+  taichi_assert_format_with_launch_id(runtime, /*launch_id=*/0, test, format,
+                                      num_arguments, arguments);
+}
+
+void taichi_assert_format_in_launch(RuntimeContext *context,
+                                    i32 test,
+                                    const char *format,
+                                    int num_arguments,
+                                    uint64 *arguments) {
+  taichi_assert_format_with_launch_id(context->runtime, context->launch_id,
+                                      test, format, num_arguments, arguments);
+}
+
 void taichi_assert_runtime(LLVMRuntime *runtime, i32 test, const char *msg) {
   taichi_assert_format(runtime, test, msg, 0, nullptr);
 }
@@ -915,6 +1066,7 @@ void runtime_initialize(
   runtime->memory_pool = memory_pool;
 
   runtime->total_requested_memory = 0;
+  runtime->num_error_records = 0;
 
   // runtime->allocate ready to use
   runtime->mem_req_queue = (MemRequestQueue *)runtime->allocate_aligned(
@@ -942,6 +1094,14 @@ void runtime_initialize_snodes(LLVMRuntime *runtime,
   // and the size of the root buffer memory are aligned to page size.
   runtime->root_mem_sizes[snode_tree_id] = rounded_size;
   runtime->roots[snode_tree_id] = ptr;
+  for (int i = root_id; i < root_id + num_snodes; i++) {
+    runtime->activation_changed[i] = 0;
+    runtime->activation_versions[i] = 0;
+    runtime->element_list_stamps[i] = 0;
+    runtime->element_list_reused[i] = 0;
+  }
+  // The root element list below never changes.
+  runtime->element_list_stamps[root_id] = 1;
   // runtime->request_allocate_aligned ready to use
   // initialize the root node element list
   if (all_dense) {
@@ -1071,6 +1231,10 @@ void block_memfence() {
 void grid_memfence() {
 }
 
+void prefetch_read(Ptr ptr) {
+  __builtin_prefetch(ptr, /*rw=*/0, /*locality=*/3);
+}
+
 // these trivial functions are needed by the DEFINE_REDUCTION macro
 i32 op_add_i32(i32 a, i32 b) {
   return a + b;
@@ -1133,8 +1297,40 @@ DEFINE_REDUCTION(xor, i32);
 
 // "Element", "component" are different concepts
 
-void clear_list(LLVMRuntime *runtime, StructMeta *parent, StructMeta *child) {
-  auto child_list = runtime->element_lists[child->snode_id];
+void mark_activation_changed(LLVMRuntime *runtime, int snode_id) {
+  // Most callers find the flag already set, so check it first to avoid
+  // writing to a shared cache line.
+  if (!runtime->activation_changed[snode_id])
+    runtime->activation_changed[snode_id] = 1;
+}
+
+u64 get_activation_version(LLVMRuntime *runtime, int snode_id) {
+  if (runtime->activation_changed[snode_id]) {
+    runtime->activation_changed[snode_id] = 0;
+    runtime->activation_versions[snode_id]++;
+  }
+  return runtime->activation_versions[snode_id];
+}
+
+// The element list of |child| depends on the list of |parent|, the active
+// cells of |parent|, and the size of |child| if it is dynamic. Since versions
+// and stamps only grow, the sum below changes whenever any of them does. If
+// |reuse| is false, the list is always regenerated.
+void clear_list(LLVMRuntime *runtime,
+                StructMeta *parent,
+                StructMeta *child,
+                i32 reuse) {
+  auto child_id = child->snode_id;
+  auto stamp = runtime->element_list_stamps[parent->snode_id] +
+               get_activation_version(runtime, parent->snode_id) +
+               get_activation_version(runtime, child_id);
+  if (reuse && runtime->element_list_stamps[child_id] == stamp) {
+    runtime->element_list_reused[child_id] = 1;
+    return;
+  }
+  runtime->element_list_reused[child_id] = 0;
+  runtime->element_list_stamps[child_id] = stamp;
+  auto child_list = runtime->element_lists[child_id];
   child_list->clear();
 }
 
@@ -1148,6 +1344,8 @@ void clear_list(LLVMRuntime *runtime, StructMeta *parent, StructMeta *child) {
 void element_listgen_root(LLVMRuntime *runtime,
                           StructMeta *parent,
                           StructMeta *child) {
+  if (runtime->element_list_reused[child->snode_id])
+    return;
   // If there's just one element in the parent list, we need to use the blocks
   // (instead of threads) to split the parent container
   auto parent_list = runtime->element_lists[parent->snode_id];
@@ -1197,6 +1395,8 @@ void element_listgen_root(LLVMRuntime *runtime,
 void element_listgen_nonroot(LLVMRuntime *runtime,
                              StructMeta *parent,
                              StructMeta *child) {
+  if (runtime->element_list_reused[child->snode_id])
+    return;
   auto parent_list = runtime->element_lists[parent->snode_id];
   int num_parent_elements = parent_list->size();
   auto child_list = runtime->element_lists[child->snode_id];
@@ -1248,6 +1448,14 @@ void element_listgen_nonroot(LLVMRuntime *runtime,
   }
 }
 
+// The CPU parallel-for helpers store the id of the worker thread right before
+// the TLS buffer of each task, where the task reads it, since all the threads
+// share the RuntimeContext. See CodeGenLLVMCPU::emit_linear_thread_idx().
+char *init_cpu_tls_buffer(char *buffer, int thread_id) {
+  *(i32 *)buffer = thread_id;
+  return buffer + taichi_cpu_thread_id_size;
+}
+
 using BlockTask = void(RuntimeContext *, char *, Element *, int, int);
 
 struct cpu_block_task_helper_context {
@@ -1257,6 +1465,7 @@ struct cpu_block_task_helper_context {
   int element_size;
   int element_split;
   std::size_t tls_buffer_size;
+  int prefetch_bytes;
 };
 
 // TODO: To enforce inlining, we need to create in LLVM a new function that
@@ -1275,13 +1484,23 @@ void cpu_struct_for_block_helper(void *ctx_, int thread_id, int i) {
   int lower = e.loop_bounds[0] + part_id * part_size;
   int upper = e.loop_bounds[0] + (part_id + 1) * part_size;
   upper = std::min(upper, e.loop_bounds[1]);
-  alignas(8) char tls_buffer[ctx->tls_buffer_size];
+  alignas(8) char tls_buffer[taichi_cpu_thread_id_size + ctx->tls_buffer_size];
+  auto tls_ptr = init_cpu_tls_buffer(tls_buffer, thread_id);
+
+  // Blocks are handed out in order, so the next element is about to be
+  // processed by another thread. Fetch its data into the shared cache levels
+  // while this one is being processed.
+  if (ctx->prefetch_bytes > 0 && part_id == 0 &&
+      element_id + 1 < ctx->list->size()) {
+    auto next = ctx->list->get<Element>(element_id + 1).element;
+    for (int offset = 0; offset < ctx->prefetch_bytes; offset += 64) {
+      __builtin_prefetch(next + offset, /*rw=*/0, /*locality=*/1);
+    }
+  }
 
-  RuntimeContext this_thread_context = *ctx->context;
-  this_thread_context.cpu_thread_id = thread_id;
   if (lower < upper) {
-    (*ctx->task)(&this_thread_context, tls_buffer,
-                 &ctx->list->get<Element>(element_id), lower, upper);
+    (*ctx->task)(ctx->context, tls_ptr, &ctx->list->get<Element>(element_id),
+                 lower, upper);
   }
 }
 
@@ -1291,7 +1510,8 @@ void parallel_struct_for(RuntimeContext *context,
                          int element_split,
                          BlockTask *task,
                          std::size_t tls_buffer_size,
-                         int num_threads) {
+                         int num_threads,
+                         int prefetch_bytes) {
   auto list = (context->runtime)->element_lists[snode_id];
   auto list_tail = list->size();
 #if ARCH_cuda
@@ -1323,6 +1543,7 @@ void parallel_struct_for(RuntimeContext *context,
   ctx.element_size = element_size;
   ctx.element_split = element_split;
   ctx.tls_buffer_size = tls_buffer_size;
+  ctx.prefetch_bytes = prefetch_bytes;
   auto runtime = context->runtime;
   runtime->parallel_for(runtime->thread_pool, list_tail * element_split,
                         num_threads, &ctx, cpu_struct_for_block_helper);
@@ -1338,6 +1559,8 @@ struct range_task_helper_context {
   RuntimeContext *context;
   range_for_xlogue prologue{nullptr};
   RangeForTaskFunc *body{nullptr};
+  // If set, called once per block instead of calling |body| per index.
+  RangeForChunkFunc *chunk_body{nullptr};
   range_for_xlogue epilogue{nullptr};
   std::size_t tls_size{1};
   int begin;
@@ -1349,31 +1572,53 @@ struct range_task_helper_context {
 void cpu_parallel_range_for_task(void *range_context,
                                  int thread_id,
                                  int task_id) {
-  auto ctx = *(range_task_helper_context *)range_context;
-  alignas(8) char tls_buffer[ctx.tls_size];
-  auto tls_ptr = &tls_buffer[0];
+  const auto &ctx = *(range_task_helper_context *)range_context;
+  alignas(8) char tls_buffer[taichi_cpu_thread_id_size + ctx.tls_size];
+  auto tls_ptr = init_cpu_tls_buffer(tls_buffer, thread_id);
   if (ctx.prologue)
     ctx.prologue(ctx.context, tls_ptr);
 
-  RuntimeContext this_thread_context = *ctx.context;
-  this_thread_context.cpu_thread_id = thread_id;
   if (ctx.step == 1) {
     int block_start = ctx.begin + task_id * ctx.block_size;
     int block_end = std::min(block_start + ctx.block_size, ctx.end);
-    for (int i = block_start; i < block_end; i++) {
-      ctx.body(&this_thread_context, tls_ptr, i);
+    if (ctx.chunk_body) {
+      ctx.chunk_body(ctx.context, tls_ptr, block_start, block_end);
+    } else {
+      for (int i = block_start; i < block_end; i++) {
+        ctx.body(ctx.context, tls_ptr, i);
+      }
     }
   } else if (ctx.step == -1) {
     int block_start = ctx.end - task_id * ctx.block_size;
     int block_end = std::max(ctx.begin, block_start * ctx.block_size);
     for (int i = block_start - 1; i >= block_end; i--) {
-      ctx.body(&this_thread_context, tls_ptr, i);
+      ctx.body(ctx.context, tls_ptr, i);
     }
   }
   if (ctx.epilogue)
     ctx.epilogue(ctx.context, tls_ptr);
 }
 
+void launch_cpu_range_for_tasks(range_task_helper_context &ctx,
+                                int num_threads,
+                                int block_dim,
+                                int granularity) {
+  if (block_dim == 0) {
+    // adaptive block dim
+    auto num_items = (ctx.end - ctx.begin) / std::abs(ctx.step);
+    // ensure each thread has at least ~32 tasks for load balancing
+    // and each task has at least 512 items to amortize scheduler overhead
+    block_dim = std::min(512, std::max(1, num_items / (num_threads * 32)));
+  }
+  // Only the last block of the range may be partially filled.
+  block_dim = (block_dim + granularity - 1) / granularity * granularity;
+  ctx.block_size = block_dim;
+  auto runtime = ctx.context->runtime;
+  runtime->parallel_for(runtime->thread_pool,
+                        (ctx.end - ctx.begin + block_dim - 1) / block_dim,
+                        num_threads, &ctx, cpu_parallel_range_for_task);
+}
+
 void cpu_parallel_range_for(RuntimeContext *context,
                             int num_threads,
                             int begin,
@@ -1397,18 +1642,33 @@ void cpu_parallel_range_for(RuntimeContext *context,
     taichi_printf(context->runtime, "step must not be %d\n", step);
     exit(-1);
   }
-  if (block_dim == 0) {
-    // adaptive block dim
-    auto num_items = (ctx.end - ctx.begin) / std::abs(step);
-    // ensure each thread has at least ~32 tasks for load balancing
-    // and each task has at least 512 items to amortize scheduler overhead
-    block_dim = std::min(512, std::max(1, num_items / (num_threads * 32)));
-  }
-  ctx.block_size = block_dim;
-  auto runtime = context->runtime;
-  runtime->parallel_for(runtime->thread_pool,
-                        (end - begin + block_dim - 1) / block_dim, num_threads,
-                        &ctx, cpu_parallel_range_for_task);
+  launch_cpu_range_for_tasks(ctx, num_threads, block_dim, 1);
+}
+
+// Like cpu_parallel_range_for with step 1, but |body| runs a whole block of
+// indices, so that it can be vectorized with |vector_width| lanes. Blocks are
+// rounded up to a multiple of |vector_width|.
+void cpu_parallel_range_for_chunked(RuntimeContext *context,
+                                    int num_threads,
+                                    int begin,
+                                    int end,
+                                    int block_dim,
+                                    range_for_xlogue prologue,
+                                    RangeForChunkFunc *body,
+                                    range_for_xlogue epilogue,
+                                    std::size_t tls_size,
+                                    int vector_width) {
+  range_task_helper_context ctx;
+  ctx.context = context;
+  ctx.prologue = prologue;
+  ctx.tls_size = tls_size;
+  ctx.chunk_body = body;
+  ctx.epilogue = epilogue;
+  ctx.begin = begin;
+  ctx.end = end;
+  ctx.step = 1;
+  launch_cpu_range_for_tasks(ctx, num_threads, block_dim,
+                             std::max(1, vector_width));
 }
 
 void gpu_parallel_range_for(RuntimeContext *context,
@@ -1444,12 +1704,9 @@ struct mesh_task_helper_context {
 void cpu_parallel_mesh_for_task(void *range_context,
                                 int thread_id,
                                 int task_id) {
-  auto ctx = *(mesh_task_helper_context *)range_context;
-  alignas(8) char tls_buffer[ctx.tls_size];
-  auto tls_ptr = &tls_buffer[0];
-
-  RuntimeContext this_thread_context = *ctx.context;
-  this_thread_context.cpu_thread_id = thread_id;
+  const auto &ctx = *(mesh_task_helper_context *)range_context;
+  alignas(8) char tls_buffer[taichi_cpu_thread_id_size + ctx.tls_size];
+  auto tls_ptr = init_cpu_tls_buffer(tls_buffer, thread_id);
 
   int block_start = task_id * ctx.block_size;
   int block_end = std::min(block_start + ctx.block_size, ctx.num_patches);
@@ -1457,7 +1714,7 @@ void cpu_parallel_mesh_for_task(void *range_context,
   for (int idx = block_start; idx < block_end; idx++) {
     if (ctx.prologue)
       ctx.prologue(ctx.context, tls_ptr, idx);
-    ctx.body(&this_thread_context, tls_ptr, idx);
+    ctx.body(ctx.context, tls_ptr, idx);
     if (ctx.epilogue)
       ctx.epilogue(ctx.context, tls_ptr, idx);
   }
@@ -1512,7 +1769,9 @@ i32 linear_thread_idx(RuntimeContext *context) {
 #if ARCH_cuda
   return block_idx() * block_dim() + thread_idx();
 #else
-  return context->cpu_thread_id;
+  // CPU code reads the id from its TLS buffer instead, see
+  // init_cpu_tls_buffer().
+  return 0;
 #endif
 }
 
@@ -1638,9 +1897,10 @@ void gc_parallel_2(RuntimeContext *context, int snode_id) {
 
 extern "C" {
 
-u32 rand_u32(RuntimeContext *context) {
-  auto state = &((LLVMRuntime *)context->runtime)
-                    ->rand_states[linear_thread_idx(context)];
+// |thread_idx| is the linear_thread_idx() of the caller, which the code
+// generators compute.
+u32 rand_u32(RuntimeContext *context, i32 thread_idx) {
+  auto state = &((LLVMRuntime *)context->runtime)->rand_states[thread_idx];
 
   auto &x = state->x;
   auto &y = state->y;
@@ -1657,24 +1917,25 @@ u32 rand_u32(RuntimeContext *context) {
                           // it decorrelates streams of PRNGs.
 }
 
-uint64 rand_u64(RuntimeContext *context) {
-  return ((u64)rand_u32(context) << 32) + rand_u32(context);
+uint64 rand_u64(RuntimeContext *context, i32 thread_idx) {
+  return ((u64)rand_u32(context, thread_idx) << 32) +
+         rand_u32(context, thread_idx);
 }
 
-f32 rand_f32(RuntimeContext *context) {
-  return rand_u32(context) * (1.0f / 4294967296.0f);
+f32 rand_f32(RuntimeContext *context, i32 thread_idx) {
+  return rand_u32(context, thread_idx) * (1.0f / 4294967296.0f);
 }
 
-f64 rand_f64(RuntimeContext *context) {
-  return rand_u64(context) * (1.0 / 18446744073709551616.0);
+f64 rand_f64(RuntimeContext *context, i32 thread_idx) {
+  return rand_u64(context, thread_idx) * (1.0 / 18446744073709551616.0);
 }
 
-i32 rand_i32(RuntimeContext *context) {
-  return rand_u32(context);
+i32 rand_i32(RuntimeContext *context, i32 thread_idx) {
+  return rand_u32(context, thread_idx);
 }
 
-i64 rand_i64(RuntimeContext *context) {
-  return rand_u64(context);
+i64 rand_i64(RuntimeContext *context, i32 thread_idx) {
+  return rand_u64(context, thread_idx);
 }
 };
 
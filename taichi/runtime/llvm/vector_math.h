@@ -0,0 +1,316 @@
+#pragma once
+
+// Vector versions of the math functions in runtime.cpp, for loops vectorized
+// on CPUs. The approximations follow SLEEF: Cody-Waite argument reduction and
+// polynomials evaluated with the generic vector types of clang, so that each
+// variant lowers to SIMD instructions of its width. With |fast|, lower-degree
+// polynomials are used.
+//
+// Lanes that the vector code does not cover accurately, e.g. huge arguments
+// of sin and cos, fall back to the scalar function.
+
+#include <cmath>
+#include <cstdint>
+
+namespace vector_math {
+
+template <typename T>
+struct FloatBits;
+
+template <>
+struct FloatBits<float> {
+  using Int = int32_t;
+  static constexpr int kMantissaBits = 23;
+  static constexpr Int kExponentMask = 0xff;
+  static constexpr Int kBias = 127;
+  static constexpr Int kSignMask = INT32_MIN;
+  // Adding and subtracting it rounds to an integer.
+  static constexpr float kRoundingMagic = 12582912.0f;  // 1.5 * 2^23
+};
+
+template <>
+struct FloatBits<double> {
+  using Int = int64_t;
+  static constexpr int kMantissaBits = 52;
+  static constexpr Int kExponentMask = 0x7ff;
+  static constexpr Int kBias = 1023;
+  static constexpr Int kSignMask = INT64_MIN;
+  static constexpr double kRoundingMagic = 6755399441055744.0;  // 1.5 * 2^52
+};
+
+template <typename T>
+struct Constants;
+
+template <>
+struct Constants<float> {
+  // ln(2) and pi split so that multiples by small integers are exact.
+  static constexpr float kLn2Hi = 0.693145751953125f;
+  static constexpr float kLn2Lo = 1.428606765330187045e-06f;
+  static constexpr float kPiA = 3.140625f;
+  static constexpr float kPiB = 0.0009670257568359375f;
+  static constexpr float kPiC = 6.2771141529083251953e-07f;
+  static constexpr float kPiD = 1.2154201256553420762e-10f;
+  static constexpr float kExpMax = 88.72283935546875f;
+  static constexpr float kExpMin = -104.0f;
+  static constexpr float kMinNormal = 1.17549435e-38f;
+  static constexpr float kSubnormalScale = 18446744073709551616.0f;  // 2^64
+  static constexpr int kSubnormalExponent = 64;
+  static constexpr float kTrigMax = 8192.0f;
+};
+
+template <>
+struct Constants<double> {
+  static constexpr double kLn2Hi = .69314718055966295651160180568695068359375;
+  static constexpr double kLn2Lo =
+      .28235290563031577122588448175013436025525412068e-12;
+  static constexpr double kPiA = 3.1415926218032836914;
+  static constexpr double kPiB = 3.1786509424591713469e-08;
+  static constexpr double kPiC = 1.2246467864107188502e-16;
+  static constexpr double kPiD = 1.2736634327021899816e-24;
+  static constexpr double kExpMax = 709.782712893383973096;
+  static constexpr double kExpMin = -746.0;
+  static constexpr double kMinNormal = 2.2250738585072014e-308;
+  static constexpr double kSubnormalScale = 18446744073709551616.0;  // 2^64
+  static constexpr int kSubnormalExponent = 64;
+  static constexpr double kTrigMax = 1e8;
+};
+
+// Coefficients of the polynomials, highest degree first.
+template <typename T, bool fast>
+struct Coefficients;
+
+template <>
+struct Coefficients<float, false> {
+  // (e^s - 1 - s) / s^2 on [-ln(2)/2, ln(2)/2]
+  static constexpr float kExp[] = {
+      0.000198527617612853646278381f, 0.00139304355252534151077271f,
+      0.00833336077630519866943359f, 0.0416664853692054748535156f,
+      0.166666671633720397949219f, 0.5f};
+  // (atanh(t) - t) / t^3 on [-0.2, 0.2]
+  static constexpr float kLog[] = {1 / 9.0f, 1 / 7.0f, 1 / 5.0f, 1 / 3.0f};
+  // (sin(d) - d) / d^3 on [-pi/2, pi/2]
+  static constexpr float kSin[] = {
+      2.6083159809786593541503e-06f, -0.0001981069071916863322258f,
+      0.00833307858556509017944336f, -0.166666597127914428710938f};
+};
+
+template <>
+struct Coefficients<float, true> : Coefficients<float, false> {
+  static constexpr float kExp[] = {1 / 720.0f, 1 / 120.0f, 1 / 24.0f,
+                                   1 / 6.0f, 0.5f};
+  static constexpr float kLog[] = {1 / 7.0f, 1 / 5.0f, 1 / 3.0f};
+};
+
+template <>
+struct Coefficients<double, false> {
+  static constexpr double kExp[] = {
+      2.08860621107283687536341e-09, 2.51112930892876518610661e-08,
+      2.75573911234900471893338e-07, 2.75572362911928827629423e-06,
+      2.4801587159235472998791e-05,  0.000198412698960509205564975,
+      0.00138888888889774492207962,  0.00833333333331652721664984,
+      0.0416666666666665047591422,   0.166666666666666851703837,
+      0.5};
+  static constexpr double kLog[] = {
+      1 / 23.0, 1 / 21.0, 1 / 19.0, 1 / 17.0, 1 / 15.0, 1 / 13.0,
+      1 / 11.0, 1 / 9.0,  1 / 7.0,  1 / 5.0,  1 / 3.0};
+  static constexpr double kSin[] = {
+      -7.97255955009037868891952e-18, 2.81009972710863200091251e-15,
+      -7.64712219118158833288484e-13, 1.60590430605664501629054e-10,
+      -2.50521083763502045810755e-08, 2.75573192239198747630416e-06,
+      -0.000198412698412696162806809, 0.00833333333333332974823815,
+      -0.166666666666666657414808};
+};
+
+template <>
+struct Coefficients<double, true> : Coefficients<double, false> {
+  static constexpr double kLog[] = {1 / 19.0, 1 / 17.0, 1 / 15.0, 1 / 13.0,
+                                    1 / 11.0, 1 / 9.0,  1 / 7.0,  1 / 5.0,
+                                    1 / 3.0};
+};
+
+template <typename T, int N, bool fast = false>
+struct VectorMath {
+  using Int = typename FloatBits<T>::Int;
+  typedef T V __attribute__((vector_size(sizeof(T) * N)));
+  typedef Int I __attribute__((vector_size(sizeof(T) * N)));
+  using Bits = FloatBits<T>;
+  using C = Constants<T>;
+  using P = Coefficients<T, fast>;
+
+  static V splat(T x) {
+    return V{} + x;
+  }
+
+  // Lanes of |mask| are all ones or all zeros.
+  static V select(I mask, V a, V b) {
+    return (V)((mask & (I)a) | (~mask & (I)b));
+  }
+
+  // Rounds to the nearest integer, for |x| < 2^(kMantissaBits - 1).
+  static V round(V x) {
+    return (x + Bits::kRoundingMagic) - Bits::kRoundingMagic;
+  }
+
+  static I to_int(V x) {
+    return __builtin_convertvector(x, I);
+  }
+
+  static V to_float(I x) {
+    return __builtin_convertvector(x, V);
+  }
+
+  static V abs(V x) {
+    return (V)((I)x & ~Bits::kSignMask);
+  }
+
+  // 2^e for normal results.
+  static V pow2i(I e) {
+    return (V)((e + Bits::kBias) << Bits::kMantissaBits);
+  }
+
+  // x * 2^e, split so that neither factor overflows.
+  static V ldexp(V x, I e) {
+    I half = e >> 1;
+    return x * pow2i(half) * pow2i(e - half);
+  }
+
+  template <int K>
+  static V polynomial(V x, const T (&coefficients)[K]) {
+    V u = splat(coefficients[0]);
+    for (int i = 1; i < K; i++) {
+      u = u * x + coefficients[i];
+    }
+    return u;
+  }
+
+  static V exp(V x) {
+    I in_range = (x == x) & (x <= C::kExpMax) & (x >= C::kExpMin);
+    // Keep converted values defined in lanes that are fixed up below.
+    V xr = select(in_range, x, splat(0));
+    V q = round(xr * (T)1.442695040888963407359924681001892137);
+    V s = xr - q * C::kLn2Hi - q * C::kLn2Lo;
+    V u = polynomial(s, P::kExp);
+    u = s * s * u + s + 1;
+    V result = ldexp(u, to_int(q));
+    result = select(x > C::kExpMax, splat(__builtin_inf()), result);
+    result = select(x < C::kExpMin, splat(0), result);
+    return select(x == x, result, x);
+  }
+
+  static V log(V x) {
+    I subnormal = x < C::kMinNormal;
+    V xs = select(subnormal, x * C::kSubnormalScale, x);
+    // e = ilogb(x * 4 / 3), so that m = x / 2^e is in [0.75, 1.5).
+    I e = (((I)(xs * (T)(1 / 0.75)) >> Bits::kMantissaBits) &
+           Bits::kExponentMask) -
+          Bits::kBias;
+    V m = (V)((I)xs - (e << Bits::kMantissaBits));
+    e = e - (subnormal & C::kSubnormalExponent);
+    V ef = to_float(e);
+    V t = (m - 1) / (m + 1);
+    V t2 = t * t;
+    V u = polynomial(t2, P::kLog);
+    V result = ef * C::kLn2Hi + (2 * t + (ef * C::kLn2Lo + 2 * t * t2 * u));
+    result = select(x == __builtin_inf(), splat(__builtin_inf()), result);
+    result = select((x < 0) | (x != x), splat(__builtin_nan("")), result);
+    return select(x == 0, splat(-__builtin_inf()), result);
+  }
+
+  // Recomputes the lanes of |result| where |mask| is set with the scalar
+  // function |f|.
+  template <typename F>
+  static V fix_lanes(I mask, V x, V result, F f) {
+    bool any = false;
+    for (int i = 0; i < N; i++) {
+      any |= mask[i] != 0;
+    }
+    if (any) {
+      for (int i = 0; i < N; i++) {
+        if (mask[i]) {
+          result[i] = f(x[i]);
+        }
+      }
+    }
+    return result;
+  }
+
+  static V sin(V x) {
+    I reducible = abs(x) <= C::kTrigMax;
+    V xr = select(reducible, x, splat(0));
+    // sin(x) = sin(d) * (-1)^q, where d = x - q * pi is in [-pi/2, pi/2].
+    V q = round(xr * (T)0.318309886183790671537767526745028724);
+    V d = xr - q * C::kPiA - q * C::kPiB - q * C::kPiC - q * C::kPiD;
+    I odd = (to_int(q) & 1) != 0;
+    d = (V)((I)d ^ (odd & Bits::kSignMask));
+    V s = d * d;
+    V u = polynomial(s, P::kSin);
+    return fix_lanes(~reducible, x, d + d * s * u,
+                     [](T a) { return std::sin(a); });
+  }
+
+  static V cos(V x) {
+    I reducible = abs(x) <= C::kTrigMax;
+    V xr = select(reducible, x, splat(0));
+    // cos(x) = sin(d) * (-1)^(q + 1), where d = x - (q + 1/2) * pi.
+    V q = round(xr * (T)0.318309886183790671537767526745028724 - (T)0.5);
+    V q2 = q * 2 + 1;
+    V d = xr - q2 * (C::kPiA * (T)0.5) - q2 * (C::kPiB * (T)0.5) -
+          q2 * (C::kPiC * (T)0.5) - q2 * (C::kPiD * (T)0.5);
+    I even = (to_int(q) & 1) == 0;
+    d = (V)((I)d ^ (even & Bits::kSignMask));
+    V s = d * d;
+    V u = polynomial(s, P::kSin);
+    return fix_lanes(~reducible, x, d + d * s * u,
+                     [](T a) { return std::cos(a); });
+  }
+};
+
+// pow and tanh in f32 are evaluated with f64 lanes, where the error
+// amplification of exp(y * log(x)) and the cancellation in tanh do not
+// show in the rounded result.
+template <int N, bool fast = false>
+struct VectorMathF32 {
+  using F = VectorMath<float, N, fast>;
+  using D = VectorMath<double, N>;
+  using V = typename F::V;
+  using I = typename F::I;
+  using DV = typename D::V;
+
+  static V pow(V x, V y) {
+    I regular = (x > 0) & (x < __builtin_inff()) &
+                            (F::abs(y) < __builtin_inff());
+    // Zeros, negative bases and non-finite operands go to std::pow.
+    DV xd =
+        __builtin_convertvector(F::select(regular, x, F::splat(1)), DV);
+    DV yd = __builtin_convertvector(y, DV);
+    V result = __builtin_convertvector(D::exp(yd * D::log(xd)), V);
+    bool any = false;
+    for (int i = 0; i < N; i++) {
+      any |= regular[i] == 0;
+    }
+    if (any) {
+      for (int i = 0; i < N; i++) {
+        if (!regular[i]) {
+          result[i] = std::pow(x[i], y[i]);
+        }
+      }
+    }
+    return result;
+  }
+
+  static V tanh(V x) {
+    DV xd = __builtin_convertvector(x, DV);
+    // tanh(x) rounds to +-1 in f32 beyond |x| = 9.
+    xd = D::select(xd > 9, D::splat(9), xd);
+    xd = D::select(xd < -9, D::splat(-9), xd);
+    DV e = D::exp(xd * 2);
+    DV result = (e - 1) / (e + 1);
+    // Avoid the cancellation in e - 1 for small |x|.
+    DV x2 = xd * xd;
+    DV series = xd * (1 + x2 * (x2 * (2 / 15.0) - 1 / 3.0));
+    result = D::select(D::abs(xd) < 0x1p-6, series, result);
+    return __builtin_convertvector(result, V);
+  }
+};
+
+}  // namespace vector_math
@@ -12,6 +12,11 @@
 
 TI_NAMESPACE_BEGIN
 
+namespace {
+thread_local bool is_worker = false;
+thread_local int current_thread_id = 0;
+}  // namespace
+
 bool test_threading() {
   auto tp = ThreadPool(20);
   for (int j = 0; j < 100; j++) {
@@ -45,6 +50,14 @@ void ThreadPool::run(int splits,
                      int desired_num_threads,
                      void *range_for_task_context,
                      RangeForTaskFunc *func) {
+  if (is_worker) {
+    // A task running on a worker, e.g., one of several concurrent tasks, runs
+    // its nested parallel-for on the same thread.
+    for (int i = 0; i < splits; i++) {
+      func(range_for_task_context, current_thread_id, i);
+    }
+    return;
+  }
   {
     std::lock_guard _(mutex);
     this->range_for_task_context = range_for_task_context;
@@ -76,6 +89,8 @@ void ThreadPool::target() {
     std::lock_guard<std::mutex> lock(mutex);
     thread_id = thread_counter++;
   }
+  is_worker = true;
+  current_thread_id = thread_id;
   while (true) {
     {
       std::unique_lock<std::mutex> lock(mutex);
@@ -2,6 +2,7 @@
 #include "taichi/ir/control_flow_graph.h"
 #include "taichi/ir/transforms.h"
 #include "taichi/ir/analysis.h"
+#include "taichi/ir/pass.h"
 #include "taichi/system/profiler.h"
 
 TLANG_NAMESPACE_BEGIN
@@ -11,9 +12,17 @@ bool cfg_optimization(
     IRNode *root,
     bool after_lower_access,
     const std::optional<ControlFlowGraph::LiveVarAnalysisConfig>
-        &lva_config_opt) {
+        &lva_config_opt,
+    AnalysisManager *amgr) {
   TI_AUTO_PROF;
-  auto cfg = analysis::build_cfg(root);
+  std::unique_ptr<ControlFlowGraph> cfg;
+  if (amgr) {
+    if (auto *cached = amgr->get_cached_analysis<BuildCFGPass>())
+      cfg = std::move(cached->cfg);
+    amgr->invalidate<BuildCFGPass>();
+  }
+  if (!cfg)
+    cfg = analysis::build_cfg(root);
   bool result_modified = false;
   while (true) {
     bool modified = false;
@@ -28,7 +37,10 @@ bool cfg_optimization(
       break;
   }
   // TODO: implement cfg->dead_instruction_elimination()
-  die(root);  // remove unused allocas
+  bool cfg_valid = !die(root);  // remove unused allocas
+  // The optimizations above keep the CFG up to date, but die() does not.
+  if (cfg_valid && amgr)
+    amgr->cache_analysis<BuildCFGPass>({std::move(cfg)});
   return result_modified;
 }
 }  // namespace irpass
@@ -1,4 +1,5 @@
 #include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
 #include "taichi/ir/statements.h"
 #include "taichi/ir/transforms.h"
 #include "taichi/ir/visitors.h"
@@ -49,6 +50,7 @@ class CheckOutOfBound : public BasicStmtVisitor {
     auto zero = new_stmts.push_back<ConstStmt>(LaneAttribute<TypedConstant>(0));
     Stmt *result =
         new_stmts.push_back<ConstStmt>(LaneAttribute<TypedConstant>(true));
+    bool all_in_bounds = true;
 
     std::string msg =
         fmt::format("(kernel={}) Accessing field ({}) of size (", kernel_name,
@@ -61,19 +63,25 @@ class CheckOutOfBound : public BasicStmtVisitor {
       // Note that during lower_ast, index arguments to GlobalPtrStmt are
       // already converted to [0, +inf) range.
 
-      auto lower_bound = zero;
-      auto check_lower_bound = new_stmts.push_back<BinaryOpStmt>(
-          BinaryOpType::cmp_ge, stmt->indices[i], lower_bound);
       int size_i = snode->shape_along_axis(i);
-      int upper_bound_i = size_i;
-      auto upper_bound = new_stmts.push_back<ConstStmt>(
-          LaneAttribute<TypedConstant>(upper_bound_i));
-      auto check_upper_bound = new_stmts.push_back<BinaryOpStmt>(
-          BinaryOpType::cmp_lt, stmt->indices[i], upper_bound);
-      auto check_i = new_stmts.push_back<BinaryOpStmt>(
-          BinaryOpType::bit_and, check_lower_bound, check_upper_bound);
-      result = new_stmts.push_back<BinaryOpStmt>(BinaryOpType::bit_and, result,
-                                                 check_i);
+      // Skip indices that are known to be in bounds, e.g., loop indices.
+      if (stmt->indices[i]->width() != 1 ||
+          !irpass::analysis::value_range(stmt->indices[i])
+               .within(0, size_i - 1)) {
+        all_in_bounds = false;
+        auto lower_bound = zero;
+        auto check_lower_bound = new_stmts.push_back<BinaryOpStmt>(
+            BinaryOpType::cmp_ge, stmt->indices[i], lower_bound);
+        int upper_bound_i = size_i;
+        auto upper_bound = new_stmts.push_back<ConstStmt>(
+            LaneAttribute<TypedConstant>(upper_bound_i));
+        auto check_upper_bound = new_stmts.push_back<BinaryOpStmt>(
+            BinaryOpType::cmp_lt, stmt->indices[i], upper_bound);
+        auto check_i = new_stmts.push_back<BinaryOpStmt>(
+            BinaryOpType::bit_and, check_lower_bound, check_upper_bound);
+        result = new_stmts.push_back<BinaryOpStmt>(BinaryOpType::bit_and,
+                                                   result, check_i);
+      }
       if (i > 0) {
         msg += ", ";
         offset_msg += ", ";
@@ -99,9 +107,11 @@ class CheckOutOfBound : public BasicStmtVisitor {
     }
     msg += ")";
 
+    set_done(stmt);
+    if (all_in_bounds)
+      return;
     new_stmts.push_back<AssertStmt>(result, msg, args);
     modifier.insert_before(stmt, std::move(new_stmts));
-    set_done(stmt);
   }
 
   static bool run(IRNode *node,
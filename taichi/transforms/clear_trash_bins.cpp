@@ -0,0 +1,37 @@
+#include "taichi/ir/ir.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+// This pass frees all erased statements that are still kept alive in
+// Block::trash_bin, so that their memory can be reused by the IR arena.
+class ClearTrashBins : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  ClearTrashBins() {
+    allow_undefined_visitor = true;
+    invoke_default_visitor = false;
+  }
+
+  void visit(Block *block) override {
+    block->clear_trash_bin();
+    BasicStmtVisitor::visit(block);
+  }
+
+  static void run(IRNode *node) {
+    ClearTrashBins instance;
+    node->accept(&instance);
+  }
+};
+
+namespace irpass {
+void clear_trash_bins(IRNode *root) {
+  TI_AUTO_PROF;
+  ClearTrashBins::run(root);
+}
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
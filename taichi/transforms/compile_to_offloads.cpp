@@ -41,28 +41,41 @@ void compile_to_offloads(IRNode *ir,
   auto print = make_pass_printer(verbose, kernel->get_name(), ir);
   print("Initial IR");
 
+  PassInstrumentation instrumentation(
+      /*track_ir_delta=*/config.print_pass_stats);
+  AnalysisManager amgr(&instrumentation);
+  // Runs a pass that may modify the IR without reporting it.
+  auto run = [&](const PassID &id, const std::function<void()> &pass) {
+    amgr.run_transform(ir, id, [&]() {
+      pass();
+      return true;
+    });
+  };
+
   if (grad) {
-    irpass::reverse_segments(ir);
+    run("reverse_segments", [&]() { irpass::reverse_segments(ir); });
     print("Segment reversed (for autodiff)");
   }
 
   if (start_from_ast) {
-    irpass::frontend_type_check(ir);
-    irpass::lower_ast(ir);
+    run("frontend_type_check", [&]() { irpass::frontend_type_check(ir); });
+    run("lower_ast", [&]() { irpass::lower_ast(ir); });
     print("Lowered");
   }
 
-  irpass::type_check(ir, config);
+  run("type_check", [&]() { irpass::type_check(ir, config); });
   print("Typechecked");
   irpass::analysis::verify(ir);
 
   if (kernel->is_evaluator) {
     TI_ASSERT(!grad);
 
-    irpass::demote_operations(ir, config);
+    amgr.run_transform(ir, "demote_operations", [&]() {
+      return irpass::demote_operations(ir, config);
+    });
     print("Operations demoted");
 
-    irpass::offload(ir, config);
+    run("offload", [&]() { irpass::offload(ir, config); });
     print("Offloaded");
     irpass::analysis::verify(ir);
     return;
@@ -71,17 +84,21 @@ void compile_to_offloads(IRNode *ir,
   // TODO: strictly enforce bit vectorization for x86 cpu and CUDA now
   //       create a separate CompileConfig flag for the new pass
   if (arch_is_cpu(config.arch) || config.arch == Arch::cuda) {
-    irpass::bit_loop_vectorize(ir);
-    irpass::type_check(ir, config);
+    run("bit_loop_vectorize", [&]() {
+      irpass::bit_loop_vectorize(ir);
+      irpass::type_check(ir, config);
+    });
     print("Bit Loop Vectorized");
     irpass::analysis::verify(ir);
   }
 
-  irpass::full_simplify(ir, config, {false, kernel->program});
+  irpass::full_simplify(ir, config, {false, kernel->program, &amgr});
   print("Simplified I");
   irpass::analysis::verify(ir);
 
-  if (irpass::inlining(ir, config, {})) {
+  if (amgr.run_transform(ir, "inlining", [&]() {
+        return irpass::inlining(ir, config, {});
+      })) {
     print("Functions inlined");
     irpass::analysis::verify(ir);
   }
@@ -92,47 +109,76 @@ void compile_to_offloads(IRNode *ir,
 
   if (grad) {
     // Remove local atomics here so that we don't have to handle their gradients
-    irpass::demote_atomics(ir, config);
+    amgr.run_transform(ir, "demote_atomics",
+                       [&]() { return irpass::demote_atomics(ir, config); });
 
-    irpass::full_simplify(ir, config, {false, kernel->program});
-    irpass::auto_diff(ir, config, ad_use_stack);
-    irpass::full_simplify(ir, config, {false, kernel->program});
+    irpass::full_simplify(ir, config, {false, kernel->program, &amgr});
+    run("auto_diff", [&]() { irpass::auto_diff(ir, config, ad_use_stack); });
+    irpass::full_simplify(ir, config, {false, kernel->program, &amgr});
     print("Gradient");
     irpass::analysis::verify(ir);
   }
 
   if (config.check_out_of_bound) {
-    irpass::check_out_of_bound(ir, config, {kernel->get_name()});
+    amgr.run_transform(ir, "check_out_of_bound", [&]() {
+      return irpass::check_out_of_bound(ir, config, {kernel->get_name()});
+    });
     print("Bound checked");
     irpass::analysis::verify(ir);
   }
 
-  irpass::flag_access(ir);
+  if (config.advanced_optimization &&
+      amgr.run_transform(ir, "narrow_indices", [&]() {
+        return irpass::narrow_indices(ir, config);
+      })) {
+    print("Indices narrowed");
+    irpass::analysis::verify(ir);
+  }
+
+  // Only the activation flags are changed, so the CFG stays valid.
+  amgr.run_transform(
+      ir, "flag_access", [&]() { return irpass::flag_access(ir); },
+      PreservedAnalyses::none().preserve<BuildCFGPass>());
   print("Access flagged I");
   irpass::analysis::verify(ir);
 
-  irpass::full_simplify(ir, config, {false, kernel->program});
+  irpass::full_simplify(ir, config, {false, kernel->program, &amgr});
   print("Simplified II");
   irpass::analysis::verify(ir);
 
-  irpass::offload(ir, config);
+  run("offload", [&]() { irpass::offload(ir, config); });
   print("Offloaded");
   irpass::analysis::verify(ir);
 
   // TODO: This pass may be redundant as cfg_optimization() is already called
   //  in full_simplify().
   if (config.opt_level > 0 && config.cfg_optimization) {
-    irpass::cfg_optimization(ir, false);
+    // Shares the ID with the call in full_simplify(), so that the latter can
+    // be skipped if nothing changes in between.
+    amgr.run_transform(
+        ir, "cfg_optimization",
+        [&]() {
+          return irpass::cfg_optimization(ir, false, std::nullopt, &amgr);
+        },
+        PreservedAnalyses::none().preserve<BuildCFGPass>());
     print("Optimized by CFG");
     irpass::analysis::verify(ir);
   }
 
-  irpass::flag_access(ir);
+  amgr.run_transform(
+      ir, "flag_access", [&]() { return irpass::flag_access(ir); },
+      PreservedAnalyses::none().preserve<BuildCFGPass>());
   print("Access flagged II");
 
-  irpass::full_simplify(ir, config, {false, kernel->program});
+  irpass::full_simplify(ir, config, {false, kernel->program, &amgr});
   print("Simplified III");
   irpass::analysis::verify(ir);
+  irpass::clear_trash_bins(ir);
+
+  if (config.print_pass_stats) {
+    instrumentation.print(
+        fmt::format("[{}] compile_to_offloads", kernel->get_name()));
+  }
 }
 
 void offload_to_executable(IRNode *ir,
@@ -152,7 +198,9 @@ void offload_to_executable(IRNode *ir,
   // For now, putting this after TLS will disable TLS, because it can only
   // handle range-fors at this point.
 
-  auto amgr = std::make_unique<AnalysisManager>();
+  PassInstrumentation instrumentation(
+      /*track_ir_delta=*/config.print_pass_stats);
+  auto amgr = std::make_unique<AnalysisManager>(&instrumentation);
 
   print("Start offload_to_executable");
   irpass::analysis::verify(ir);
@@ -173,6 +221,16 @@ void offload_to_executable(IRNode *ir,
     irpass::analysis::verify(ir);
   }
 
+  if (config.fuse_range_fors && !config.async_mode &&
+      irpass::fuse_range_fors(ir, config)) {
+    print("Range-fors fused");
+    irpass::analysis::verify(ir);
+    // Forward the stores of the first task to the loads of the second one.
+    amgr->invalidate();
+    irpass::full_simplify(ir, config, {false, kernel->program, amgr.get()});
+    print("Simplified after range-for fusion");
+  }
+
   if (is_extension_supported(config.arch, Extension::mesh) &&
       config.demote_no_access_mesh_fors) {
     irpass::demote_no_access_mesh_fors(ir);
@@ -184,6 +242,12 @@ void offload_to_executable(IRNode *ir,
   if (make_thread_local) {
     irpass::make_thread_local(ir, config);
     print("Make thread local");
+
+    if (config.privatize_scatter_adds && arch_is_cpu(config.arch) &&
+        irpass::privatize_scatter_adds(ir, config)) {
+      print("Scatter adds privatized");
+      irpass::analysis::verify(ir);
+    }
   }
 
   if (is_extension_supported(config.arch, Extension::mesh)) {
@@ -192,7 +256,8 @@ void offload_to_executable(IRNode *ir,
     if (config.make_mesh_block_local) {
       irpass::make_mesh_block_local(ir, config, {kernel->get_name()});
       print("Make mesh block local");
-      irpass::full_simplify(ir, config, {false, kernel->program});
+      amgr->invalidate();
+      irpass::full_simplify(ir, config, {false, kernel->program, amgr.get()});
       print("Simplified X");
     }
   }
@@ -223,11 +288,25 @@ void offload_to_executable(IRNode *ir,
   print("Remove loop_unique");
   irpass::analysis::verify(ir);
 
+  if (config.software_prefetch && arch_is_cpu(config.arch) &&
+      lower_global_access) {
+    if (irpass::insert_prefetches(ir, config)) {
+      print("Prefetches inserted");
+      irpass::analysis::verify(ir);
+    }
+  }
+
   if (lower_global_access) {
     irpass::lower_access(ir, config, {kernel->no_activate, true});
     print("Access lowered");
     irpass::analysis::verify(ir);
 
+    if (config.strength_reduce_addresses && !config.debug &&
+        irpass::share_stencil_bases(ir, config)) {
+      print("Stencil bases shared");
+      irpass::analysis::verify(ir);
+    }
+
     irpass::die(ir);
     print("DIE");
     irpass::analysis::verify(ir);
@@ -240,11 +319,13 @@ void offload_to_executable(IRNode *ir,
   irpass::demote_operations(ir, config);
   print("Operations demoted");
 
-  irpass::full_simplify(ir, config, {lower_global_access, kernel->program});
+  amgr->invalidate();
+  irpass::full_simplify(ir, config,
+                        {lower_global_access, kernel->program, amgr.get()});
   print("Simplified IV");
 
   if (determine_ad_stack_size) {
-    irpass::determine_ad_stack_size(ir, config);
+    irpass::determine_ad_stack_size(ir, config, amgr.get());
     print("Autodiff stack size determined");
   }
 
@@ -256,6 +337,23 @@ void offload_to_executable(IRNode *ir,
   // Final field registration correctness & type checking
   irpass::type_check(ir, config);
   irpass::analysis::verify(ir);
+
+  // Vector values are not understood by the passes above, so this must be the
+  // last transform before codegen.
+  if (config.slp_vectorize && arch_is_cpu(config.arch) &&
+      arch_uses_llvm(config.arch) && lower_global_access) {
+    if (irpass::slp_vectorize(ir, config)) {
+      irpass::die(ir);
+      print("SLP vectorized");
+      irpass::analysis::verify(ir);
+    }
+  }
+  irpass::clear_trash_bins(ir);
+
+  if (config.print_pass_stats) {
+    instrumentation.print(
+        fmt::format("[{}] offload_to_executable", kernel->get_name()));
+  }
 }
 
 void compile_to_executable(IRNode *ir,
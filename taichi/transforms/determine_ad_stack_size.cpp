@@ -12,7 +12,9 @@ namespace lang {
 
 namespace irpass {
 
-bool determine_ad_stack_size(IRNode *root, const CompileConfig &config) {
+bool determine_ad_stack_size(IRNode *root,
+                             const CompileConfig &config,
+                             AnalysisManager *amgr) {
   if (irpass::analysis::gather_statements(root, [&](Stmt *s) {
         if (auto ad_stack = s->cast<AdStackAllocaStmt>()) {
           return ad_stack->max_size == 0;  // adaptive
@@ -21,7 +23,17 @@ bool determine_ad_stack_size(IRNode *root, const CompileConfig &config) {
       }).empty()) {
     return false;  // no AD-stacks with adaptive size
   }
-  auto cfg = analysis::build_cfg(root);
+  // Only the sizes of the AD-stacks are changed, so a cached CFG stays valid.
+  std::unique_ptr<ControlFlowGraph> local_cfg;
+  ControlFlowGraph *cfg = nullptr;
+  if (amgr) {
+    if (auto *cached = amgr->get_cached_analysis<BuildCFGPass>())
+      cfg = cached->cfg.get();
+  }
+  if (!cfg) {
+    local_cfg = analysis::build_cfg(root);
+    cfg = local_cfg.get();
+  }
   cfg->simplify_graph();
   cfg->determine_ad_stack_size(config.default_ad_stack_size);
   return true;
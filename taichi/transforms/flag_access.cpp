@@ -1,4 +1,5 @@
 #include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
 #include "taichi/ir/statements.h"
 #include "taichi/ir/transforms.h"
 #include "taichi/ir/visitors.h"
@@ -170,10 +171,21 @@ class WeakenAccess : public BasicStmtVisitor {
 
 namespace irpass {
 
-void flag_access(IRNode *root) {
+bool flag_access(IRNode *root) {
   TI_AUTO_PROF;
+  auto ptrs = analysis::gather_statements(
+      root, [](Stmt *stmt) { return stmt->is<GlobalPtrStmt>(); });
+  std::vector<bool> old_activate;
+  old_activate.reserve(ptrs.size());
+  for (auto ptr : ptrs)
+    old_activate.push_back(ptr->as<GlobalPtrStmt>()->activate);
   FlagAccess flag_access(root);
   WeakenAccess weaken_access(root);
+  for (int i = 0; i < (int)ptrs.size(); i++) {
+    if (ptrs[i]->as<GlobalPtrStmt>()->activate != old_activate[i])
+      return true;
+  }
+  return false;
 }
 
 }  // namespace irpass
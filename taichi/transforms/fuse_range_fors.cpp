@@ -0,0 +1,363 @@
+// Fuse adjacent range-for offloads with the same iteration space
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+using TaskType = OffloadedStmt::TaskType;
+
+constexpr int64 kUnbounded = std::numeric_limits<int64>::max();
+// Keeps products of place values and factors from overflowing int64.
+constexpr int64 kMaxPlaceValue = 1LL << 31;
+
+// Stands for all the external arrays, which may alias each other.
+SNode *const kExternalArrays = nullptr;
+
+// floor(i / low) % (high / low) of a non-negative loop index i. |high| is
+// kUnbounded for floor(i / low).
+struct Digit {
+  int64 low;
+  int64 high;
+};
+
+std::optional<int64> const_int(Stmt *stmt) {
+  auto const_stmt = stmt->cast<ConstStmt>();
+  if (!const_stmt || const_stmt->width() != 1 ||
+      !is_integral(const_stmt->ret_type)) {
+    return std::nullopt;
+  }
+  return const_stmt->val[0].val_as_int64();
+}
+
+std::optional<Digit> digit_of(Stmt *stmt, OffloadedStmt *loop) {
+  if (auto loop_index = stmt->cast<LoopIndexStmt>()) {
+    if (loop_index->loop != loop)
+      return std::nullopt;
+    return Digit{1, kUnbounded};
+  }
+  if (auto unary = stmt->cast<UnaryOpStmt>()) {
+    if (unary->op_type == UnaryOpType::cast_value &&
+        is_integral(unary->cast_type) && data_type_bits(unary->cast_type) >= 32)
+      return digit_of(unary->operand, loop);
+    return std::nullopt;
+  }
+  // |stmt| is floor(input / low_factor) % (high_factor / low_factor).
+  Stmt *input = nullptr;
+  int64 low_factor = 1;
+  int64 high_factor = kUnbounded;
+  if (auto bit_extract = stmt->cast<BitExtractStmt>()) {
+    if (bit_extract->bit_end > 31)
+      return std::nullopt;
+    input = bit_extract->input;
+    low_factor = 1LL << bit_extract->bit_begin;
+    high_factor = 1LL << bit_extract->bit_end;
+  } else if (auto binary = stmt->cast<BinaryOpStmt>()) {
+    auto divisor = const_int(binary->rhs);
+    if (!divisor || *divisor <= 0 || *divisor > kMaxPlaceValue)
+      return std::nullopt;
+    input = binary->lhs;
+    if (binary->op_type == BinaryOpType::mod) {
+      high_factor = *divisor;
+    } else if (binary->op_type == BinaryOpType::div ||
+               binary->op_type == BinaryOpType::floordiv) {
+      low_factor = *divisor;
+    } else {
+      return std::nullopt;
+    }
+  } else {
+    return std::nullopt;
+  }
+  auto digit = digit_of(input, loop);
+  if (!digit)
+    return std::nullopt;
+  if (digit->high != kUnbounded) {
+    // The result is a digit of |input| only if it does not wrap around
+    // within |input|.
+    int64 radix = digit->high / digit->low;
+    int64 factor = high_factor == kUnbounded ? low_factor : high_factor;
+    if (radix % factor != 0)
+      return std::nullopt;
+  }
+  Digit result{digit->low * low_factor,
+               high_factor == kUnbounded ? digit->high
+                                         : digit->low * high_factor};
+  if (result.low > kMaxPlaceValue ||
+      (result.high != kUnbounded && result.high > kMaxPlaceValue)) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+// Decomposes |stmt| into a constant plus a sum of scaled digits of the loop
+// index.
+bool gather_terms(Stmt *stmt,
+                  OffloadedStmt *loop,
+                  int64 scale,
+                  std::vector<std::pair<int64, Digit>> &terms) {
+  if (const_int(stmt))
+    return true;
+  if (auto binary = stmt->cast<BinaryOpStmt>()) {
+    if (binary->op_type == BinaryOpType::add) {
+      return gather_terms(binary->lhs, loop, scale, terms) &&
+             gather_terms(binary->rhs, loop, scale, terms);
+    }
+    if (binary->op_type == BinaryOpType::sub && const_int(binary->rhs))
+      return gather_terms(binary->lhs, loop, scale, terms);
+    if (binary->op_type == BinaryOpType::mul) {
+      auto operand = binary->lhs;
+      auto factor = const_int(binary->rhs);
+      if (!factor) {
+        operand = binary->rhs;
+        factor = const_int(binary->lhs);
+      }
+      if (factor && *factor > 0 && *factor <= kMaxPlaceValue &&
+          scale <= kMaxPlaceValue) {
+        return gather_terms(operand, loop, scale * *factor, terms);
+      }
+    }
+  }
+  auto digit = digit_of(stmt, loop);
+  if (!digit)
+    return false;
+  terms.emplace_back(scale, *digit);
+  return true;
+}
+
+// Returns true if different iterations of |loop| always get different
+// |indices|. This holds if the indices determine enough digits of the loop
+// index, e.g., the coordinates computed by demote_dense_struct_fors.
+bool is_injective(const std::vector<Stmt *> &indices, OffloadedStmt *loop) {
+  if (loop->begin_value < 0)
+    return false;
+  std::vector<Digit> digits;
+  for (auto index : indices) {
+    std::vector<std::pair<int64, Digit>> terms;
+    if (!gather_terms(index, loop, 1, terms))
+      continue;
+    // The index determines its digits only if their scaled ranges do not
+    // overlap.
+    std::sort(terms.begin(), terms.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    bool determined = true;
+    for (int i = 0; i + 1 < (int)terms.size(); i++) {
+      const auto &digit = terms[i].second;
+      if (digit.high == kUnbounded ||
+          terms[i + 1].first / terms[i].first < digit.high / digit.low) {
+        determined = false;
+        break;
+      }
+    }
+    if (!determined)
+      continue;
+    for (auto &term : terms)
+      digits.push_back(term.second);
+  }
+  // i % known is determined by the indices.
+  int64 known = 1;
+  bool progress = true;
+  while (known < loop->end_value && progress) {
+    progress = false;
+    for (auto &digit : digits) {
+      if (known % digit.low == 0 && digit.high > known) {
+        known = digit.high;
+        progress = true;
+      }
+    }
+  }
+  return known >= loop->end_value;
+}
+
+struct Access {
+  Stmt *ptr;
+  bool write;
+};
+
+SNode *physical_snode(SNode *snode) {
+  if (snode->parent && (snode->parent->type == SNodeType::bit_struct ||
+                        snode->parent->type == SNodeType::bit_array)) {
+    return snode->parent;
+  }
+  return snode;
+}
+
+// Returns std::nullopt if |task| cannot be fused with its neighbors.
+std::optional<std::unordered_map<SNode *, std::vector<Access>>>
+gather_accesses(OffloadedStmt *task) {
+  std::unordered_map<SNode *, std::vector<Access>> accesses;
+  bool fusible = true;
+  auto add = [&](Stmt *ptr, bool write) {
+    if (auto global_ptr = ptr->cast<GlobalPtrStmt>()) {
+      if (global_ptr->width() != 1) {
+        fusible = false;
+        return;
+      }
+      auto snode = global_ptr->snodes[0];
+      if (global_ptr->activate && !snode->is_path_all_dense)
+        fusible = false;
+      accesses[physical_snode(snode)].push_back({ptr, write});
+    } else if (ptr->is<ExternalPtrStmt>()) {
+      accesses[kExternalArrays].push_back({ptr, write});
+    } else if (!ptr->is<AllocaStmt>()) {
+      fusible = false;
+    }
+  };
+  irpass::analysis::gather_statements(task->body.get(), [&](Stmt *stmt) {
+    if (stmt->is<GlobalTemporaryStmt>() || stmt->is<SNodeOpStmt>() ||
+        stmt->is<InternalFuncStmt>() || stmt->is<ExternalFuncCallStmt>() ||
+        stmt->is<FuncCallStmt>() || stmt->is<PrintStmt>() ||
+        stmt->is<ReturnStmt>() || stmt->is<SNodeLookupStmt>() ||
+        stmt->is<GetChStmt>()) {
+      fusible = false;
+    } else if (auto cont = stmt->cast<ContinueStmt>()) {
+      // Skipping the rest of an iteration would also skip the other task.
+      if (cont->scope == nullptr || cont->scope == task)
+        fusible = false;
+    } else if (auto load = stmt->cast<GlobalLoadStmt>()) {
+      add(load->src, /*write=*/false);
+    } else if (auto store = stmt->cast<GlobalStoreStmt>()) {
+      add(store->dest, /*write=*/true);
+    } else if (auto atomic = stmt->cast<AtomicOpStmt>()) {
+      add(atomic->dest, /*write=*/true);
+    } else if (stmt->is<BitStructStoreStmt>() || stmt->is<PtrOffsetStmt>()) {
+      fusible = false;
+    }
+    return false;
+  });
+  if (!fusible)
+    return std::nullopt;
+  return accesses;
+}
+
+bool same_iteration_space(OffloadedStmt *a, OffloadedStmt *b) {
+  auto is_const_range_for = [](OffloadedStmt *task) {
+    return task->task_type == TaskType::range_for && task->const_begin &&
+           task->const_end && !task->tls_prologue && !task->bls_prologue &&
+           !task->mesh_prologue;
+  };
+  return is_const_range_for(a) && is_const_range_for(b) &&
+         a->begin_value == b->begin_value && a->end_value == b->end_value &&
+         a->reversed == b->reversed && a->block_dim == b->block_dim &&
+         a->grid_dim == b->grid_dim &&
+         a->num_cpu_threads == b->num_cpu_threads;
+}
+
+std::vector<Stmt *> indices_of(Stmt *ptr) {
+  if (auto global_ptr = ptr->cast<GlobalPtrStmt>())
+    return global_ptr->indices;
+  return ptr->as<ExternalPtrStmt>()->indices;
+}
+
+// Iteration i of |b| depends on no other iteration of |a| than i, if all the
+// states that both touch, and at least one writes, are accessed at the same
+// index by both, and different iterations access different elements.
+bool only_same_index_dependencies(
+    OffloadedStmt *a,
+    const std::unordered_map<SNode *, std::vector<Access>> &accesses_a,
+    OffloadedStmt *b,
+    const std::unordered_map<SNode *, std::vector<Access>> &accesses_b) {
+  auto has_write = [](const std::vector<Access> &accesses) {
+    return std::any_of(accesses.begin(), accesses.end(),
+                       [](const Access &access) { return access.write; });
+  };
+  const std::unordered_map<int, int> a_to_a = {{a->id, a->id}};
+  const std::unordered_map<int, int> a_to_b = {{a->id, b->id}};
+  for (auto &[snode, list_a] : accesses_a) {
+    auto it = accesses_b.find(snode);
+    if (it == accesses_b.end())
+      continue;
+    auto &list_b = it->second;
+    if (!has_write(list_a) && !has_write(list_b))
+      continue;
+    auto ptr = list_a[0].ptr;
+    if (!is_injective(indices_of(ptr), a))
+      return false;
+    for (auto &access : list_a) {
+      if (!irpass::analysis::same_value(ptr, access.ptr, a_to_a))
+        return false;
+    }
+    for (auto &access : list_b) {
+      if (!irpass::analysis::same_value(ptr, access.ptr, a_to_b))
+        return false;
+    }
+  }
+  return true;
+}
+
+void fuse(OffloadedStmt *a, OffloadedStmt *b) {
+  // An SNode that one task only reads is not read-only in the fused task if
+  // the other task writes it, e.g., CUDA must not load it through the
+  // non-coherent cache.
+  auto writes_a = irpass::analysis::gather_snode_read_writes(a).second;
+  auto writes_b = irpass::analysis::gather_snode_read_writes(b).second;
+  auto options_a = a->mem_access_opt.get_all();
+  auto options_b = b->mem_access_opt.get_all();
+  a->mem_access_opt.clear();
+  auto merge = [&](const auto &options, const auto &other_writes) {
+    for (auto &[snode, flags] : options) {
+      for (auto flag : flags) {
+        if (flag == SNodeAccessFlag::read_only && other_writes.count(snode))
+          continue;
+        a->mem_access_opt.add_flag(snode, flag);
+      }
+    }
+  };
+  merge(options_a, writes_b);
+  merge(options_b, writes_a);
+
+  for (auto &stmt : b->body->statements)
+    a->body->insert(std::move(stmt));
+  b->body->statements.clear();
+  irpass::replace_all_usages_with(a, b, a);
+}
+
+}  // namespace
+
+namespace irpass {
+
+bool fuse_range_fors(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  auto block = root->cast<Block>();
+  if (!block)
+    return false;
+  bool modified = false;
+  int i = 0;
+  while (i + 1 < (int)block->statements.size()) {
+    auto a = block->statements[i]->as<OffloadedStmt>();
+    auto b = block->statements[i + 1]->as<OffloadedStmt>();
+    std::optional<std::unordered_map<SNode *, std::vector<Access>>> accesses_a,
+        accesses_b;
+    if (same_iteration_space(a, b)) {
+      accesses_a = gather_accesses(a);
+      accesses_b = gather_accesses(b);
+    }
+    if (accesses_a && accesses_b &&
+        only_same_index_dependencies(a, *accesses_a, b, *accesses_b)) {
+      fuse(a, b);
+      block->erase(i + 1);
+      modified = true;
+    } else {
+      i++;
+    }
+  }
+  if (!modified)
+    return false;
+  re_id(root);
+  type_check(root, config);
+  return true;
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
@@ -0,0 +1,346 @@
+// Global Value Numbering
+
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+/**
+ * Hash-consing global value numbering scoped by the dominator tree.
+ *
+ * In CHI IR, a statement dominates the statements after it in the same block
+ * and everything nested in them, so the scopes of the value table follow the
+ * block nesting. The value number of a statement is its leader, i.e. the
+ * first equivalent statement that dominates it. Operands are renamed to their
+ * leaders before a statement is numbered, so a statement is keyed by its
+ * kind, its attributes and its operand pointers, and equivalent statements
+ * are found with a single lookup instead of pairwise comparisons.
+ *
+ * Global loads are numbered by their source pointer, and are available until
+ * a store that may alias the pointer according to alias analysis, or an
+ * operation with unknown side effects. Entering a loop kills the loads that
+ * may be overwritten anywhere in the loop body.
+ */
+class GlobalValueNumbering : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  explicit GlobalValueNumbering(IRNode *root) : root_(root) {
+    allow_undefined_visitor = true;
+    invoke_default_visitor = true;
+  }
+
+  void visit(Stmt *stmt) override {
+    rename_operands(stmt);
+    if (auto global_load = stmt->cast<GlobalLoadStmt>()) {
+      number_load(global_load);
+      return;
+    }
+    kill_loads(stmt);
+    if (!stmt->common_statement_eliminable())
+      return;
+    auto hash_value = hash(stmt);
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); scope++) {
+      auto it = scope->expressions.find(hash_value);
+      if (it == scope->expressions.end())
+        continue;
+      for (auto prev_stmt : it->second) {
+        if (equivalent(stmt, prev_stmt)) {
+          replace(stmt, prev_stmt);
+          return;
+        }
+      }
+    }
+    scopes_.back().expressions[hash_value].push_back(stmt);
+  }
+
+  void preprocess_container_stmt(Stmt *stmt) override {
+    rename_operands(stmt);
+    if (stmt->is<RangeForStmt>() || stmt->is<StructForStmt>() ||
+        stmt->is<MeshForStmt>() || stmt->is<WhileStmt>()) {
+      // Loads before the loop are still available in the first iteration
+      // only if nothing in the loop overwrites them.
+      irpass::analysis::gather_statements(stmt, [&](Stmt *s) {
+        kill_loads(s);
+        return false;
+      });
+    }
+  }
+
+  void visit(Block *stmt_list) override {
+    scopes_.emplace_back();
+    for (auto &stmt : stmt_list->statements) {
+      stmt->accept(this);
+    }
+    for (auto ptr : scopes_.back().loaded_ptrs) {
+      auto it = available_loads_.find(ptr);
+      if (it != available_loads_.end() &&
+          it->second.depth == (int)scopes_.size()) {
+        available_loads_.erase(it);
+      }
+    }
+    scopes_.pop_back();
+  }
+
+  void visit(OffloadedStmt *stmt) override {
+    // Offloaded tasks may run on other threads.
+    available_loads_.clear();
+    BasicStmtVisitor::visit(stmt);
+    available_loads_.clear();
+  }
+
+  void visit(IfStmt *if_stmt) override {
+    rename_operands(if_stmt);
+    if (if_stmt->true_statements) {
+      if (if_stmt->true_statements->statements.empty()) {
+        if_stmt->set_true_statements(nullptr);
+      }
+    }
+
+    if (if_stmt->false_statements) {
+      if (if_stmt->false_statements->statements.empty()) {
+        if_stmt->set_false_statements(nullptr);
+      }
+    }
+
+    // Move common statements at the beginning or the end of both branches
+    // outside.
+    if (if_stmt->true_statements && if_stmt->false_statements) {
+      auto &true_clause = if_stmt->true_statements;
+      auto &false_clause = if_stmt->false_statements;
+      // The hoisted statements are not visited later, so rename them now.
+      rename_operands(true_clause->statements[0].get());
+      rename_operands(false_clause->statements[0].get());
+      rename_operands(true_clause->statements.back().get());
+      rename_operands(false_clause->statements.back().get());
+      if (irpass::analysis::same_statements(
+              true_clause->statements[0].get(),
+              false_clause->statements[0].get())) {
+        // Directly modify this because it won't invalidate any iterators.
+        auto common_stmt = true_clause->extract(0);
+        irpass::replace_all_usages_with(false_clause.get(),
+                                        false_clause->statements[0].get(),
+                                        common_stmt.get());
+        modifier_.insert_before(if_stmt, std::move(common_stmt));
+        false_clause->erase(0);
+      }
+      if (!true_clause->statements.empty() &&
+          !false_clause->statements.empty() &&
+          irpass::analysis::same_statements(
+              true_clause->statements.back().get(),
+              false_clause->statements.back().get())) {
+        // Directly modify this because it won't invalidate any iterators.
+        auto common_stmt = true_clause->extract((int)true_clause->size() - 1);
+        irpass::replace_all_usages_with(false_clause.get(),
+                                        false_clause->statements.back().get(),
+                                        common_stmt.get());
+        modifier_.insert_after(if_stmt, std::move(common_stmt));
+        false_clause->erase((int)false_clause->size() - 1);
+      }
+    }
+
+    if (if_stmt->true_statements)
+      if_stmt->true_statements->accept(this);
+    if (if_stmt->false_statements)
+      if_stmt->false_statements->accept(this);
+  }
+
+  static bool run(IRNode *node) {
+    bool modified = false;
+    while (true) {
+      GlobalValueNumbering gvn(node);
+      gvn.pinned_ = irpass::analysis::gather_non_operand_references(node);
+      node->accept(&gvn);
+      bool modified_in_this_round = gvn.erase_replaced();
+      if (gvn.modifier_.modify_ir())
+        modified_in_this_round = true;
+      if (!modified_in_this_round)
+        break;
+      modified = true;
+    }
+    return modified;
+  }
+
+ private:
+  struct AvailableLoad {
+    GlobalLoadStmt *load;
+    // The scope depth where |load| is defined.
+    int depth;
+  };
+
+  struct Scope {
+    std::unordered_map<std::size_t, std::vector<Stmt *>> expressions;
+    // The pointers whose loads are made available in this scope.
+    std::vector<Stmt *> loaded_ptrs;
+  };
+
+  static std::size_t hash_combine(std::size_t seed, std::size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  }
+
+  static std::size_t hash(Stmt *stmt) {
+    std::size_t hash_value =
+        std::hash<std::type_index>{}(std::type_index(typeid(*stmt)));
+    hash_value = hash_combine(hash_value, stmt->ret_type.hash());
+    for (int i = 0; i < stmt->num_operands(); i++) {
+      hash_value =
+          hash_combine(hash_value, std::hash<Stmt *>{}(stmt->operand(i)));
+    }
+    // The attributes which most often tell statements with the same operands
+    // apart. The rest are compared in equivalent().
+    if (auto unary = stmt->cast<UnaryOpStmt>()) {
+      hash_value = hash_combine(hash_value, (std::size_t)unary->op_type);
+    } else if (auto binary = stmt->cast<BinaryOpStmt>()) {
+      hash_value = hash_combine(hash_value, (std::size_t)binary->op_type);
+    } else if (auto ternary = stmt->cast<TernaryOpStmt>()) {
+      hash_value = hash_combine(hash_value, (std::size_t)ternary->op_type);
+    } else if (auto constant = stmt->cast<ConstStmt>()) {
+      for (auto &val : constant->val.data) {
+        uint64 bits = val.value_bits;
+        if (val.dt->is<PrimitiveType>() && data_type_size(val.dt) < 8) {
+          // Only the low bytes of the union are defined.
+          bits &= (1ULL << (data_type_size(val.dt) * 8)) - 1;
+        }
+        hash_value = hash_combine(hash_value, std::hash<uint64>{}(bits));
+      }
+    }
+    return hash_value;
+  }
+
+  static bool equivalent(Stmt *this_stmt, Stmt *prev_stmt) {
+    // Is this_stmt eliminable given that prev_stmt dominates it?
+    if (typeid(*this_stmt) != typeid(*prev_stmt))
+      return false;
+    if (this_stmt->is<GlobalPtrStmt>()) {
+      auto this_ptr = this_stmt->as<GlobalPtrStmt>();
+      auto prev_ptr = prev_stmt->as<GlobalPtrStmt>();
+      return irpass::analysis::definitely_same_address(this_ptr, prev_ptr) &&
+             (this_ptr->activate == prev_ptr->activate || prev_ptr->activate);
+    }
+    if (this_stmt->num_operands() != prev_stmt->num_operands())
+      return false;
+    for (int i = 0; i < this_stmt->num_operands(); i++) {
+      if (this_stmt->operand(i) != prev_stmt->operand(i))
+        return false;
+    }
+    if (this_stmt->is<LoopUniqueStmt>()) {
+      // Merge the "covers" information into prev_loop_unique.
+      // Notice that this_loop_unique->covers is corrupted here.
+      auto this_loop_unique = this_stmt->as<LoopUniqueStmt>();
+      auto prev_loop_unique = prev_stmt->as<LoopUniqueStmt>();
+      prev_loop_unique->covers.insert(this_loop_unique->covers.begin(),
+                                      this_loop_unique->covers.end());
+      return true;
+    }
+    return this_stmt->field_manager.equal(prev_stmt->field_manager);
+  }
+
+  static bool is_numbered_load_source(Stmt *ptr) {
+    // Block-local and global temporary buffers are shared with other threads
+    // of the task, so their loads are not numbered.
+    return ptr->is<GlobalPtrStmt>() || ptr->is<ExternalPtrStmt>() ||
+           ptr->is<ThreadLocalPtrStmt>();
+  }
+
+  void number_load(GlobalLoadStmt *stmt) {
+    if (!is_numbered_load_source(stmt->src))
+      return;
+    auto it = available_loads_.find(stmt->src);
+    if (it != available_loads_.end() &&
+        it->second.load->ret_type == stmt->ret_type) {
+      replace(stmt, it->second.load);
+      return;
+    }
+    available_loads_[stmt->src] = {stmt, (int)scopes_.size()};
+    scopes_.back().loaded_ptrs.push_back(stmt->src);
+  }
+
+  void kill_loads(Stmt *stmt) {
+    if (available_loads_.empty())
+      return;
+    auto store_ptrs = irpass::analysis::get_store_destination(stmt);
+    if (store_ptrs.empty()) {
+      if (stmt->has_global_side_effect() && !stmt->is_container_statement()) {
+        // Unknown side effects
+        available_loads_.clear();
+      }
+      return;
+    }
+    for (auto it = available_loads_.begin(); it != available_loads_.end();) {
+      bool killed = false;
+      for (auto store_ptr : store_ptrs) {
+        if (irpass::analysis::maybe_same_address(store_ptr, it->first)) {
+          killed = true;
+          break;
+        }
+      }
+      if (killed) {
+        it = available_loads_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+  void rename_operands(Stmt *stmt) {
+    if (leaders_.empty())
+      return;
+    for (int i = 0; i < stmt->num_operands(); i++) {
+      auto it = leaders_.find(stmt->operand(i));
+      if (it != leaders_.end())
+        stmt->set_operand(i, it->second);
+    }
+  }
+
+  void replace(Stmt *stmt, Stmt *leader) {
+    if (pinned_.find(stmt) != pinned_.end())
+      return;
+    // All users of |stmt| are dominated by it and visited later, and they
+    // will be renamed then.
+    leaders_[stmt] = leader;
+    replaced_blocks_.insert(stmt->parent);
+  }
+
+  // Erases the replaced statements with one pass over each block.
+  bool erase_replaced() {
+    for (auto block : replaced_blocks_) {
+      std::vector<pStmt> statements;
+      statements.reserve(block->statements.size());
+      for (auto &stmt : block->statements) {
+        if (leaders_.find(stmt.get()) != leaders_.end()) {
+          stmt->erased = true;
+          block->trash_bin.push_back(std::move(stmt));
+        } else {
+          statements.push_back(std::move(stmt));
+        }
+      }
+      block->statements = std::move(statements);
+    }
+    return !leaders_.empty();
+  }
+
+  IRNode *root_;
+  std::vector<Scope> scopes_;
+  std::unordered_map<Stmt *, AvailableLoad> available_loads_;
+  std::unordered_map<Stmt *, Stmt *> leaders_;
+  std::unordered_set<Stmt *> pinned_;
+  std::unordered_set<Block *> replaced_blocks_;
+  DelayedIRModifier modifier_;
+};
+
+namespace irpass {
+bool global_value_numbering(IRNode *root) {
+  TI_AUTO_PROF;
+  return GlobalValueNumbering::run(root);
+}
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
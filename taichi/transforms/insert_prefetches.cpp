@@ -0,0 +1,302 @@
+// Software prefetching of indirect global accesses
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// The latency of a cache miss, in statements of a loop body.
+constexpr int kMissLatency = 256;
+constexpr int kMaxPrefetchDistance = 64;
+constexpr int kMaxPrefetchesPerLoop = 8;
+
+Stmt *innermost_loop(Stmt *stmt) {
+  for (auto block = stmt->parent; block; block = block->parent_block()) {
+    auto s = block->parent_stmt;
+    if (s && (s->is<RangeForStmt>() || s->is<StructForStmt>() ||
+              s->is<MeshForStmt>() || s->is<WhileStmt>() ||
+              s->is<OffloadedStmt>())) {
+      return s;
+    }
+  }
+  return nullptr;
+}
+
+bool defined_in(Stmt *stmt, Block *block) {
+  for (auto b = stmt->parent; b; b = b->parent_block()) {
+    if (b == block)
+      return true;
+  }
+  return false;
+}
+
+// The guards of the loop body are not carried over to the shifted address,
+// e.g., "if cnt[i] > 0: x[tot[i] // cnt[i]]", so operations that can trap on
+// some operands, such as integer division by zero, are not shifted.
+bool may_trap(Stmt *stmt) {
+  auto bin = stmt->cast<BinaryOpStmt>();
+  if (!bin || !is_integral(bin->ret_type))
+    return false;
+  return bin->op_type == BinaryOpType::div ||
+         bin->op_type == BinaryOpType::floordiv ||
+         bin->op_type == BinaryOpType::mod || bin->op_type == BinaryOpType::pow;
+}
+
+// Computes the address |d| iterations ahead of the current one, e.g.,
+// x[idx[min(i + d, n - 1)]] for x[idx[i]], right before the current address.
+// Indices of the loaded arrays and of SNodes are clamped to their shapes, as
+// the lookups in sparse SNodes load, too. The address itself is only
+// prefetched, so nothing here can fault.
+class AddressShifter {
+ public:
+  AddressShifter(Stmt *loop, Block *body, int distance)
+      : loop_(loop), body_(body), distance_(distance) {
+  }
+
+  // Returns nullptr if the address does not depend on a load in the loop.
+  Stmt *shift_address(Stmt *ptr) {
+    loads_shifted_ = false;
+    auto shifted = shift_pointer(ptr, /*clamp=*/false);
+    if (!shifted || shifted == ptr || !loads_shifted_)
+      return nullptr;
+    return shifted;
+  }
+
+  VecStatement new_statements;
+
+ private:
+  Stmt *loop_;
+  Block *body_;
+  int distance_;
+  bool loads_shifted_{false};
+  std::unordered_map<Stmt *, Stmt *> shifted_;
+
+  template <typename T, typename... Args>
+  T *push_back(Args &&... args) {
+    return new_statements.push_back<T>(std::forward<Args>(args)...);
+  }
+
+  Stmt *shift(Stmt *stmt) {
+    auto it = shifted_.find(stmt);
+    if (it != shifted_.end())
+      return it->second;
+    auto result = shift_uncached(stmt);
+    shifted_[stmt] = result;
+    return result;
+  }
+
+  Stmt *shift_uncached(Stmt *stmt) {
+    if (!defined_in(stmt, body_) || stmt->is<ConstStmt>() ||
+        stmt->is<ArgLoadStmt>() || stmt->is<GetRootStmt>() ||
+        stmt->is<ExternalTensorShapeAlongAxisStmt>()) {
+      // The same in all iterations.
+      return stmt;
+    }
+    if (auto loop_index = stmt->cast<LoopIndexStmt>()) {
+      if (loop_index->loop != loop_)
+        return nullptr;
+      auto distance = push_back<ConstStmt>(TypedConstant(distance_));
+      return push_back<BinaryOpStmt>(BinaryOpType::add, stmt, distance);
+    }
+    if (auto load = stmt->cast<GlobalLoadStmt>()) {
+      if (!is_integral(load->ret_type) || innermost_loop(load) != loop_)
+        return nullptr;
+      auto ptr = shift_pointer(load->src, /*clamp=*/true);
+      if (!ptr)
+        return nullptr;
+      if (ptr == load->src)
+        return stmt;
+      loads_shifted_ = true;
+      return push_back<GlobalLoadStmt>(ptr);
+    }
+    if ((!stmt->is<BinaryOpStmt>() && !stmt->is<UnaryOpStmt>() &&
+         !stmt->is<TernaryOpStmt>()) ||
+        may_trap(stmt)) {
+      return nullptr;
+    }
+    std::vector<Stmt *> operands;
+    bool changed = false;
+    for (int i = 0; i < stmt->num_operands(); i++) {
+      auto op = shift(stmt->operand(i));
+      if (!op)
+        return nullptr;
+      changed = changed || op != stmt->operand(i);
+      operands.push_back(op);
+    }
+    if (!changed)
+      return stmt;
+    auto cloned = new_statements.push_back(stmt->clone());
+    for (int i = 0; i < (int)operands.size(); i++)
+      cloned->set_operand(i, operands[i]);
+    return cloned;
+  }
+
+  // Keeps |index| in [0, |size|).
+  Stmt *clamp_index(Stmt *index, Stmt *size) {
+    auto one = push_back<ConstStmt>(TypedConstant(1));
+    auto zero = push_back<ConstStmt>(TypedConstant(0));
+    auto last = push_back<BinaryOpStmt>(BinaryOpType::sub, size, one);
+    auto upper = push_back<BinaryOpStmt>(BinaryOpType::min, index, last);
+    return push_back<BinaryOpStmt>(BinaryOpType::max, upper, zero);
+  }
+
+  Stmt *shift_pointer(Stmt *ptr, bool clamp) {
+    auto global_ptr = ptr->cast<GlobalPtrStmt>();
+    auto external_ptr = ptr->cast<ExternalPtrStmt>();
+    if (!global_ptr && !external_ptr)
+      return nullptr;
+    if (ptr->width() != 1 || !ptr->ret_type.ptr_removed()->is<PrimitiveType>())
+      return nullptr;
+    if (global_ptr) {
+      auto parent = global_ptr->snodes[0]->parent;
+      if (parent->type == SNodeType::bit_struct ||
+          parent->type == SNodeType::bit_array) {
+        return nullptr;
+      }
+    }
+    const auto &indices =
+        global_ptr ? global_ptr->indices : external_ptr->indices;
+    std::vector<Stmt *> new_indices;
+    bool changed = false;
+    for (int i = 0; i < (int)indices.size(); i++) {
+      auto index = shift(indices[i]);
+      if (!index)
+        return nullptr;
+      if (index != indices[i]) {
+        changed = true;
+        if (clamp || global_ptr) {
+          Stmt *size;
+          if (global_ptr) {
+            size = push_back<ConstStmt>(
+                TypedConstant(global_ptr->snodes[0]->shape_along_axis(i)));
+          } else {
+            auto arg_id =
+                external_ptr->base_ptrs[0]->as<ArgLoadStmt>()->arg_id;
+            size = push_back<ExternalTensorShapeAlongAxisStmt>(i, arg_id);
+          }
+          index = clamp_index(index, size);
+        }
+      }
+      new_indices.push_back(index);
+    }
+    if (!changed)
+      return ptr;
+    if (global_ptr) {
+      return push_back<GlobalPtrStmt>(global_ptr->snodes, new_indices,
+                                      /*activate=*/false);
+    }
+    return push_back<ExternalPtrStmt>(external_ptr->base_ptrs, new_indices);
+  }
+};
+
+class InsertPrefetches : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  explicit InsertPrefetches(const CompileConfig &config) : config_(config) {
+    allow_undefined_visitor = true;
+  }
+
+  void visit(OffloadedStmt *stmt) override {
+    if ((stmt->task_type == OffloadedStmt::TaskType::range_for &&
+         !stmt->reversed) ||
+        (stmt->task_type == OffloadedStmt::TaskType::struct_for &&
+         stmt->snode->num_active_indices == 1)) {
+      loops_.emplace_back(stmt, stmt->body.get());
+    }
+    BasicStmtVisitor::visit(stmt);
+  }
+
+  void visit(RangeForStmt *stmt) override {
+    if (!stmt->reversed)
+      loops_.emplace_back(stmt, stmt->body.get());
+    stmt->body->accept(this);
+  }
+
+  static bool run(IRNode *root, const CompileConfig &config) {
+    InsertPrefetches pass(config);
+    root->accept(&pass);
+    bool modified = false;
+    for (auto &[loop, body] : pass.loops_) {
+      if (pass.insert_prefetches(loop, body))
+        modified = true;
+    }
+    return modified;
+  }
+
+ private:
+  const CompileConfig &config_;
+  std::vector<std::pair<Stmt *, Block *>> loops_;
+
+  int prefetch_distance(Block *body) {
+    if (config_.prefetch_distance > 0)
+      return config_.prefetch_distance;
+    int cost = std::max(
+        1, (int)irpass::analysis::gather_statements(body, [](Stmt *) {
+             return true;
+           }).size());
+    return std::clamp((kMissLatency + cost - 1) / cost, 1,
+                      kMaxPrefetchDistance);
+  }
+
+  bool insert_prefetches(Stmt *loop, Block *body) {
+    auto ptrs = irpass::analysis::gather_statements(body, [&](Stmt *s) {
+      return (s->is<GlobalPtrStmt>() || s->is<ExternalPtrStmt>()) &&
+             innermost_loop(s) == loop;
+    });
+    if (ptrs.empty())
+      return false;
+    int distance = prefetch_distance(body);
+    // Components of the same cell are usually on the same cache line.
+    std::set<std::pair<void *, std::vector<Stmt *>>> prefetched;
+    int num_prefetches = 0;
+    for (auto ptr : ptrs) {
+      if (num_prefetches == kMaxPrefetchesPerLoop)
+        break;
+      std::pair<void *, std::vector<Stmt *>> cell;
+      if (auto global_ptr = ptr->cast<GlobalPtrStmt>()) {
+        cell = {global_ptr->snodes[0]->parent, global_ptr->indices};
+      } else {
+        auto external_ptr = ptr->as<ExternalPtrStmt>();
+        cell = {external_ptr->base_ptrs[0], external_ptr->indices};
+      }
+      if (prefetched.count(cell))
+        continue;
+      AddressShifter shifter(loop, body, distance);
+      auto shifted = shifter.shift_address(ptr);
+      if (!shifted)
+        continue;
+      shifter.new_statements.push_back<PrefetchStmt>(shifted);
+      ptr->parent->insert_before(ptr, std::move(shifter.new_statements));
+      prefetched.insert(cell);
+      num_prefetches++;
+    }
+    return num_prefetches > 0;
+  }
+};
+
+}  // namespace
+
+namespace irpass {
+
+bool insert_prefetches(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  if (!InsertPrefetches::run(root, config))
+    return false;
+  type_check(root, config);
+  return true;
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
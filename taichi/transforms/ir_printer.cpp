@@ -430,6 +430,10 @@ class IRPrinter : public IRVisitor {
           stmt->src->name());
   }
 
+  void visit(PrefetchStmt *stmt) override {
+    print("{} : prefetch {}", stmt->name(), stmt->ptr->name());
+  }
+
   void visit(GlobalStoreStmt *stmt) override {
     print("{}{} : global store [{} <- {}]", stmt->type_hint(), stmt->name(),
           stmt->dest->name(), stmt->val->name());
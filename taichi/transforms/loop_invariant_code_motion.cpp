@@ -1,10 +1,12 @@
 #include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
 #include "taichi/ir/statements.h"
 #include "taichi/ir/transforms.h"
 #include "taichi/ir/visitors.h"
 #include "taichi/system/profiler.h"
 
 #include <stack>
+#include <unordered_set>
 
 TLANG_NAMESPACE_BEGIN
 
@@ -160,10 +162,330 @@ class LoopInvariantCodeMotion : public BasicStmtVisitor {
   }
 };
 
+// Scalar replacement of global accesses to loop-invariant addresses inside
+// serial loops, i.e., loops nested in an offloaded task:
+//
+// for j in range(n):          tmp = x[i]  (if n > 0)
+//   x[i] = x[i] * a[j]   =>   for j in range(n):
+//                               tmp = tmp * a[j]
+//                             x[i] = tmp  (if n > 0)
+//
+// Atomic accumulations like x[i] += f(j) are accumulated into a local
+// variable instead, and added to x[i] with a single atomic after the loop
+// (if n > 0).
+// An address is promoted only if no other access in the loop may alias it.
+class GlobalAccessPromotion : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  GlobalAccessPromotion() {
+    allow_undefined_visitor = true;
+  }
+
+  void visit(OffloadedStmt *stmt) override {
+    in_offload_ = true;
+    BasicStmtVisitor::visit(stmt);
+    in_offload_ = false;
+  }
+
+  // Inner loops are collected first. Their promoted accesses are guarded by
+  // their trip counts, so they stay in the enclosing loops.
+  void visit(RangeForStmt *stmt) override {
+    stmt->body->accept(this);
+    if (in_offload_)
+      loops_.push_back(stmt);
+  }
+
+  static bool run(IRNode *root) {
+    GlobalAccessPromotion promotion;
+    root->accept(&promotion);
+    bool modified = false;
+    for (auto loop : promotion.loops_) {
+      if (promote(loop))
+        modified = true;
+    }
+    return modified;
+  }
+
+ private:
+  struct Candidate {
+    Stmt *ptr;
+    std::vector<Stmt *> loads, stores, atomics;
+    bool aliased{false};
+  };
+
+  bool in_offload_{false};
+  std::vector<RangeForStmt *> loops_;
+
+  static bool defined_in(Stmt *stmt, Block *block) {
+    for (auto b = stmt->parent; b; b = b->parent_block()) {
+      if (b == block)
+        return true;
+    }
+    return false;
+  }
+
+  static bool is_invariant_pointer(Stmt *ptr, Block *body) {
+    if (!ptr->is<GlobalPtrStmt>() && !ptr->is<ExternalPtrStmt>())
+      return false;
+    if (ptr->width() != 1 || !ptr->ret_type.ptr_removed()->is<PrimitiveType>())
+      return false;
+    for (auto op : ptr->get_operands()) {
+      if (op && defined_in(op, body))
+        return false;
+    }
+    return true;
+  }
+
+  // Adding zero to an element of a sparse SNode would activate it.
+  static bool never_activates(Stmt *ptr) {
+    if (auto global_ptr = ptr->cast<GlobalPtrStmt>()) {
+      for (auto s = global_ptr->snodes[0]->parent; s; s = s->parent) {
+        if (s->type != SNodeType::dense && s->type != SNodeType::root)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static bool promote(RangeForStmt *loop) {
+    Block *body = loop->body.get();
+    auto stmts = irpass::analysis::gather_statements(
+        body, [](Stmt *) { return true; });
+
+    // The top-level statements of |body| that run in every iteration, i.e.,
+    // those not preceded by a statement that may skip the rest of it.
+    std::unordered_set<Stmt *> every_iteration;
+    for (auto &s : body->statements) {
+      every_iteration.insert(s.get());
+      if (s->is<ContinueStmt>() || s->is<ReturnStmt>() ||
+          !irpass::analysis::gather_statements(s.get(), [](Stmt *t) {
+             return t->is<ContinueStmt>() || t->is<ReturnStmt>();
+           }).empty()) {
+        break;
+      }
+    }
+
+    std::vector<Candidate> candidates;
+    std::vector<Stmt *> other_ptrs;
+    std::unordered_set<Stmt *> used;
+    for (auto stmt : stmts) {
+      if (stmt->is<FuncCallStmt>() || stmt->is<InternalFuncStmt>() ||
+          stmt->is<ExternalFuncCallStmt>() || stmt->is<SNodeOpStmt>() ||
+          stmt->is<ClearListStmt>()) {
+        // Unknown side effects
+        return false;
+      }
+      for (auto op : stmt->get_operands()) {
+        if (op)
+          used.insert(op);
+      }
+
+      Stmt *ptr = nullptr;
+      if (auto load = stmt->cast<GlobalLoadStmt>())
+        ptr = load->src;
+      else if (auto store = stmt->cast<GlobalStoreStmt>())
+        ptr = store->dest;
+      else if (auto atomic = stmt->cast<AtomicOpStmt>())
+        ptr = atomic->dest;
+      if (ptr && is_invariant_pointer(ptr, body)) {
+        auto it = std::find_if(
+            candidates.begin(), candidates.end(), [&](const Candidate &c) {
+              return irpass::analysis::definitely_same_address(c.ptr, ptr);
+            });
+        if (it == candidates.end()) {
+          candidates.push_back({ptr});
+          it = candidates.end() - 1;
+        }
+        if (stmt->is<GlobalLoadStmt>())
+          it->loads.push_back(stmt);
+        else if (stmt->is<GlobalStoreStmt>())
+          it->stores.push_back(stmt);
+        else
+          it->atomics.push_back(stmt);
+        continue;
+      }
+      for (auto p : irpass::analysis::get_load_pointers(stmt))
+        other_ptrs.push_back(p);
+      for (auto p : irpass::analysis::get_store_destination(stmt))
+        other_ptrs.push_back(p);
+      if (auto bit_struct_store = stmt->cast<BitStructStoreStmt>())
+        other_ptrs.push_back(bit_struct_store->ptr);
+    }
+
+    for (int i = 0; i < (int)candidates.size(); i++) {
+      auto &c = candidates[i];
+      for (int j = i + 1; j < (int)candidates.size(); j++) {
+        if (irpass::analysis::maybe_same_address(c.ptr, candidates[j].ptr)) {
+          c.aliased = true;
+          candidates[j].aliased = true;
+        }
+      }
+      for (auto p : other_ptrs) {
+        if (c.aliased)
+          break;
+        if (irpass::analysis::maybe_same_address(c.ptr, p))
+          c.aliased = true;
+      }
+    }
+
+    bool modified = false;
+    Stmt *trip_cond = nullptr;
+    // The promoted accesses are executed only if the loop runs, so that the
+    // program touches no address it did not touch before.
+    auto get_trip_cond = [&]() {
+      if (!trip_cond) {
+        auto cond = std::make_unique<BinaryOpStmt>(BinaryOpType::cmp_lt,
+                                                   loop->begin, loop->end);
+        cond->ret_type = PrimitiveType::i32;
+        trip_cond = loop->insert_before_me(std::move(cond));
+      }
+      return trip_cond;
+    };
+    for (auto &c : candidates) {
+      if (c.aliased)
+        continue;
+      // The hoisted load and the sunk atomic access the address once the loop
+      // runs, so the loop must access it in every iteration as well. Under a
+      // condition, the address may be invalid, e.g., x[k] with k < 0 in
+      // "if k >= 0: s += x[k]".
+      auto runs_every_iteration = [&](Stmt *stmt) {
+        return every_iteration.count(stmt) > 0;
+      };
+      if (std::none_of(c.loads.begin(), c.loads.end(), runs_every_iteration) &&
+          std::none_of(c.stores.begin(), c.stores.end(),
+                       runs_every_iteration) &&
+          std::none_of(c.atomics.begin(), c.atomics.end(),
+                       runs_every_iteration)) {
+        continue;
+      }
+      auto dt = c.ptr->ret_type.ptr_removed();
+      if (!c.atomics.empty()) {
+        if (!c.loads.empty() || !c.stores.empty() || !never_activates(c.ptr))
+          continue;
+        bool reducible = true;
+        for (auto stmt : c.atomics) {
+          auto atomic = stmt->as<AtomicOpStmt>();
+          if ((atomic->op_type != AtomicOpType::add &&
+               atomic->op_type != AtomicOpType::sub) ||
+              atomic->val->ret_type != dt || used.count(atomic)) {
+            reducible = false;
+            break;
+          }
+        }
+        if (reducible) {
+          promote_accumulation(loop, c, dt, get_trip_cond());
+          modified = true;
+        }
+        continue;
+      }
+      // A store is sunk only if it happens in every iteration.
+      if (!c.stores.empty() && std::none_of(c.stores.begin(), c.stores.end(),
+                                            runs_every_iteration)) {
+        continue;
+      }
+      bool same_type = true;
+      for (auto load : c.loads)
+        same_type = same_type && load->ret_type == dt;
+      for (auto store : c.stores) {
+        auto val = store->as<GlobalStoreStmt>()->val;
+        same_type = same_type && val->ret_type == dt;
+      }
+      if (!same_type)
+        continue;
+      promote_load_store(loop, c, dt, get_trip_cond());
+      modified = true;
+    }
+    return modified;
+  }
+
+  static void promote_load_store(Stmt *loop,
+                                 const Candidate &c,
+                                 DataType dt,
+                                 Stmt *trip_cond) {
+    // The pointer is cloned into each guarded block, since it may activate
+    // the cell it points to.
+    VecStatement before;
+    auto var = before.push_back<AllocaStmt>(dt);
+    auto load_block = std::make_unique<Block>();
+    auto load_ptr = load_block->insert(c.ptr->clone());
+    auto load = load_block->push_back<GlobalLoadStmt>(load_ptr);
+    load->ret_type = dt;
+    load_block->push_back<LocalStoreStmt>(var, load);
+    auto load_if = before.push_back<IfStmt>(trip_cond);
+    load_if->set_true_statements(std::move(load_block));
+    loop->parent->insert_before(loop, std::move(before));
+
+    for (auto stmt : c.loads) {
+      auto local_load = std::make_unique<LocalLoadStmt>(LocalAddress(var, 0));
+      local_load->ret_type = dt;
+      stmt->replace_with(VecStatement(std::move(local_load)));
+    }
+    for (auto stmt : c.stores) {
+      stmt->replace_with(VecStatement(std::make_unique<LocalStoreStmt>(
+          var, stmt->as<GlobalStoreStmt>()->val)));
+    }
+
+    if (!c.stores.empty()) {
+      auto store_block = std::make_unique<Block>();
+      auto val = store_block->push_back<LocalLoadStmt>(LocalAddress(var, 0));
+      val->ret_type = dt;
+      auto store_ptr = store_block->insert(c.ptr->clone());
+      store_block->push_back<GlobalStoreStmt>(store_ptr, val);
+      auto store_if = std::make_unique<IfStmt>(trip_cond);
+      store_if->set_true_statements(std::move(store_block));
+      loop->insert_after_me(std::move(store_if));
+    }
+  }
+
+  static void promote_accumulation(Stmt *loop,
+                                   const Candidate &c,
+                                   DataType dt,
+                                   Stmt *trip_cond) {
+    VecStatement before;
+    auto var = before.push_back<AllocaStmt>(dt);
+    // -0.0 is the identity of floating-point addition.
+    if (dt->is_primitive(PrimitiveTypeID::f32)) {
+      auto zero = before.push_back<ConstStmt>(TypedConstant((float32)-0.0));
+      before.push_back<LocalStoreStmt>(var, zero);
+    } else if (dt->is_primitive(PrimitiveTypeID::f64)) {
+      auto zero = before.push_back<ConstStmt>(TypedConstant((float64)-0.0));
+      before.push_back<LocalStoreStmt>(var, zero);
+    }
+    loop->parent->insert_before(loop, std::move(before));
+
+    for (auto stmt : c.atomics) {
+      auto atomic = stmt->as<AtomicOpStmt>();
+      VecStatement accumulation;
+      auto old = accumulation.push_back<LocalLoadStmt>(LocalAddress(var, 0));
+      old->ret_type = dt;
+      auto sum = accumulation.push_back<BinaryOpStmt>(
+          atomic_to_binary_op_type(atomic->op_type), old, atomic->val);
+      sum->ret_type = dt;
+      accumulation.push_back<LocalStoreStmt>(var, sum);
+      stmt->replace_with(std::move(accumulation), /*replace_usages=*/false);
+    }
+
+    auto after = std::make_unique<Block>();
+    auto sum = after->push_back<LocalLoadStmt>(LocalAddress(var, 0));
+    sum->ret_type = dt;
+    auto ptr = after->insert(c.ptr->clone());
+    auto atomic = after->push_back<AtomicOpStmt>(AtomicOpType::add, ptr, sum);
+    atomic->ret_type = dt;
+    auto after_if = std::make_unique<IfStmt>(trip_cond);
+    after_if->set_true_statements(std::move(after));
+    loop->insert_after_me(std::move(after_if));
+  }
+};
+
 namespace irpass {
 bool loop_invariant_code_motion(IRNode *root, const CompileConfig &config) {
   TI_AUTO_PROF;
-  return LoopInvariantCodeMotion::run(root, config);
+  bool modified = LoopInvariantCodeMotion::run(root, config);
+  if (config.promote_loop_invariant_global_accesses &&
+      GlobalAccessPromotion::run(root))
+    modified = true;
+  return modified;
 }
 }  // namespace irpass
 
@@ -47,13 +47,16 @@ class LowerAccess : public IRVisitor {
   const std::vector<SNode *> &kernel_forces_no_activate;
   bool lower_atomic_ptr;
   bool packed;
+  bool assume_in_bounds;
 
   LowerAccess(const std::vector<SNode *> &kernel_forces_no_activate,
               bool lower_atomic_ptr,
-              bool packed)
+              bool packed,
+              bool assume_in_bounds)
       : kernel_forces_no_activate(kernel_forces_no_activate),
         lower_atomic_ptr(lower_atomic_ptr),
-        packed(packed) {
+        packed(packed),
+        assume_in_bounds(assume_in_bounds) {
     // TODO: change this to false
     allow_undefined_visitor = true;
     current_struct_for = nullptr;
@@ -102,8 +105,8 @@ class LowerAccess : public IRVisitor {
       TI_ASSERT(!pointer_needs_activation);
     }
 
-    PtrLowererImpl lowerer{leaf_snode,        indices, snode_op,
-                           is_bit_vectorized, lowered, packed};
+    PtrLowererImpl lowerer{leaf_snode, indices, snode_op, is_bit_vectorized,
+                           lowered,    packed,  assume_in_bounds};
     lowerer.set_pointer_needs_activation(pointer_needs_activation);
     lowerer.set_lower_access(this);
     lowerer.run();
@@ -156,6 +159,14 @@ class LowerAccess : public IRVisitor {
     modifier.insert_before(stmt, std::move(lowered));
   }
 
+  void visit(PrefetchStmt *stmt) override {
+    if (!stmt->ptr->is<GlobalPtrStmt>())
+      return;
+    auto lowered = lower_vector_ptr(stmt->ptr->as<GlobalPtrStmt>(), false);
+    stmt->ptr = lowered.back().get();
+    modifier.insert_before(stmt, std::move(lowered));
+  }
+
   // TODO: this seems to be redundant
   void visit(PtrOffsetStmt *stmt) override {
     if (!stmt->is_unlowered_global_ptr())
@@ -227,8 +238,10 @@ class LowerAccess : public IRVisitor {
   static bool run(IRNode *node,
                   const std::vector<SNode *> &kernel_forces_no_activate,
                   bool lower_atomic,
-                  bool packed) {
-    LowerAccess inst(kernel_forces_no_activate, lower_atomic, packed);
+                  bool packed,
+                  bool assume_in_bounds) {
+    LowerAccess inst(kernel_forces_no_activate, lower_atomic, packed,
+                     assume_in_bounds);
     bool modified = false;
     while (true) {
       node->accept(&inst);
@@ -319,8 +332,13 @@ namespace irpass {
 bool lower_access(IRNode *root,
                   const CompileConfig &config,
                   const LowerAccessPass::Args &args) {
-  bool modified = LowerAccess::run(root, args.kernel_forces_no_activate,
-                                   args.lower_atomic, config.packed);
+  // Out-of-bound indices are only wrapped around in debug mode, where they
+  // are reported after the kernel finishes instead of crashing it.
+  const bool assume_in_bounds =
+      config.strength_reduce_addresses && !config.debug;
+  bool modified =
+      LowerAccess::run(root, args.kernel_forces_no_activate, args.lower_atomic,
+                       config.packed, assume_in_bounds);
   type_check(root, config);
   return modified;
 }
@@ -9,6 +9,9 @@ TLANG_NAMESPACE_BEGIN
 
 namespace {
 
+// The L1 data cache size of common CPUs
+constexpr std::size_t kCpuBlsSizeHint = 32 * 1024;
+
 void make_block_local_offload(OffloadedStmt *offload,
                               const CompileConfig &config,
                               const std::string &kernel_name) {
@@ -58,6 +61,28 @@ void make_block_local_offload(OffloadedStmt *offload,
     bls_offset_in_bytes +=
         (dtype_size - bls_offset_in_bytes % dtype_size) % dtype_size;
 
+    // Converts the coordinate of a BLS element along axis |i| to the global
+    // index
+    auto bls_coord_to_global = [&](Block *element_block, int i,
+                                   Stmt *bls_coord) -> Stmt * {
+      Stmt *global_index = element_block->push_back<BinaryOpStmt>(
+          BinaryOpType::add, bls_coord,
+          element_block->push_back<ConstStmt>(
+              TypedConstant(pad.second.bounds[i].low)));
+
+      auto block_corner =
+          element_block->push_back<BlockCornerIndexStmt>(offload, i);
+      if (pad.second.coefficients[i] > 1) {
+        block_corner = element_block->push_back<BinaryOpStmt>(
+            BinaryOpType::mul, block_corner,
+            element_block->push_back<ConstStmt>(
+                TypedConstant(pad.second.coefficients[i])));
+      }
+
+      return element_block->push_back<BinaryOpStmt>(
+          BinaryOpType::add, global_index, block_corner);
+    };
+
     // This lambda is used for both BLS prologue and epilogue creation
     auto create_xlogue =
         [&](std::unique_ptr<Block> &block,
@@ -68,6 +93,56 @@ void make_block_local_offload(OffloadedStmt *offload,
             block = std::make_unique<Block>();
             block->parent_stmt = offload;
           }
+          if (arch_is_cpu(config.arch)) {
+            // A CPU thread processes a whole block by itself, so it walks the
+            // BLS buffer with a serial loop nest. The innermost loop is
+            // contiguous in both the buffer and the block, so that LLVM can
+            // vectorize the copy.
+            Block *element_block = block.get();
+            Stmt *bls_element_id = nullptr;
+            std::vector<Stmt *> global_indices(dim);
+            for (int i = 0; i < dim; i++) {
+              auto loop = element_block
+                              ->push_back<RangeForStmt>(
+                                  element_block->push_back<ConstStmt>(
+                                      TypedConstant(0)),
+                                  element_block->push_back<ConstStmt>(
+                                      TypedConstant(pad.second.pad_size[i])),
+                                  std::make_unique<Block>(),
+                                  /*bit_vectorize=*/-1,
+                                  /*num_cpu_threads=*/1, /*block_dim=*/0,
+                                  /*strictly_serialized=*/true)
+                              ->as<RangeForStmt>();
+              element_block = loop->body.get();
+              auto bls_coord =
+                  element_block->push_back<LoopIndexStmt>(loop, 0);
+              if (bls_element_id == nullptr) {
+                bls_element_id = bls_coord;
+              } else {
+                bls_element_id = element_block->push_back<BinaryOpStmt>(
+                    BinaryOpType::add,
+                    element_block->push_back<BinaryOpStmt>(
+                        BinaryOpType::mul, bls_element_id,
+                        element_block->push_back<ConstStmt>(
+                            TypedConstant(pad.second.pad_size[i]))),
+                    bls_coord);
+              }
+              global_indices[i] =
+                  bls_coord_to_global(element_block, i, bls_coord);
+            }
+            auto bls_element_offset_bytes =
+                element_block->push_back<BinaryOpStmt>(
+                    BinaryOpType::mul, bls_element_id,
+                    element_block->push_back<ConstStmt>(
+                        TypedConstant(dtype_size)));
+            bls_element_offset_bytes = element_block->push_back<BinaryOpStmt>(
+                BinaryOpType::add, bls_element_offset_bytes,
+                element_block->push_back<ConstStmt>(
+                    TypedConstant((int32)bls_offset_in_bytes)));
+            operation(element_block, global_indices, bls_element_offset_bytes);
+            return;
+          }
+
           // Equivalent to CUDA threadIdx
           Stmt *thread_idx_stmt =
               block->push_back<LoopLinearIndexStmt>(offload);
@@ -152,25 +227,8 @@ void make_block_local_offload(OffloadedStmt *offload,
               bls_element_id_partial = element_block->push_back<BinaryOpStmt>(
                   BinaryOpType::div, bls_element_id_partial, pad_size_stmt);
 
-              auto global_index_this_dim =
-                  element_block->push_back<BinaryOpStmt>(
-                      BinaryOpType::add, bls_coord,
-                      element_block->push_back<ConstStmt>(
-                          TypedConstant(pad.second.bounds[i].low)));
-
-              auto block_corner =
-                  element_block->push_back<BlockCornerIndexStmt>(offload, i);
-              if (pad.second.coefficients[i] > 1) {
-                block_corner = element_block->push_back<BinaryOpStmt>(
-                    BinaryOpType::mul, block_corner,
-                    element_block->push_back<ConstStmt>(
-                        TypedConstant(pad.second.coefficients[i])));
-              }
-
-              global_index_this_dim = element_block->push_back<BinaryOpStmt>(
-                  BinaryOpType::add, global_index_this_dim, block_corner);
-
-              global_indices[i] = global_index_this_dim;
+              global_indices[i] =
+                  bls_coord_to_global(element_block, i, bls_coord);
             }
 
             operation(element_block, global_indices, bls_element_offset_bytes);
@@ -332,6 +390,20 @@ void make_block_local_offload(OffloadedStmt *offload,
   }  // for (auto &pad : pads->pads)
 
   offload->bls_size = std::max(std::size_t(1), bls_offset_in_bytes);
+
+  if (arch_is_cpu(config.arch)) {
+    // Let a single part cover the whole block, since every part of a block
+    // fills the BLS buffer of its own.
+    offload->block_dim =
+        (int)std::min(offload->snode->max_num_elements(),
+                      (int64)taichi_listgen_max_element_size);
+    if (offload->bls_size > kCpuBlsSizeHint) {
+      TI_WARN(
+          "(kernel={}) The BLS buffer takes {} bytes, which might not fit in "
+          "the L1 cache. Consider using a smaller block.",
+          kernel_name, offload->bls_size);
+    }
+  }
 }
 
 }  // namespace
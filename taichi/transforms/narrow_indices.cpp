@@ -0,0 +1,150 @@
+// Narrow 64-bit index arithmetic to 32 bits where the values fit
+
+#include <limits>
+#include <unordered_map>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+bool fits_in_i32(Stmt *stmt) {
+  return irpass::analysis::value_range(stmt).within(
+      std::numeric_limits<int32>::min(), std::numeric_limits<int32>::max());
+}
+
+bool is_wide_signed_integer(DataType dt) {
+  return is_integral(dt) && is_signed(dt) && data_type_bits(dt) > 32;
+}
+
+// Rewrites the index expressions of field and external array accesses, e.g.,
+// i64(i) * 3 + 1, into the same computation on i32. Truncation commutes with
+// additions, multiplications and bitwise operations, so these only need the
+// final index to fit in i32. Other operations need their operands and results
+// to fit as well.
+class NarrowIndices : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  NarrowIndices() {
+    allow_undefined_visitor = true;
+  }
+
+  void visit(GlobalPtrStmt *stmt) override {
+    narrow_indices(stmt, stmt->indices);
+  }
+
+  void visit(ExternalPtrStmt *stmt) override {
+    narrow_indices(stmt, stmt->indices);
+  }
+
+  static bool run(IRNode *root) {
+    NarrowIndices pass;
+    root->accept(&pass);
+    return pass.modifier_.modify_ir() || pass.modified_;
+  }
+
+ private:
+  bool modified_{false};
+  DelayedIRModifier modifier_;
+  VecStatement new_statements_;
+  std::unordered_map<Stmt *, Stmt *> narrowed_;
+
+  void narrow_indices(Stmt *ptr, std::vector<Stmt *> &indices) {
+    if (ptr->width() != 1)
+      return;
+    for (auto &index : indices) {
+      if (!is_wide_signed_integer(index->ret_type) || !fits_in_i32(index))
+        continue;
+      // Casting the index alone does not save any 64-bit operation.
+      if (!index->is<BinaryOpStmt>() && !index->is<UnaryOpStmt>())
+        continue;
+      index = narrow(index);
+      modified_ = true;
+    }
+    if (!new_statements_.stmts.empty())
+      modifier_.insert_before(ptr, std::move(new_statements_));
+    new_statements_.stmts.clear();
+    narrowed_.clear();
+  }
+
+  Stmt *cast_to_i32(Stmt *stmt) {
+    auto cast =
+        new_statements_.push_back<UnaryOpStmt>(UnaryOpType::cast_value, stmt);
+    cast->as<UnaryOpStmt>()->cast_type = PrimitiveType::i32;
+    cast->ret_type = PrimitiveType::i32;
+    return cast;
+  }
+
+  Stmt *narrow(Stmt *stmt) {
+    auto it = narrowed_.find(stmt);
+    if (it != narrowed_.end())
+      return it->second;
+    auto result = narrow_uncached(stmt);
+    narrowed_[stmt] = result;
+    return result;
+  }
+
+  // Returns a 32-bit statement equal to |stmt| modulo 2^32.
+  Stmt *narrow_uncached(Stmt *stmt) {
+    if (stmt->ret_type->is_primitive(PrimitiveTypeID::i32))
+      return stmt;
+    if (!is_wide_signed_integer(stmt->ret_type))
+      return cast_to_i32(stmt);
+    if (auto const_stmt = stmt->cast<ConstStmt>()) {
+      auto val = (int32)const_stmt->val[0].val_int();
+      auto narrowed = new_statements_.push_back<ConstStmt>(TypedConstant(val));
+      narrowed->ret_type = PrimitiveType::i32;
+      return narrowed;
+    }
+    if (auto unary = stmt->cast<UnaryOpStmt>()) {
+      if (unary->op_type == UnaryOpType::cast_value &&
+          is_integral(unary->operand->ret_type) &&
+          data_type_bits(unary->operand->ret_type) >= 32) {
+        return narrow(unary->operand);
+      }
+      return cast_to_i32(stmt);
+    }
+    auto binary = stmt->cast<BinaryOpStmt>();
+    if (!binary)
+      return cast_to_i32(stmt);
+    const auto op = binary->op_type;
+    bool wraps = op == BinaryOpType::add || op == BinaryOpType::sub ||
+                 op == BinaryOpType::mul || op == BinaryOpType::bit_and ||
+                 op == BinaryOpType::bit_or || op == BinaryOpType::bit_xor;
+    bool exact = (op == BinaryOpType::min || op == BinaryOpType::max ||
+                  op == BinaryOpType::div || op == BinaryOpType::floordiv ||
+                  op == BinaryOpType::mod) &&
+                 fits_in_i32(binary) && fits_in_i32(binary->lhs) &&
+                 fits_in_i32(binary->rhs);
+    if (!wraps && !exact)
+      return cast_to_i32(stmt);
+    auto lhs = narrow(binary->lhs);
+    auto rhs = narrow(binary->rhs);
+    auto narrowed = new_statements_.push_back<BinaryOpStmt>(op, lhs, rhs);
+    narrowed->ret_type = PrimitiveType::i32;
+    return narrowed;
+  }
+};
+
+}  // namespace
+
+namespace irpass {
+
+bool narrow_indices(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  if (!NarrowIndices::run(root))
+    return false;
+  type_check(root, config);
+  return true;
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
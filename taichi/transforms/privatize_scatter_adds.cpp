@@ -0,0 +1,307 @@
+// Privatize small targets of scattered atomic adds per CPU thread
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// Private copies larger than a typical per-core L2 cache would be evicted
+// between the updates.
+constexpr std::size_t kMaxPrivateCopyBytes = 256 * 1024;
+// Private copies are padded to cache lines, so that no two threads write to
+// the same line.
+constexpr std::size_t kCacheLineBytes = 64;
+
+std::size_t round_up(std::size_t x, std::size_t alignment) {
+  return (x + alignment - 1) / alignment * alignment;
+}
+
+// Returns the end of the global temporaries used by |root|.
+std::size_t global_temporaries_end(Block *root) {
+  std::size_t end = 0;
+  irpass::analysis::gather_statements(root, [&](Stmt *stmt) {
+    if (auto tmp = stmt->cast<GlobalTemporaryStmt>()) {
+      std::size_t size;
+      if (auto tensor_type = tmp->ret_type->cast<TensorType>()) {
+        size = tensor_type->get_num_elements() *
+               data_type_size(tensor_type->get_element_type());
+      } else {
+        size = data_type_size(tmp->ret_type.ptr_removed());
+      }
+      end = std::max(end, tmp->offset + size);
+    } else if (auto offload = stmt->cast<OffloadedStmt>()) {
+      if (!offload->const_begin)
+        end = std::max(end, offload->begin_offset + sizeof(int32));
+      if (!offload->const_end)
+        end = std::max(end, offload->end_offset + sizeof(int32));
+    }
+    return false;
+  });
+  return end;
+}
+
+bool is_privatizable(GlobalPtrStmt *ptr) {
+  auto snode = ptr->snodes[0];
+  return ptr->width() == 1 && snode->type == SNodeType::place &&
+         snode->dt->is<PrimitiveType>() && !ptr->indices.empty() &&
+         (int)ptr->indices.size() == snode->num_active_indices &&
+         snode->parent->type == SNodeType::dense && snode->is_path_all_dense;
+}
+
+// Replaces atomic adds to a small dense field in a parallel range-for, e.g.,
+// hist[bin(x[i])] += 1, with plain adds to a copy of the field private to each
+// CPU thread. The copies live in the global temporary buffer. A range-for
+// before the loop zero-fills them, and a range-for after the loop adds them up
+// into the field, each thread summing over the copies of a few cells.
+class PrivatizeScatterAdds {
+ public:
+  explicit PrivatizeScatterAdds(Block *root)
+      : root_(root), buffer_end_(global_temporaries_end(root)) {
+  }
+
+  bool run() {
+    std::vector<OffloadedStmt *> offloads;
+    for (auto &stmt : root_->statements) {
+      if (auto offload = stmt->cast<OffloadedStmt>())
+        offloads.push_back(offload);
+    }
+    bool modified = false;
+    for (auto offload : offloads) {
+      if (privatize(offload))
+        modified = true;
+    }
+    return modified;
+  }
+
+ private:
+  Block *root_;
+  std::size_t buffer_end_;
+
+  // Finds the fields that |offload| only atomically adds to, without using
+  // the old values.
+  static std::vector<std::pair<SNode *, std::vector<AtomicOpStmt *>>>
+  find_targets(OffloadedStmt *offload) {
+    std::vector<std::pair<SNode *, std::vector<AtomicOpStmt *>>> targets;
+    std::unordered_map<SNode *, int> target_ids;
+    std::unordered_set<SNode *> disqualified;
+    auto stmts = irpass::analysis::gather_statements(
+        offload->body.get(), [](Stmt *) { return true; });
+    for (auto stmt : stmts) {
+      if (stmt->is<FuncCallStmt>() || stmt->is<SNodeOpStmt>())
+        return {};
+      auto atomic = stmt->cast<AtomicOpStmt>();
+      const bool is_add = atomic && (atomic->op_type == AtomicOpType::add ||
+                                     atomic->op_type == AtomicOpType::sub);
+      for (auto op : stmt->get_operands()) {
+        if (op == nullptr)
+          continue;
+        if (auto ptr = op->cast<GlobalPtrStmt>()) {
+          if (!is_add || atomic->dest != ptr || !is_privatizable(ptr)) {
+            disqualified.insert(ptr->snodes[0]);
+            continue;
+          }
+          auto snode = ptr->snodes[0];
+          if (target_ids.count(snode) == 0) {
+            target_ids[snode] = (int)targets.size();
+            targets.emplace_back(snode, std::vector<AtomicOpStmt *>());
+          }
+          targets[target_ids[snode]].second.push_back(atomic);
+        } else if (auto old_value = op->cast<AtomicOpStmt>()) {
+          if (auto dest = old_value->dest->cast<GlobalPtrStmt>())
+            disqualified.insert(dest->snodes[0]);
+        }
+      }
+    }
+    targets.erase(std::remove_if(targets.begin(), targets.end(),
+                                 [&](const auto &target) {
+                                   return disqualified.count(target.first);
+                                 }),
+                  targets.end());
+    return targets;
+  }
+
+  static std::unique_ptr<OffloadedStmt> make_range_for(OffloadedStmt *loop,
+                                                       int end) {
+    auto offload = Stmt::make_typed<OffloadedStmt>(
+        OffloadedStmt::TaskType::range_for, loop->device);
+    offload->const_begin = true;
+    offload->const_end = true;
+    offload->begin_value = 0;
+    offload->end_value = end;
+    offload->grid_dim = loop->grid_dim;
+    offload->block_dim = loop->block_dim;
+    offload->num_cpu_threads = loop->num_cpu_threads;
+    return offload;
+  }
+
+  static Stmt *constant(VecStatement &stmts, int32 val) {
+    return stmts.push_back<ConstStmt>(TypedConstant(val));
+  }
+
+  bool privatize(OffloadedStmt *offload) {
+    if (offload->task_type != OffloadedTaskType::range_for ||
+        offload->reversed || offload->num_cpu_threads <= 1) {
+      return false;
+    }
+    bool modified = false;
+    for (auto &[snode, atomics] : find_targets(offload)) {
+      const int num_indices = snode->num_active_indices;
+      int64 num_cells = 1;
+      for (int i = 0; i < num_indices; i++)
+        num_cells *= snode->shape_along_axis(i);
+      const auto data_type = snode->dt;
+      const auto cell_bytes = data_type_size(data_type);
+      if (num_cells * cell_bytes > kMaxPrivateCopyBytes)
+        continue;
+      const int num_copies = offload->num_cpu_threads;
+      // Merging the copies costs as much as this many updates.
+      if (offload->const_begin && offload->const_end &&
+          offload->end_value - offload->begin_value < num_copies * num_cells) {
+        continue;
+      }
+      const auto copy_bytes = round_up(num_cells * cell_bytes, kCacheLineBytes);
+      const int copy_cells = (int)(copy_bytes / cell_bytes);
+      const auto buffer_offset = round_up(buffer_end_, kCacheLineBytes);
+      if (buffer_offset + num_copies * copy_bytes >
+          taichi_global_tmp_buffer_size) {
+        continue;
+      }
+      buffer_end_ = buffer_offset + num_copies * copy_bytes;
+      const auto buffer_type = TypeFactory::create_tensor_type(
+          {num_copies * copy_cells}, data_type);
+
+      // Returns the pointer to the |cell|-th cell of the |copy|-th copy.
+      auto private_ptr = [&](VecStatement &stmts, Stmt *copy, Stmt *cell) {
+        auto index = stmts.push_back<BinaryOpStmt>(
+            BinaryOpType::mul, copy, constant(stmts, copy_cells));
+        index = stmts.push_back<BinaryOpStmt>(BinaryOpType::add, index, cell);
+        auto offset_bytes = stmts.push_back<BinaryOpStmt>(
+            BinaryOpType::mul, index, constant(stmts, (int32)cell_bytes));
+        auto buffer =
+            stmts.push_back<GlobalTemporaryStmt>(buffer_offset, buffer_type);
+        return stmts.push_back<PtrOffsetStmt>(buffer, offset_bytes);
+      };
+
+      // Step 1:
+      // Zero-fill the private copies
+      {
+        auto zero_fill = make_range_for(offload, num_copies * copy_cells);
+        VecStatement stmts;
+        auto index = stmts.push_back<LoopIndexStmt>(zero_fill.get(), 0);
+        auto ptr = private_ptr(stmts, constant(stmts, 0), index);
+        auto zero = stmts.push_back<ConstStmt>(TypedConstant(data_type, 0));
+        stmts.push_back<GlobalStoreStmt>(ptr, zero);
+        zero_fill->body->insert(std::move(stmts));
+        root_->insert_before(offload, VecStatement(std::move(zero_fill)));
+      }
+
+      // Step 2:
+      // Add to the copy of the current thread without atomics
+      for (auto atomic : atomics) {
+        auto dest = atomic->dest->as<GlobalPtrStmt>();
+        VecStatement stmts;
+        auto thread_id = stmts.push_back<InternalFuncStmt>(
+            "linear_thread_idx", std::vector<Stmt *>{});
+        Stmt *cell = nullptr;
+        for (int i = 0; i < num_indices; i++) {
+          if (cell == nullptr) {
+            cell = dest->indices[i];
+          } else {
+            cell = stmts.push_back<BinaryOpStmt>(
+                BinaryOpType::mul, cell,
+                constant(stmts, snode->shape_along_axis(i)));
+            cell = stmts.push_back<BinaryOpStmt>(BinaryOpType::add, cell,
+                                                 dest->indices[i]);
+          }
+        }
+        auto ptr = private_ptr(stmts, thread_id, cell);
+        auto old_value = stmts.push_back<GlobalLoadStmt>(ptr);
+        auto new_value = stmts.push_back<BinaryOpStmt>(
+            atomic_to_binary_op_type(atomic->op_type), old_value, atomic->val);
+        stmts.push_back<GlobalStoreStmt>(ptr, new_value);
+        atomic->parent->replace_with(atomic, std::move(stmts));
+      }
+
+      // Step 3:
+      // Add the private copies up into the field
+      {
+        auto merge = make_range_for(offload, (int)num_cells);
+        VecStatement stmts;
+        auto cell = stmts.push_back<LoopIndexStmt>(merge.get(), 0);
+        auto sum = stmts.push_back<AllocaStmt>(data_type);
+        stmts.push_back<LocalStoreStmt>(
+            sum, stmts.push_back<ConstStmt>(TypedConstant(data_type, 0)));
+        {
+          auto copies = std::make_unique<Block>();
+          auto loop = stmts
+                          .push_back<RangeForStmt>(
+                              constant(stmts, 0), constant(stmts, num_copies),
+                              std::move(copies), /*bit_vectorize=*/-1,
+                              /*num_cpu_threads=*/1, /*block_dim=*/0,
+                              /*strictly_serialized=*/true)
+                          ->as<RangeForStmt>();
+          VecStatement body;
+          auto copy = body.push_back<LoopIndexStmt>(loop, 0);
+          auto value = body.push_back<GlobalLoadStmt>(
+              private_ptr(body, copy, cell));
+          auto partial_sum = body.push_back<BinaryOpStmt>(
+              BinaryOpType::add, body.push_back<LocalLoadStmt>(
+                                     LocalAddress(sum, 0)),
+              value);
+          body.push_back<LocalStoreStmt>(sum, partial_sum);
+          loop->body->insert(std::move(body));
+        }
+        std::vector<Stmt *> indices(num_indices);
+        Stmt *partial_cell = cell;
+        for (int i = num_indices - 1; i >= 0; i--) {
+          auto shape = constant(stmts, snode->shape_along_axis(i));
+          indices[i] =
+              stmts.push_back<BinaryOpStmt>(BinaryOpType::mod, partial_cell,
+                                            shape);
+          partial_cell = stmts.push_back<BinaryOpStmt>(BinaryOpType::div,
+                                                       partial_cell, shape);
+        }
+        auto ptr = stmts.push_back<GlobalPtrStmt>(LaneAttribute<SNode *>(snode),
+                                                  indices, /*activate=*/false);
+        auto total = stmts.push_back<BinaryOpStmt>(
+            BinaryOpType::add, stmts.push_back<GlobalLoadStmt>(ptr),
+            stmts.push_back<LocalLoadStmt>(LocalAddress(sum, 0)));
+        stmts.push_back<GlobalStoreStmt>(ptr, total);
+        merge->body->insert(std::move(stmts));
+        root_->insert_after(offload, VecStatement(std::move(merge)));
+      }
+      modified = true;
+    }
+    return modified;
+  }
+};
+
+}  // namespace
+
+namespace irpass {
+
+bool privatize_scatter_adds(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  auto root_block = root->cast<Block>();
+  if (root_block == nullptr)
+    return false;
+  PrivatizeScatterAdds pass(root_block);
+  if (!pass.run())
+    return false;
+  type_check(root, config);
+  return true;
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
@@ -16,12 +16,14 @@ ScalarPointerLowerer::ScalarPointerLowerer(SNode *leaf_snode,
                                            const SNodeOpType snode_op,
                                            const bool is_bit_vectorized,
                                            VecStatement *lowered,
-                                           const bool packed)
+                                           const bool packed,
+                                           const bool assume_in_bounds)
     : indices_(indices),
       snode_op_(snode_op),
       is_bit_vectorized_(is_bit_vectorized),
       lowered_(lowered),
-      packed_(packed) {
+      packed_(packed),
+      assume_in_bounds_(assume_in_bounds) {
   for (auto *s = leaf_snode; s != nullptr; s = s->parent) {
     snodes_.push_back(s);
   }
@@ -56,6 +58,12 @@ void ScalarPointerLowerer::run() {
       total_shape[j] *= s->extractors[j].shape;
     }
   }
+  // An SNode that is the only one along an axis consumes the whole index.
+  // Extracting it is then a no-op for in-bound indices, and leaving it out
+  // keeps the address affine in the index, e.g., for induction variables.
+  const auto full_bits = start_bits;
+  const auto full_shape = total_shape;
+  const bool skip_full_extraction = assume_in_bounds_ && !is_bit_vectorized_;
 
   if (path_length_ == 0)
     return;
@@ -81,13 +89,21 @@ void ScalarPointerLowerer::run() {
         const int prev = total_shape[k];
         total_shape[k] /= snode->extractors[k].shape;
         const int next = total_shape[k];
-        extracted = generate_mod_x_div_y(lowered_, indices_[k_], prev, next);
+        if (skip_full_extraction && prev == full_shape[k] && next == 1) {
+          extracted = indices_[k_];
+        } else {
+          extracted = generate_mod_x_div_y(lowered_, indices_[k_], prev, next);
+        }
       } else {
         const int end = start_bits[k];
         start_bits[k] -= snode->extractors[k].num_bits;
         const int begin = start_bits[k];
-        extracted =
-            lowered_->push_back<BitExtractStmt>(indices_[k_], begin, end);
+        if (skip_full_extraction && begin == 0 && end == full_bits[k]) {
+          extracted = indices_[k_];
+        } else {
+          extracted =
+              lowered_->push_back<BitExtractStmt>(indices_[k_], begin, end);
+        }
       }
       lowered_indices.push_back(extracted);
       strides.push_back(snode->extractors[k].shape);
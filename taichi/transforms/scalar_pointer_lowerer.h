@@ -26,13 +26,17 @@ class ScalarPointerLowerer {
    * @param snode_op: SNode operation
    * @param is_bit_vectorized: Is @param leaf_snode bit vectorized
    * @param lowered: Collects the output ops
+   * @param packed: Whether the SNode tree is in packed mode
+   * @param assume_in_bounds: Whether @param indices are within the shape of
+   * the field, so that an index consumed by a single SNode is used as is
    */
   explicit ScalarPointerLowerer(SNode *leaf_snode,
                                 const std::vector<Stmt *> &indices,
                                 const SNodeOpType snode_op,
                                 const bool is_bit_vectorized,
                                 VecStatement *lowered,
-                                const bool packed);
+                                const bool packed,
+                                const bool assume_in_bounds);
 
   virtual ~ScalarPointerLowerer() = default;
   /**
@@ -69,6 +73,7 @@ class ScalarPointerLowerer {
   const bool is_bit_vectorized_;
   VecStatement *const lowered_;
   const bool packed_;
+  const bool assume_in_bounds_;
 
  private:
   std::vector<SNode *> snodes_;
@@ -0,0 +1,116 @@
+// Express neighboring cells of dense SNodes by constant offsets
+
+#include <limits>
+#include <map>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// Splits |stmt| into a base and a constant, e.g., i - 1 into (i, -1).
+std::pair<Stmt *, int64> split_constant_offset(Stmt *stmt) {
+  int64 offset = 0;
+  while (auto bin = stmt->cast<BinaryOpStmt>()) {
+    if (bin->width() != 1 || (bin->op_type != BinaryOpType::add &&
+                              bin->op_type != BinaryOpType::sub)) {
+      break;
+    }
+    auto lhs = bin->lhs->cast<ConstStmt>();
+    auto rhs = bin->rhs->cast<ConstStmt>();
+    if (rhs && is_integral(rhs->ret_type)) {
+      auto val = rhs->val[0].val_int();
+      offset += bin->op_type == BinaryOpType::add ? val : -val;
+      stmt = bin->lhs;
+    } else if (lhs && is_integral(lhs->ret_type) &&
+               bin->op_type == BinaryOpType::add) {
+      offset += lhs->val[0].val_int();
+      stmt = bin->rhs;
+    } else {
+      break;
+    }
+  }
+  return {stmt, offset};
+}
+
+// Rewrites the linearized indices of stencil accesses like x[i + 1, j - 1]
+// into the linearized index of x[i, j] plus a constant. Cells of a dense
+// SNode are contiguous, so the codegen turns the constant into an offset
+// from the pointer to x[i, j], which all neighbors share after CSE.
+class ShareStencilBases {
+ public:
+  static bool run(IRNode *root) {
+    using Key = std::pair<std::vector<Stmt *>, std::vector<int>>;
+    std::map<Key, std::vector<LinearizeStmt *>> groups;
+    std::map<LinearizeStmt *, int64> offsets;
+    auto lookups = irpass::analysis::gather_statements(root, [](Stmt *s) {
+      auto lookup = s->cast<SNodeLookupStmt>();
+      return lookup && lookup->snode->type == SNodeType::dense &&
+             lookup->input_index->is<LinearizeStmt>();
+    });
+    for (auto s : lookups) {
+      auto linearized =
+          s->as<SNodeLookupStmt>()->input_index->as<LinearizeStmt>();
+      if (offsets.count(linearized) || linearized->width() != 1)
+        continue;
+      Key key{{}, linearized->strides};
+      int64 offset = 0;
+      for (int i = 0; i < (int)linearized->inputs.size(); i++) {
+        auto [base, input_offset] =
+            split_constant_offset(linearized->inputs[i]);
+        key.first.push_back(base);
+        offset = offset * linearized->strides[i] + input_offset;
+      }
+      offsets[linearized] = offset;
+      groups[key].push_back(linearized);
+    }
+
+    bool modified = false;
+    for (auto &[key, members] : groups) {
+      if (members.size() < 2)
+        continue;
+      for (auto linearized : members) {
+        if (key.first == linearized->inputs)
+          continue;
+        auto offset = offsets[linearized];
+        if (offset < std::numeric_limits<int32>::min() ||
+            offset > std::numeric_limits<int32>::max()) {
+          continue;
+        }
+        VecStatement new_statements;
+        auto base =
+            new_statements.push_back<LinearizeStmt>(key.first, key.second);
+        if (offset != 0) {
+          auto offset_stmt =
+              new_statements.push_back<ConstStmt>(TypedConstant((int32)offset));
+          new_statements.push_back<BinaryOpStmt>(BinaryOpType::add, base,
+                                                 offset_stmt);
+        }
+        linearized->replace_with(std::move(new_statements));
+        modified = true;
+      }
+    }
+    return modified;
+  }
+};
+
+}  // namespace
+
+namespace irpass {
+
+bool share_stencil_bases(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  if (!ShareStencilBases::run(root))
+    return false;
+  type_check(root, config);
+  return true;
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
@@ -637,51 +637,161 @@ void full_simplify(IRNode *root,
                    const CompileConfig &config,
                    const FullSimplifyPass::Args &args) {
   TI_AUTO_PROF;
-  if (config.advanced_optimization) {
-    bool first_iteration = true;
-    while (true) {
-      bool modified = false;
-      if (extract_constant(root, config))
-        modified = true;
-      if (unreachable_code_elimination(root))
-        modified = true;
-      if (binary_op_simplify(root, config))
-        modified = true;
-      if (config.constant_folding &&
-          constant_fold(root, config, {args.program}))
-        modified = true;
-      if (die(root))
-        modified = true;
-      if (alg_simp(root, config))
-        modified = true;
-      if (loop_invariant_code_motion(root, config))
-        modified = true;
-      if (die(root))
-        modified = true;
-      if (simplify(root, config))
-        modified = true;
-      if (die(root))
-        modified = true;
-      if (config.opt_level > 0 && whole_kernel_cse(root))
-        modified = true;
-      // Don't do this time-consuming optimization pass again if the IR is
-      // not modified.
-      if (config.opt_level > 0 && (first_iteration || modified) &&
-          config.cfg_optimization &&
-          cfg_optimization(root, args.after_lower_access))
-        modified = true;
-      first_iteration = false;
-      if (!modified)
-        break;
-    }
+  std::unique_ptr<AnalysisManager> local_amgr;
+  auto *amgr = args.amgr;
+  if (amgr == nullptr) {
+    local_amgr = std::make_unique<AnalysisManager>();
+    amgr = local_amgr.get();
+  }
+  // The transforms below don't take arguments other than |config| (fixed
+  // during a compilation) and |after_lower_access|, so the latter is all that
+  // needs to be encoded in the fixpoint IDs.
+  const auto suffix = args.after_lower_access ? "@after_lower_access" : "";
+  auto run = [&](const std::string &id, const std::function<bool()> &pass,
+                 const PreservedAnalyses &preserved =
+                     PreservedAnalyses::none()) {
+    return amgr->run_transform(root, id + suffix, pass, preserved);
+  };
+  auto run_cfg_optimization = [&]() {
+    return run(
+        "cfg_optimization",
+        [&]() {
+          return cfg_optimization(root, args.after_lower_access, std::nullopt,
+                                  amgr);
+        },
+        PreservedAnalyses::none().preserve<BuildCFGPass>());
+  };
+  if (amgr->is_at_fixpoint(FullSimplifyPass::id + suffix)) {
     return;
   }
-  if (config.constant_folding) {
-    constant_fold(root, config, {args.program});
+  if (config.advanced_optimization) {
+    std::unique_ptr<IRNode> reference;
+    if (config.worklist_simplify && config.check_worklist_simplify) {
+      auto reference_config = config;
+      reference_config.worklist_simplify = false;
+      reference = root->clone();
+      full_simplify(reference.get(), reference_config,
+                    {args.after_lower_access, args.program});
+    }
+    bool at_fixpoint = false;
+    if (config.worklist_simplify) {
+      // The local rewrites a whole-IR pass exposes are propagated through the
+      // def-use chains by worklist_simplify() right away. The whole-IR passes
+      // still run in rounds until none of them modifies the IR, since they may
+      // expose rewrites to each other as well.
+      if (run("worklist_simplify",
+              [&]() { return worklist_simplify(root, config); }))
+        run("die", [&]() { return die(root); });
+      while (true) {
+        bool modified = false;
+        auto propagate = [&](bool pass_modified) {
+          if (!pass_modified)
+            return;
+          modified = true;
+          run("worklist_simplify",
+              [&]() { return worklist_simplify(root, config); });
+          run("die", [&]() { return die(root); });
+        };
+        propagate(run("extract_constant", [&]() {
+          return extract_constant(root, config);
+        }));
+        propagate(run("unreachable_code_elimination", [&]() {
+          return unreachable_code_elimination(root);
+        }));
+        propagate(run("binary_op_simplify", [&]() {
+          return binary_op_simplify(root, config);
+        }));
+        if (config.constant_folding) {
+          propagate(run("constant_fold", [&]() {
+            return constant_fold(root, config, {args.program});
+          }));
+        }
+        propagate(run("alg_simp", [&]() { return alg_simp(root, config); }));
+        propagate(run("loop_invariant_code_motion", [&]() {
+          return loop_invariant_code_motion(root, config);
+        }));
+        propagate(run("simplify", [&]() { return simplify(root, config); }));
+        if (config.opt_level > 0) {
+          propagate(run("global_value_numbering",
+                        [&]() { return global_value_numbering(root); }));
+        }
+        if (config.opt_level > 0 && config.cfg_optimization)
+          propagate(run_cfg_optimization());
+        if (!modified)
+          break;
+      }
+      // Every pass ran on the final IR without modifying it.
+      at_fixpoint = true;
+    } else {
+      bool first_iteration = true;
+      while (true) {
+        bool modified = false;
+        if (run("extract_constant",
+                [&]() { return extract_constant(root, config); }))
+          modified = true;
+        if (run("unreachable_code_elimination",
+                [&]() { return unreachable_code_elimination(root); }))
+          modified = true;
+        if (run("binary_op_simplify",
+                [&]() { return binary_op_simplify(root, config); }))
+          modified = true;
+        if (config.constant_folding && run("constant_fold", [&]() {
+              return constant_fold(root, config, {args.program});
+            }))
+          modified = true;
+        if (run("die", [&]() { return die(root); }))
+          modified = true;
+        if (run("alg_simp", [&]() { return alg_simp(root, config); }))
+          modified = true;
+        if (run("loop_invariant_code_motion",
+                [&]() { return loop_invariant_code_motion(root, config); }))
+          modified = true;
+        if (run("die", [&]() { return die(root); }))
+          modified = true;
+        if (run("simplify", [&]() { return simplify(root, config); }))
+          modified = true;
+        if (run("die", [&]() { return die(root); }))
+          modified = true;
+        if (config.opt_level > 0 &&
+            run("global_value_numbering",
+                [&]() { return global_value_numbering(root); }))
+          modified = true;
+        // Don't do this time-consuming optimization pass again if the IR is
+        // not modified.
+        if (config.opt_level > 0 && (first_iteration || modified) &&
+            config.cfg_optimization && run_cfg_optimization())
+          modified = true;
+        first_iteration = false;
+        if (!modified)
+          break;
+      }
+      // The loop above stops without rerunning cfg_optimization, so running
+      // full_simplify() again is only known to be a no-op if
+      // cfg_optimization didn't change the IR the last time either.
+      at_fixpoint =
+          config.opt_level == 0 || !config.cfg_optimization ||
+          amgr->is_at_fixpoint(std::string("cfg_optimization") + suffix);
+    }
+    if (reference && !analysis::same_statements(root, reference.get())) {
+      std::string result, expected;
+      print(root, &result);
+      print(reference.get(), &expected);
+      TI_WARN(
+          "full_simplify() with worklist_simplify differs from the fixpoint "
+          "driver:\n{}\nExpected:\n{}",
+          result, expected);
+    }
+    if (at_fixpoint)
+      amgr->mark_at_fixpoint(FullSimplifyPass::id + suffix);
+  } else {
+    if (config.constant_folding) {
+      constant_fold(root, config, {args.program});
+      die(root);
+    }
+    simplify(root, config);
     die(root);
+    amgr->invalidate();
   }
-  simplify(root, config);
-  die(root);
 }
 
 }  // namespace irpass
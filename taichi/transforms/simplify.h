@@ -12,6 +12,9 @@ class FullSimplifyPass : public Pass {
   struct Args {
     bool after_lower_access;
     Program *program;
+    // If not null, fixpoints and cached analyses are shared with the caller,
+    // which must invalidate |amgr| when it modifies the IR by other means.
+    AnalysisManager *amgr{nullptr};
   };
 };
 
@@ -0,0 +1,459 @@
+// Superword-level parallelism (SLP) vectorization
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/type_utils.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// Element types of the vector values CodeGenLLVM supports.
+bool is_vectorizable_type(DataType dt) {
+  return dt->is_primitive(PrimitiveTypeID::f32) ||
+         dt->is_primitive(PrimitiveTypeID::f64) ||
+         dt->is_primitive(PrimitiveTypeID::i32) ||
+         dt->is_primitive(PrimitiveTypeID::i64) ||
+         dt->is_primitive(PrimitiveTypeID::u32) ||
+         dt->is_primitive(PrimitiveTypeID::u64);
+}
+
+bool is_vectorizable_op(Stmt *stmt) {
+  if (auto binary = stmt->cast<BinaryOpStmt>()) {
+    auto op = binary->op_type;
+    if (op == BinaryOpType::add || op == BinaryOpType::sub ||
+        op == BinaryOpType::mul) {
+      return true;
+    }
+    if (is_real(binary->ret_type)) {
+      return op == BinaryOpType::div || op == BinaryOpType::max ||
+             op == BinaryOpType::min;
+    }
+    return op == BinaryOpType::bit_and || op == BinaryOpType::bit_or ||
+           op == BinaryOpType::bit_xor;
+  }
+  if (auto unary = stmt->cast<UnaryOpStmt>()) {
+    return unary->op_type == UnaryOpType::neg ||
+           (unary->op_type == UnaryOpType::sqrt && is_real(unary->ret_type));
+  }
+  return false;
+}
+
+// Returns the place SNode component |ptr| points to, if it is laid out in the
+// cell of its parent as a plain struct member.
+GetChStmt *as_component_ptr(Stmt *ptr) {
+  auto get_ch = ptr->cast<GetChStmt>();
+  if (!get_ch || get_ch->is_bit_vectorized ||
+      get_ch->ret_type->as<PointerType>()->is_bit_pointer()) {
+    return nullptr;
+  }
+  if (get_ch->output_snode->type != SNodeType::place ||
+      !is_vectorizable_type(get_ch->output_snode->dt)) {
+    return nullptr;
+  }
+  return get_ch;
+}
+
+// Whether |ptrs| point to consecutive components of the same cell. Members of
+// the same type are contiguous in the cell, so the lanes form a vector in
+// memory.
+bool are_adjacent_components(const std::vector<Stmt *> &ptrs) {
+  auto first = as_component_ptr(ptrs[0]);
+  if (!first)
+    return false;
+  for (int i = 1; i < (int)ptrs.size(); i++) {
+    auto get_ch = as_component_ptr(ptrs[i]);
+    if (!get_ch || get_ch->input_ptr != first->input_ptr ||
+        get_ch->chid != first->chid + i ||
+        get_ch->output_snode->dt != first->output_snode->dt) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * Packs isomorphic scalar statements of a block, which work on adjacent
+ * components of the same vector or matrix field, into vector statements of
+ * tensor types.
+ *
+ * Seeds are stores to consecutive components of a cell. Starting from them,
+ * packs are extended bottom-up through the operands (Larsen & Amarasinghe,
+ * PLDI'00): lanes with the same arithmetic operation become a vector
+ * operation, loads of consecutive components become a vector load, and
+ * anything else is gathered from scalars with an ElementShuffleStmt.
+ *
+ * Each vector statement is placed after the last of its lanes, so memory
+ * accesses only move later, and a pack is only formed if none of the
+ * statements it moves across may access the same memory. The scalar
+ * statements are left to DIE.
+ */
+class SLPVectorize : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  SLPVectorize(IRNode *root, const CompileConfig &config)
+      : max_lanes_(std::max(config.max_vector_width, 1)) {
+    allow_undefined_visitor = true;
+    invoke_default_visitor = true;
+    irpass::analysis::gather_statements(root, [&](Stmt *stmt) {
+      for (auto op : stmt->get_operands()) {
+        if (op)
+          users_[op].push_back(stmt);
+      }
+      return false;
+    });
+  }
+
+  void visit(Block *block) override {
+    for (auto &stmt : block->statements) {
+      stmt->accept(this);
+    }
+    vectorize(block);
+  }
+
+  static bool run(IRNode *root, const CompileConfig &config) {
+    SLPVectorize pass(root, config);
+    root->accept(&pass);
+    return pass.modified_;
+  }
+
+ private:
+  struct Pack {
+    std::vector<Stmt *> lanes;
+    std::vector<Pack *> operands;
+    // Gathered from scalars instead of computed by a vector operation.
+    bool gather{false};
+    Stmt *vector{nullptr};
+  };
+
+  void vectorize(Block *block) {
+    block_ = block;
+    positions_.clear();
+    for (int i = 0; i < (int)block->statements.size(); i++) {
+      positions_[block->statements[i].get()] = i;
+    }
+
+    // Group the stores to components by their cell, in program order.
+    std::vector<Stmt *> cells;
+    std::unordered_map<Stmt *, std::vector<GlobalStoreStmt *>> stores;
+    for (auto &stmt : block->statements) {
+      auto store = stmt->cast<GlobalStoreStmt>();
+      if (!store)
+        continue;
+      auto get_ch = as_component_ptr(store->dest);
+      if (!get_ch || store->val->ret_type != get_ch->output_snode->dt)
+        continue;
+      auto &group = stores[get_ch->input_ptr];
+      if (group.empty())
+        cells.push_back(get_ch->input_ptr);
+      group.push_back(store);
+    }
+
+    for (auto cell : cells) {
+      auto &group = stores[cell];
+      std::stable_sort(group.begin(), group.end(), [](auto *a, auto *b) {
+        return a->dest->template as<GetChStmt>()->chid <
+               b->dest->template as<GetChStmt>()->chid;
+      });
+      // Split the stores into runs of adjacent components.
+      std::vector<Stmt *> run;
+      auto flush = [&]() {
+        for (int i = 0; i + 1 < (int)run.size(); i += max_lanes_) {
+          int n = std::min(max_lanes_, (int)run.size() - i);
+          if (n >= 2) {
+            vectorize_stores(
+                std::vector<Stmt *>(run.begin() + i, run.begin() + i + n));
+          }
+        }
+        run.clear();
+      };
+      for (auto store : group) {
+        if (!run.empty() &&
+            !are_adjacent_components(
+                {run.back()->as<GlobalStoreStmt>()->dest, store->dest})) {
+          flush();
+        }
+        run.push_back(store);
+      }
+      flush();
+    }
+
+    if (!insertions_.empty() || !erased_.empty()) {
+      commit(block);
+    }
+  }
+
+  void vectorize_stores(const std::vector<Stmt *> &stores) {
+    std::vector<Stmt *> ptrs, vals;
+    for (auto store : stores) {
+      ptrs.push_back(store->as<GlobalStoreStmt>()->dest);
+      vals.push_back(store->as<GlobalStoreStmt>()->val);
+    }
+    if (!can_move_to_last(stores, ptrs, /*is_store=*/true))
+      return;
+
+    packs_.clear();
+    packs_by_lanes_.clear();
+    auto val = build(vals);
+    if (!is_profitable(stores))
+      return;
+
+    auto store = Stmt::make<GlobalStoreStmt>(ptrs[0], emit(val));
+    insertions_[last_of(stores)].push_back(std::move(store));
+    for (auto s : stores) {
+      erased_.insert(s);
+    }
+    modified_ = true;
+  }
+
+  Pack *build(const std::vector<Stmt *> &lanes) {
+    auto it = packs_by_lanes_.find(lanes);
+    if (it != packs_by_lanes_.end())
+      return it->second;
+    packs_.push_back(std::make_unique<Pack>());
+    auto pack = packs_.back().get();
+    pack->lanes = lanes;
+    packs_by_lanes_[lanes] = pack;
+
+    if (!are_isomorphic(lanes)) {
+      pack->gather = true;
+      return pack;
+    }
+    for (int i = 0; i < lanes[0]->num_operands(); i++) {
+      if (lanes[0]->is<GlobalLoadStmt>())
+        break;
+      std::vector<Stmt *> operand_lanes;
+      for (auto lane : lanes) {
+        operand_lanes.push_back(lane->operand(i));
+      }
+      pack->operands.push_back(build(operand_lanes));
+    }
+    return pack;
+  }
+
+  bool are_isomorphic(const std::vector<Stmt *> &lanes) {
+    auto first = lanes[0];
+    std::unordered_set<Stmt *> distinct(lanes.begin(), lanes.end());
+    if (distinct.size() != lanes.size())
+      return false;
+    if (!is_vectorizable_type(first->ret_type))
+      return false;
+    for (auto lane : lanes) {
+      if (lane->parent != block_ || typeid(*lane) != typeid(*first) ||
+          lane->ret_type != first->ret_type) {
+        return false;
+      }
+    }
+    if (first->is<GlobalLoadStmt>()) {
+      std::vector<Stmt *> ptrs;
+      for (auto lane : lanes) {
+        ptrs.push_back(lane->as<GlobalLoadStmt>()->src);
+      }
+      return are_adjacent_components(ptrs) &&
+             can_move_to_last(lanes, ptrs, /*is_store=*/false);
+    }
+    if (!is_vectorizable_op(first))
+      return false;
+    for (auto lane : lanes) {
+      if (auto binary = lane->cast<BinaryOpStmt>()) {
+        if (binary->op_type != first->as<BinaryOpStmt>()->op_type)
+          return false;
+      } else if (lane->as<UnaryOpStmt>()->op_type !=
+                 first->as<UnaryOpStmt>()->op_type) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether the memory accesses |lanes| to |ptrs| can all be moved to the
+  // position of the last of them. As memory accesses only move later, two
+  // accesses can only be reordered if one of them moves across the original
+  // position of the other, which is checked here.
+  bool can_move_to_last(const std::vector<Stmt *> &lanes,
+                        const std::vector<Stmt *> &ptrs,
+                        bool is_store) {
+    std::unordered_set<Stmt *> lane_set(lanes.begin(), lanes.end());
+    int end = positions_[last_of(lanes)];
+    for (int k = 0; k < (int)lanes.size(); k++) {
+      auto may_alias = [&](const std::vector<Stmt *> &others) {
+        for (auto other : others) {
+          if (irpass::analysis::maybe_same_address(other, ptrs[k]))
+            return true;
+        }
+        return false;
+      };
+      auto conflicts = [&](Stmt *stmt) {
+        auto dests = irpass::analysis::get_store_destination(stmt);
+        if (dests.empty()) {
+          // Control flow and operations with unknown effects.
+          if (stmt->has_global_side_effect())
+            return true;
+        } else if (may_alias(dests)) {
+          return true;
+        }
+        return is_store &&
+               may_alias(irpass::analysis::get_load_pointers(stmt));
+      };
+      for (int i = positions_[lanes[k]] + 1; i < end; i++) {
+        auto stmt = block_->statements[i].get();
+        if (lane_set.count(stmt))
+          continue;
+        if (!irpass::analysis::gather_statements(stmt, conflicts).empty())
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Every vector operation saves the scalar operations of its lanes, unless a
+  // lane is also used outside the tree. Gathering scalars costs an insertion
+  // per variable lane.
+  bool is_profitable(const std::vector<Stmt *> &stores) {
+    std::unordered_set<Stmt *> tree(stores.begin(), stores.end());
+    for (auto &pack : packs_) {
+      if (!pack->gather)
+        tree.insert(pack->lanes.begin(), pack->lanes.end());
+    }
+    int saved = (int)stores.size() - 1, cost = 0;
+    for (auto &pack : packs_) {
+      if (pack->gather) {
+        std::unordered_set<Stmt *> distinct(pack->lanes.begin(),
+                                            pack->lanes.end());
+        if (distinct.size() == 1) {
+          cost += 1;  // a broadcast
+          continue;
+        }
+        for (auto lane : distinct) {
+          if (!lane->is<ConstStmt>())
+            cost += 1;
+        }
+        continue;
+      }
+      saved += (int)pack->lanes.size() - 1;
+      for (auto lane : pack->lanes) {
+        for (auto user : users_[lane]) {
+          if (!tree.count(user)) {
+            saved -= 1;
+            break;
+          }
+        }
+      }
+    }
+    return saved > cost;
+  }
+
+  Stmt *emit(Pack *pack) {
+    if (pack->vector)
+      return pack->vector;
+    std::vector<Stmt *> operands;
+    for (auto operand : pack->operands) {
+      operands.push_back(emit(operand));
+    }
+    auto first = pack->lanes[0];
+    std::unique_ptr<Stmt> vector;
+    if (pack->gather) {
+      LaneAttribute<VectorElement> elements;
+      for (auto lane : pack->lanes) {
+        elements.push_back(VectorElement(lane, 0));
+      }
+      vector = Stmt::make<ElementShuffleStmt>(elements);
+    } else {
+      if (auto load = first->cast<GlobalLoadStmt>()) {
+        vector = Stmt::make<GlobalLoadStmt>(load->src);
+      } else if (auto binary = first->cast<BinaryOpStmt>()) {
+        vector = Stmt::make<BinaryOpStmt>(binary->op_type, operands[0],
+                                          operands[1]);
+      } else {
+        vector = Stmt::make<UnaryOpStmt>(first->as<UnaryOpStmt>()->op_type,
+                                         operands[0]);
+      }
+      vector->ret_type = TypeFactory::create_tensor_type(
+          {(int)pack->lanes.size()}, first->ret_type);
+    }
+    pack->vector = vector.get();
+    insertions_[last_of(pack->lanes)].push_back(std::move(vector));
+    return pack->vector;
+  }
+
+  // The last statement of |stmts| in this block, or nullptr if none of them
+  // is in this block.
+  Stmt *last_of(const std::vector<Stmt *> &stmts) {
+    Stmt *last = nullptr;
+    for (auto stmt : stmts) {
+      auto it = positions_.find(stmt);
+      if (it != positions_.end() &&
+          (!last || it->second > positions_[last])) {
+        last = stmt;
+      }
+    }
+    return last;
+  }
+
+  // Inserts the vector statements after their anchors and erases the
+  // vectorized stores, with one pass over the block.
+  void commit(Block *block) {
+    std::vector<pStmt> statements;
+    statements.reserve(block->statements.size() + insertions_.size());
+    auto insert_after = [&](Stmt *anchor) {
+      auto it = insertions_.find(anchor);
+      if (it == insertions_.end())
+        return;
+      for (auto &stmt : it->second) {
+        stmt->parent = block;
+        statements.push_back(std::move(stmt));
+      }
+    };
+    insert_after(nullptr);
+    for (auto &stmt : block->statements) {
+      auto anchor = stmt.get();
+      if (erased_.count(anchor)) {
+        stmt->erased = true;
+        block->trash_bin.push_back(std::move(stmt));
+      } else {
+        statements.push_back(std::move(stmt));
+      }
+      insert_after(anchor);
+    }
+    block->statements = std::move(statements);
+    insertions_.clear();
+    erased_.clear();
+  }
+
+  const int max_lanes_;
+  bool modified_{false};
+  std::unordered_map<Stmt *, std::vector<Stmt *>> users_;
+
+  // States of the block being vectorized
+  Block *block_{nullptr};
+  std::unordered_map<Stmt *, int> positions_;
+  std::unordered_map<Stmt *, std::vector<pStmt>> insertions_;
+  std::unordered_set<Stmt *> erased_;
+
+  // States of the tree being built
+  std::vector<std::unique_ptr<Pack>> packs_;
+  std::map<std::vector<Stmt *>, Pack *> packs_by_lanes_;
+};
+
+namespace irpass {
+
+bool slp_vectorize(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  return SLPVectorize::run(root, config);
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
@@ -379,7 +379,7 @@ class TypeCheck : public IRVisitor {
 
   void visit(ElementShuffleStmt *stmt) override {
     TI_ASSERT(stmt->elements.size() != 0);
-    stmt->element_type() = stmt->elements[0].stmt->element_type();
+    stmt->ret_type = stmt->infer_ret_type();
   }
 
   void visit(RangeAssumptionStmt *stmt) override {
@@ -0,0 +1,380 @@
+// Worklist-driven simplification
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+TLANG_NAMESPACE_BEGIN
+
+namespace {
+
+// Collects all statements (including container statements) in program
+// order.
+class StatementCollector : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  std::vector<Stmt *> statements;
+
+  StatementCollector() {
+    allow_undefined_visitor = true;
+    invoke_default_visitor = true;
+  }
+
+  void visit(Stmt *stmt) override {
+    statements.push_back(stmt);
+  }
+
+  void preprocess_container_stmt(Stmt *stmt) override {
+    statements.push_back(stmt);
+  }
+};
+
+}  // namespace
+
+// Unlike the fixpoint driver in full_simplify(), which reruns every pass on
+// the whole IR until nothing changes, this pass visits a statement again
+// only when one of its operands or users has changed.
+//
+// Def-use chains are built once. The rewrite rules, dispatched on the
+// statement kind by the visitor, are a subset of alg_simp, constant_fold and
+// die which only need the statement and its operands to decide. Erasures and
+// insertions are recorded and applied to each affected block in a single
+// sweep at the end, so a rewrite costs O(#users) rather than O(#statements).
+class WorklistSimplify : public IRVisitor {
+ public:
+  WorklistSimplify(IRNode *root, const CompileConfig &config)
+      : root_(root), config_(config) {
+    allow_undefined_visitor = true;
+    invoke_default_visitor = false;
+  }
+
+  bool run() {
+    StatementCollector collector;
+    root_->accept(&collector);
+    // These must be neither replaced nor eliminated.
+    pinned_ = irpass::analysis::gather_non_operand_references(root_);
+    for (auto *stmt : collector.statements) {
+      add_uses(stmt);
+    }
+    for (auto *stmt : collector.statements) {
+      enqueue(stmt);
+    }
+    while (!worklist_.empty()) {
+      auto *stmt = worklist_.front();
+      worklist_.pop_front();
+      in_worklist_.erase(stmt);
+      if (erased_.find(stmt) != erased_.end())
+        continue;
+      if (is_dead(stmt)) {
+        erase(stmt);
+        continue;
+      }
+      stmt->accept(this);
+    }
+    commit();
+    return modified_;
+  }
+
+  void visit(UnaryOpStmt *stmt) override {
+    if (stmt->is_cast() && stmt->cast_type == stmt->operand->ret_type) {
+      // cast<T>(a) -> a if a is of type T
+      replace_with_operand(stmt, stmt->operand);
+      return;
+    }
+    auto *operand = stmt->operand->cast<ConstStmt>();
+    if (!config_.constant_folding || stmt->width() != 1 || !operand ||
+        !is_foldable(stmt->ret_type) || operand->ret_type != stmt->ret_type) {
+      return;
+    }
+    uint64 val = (uint64)operand->val[0].val_as_int64();
+    if (stmt->op_type == UnaryOpType::neg) {
+      replace_with_constant(stmt, 0 - val);
+    } else if (stmt->op_type == UnaryOpType::bit_not) {
+      replace_with_constant(stmt, ~val);
+    }
+  }
+
+  void visit(BinaryOpStmt *stmt) override {
+    if (stmt->width() != 1)
+      return;
+    auto *lhs = stmt->lhs->cast<ConstStmt>();
+    auto *rhs = stmt->rhs->cast<ConstStmt>();
+    if (lhs && rhs && try_fold(stmt, lhs, rhs))
+      return;
+    auto op = stmt->op_type;
+    if (op == BinaryOpType::add || op == BinaryOpType::bit_or ||
+        op == BinaryOpType::bit_xor) {
+      // a +|^ 0 -> a, 0 +|^ a -> a
+      if (is_value(rhs, 0) && replace_with_operand(stmt, stmt->lhs))
+        return;
+      if (is_value(lhs, 0) && replace_with_operand(stmt, stmt->rhs))
+        return;
+    } else if (op == BinaryOpType::sub) {
+      // a - 0 -> a
+      if (is_value(rhs, 0) && replace_with_operand(stmt, stmt->lhs))
+        return;
+    } else if (op == BinaryOpType::mul) {
+      // a * 1 -> a, 1 * a -> a
+      if (is_value(rhs, 1) && replace_with_operand(stmt, stmt->lhs))
+        return;
+      if (is_value(lhs, 1) && replace_with_operand(stmt, stmt->rhs))
+        return;
+    } else if (op == BinaryOpType::div || op == BinaryOpType::floordiv) {
+      // a / 1 -> a
+      if (is_value(rhs, 1) && replace_with_operand(stmt, stmt->lhs))
+        return;
+    } else if (op == BinaryOpType::bit_and) {
+      // a & -1 -> a, -1 & a -> a
+      if (is_value(rhs, -1) && replace_with_operand(stmt, stmt->lhs))
+        return;
+      if (is_value(lhs, -1) && replace_with_operand(stmt, stmt->rhs))
+        return;
+    } else if (op == BinaryOpType::bit_shl || op == BinaryOpType::bit_shr ||
+               op == BinaryOpType::bit_sar) {
+      // a << 0 -> a, a >> 0 -> a
+      if (is_value(rhs, 0) && replace_with_operand(stmt, stmt->lhs))
+        return;
+    }
+    if (!is_integral(stmt->ret_type) ||
+        !irpass::analysis::same_value(stmt->lhs, stmt->rhs)) {
+      return;
+    }
+    if (op == BinaryOpType::bit_and || op == BinaryOpType::bit_or ||
+        op == BinaryOpType::min || op == BinaryOpType::max) {
+      // a &|min|max a -> a
+      replace_with_operand(stmt, stmt->lhs);
+    } else if ((op == BinaryOpType::sub || op == BinaryOpType::bit_xor) &&
+               is_foldable(stmt->ret_type)) {
+      // a -^ a -> 0
+      replace_with_constant(stmt, 0);
+    }
+  }
+
+  void visit(AssertStmt *stmt) override {
+    auto *cond = stmt->cond->cast<ConstStmt>();
+    if (cond && cond->width() == 1 && !cond->val[0].equal_value(0)) {
+      // this statement has no effect
+      erase(stmt);
+    }
+  }
+
+  void visit(WhileControlStmt *stmt) override {
+    auto *cond = stmt->cond->cast<ConstStmt>();
+    if (cond && cond->width() == 1 && !cond->val[0].equal_value(0)) {
+      // this statement has no effect
+      erase(stmt);
+    }
+  }
+
+ private:
+  // The integer types whose arithmetic is folded here: the operations wrap
+  // around exactly like their uint64 counterparts truncated to the type.
+  static bool is_foldable(DataType dt) {
+    return dt->is_primitive(PrimitiveTypeID::i32) ||
+           dt->is_primitive(PrimitiveTypeID::i64) ||
+           dt->is_primitive(PrimitiveTypeID::u32) ||
+           dt->is_primitive(PrimitiveTypeID::u64);
+  }
+
+  static bool is_value(ConstStmt *stmt, int value) {
+    if (!stmt || stmt->width() != 1)
+      return false;
+    return stmt->val[0].equal_value(value);
+  }
+
+  bool try_fold(BinaryOpStmt *stmt, ConstStmt *lhs, ConstStmt *rhs) {
+    auto dt = stmt->ret_type;
+    if (!config_.constant_folding || !is_foldable(dt) ||
+        lhs->ret_type != dt || rhs->ret_type != dt) {
+      return false;
+    }
+    uint64 a = (uint64)lhs->val[0].val_as_int64();
+    uint64 b = (uint64)rhs->val[0].val_as_int64();
+    bool less = is_signed(dt) ? (int64)a < (int64)b : a < b;
+    switch (stmt->op_type) {
+      case BinaryOpType::add:
+        replace_with_constant(stmt, a + b);
+        return true;
+      case BinaryOpType::sub:
+        replace_with_constant(stmt, a - b);
+        return true;
+      case BinaryOpType::mul:
+        replace_with_constant(stmt, a * b);
+        return true;
+      case BinaryOpType::bit_and:
+        replace_with_constant(stmt, a & b);
+        return true;
+      case BinaryOpType::bit_or:
+        replace_with_constant(stmt, a | b);
+        return true;
+      case BinaryOpType::bit_xor:
+        replace_with_constant(stmt, a ^ b);
+        return true;
+      case BinaryOpType::min:
+        replace_with_constant(stmt, less ? a : b);
+        return true;
+      case BinaryOpType::max:
+        replace_with_constant(stmt, less ? b : a);
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool can_replace(Stmt *stmt) const {
+    return pinned_.find(stmt) == pinned_.end();
+  }
+
+  bool replace_with_operand(Stmt *stmt, Stmt *operand) {
+    if (!can_replace(stmt) || operand->ret_type != stmt->ret_type)
+      return false;
+    replace(stmt, operand);
+    return true;
+  }
+
+  void replace_with_constant(Stmt *stmt, uint64 value) {
+    if (!can_replace(stmt))
+      return;
+    auto *constant = insert_before(
+        stmt, Stmt::make<ConstStmt>(LaneAttribute<TypedConstant>(
+                  TypedConstant(stmt->ret_type, value))));
+    replace(stmt, constant);
+  }
+
+  bool is_dead(Stmt *stmt) const {
+    if (stmt->is_container_statement() || !stmt->dead_instruction_eliminable())
+      return false;
+    if (pinned_.find(stmt) != pinned_.end())
+      return false;
+    auto it = num_uses_.find(stmt);
+    return it == num_uses_.end() || it->second == 0;
+  }
+
+  void enqueue(Stmt *stmt) {
+    if (in_worklist_.insert(stmt).second)
+      worklist_.push_back(stmt);
+  }
+
+  void add_uses(Stmt *stmt) {
+    for (auto *op : stmt->get_operands()) {
+      if (op) {
+        num_uses_[op]++;
+        users_[op].push_back(stmt);
+      }
+    }
+  }
+
+  // Redirects all users of |old_stmt| to |new_stmt| and erases |old_stmt|.
+  void replace(Stmt *old_stmt, Stmt *new_stmt) {
+    TI_ASSERT(can_replace(old_stmt));
+    auto users = std::move(users_[old_stmt]);
+    users_.erase(old_stmt);
+    for (auto *user : users) {
+      if (erased_.find(user) != erased_.end())
+        continue;
+      int num_uses = 0;
+      for (int i = 0; i < user->num_operands(); i++) {
+        if (user->operand(i) == old_stmt)
+          num_uses++;
+      }
+      if (num_uses == 0)
+        continue;  // already redirected, or |user| appears twice
+      user->replace_operand_with(old_stmt, new_stmt);
+      num_uses_[new_stmt] += num_uses;
+      users_[new_stmt].push_back(user);
+      enqueue(user);
+    }
+    num_uses_[old_stmt] = 0;
+    enqueue(new_stmt);
+    erase(old_stmt);
+  }
+
+  void erase(Stmt *stmt) {
+    TI_ASSERT(num_uses_[stmt] == 0 || !stmt->dead_instruction_eliminable());
+    erased_.insert(stmt);
+    for (auto *op : stmt->get_operands()) {
+      if (op && --num_uses_[op] == 0)
+        enqueue(op);
+    }
+    touched_blocks_.insert(stmt->parent);
+    modified_ = true;
+  }
+
+  Stmt *insert_before(Stmt *anchor, std::unique_ptr<Stmt> &&new_stmt) {
+    auto *stmt = new_stmt.get();
+    stmt->parent = anchor->parent;
+    add_uses(stmt);
+    pending_insertions_[anchor].push_back(std::move(new_stmt));
+    touched_blocks_.insert(anchor->parent);
+    enqueue(stmt);
+    modified_ = true;
+    return stmt;
+  }
+
+  void emit(std::unique_ptr<Stmt> &&stmt,
+            Block *block,
+            std::vector<std::unique_ptr<Stmt>> &statements) {
+    auto it = pending_insertions_.find(stmt.get());
+    if (it != pending_insertions_.end()) {
+      auto inserted = std::move(it->second);
+      pending_insertions_.erase(it);
+      for (auto &s : inserted) {
+        emit(std::move(s), block, statements);
+      }
+    }
+    if (erased_.find(stmt.get()) != erased_.end()) {
+      stmt->erased = true;
+      block->trash_bin.push_back(std::move(stmt));
+    } else {
+      statements.push_back(std::move(stmt));
+    }
+  }
+
+  // Applies the recorded insertions and erasures, one pass per block.
+  void commit() {
+    for (auto *block : touched_blocks_) {
+      std::vector<std::unique_ptr<Stmt>> statements;
+      statements.reserve(block->statements.size());
+      for (auto &stmt : block->statements) {
+        emit(std::move(stmt), block, statements);
+      }
+      block->statements = std::move(statements);
+    }
+    TI_ASSERT(pending_insertions_.empty());
+  }
+
+  IRNode *root_;
+  const CompileConfig &config_;
+  bool modified_{false};
+
+  std::deque<Stmt *> worklist_;
+  std::unordered_set<Stmt *> in_worklist_;
+  std::unordered_map<Stmt *, int> num_uses_;
+  // May contain stale entries; they are checked against the operands.
+  std::unordered_map<Stmt *, std::vector<Stmt *>> users_;
+  std::unordered_set<Stmt *> pinned_;
+  std::unordered_set<Stmt *> erased_;
+  std::unordered_map<Stmt *, std::vector<std::unique_ptr<Stmt>>>
+      pending_insertions_;
+  std::unordered_set<Block *> touched_blocks_;
+};
+
+namespace irpass {
+
+bool worklist_simplify(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  WorklistSimplify simplifier(root, config);
+  return simplifier.run();
+}
+
+}  // namespace irpass
+
+TLANG_NAMESPACE_END
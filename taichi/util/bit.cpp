@@ -24,6 +24,12 @@ std::size_t Bitset::size() const {
   return vec_.size() * kBits;
 }
 
+void Bitset::resize(int n) {
+  vec_.resize((n + kBits - 1) / kBits, 0);
+  if (n % kBits != 0)
+    vec_.back() &= (((value_t)1) << (n % kBits)) - 1;
+}
+
 void Bitset::reset() {
   for (auto &value : vec_) {
     value = 0;
@@ -174,6 +174,8 @@ class Bitset {
   Bitset();
   explicit Bitset(int n);
   std::size_t size() const;
+  // Keeps the first min(n, size()) bits. New bits are zero.
+  void resize(int n);
   void reset();
   void flip(int x);
   bool any() const;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "taichi/common/core.h"
+
+TI_NAMESPACE_BEGIN
+
+// A bounded lock-free multi-producer multi-consumer queue, after Dmitry
+// Vyukov's design. Each slot carries a sequence number, which tells whether
+// it is ready to be written or read in the current lap around the ring.
+template <typename T>
+class MPMCQueue {
+ public:
+  // |capacity| must be a power of two.
+  explicit MPMCQueue(std::size_t capacity)
+      : mask_(capacity - 1), slots_(new Slot[capacity]) {
+    TI_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+    for (std::size_t i = 0; i < capacity; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPMCQueue(const MPMCQueue &) = delete;
+  MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+  // Returns false if the queue is full.
+  bool try_push(const T &value) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[pos & mask_];
+      const std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = (std::intptr_t)seq - (std::intptr_t)pos;
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the queue is empty.
+  bool try_pop(T &value) {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[pos & mask_];
+      const std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = (std::intptr_t)seq - (std::intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          value = std::move(slot.value);
+          // Release whatever the moved-from value still holds.
+          slot.value = T();
+          slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  const std::size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  // Kept on separate cache lines, since producers and consumers contend on
+  // them independently.
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+TI_NAMESPACE_END
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "tests/cpp/struct/fake_struct_compiler.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+constexpr int kSize = 64;
+constexpr int64 kMaxCost = 1 << 16;
+
+class GroupIndependentOffloadsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_snode_ = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+    const std::vector<Axis> axes = {Axis{0}};
+    for (auto &place : places_) {
+      place = &(root_snode_->dense(axes, kSize, false)
+                    .insert_children(SNodeType::place));
+      place->dt = PrimitiveType::i32;
+    }
+    FakeStructCompiler sc;
+    sc.run(*root_snode_);
+    root_ = std::make_unique<Block>();
+  }
+
+  // Appends a range-for over [0, |end|) that runs dst[i] = src[i], or
+  // dst[i] = i if |src| is null.
+  OffloadedStmt *copy(SNode *dst, SNode *src, int end = kSize) {
+    auto offload = Stmt::make_typed<OffloadedStmt>(
+        OffloadedStmt::TaskType::range_for, Arch::x64);
+    offload->const_begin = true;
+    offload->const_end = true;
+    offload->begin_value = 0;
+    offload->end_value = end;
+    auto loop = offload.get();
+    root_->insert(std::move(offload));
+
+    IRBuilder builder;
+    builder.set_insertion_point({loop->body.get(), 0});
+    Stmt *val = builder.get_loop_index(loop);
+    if (src) {
+      val = builder.create_global_load(
+          builder.create_global_ptr(src, {builder.get_loop_index(loop)}));
+    }
+    builder.create_global_store(
+        builder.create_global_ptr(dst, {builder.get_loop_index(loop)}), val);
+    return loop;
+  }
+
+  std::unique_ptr<SNode> root_snode_;
+  SNode *places_[3]{};
+  std::unique_ptr<Block> root_;
+};
+
+TEST_F(GroupIndependentOffloadsTest, DisjointTasksShareGroup) {
+  auto [a, b, c] = places_;
+  copy(a, nullptr);
+  copy(b, nullptr);
+  copy(c, a);
+  copy(a, b);
+
+  // c = a reads what a = i writes, and a = b overwrites what c = a reads.
+  EXPECT_EQ(irpass::analysis::group_independent_offloads(root_.get(), kMaxCost),
+            (std::vector<int>{0, 2, 3}));
+}
+
+TEST_F(GroupIndependentOffloadsTest, LargeTasksRunAlone) {
+  auto [a, b, c] = places_;
+  copy(a, nullptr);
+  copy(b, nullptr, /*end=*/kMaxCost);
+  copy(c, nullptr);
+
+  EXPECT_EQ(irpass::analysis::group_independent_offloads(root_.get(), kMaxCost),
+            (std::vector<int>{0, 1, 2}));
+}
+
+}  // namespace
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,117 @@
+#include <limits>
+
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/struct/fake_struct_compiler.h"
+
+namespace taichi {
+namespace lang {
+namespace irpass {
+namespace analysis {
+
+namespace {
+
+void expect_range(Stmt *stmt, int64 low, int64 high) {
+  auto range = value_range(stmt);
+  EXPECT_EQ(range.low, low);
+  EXPECT_EQ(range.high, high);
+}
+
+}  // namespace
+
+TEST(ValueRange, NdrangeIndices) {
+  // for I in range(12): i, j = I // 4 + 1, I % 4
+  IRBuilder builder;
+  auto *loop = builder.create_range_for(builder.get_int32(0),
+                                        builder.get_int32(12));
+  Stmt *i, *j, *masked, *linear;
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *index = builder.get_loop_index(loop);
+    auto *four = builder.get_int32(4);
+    i = builder.create_add(builder.create_floordiv(index, four),
+                           builder.get_int32(1));
+    j = builder.create_mod(index, four);
+    masked = builder.create_and(index, builder.get_int32(7));
+    linear = builder.create_add(builder.create_mul(i, four), j);
+  }
+  auto block = builder.extract_ir();
+  CompileConfig config;
+  type_check(block.get(), config);
+
+  expect_range(i, 1, 3);
+  expect_range(j, 0, 3);
+  expect_range(masked, 0, 7);
+  expect_range(linear, 4, 15);
+}
+
+TEST(ValueRange, RangeAssumption) {
+  IRBuilder builder;
+  auto *base = builder.create_arg_load(0, PrimitiveType::i32, false);
+  auto *loop = builder.create_range_for(builder.get_int32(0), base);
+  Stmt *assumed, *unknown;
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *index = builder.get_loop_index(loop);
+    // The loop end is unknown, but ti.assume_in_range(index, 0, 0, 16).
+    assumed = builder.insert(Stmt::make_typed<RangeAssumptionStmt>(
+        index, builder.get_int32(0), 0, 16));
+    unknown = builder.create_add(index, builder.get_int32(1));
+  }
+  auto block = builder.extract_ir();
+  CompileConfig config;
+  type_check(block.get(), config);
+
+  expect_range(assumed, 0, 15);
+  auto range = value_range(unknown);
+  EXPECT_FALSE(range.within(0, std::numeric_limits<int32>::max() - 1));
+}
+
+TEST(ValueRange, StructForOverNonLeadingAxis) {
+  // ti.root.dense(ti.j, 12)
+  auto root = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+  auto &dense = root->dense(Axis{1}, 12, false);
+  auto &place = dense.insert_children(SNodeType::place);
+  place.dt = PrimitiveType::i32;
+  FakeStructCompiler sc;
+  sc.run(*root);
+
+  IRBuilder builder;
+  auto *loop = builder.create_struct_for(&dense);
+  Stmt *j;
+  {
+    auto _ = builder.get_loop_guard(loop);
+    j = builder.get_loop_index(loop, /*index=*/1);
+  }
+  auto block = builder.extract_ir();
+  CompileConfig config;
+  type_check(block.get(), config);
+
+  expect_range(j, 0, 11);
+}
+
+TEST(ValueRange, Overflow) {
+  IRBuilder builder;
+  auto *big = builder.get_int32(1 << 30);
+  auto *sum = builder.create_add(big, big);
+  auto *wide_big = builder.get_int64(1LL << 30);
+  auto *wide_sum = builder.create_add(wide_big, wide_big);
+  auto block = builder.extract_ir();
+  CompileConfig config;
+  type_check(block.get(), config);
+
+  // 2^31 wraps around in i32, but not in i64.
+  expect_range(sum, std::numeric_limits<int32>::min(),
+               std::numeric_limits<int32>::max());
+  expect_range(wide_sum, 1LL << 31, 1LL << 31);
+}
+
+}  // namespace analysis
+}  // namespace irpass
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#ifdef TI_WITH_LLVM
+
+#include "taichi/backends/cpu/cpu_isa.h"
+
+namespace taichi {
+namespace lang {
+
+namespace {
+
+CpuFeatures features_of(CpuIsaLevel level) {
+  CpuFeatures features;
+  for (auto &feature : cpu_isa_level_features(level)) {
+    features[feature] = true;
+  }
+  return features;
+}
+
+}  // namespace
+
+TEST(CpuIsa, Names) {
+  for (auto level : {CpuIsaLevel::x86_64, CpuIsaLevel::x86_64_v2,
+                     CpuIsaLevel::x86_64_v3, CpuIsaLevel::x86_64_v4}) {
+    EXPECT_EQ(cpu_isa_level_from_name(cpu_isa_level_name(level)), level);
+  }
+  EXPECT_FALSE(cpu_isa_level_from_name("avx2").has_value());
+}
+
+TEST(CpuIsa, SelectFromFeatures) {
+  const std::string all = "x86-64-v2,x86-64-v3,x86-64-v4";
+  // Broadwell has AVX2 but no AVX-512.
+  auto broadwell = features_of(CpuIsaLevel::x86_64_v3);
+  broadwell["avx512f"] = false;
+  EXPECT_EQ(select_cpu_isa_level(all, broadwell), CpuIsaLevel::x86_64_v3);
+
+  auto skylake_sp = features_of(CpuIsaLevel::x86_64_v4);
+  EXPECT_EQ(select_cpu_isa_level(all, skylake_sp), CpuIsaLevel::x86_64_v4);
+  EXPECT_EQ(select_cpu_isa_level("x86-64-v2,x86-64-v3", skylake_sp),
+            CpuIsaLevel::x86_64_v3);
+
+  // AVX2 without FMA does not make x86-64-v3.
+  auto no_fma = features_of(CpuIsaLevel::x86_64_v3);
+  no_fma.erase("fma");
+  EXPECT_EQ(select_cpu_isa_level(all, no_fma), CpuIsaLevel::x86_64_v2);
+  EXPECT_EQ(select_cpu_isa_level("x86-64,x86-64-v3", no_fma),
+            CpuIsaLevel::x86_64);
+}
+
+}  // namespace lang
+}  // namespace taichi
+
+#endif
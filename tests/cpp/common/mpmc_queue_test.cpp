@@ -0,0 +1,67 @@
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "taichi/util/mpmc_queue.h"
+
+namespace taichi {
+
+TEST(MPMCQueueTest, Basic) {
+  MPMCQueue<int> queue(4);
+  int value = 0;
+  EXPECT_FALSE(queue.try_pop(value));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+  for (int lap = 0; lap < 3; lap++) {
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, lap);
+    EXPECT_TRUE(queue.try_push(lap + 4));
+  }
+  for (int i = 3; i < 7; i++) {
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(MPMCQueueTest, ConcurrentProducersAndConsumers) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumValuesPerProducer = 10000;
+  MPMCQueue<int> queue(64);
+  std::vector<int> counts(kNumValuesPerProducer, 0);
+  std::vector<std::vector<int>> popped(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kNumValuesPerProducer; i++) {
+        while (!queue.try_push(i))
+          std::this_thread::yield();
+      }
+    });
+    threads.emplace_back([&, t]() {
+      int value;
+      while ((int)popped[t].size() < kNumValuesPerProducer) {
+        if (queue.try_pop(value))
+          popped[t].push_back(value);
+        else
+          std::this_thread::yield();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &values : popped) {
+    for (auto value : values) {
+      counts[value]++;
+    }
+  }
+  for (int i = 0; i < kNumValuesPerProducer; i++) {
+    EXPECT_EQ(counts[i], kNumThreads);
+  }
+}
+
+}  // namespace taichi
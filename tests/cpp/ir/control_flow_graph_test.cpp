@@ -0,0 +1,153 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/control_flow_graph.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/program/test_program.h"
+
+namespace taichi {
+namespace lang {
+
+namespace {
+
+// Checks that the bitvector-based dataflow analyses produce the same sets as
+// the reference implementations on every node.
+void expect_same_dataflow(IRNode *root) {
+  for (bool after_lower_access : {false, true}) {
+    auto cfg = irpass::analysis::build_cfg(root);
+    cfg->simplify_graph();
+    const int num_nodes = cfg->size();
+
+    cfg->reaching_definition_analysis_reference(after_lower_access);
+    cfg->live_variable_analysis_reference(after_lower_access, std::nullopt);
+    std::vector<std::unordered_set<Stmt *>> reach_in, reach_out, live_in,
+        live_out;
+    for (auto &node : cfg->nodes) {
+      reach_in.push_back(node->reach_in);
+      reach_out.push_back(node->reach_out);
+      live_in.push_back(node->live_in);
+      live_out.push_back(node->live_out);
+    }
+
+    cfg->reaching_definition_analysis(after_lower_access);
+    cfg->live_variable_analysis(after_lower_access, std::nullopt);
+    for (int i = 0; i < num_nodes; i++) {
+      EXPECT_EQ(cfg->nodes[i]->reach_in, reach_in[i]);
+      EXPECT_EQ(cfg->nodes[i]->reach_out, reach_out[i]);
+      EXPECT_EQ(cfg->nodes[i]->live_in, live_in[i]);
+      EXPECT_EQ(cfg->nodes[i]->live_out, live_out[i]);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ControlFlowGraph, DataflowStraightLine) {
+  TestProgram test_prog;
+  test_prog.setup();
+
+  // The kernel of AlgebraicSimplicationTest.SimplifyMultiplyOne.
+  auto block = std::make_unique<Block>();
+  auto func = []() {};
+  auto kernel =
+      std::make_unique<Kernel>(*test_prog.prog(), func, "fake_kernel");
+  block->kernel = kernel.get();
+
+  auto global_load_addr = block->push_back<GlobalTemporaryStmt>(
+      0, TypeFactory::create_vector_or_scalar_type(1, PrimitiveType::f32));
+  auto global_load = block->push_back<GlobalLoadStmt>(global_load_addr);
+  auto one = block->push_back<ConstStmt>(TypedConstant(1.0f));
+  auto mul1 =
+      block->push_back<BinaryOpStmt>(BinaryOpType::mul, one, global_load);
+  auto mul2 = block->push_back<BinaryOpStmt>(BinaryOpType::mul, mul1, one);
+  auto global_store_addr = block->push_back<GlobalTemporaryStmt>(
+      4, TypeFactory::create_vector_or_scalar_type(1, PrimitiveType::f32));
+  block->push_back<GlobalStoreStmt>(global_store_addr, mul2);
+  block->push_back<GlobalStoreStmt>(global_load_addr, mul1);
+  irpass::type_check(block.get(), CompileConfig());
+
+  expect_same_dataflow(block.get());
+}
+
+TEST(ControlFlowGraph, DataflowLoopsAndBranches) {
+  IRBuilder builder;
+  auto *arg = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *zero = builder.get_int32(0);
+  auto *one = builder.get_int32(1);
+  auto *ten = builder.get_int32(10);
+  auto *sum = builder.create_local_var(PrimitiveType::i32);
+  auto *counter = builder.create_local_var(PrimitiveType::i32);
+  builder.create_local_store(counter, zero);
+  auto *loop = builder.create_range_for(zero, ten);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *index = builder.get_loop_index(loop, 0);
+    auto *ptr = builder.create_external_ptr(arg, {index});
+    auto *value = builder.create_global_load(ptr);
+    auto *cond = builder.create_cmp_lt(index, builder.get_int32(5));
+    auto *if_stmt = builder.create_if(cond);
+    {
+      auto _ = builder.get_if_guard(if_stmt, true);
+      builder.create_local_store(
+          sum, builder.create_add(builder.create_local_load(sum), index));
+      builder.create_global_store(ptr, value);
+    }
+    {
+      auto _ = builder.get_if_guard(if_stmt, false);
+      builder.create_local_store(sum, zero);
+    }
+  }
+  auto *while_loop = builder.create_while_true();
+  {
+    auto _ = builder.get_loop_guard(while_loop);
+    auto *c = builder.create_local_load(counter);
+    auto *if_stmt = builder.create_if(builder.create_cmp_ge(c, ten));
+    {
+      auto _ = builder.get_if_guard(if_stmt, true);
+      builder.create_break();
+    }
+    builder.create_local_store(counter, builder.create_add(c, one));
+  }
+  auto *ptr = builder.create_external_ptr(arg, {zero});
+  builder.create_global_store(ptr, builder.create_local_load(sum));
+  auto block = builder.extract_ir();
+
+  expect_same_dataflow(block.get());
+
+  // The optimizations built on top of the analyses must still be sound.
+  irpass::cfg_optimization(block.get(), false);
+  expect_same_dataflow(block.get());
+}
+
+TEST(ControlFlowGraph, CachedBetweenPasses) {
+  IRBuilder builder;
+  auto *arg = builder.create_arg_load(0, PrimitiveType::i32, true);
+  auto *zero = builder.get_int32(0);
+  auto *ptr = builder.create_external_ptr(arg, {zero});
+  builder.create_global_store(
+      ptr, builder.create_add(builder.create_global_load(ptr),
+                              builder.get_int32(1)));
+  auto block = builder.extract_ir();
+
+  AnalysisManager amgr;
+  EXPECT_FALSE(
+      irpass::cfg_optimization(block.get(), false, std::nullopt, &amgr));
+  auto *cached = amgr.get_cached_analysis<BuildCFGPass>();
+  ASSERT_NE(cached, nullptr);
+  auto *cfg = cached->cfg.get();
+  // The next run starts from the same CFG.
+  irpass::cfg_optimization(block.get(), false, std::nullopt, &amgr);
+  cached = amgr.get_cached_analysis<BuildCFGPass>();
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->cfg.get(), cfg);
+
+  amgr.invalidate(PreservedAnalyses::none().preserve<BuildCFGPass>());
+  EXPECT_NE(amgr.get_cached_analysis<BuildCFGPass>(), nullptr);
+  amgr.invalidate();
+  EXPECT_EQ(amgr.get_cached_analysis<BuildCFGPass>(), nullptr);
+}
+
+}  // namespace lang
+}  // namespace taichi
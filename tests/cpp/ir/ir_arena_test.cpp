@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/ir_arena.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+
+namespace taichi {
+namespace lang {
+
+TEST(IRArena, AllocateAndRecycle) {
+  auto arena = IRArena::create();
+  {
+    IRArena::Scope _(arena.get());
+    auto stmt = Stmt::make<ConstStmt>(TypedConstant(1));
+    EXPECT_GT(arena->num_live_allocations(), 0);
+    auto reserved = arena->reserved_bytes();
+    EXPECT_EQ(reserved, IRArena::kChunkSize);
+    stmt.reset();
+    EXPECT_EQ(arena->num_live_allocations(), 0);
+    EXPECT_EQ(arena->live_bytes(), 0);
+
+    // Freed statements are recycled instead of growing the arena.
+    for (int i = 0; i < 1000; i++) {
+      auto s = Stmt::make<ConstStmt>(TypedConstant(i));
+    }
+    EXPECT_EQ(arena->reserved_bytes(), reserved);
+  }
+  // No arena installed: falls back to the heap.
+  auto stmt = Stmt::make<ConstStmt>(TypedConstant(2));
+  EXPECT_EQ(arena->num_live_allocations(), 0);
+}
+
+TEST(IRArena, RecycleLargeAllocations) {
+  auto arena = IRArena::create();
+  IRArena::Scope _(arena.get());
+  IRArenaAllocator<char> allocator;
+  std::size_t reserved = 0;
+  for (int i = 0; i < 100; i++) {
+    // Sizes in the same power-of-two size class share the freed blocks.
+    auto *ptr = allocator.allocate(40000 + i * 100);
+    allocator.deallocate(ptr, 0);
+    if (i == 0)
+      reserved = arena->reserved_bytes();
+  }
+  EXPECT_EQ(arena->reserved_bytes(), reserved);
+  EXPECT_EQ(arena->live_bytes(), 0);
+}
+
+TEST(IRArena, OutlivesOwner) {
+  std::unique_ptr<IRNode> ir;
+  {
+    auto arena = IRArena::create();
+    IRArena::Scope _(arena.get());
+    IRBuilder builder;
+    auto *lhs = builder.get_int32(40);
+    auto *rhs = builder.get_int32(2);
+    builder.create_add(lhs, rhs);
+    ir = builder.extract_ir();
+  }
+  // The statements keep the arena alive after its owner is gone.
+  auto *block = ir->as<Block>();
+  ASSERT_EQ(block->size(), 3);
+  EXPECT_EQ(block->statements[2]->operand(0), block->statements[0].get());
+  EXPECT_EQ(block->statements[2]->operand(1), block->statements[1].get());
+  block->erase(2);
+  irpass::clear_trash_bins(ir.get());
+  EXPECT_TRUE(block->trash_bin.empty());
+}
+
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/pass.h"
+
+namespace taichi {
+namespace lang {
+
+namespace {
+
+class FooAnalysis : public Pass {
+ public:
+  static const PassID id;
+
+  struct Result {
+    int value;
+  };
+};
+
+class BarAnalysis : public Pass {
+ public:
+  static const PassID id;
+
+  struct Result {
+    int value;
+  };
+};
+
+const PassID FooAnalysis::id = "FooAnalysis";
+const PassID BarAnalysis::id = "BarAnalysis";
+
+}  // namespace
+
+TEST(AnalysisManager, CachedAnalysesAreInvalidated) {
+  AnalysisManager amgr;
+  amgr.cache_analysis<FooAnalysis>({1});
+  amgr.cache_analysis<BarAnalysis>({2});
+  amgr.put_pass_result<FooAnalysis>({3});
+
+  // A transform without change keeps everything.
+  EXPECT_FALSE(amgr.run_transform(nullptr, "nop", []() { return false; }));
+  ASSERT_NE(amgr.get_cached_analysis<FooAnalysis>(), nullptr);
+  EXPECT_EQ(amgr.get_cached_analysis<FooAnalysis>()->value, 1);
+
+  // A modifying transform only keeps what it preserves.
+  EXPECT_TRUE(amgr.run_transform(
+      nullptr, "modify", []() { return true; },
+      PreservedAnalyses::none().preserve<BarAnalysis>()));
+  EXPECT_EQ(amgr.get_cached_analysis<FooAnalysis>(), nullptr);
+  ASSERT_NE(amgr.get_cached_analysis<BarAnalysis>(), nullptr);
+  EXPECT_EQ(amgr.get_cached_analysis<BarAnalysis>()->value, 2);
+
+  // Pass results are not bound to the IR.
+  ASSERT_NE(amgr.get_pass_result<FooAnalysis>(), nullptr);
+  EXPECT_EQ(amgr.get_pass_result<FooAnalysis>()->value, 3);
+}
+
+TEST(AnalysisManager, Fixpoints) {
+  PassInstrumentation instrumentation;
+  AnalysisManager amgr(&instrumentation);
+  int num_runs = 0;
+  auto nop = [&]() {
+    num_runs++;
+    return false;
+  };
+  amgr.run_transform(nullptr, "nop", nop);
+  amgr.run_transform(nullptr, "nop", nop);
+  EXPECT_EQ(num_runs, 1);
+  EXPECT_TRUE(amgr.is_at_fixpoint("nop"));
+
+  amgr.run_transform(nullptr, "modify", []() { return true; });
+  EXPECT_FALSE(amgr.is_at_fixpoint("nop"));
+  EXPECT_FALSE(amgr.is_at_fixpoint("modify"));
+  amgr.run_transform(nullptr, "nop", nop);
+  EXPECT_EQ(num_runs, 2);
+
+  auto &records = instrumentation.get_records();
+  EXPECT_EQ(records.at("nop").num_runs, 2);
+  EXPECT_EQ(records.at("nop").num_skipped, 1);
+  EXPECT_EQ(records.at("modify").num_modified, 1);
+}
+
+}  // namespace lang
+}  // namespace taichi
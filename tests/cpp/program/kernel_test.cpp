@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/program/kernel.h"
+#include "tests/cpp/program/test_program.h"
+
+namespace taichi {
+namespace lang {
+
+TEST(Kernel, LaunchPreparedUnpacksScalarArgs) {
+  TestProgram test_prog;
+  test_prog.setup();
+
+  // a[0] = i32(x) + z; a[1] = i32(y)
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(/*arg_id=*/0, PrimitiveType::i8, false);
+  auto *y = builder.create_arg_load(/*arg_id=*/1, PrimitiveType::f64, false);
+  auto *arr = builder.create_arg_load(/*arg_id=*/2, PrimitiveType::i32, true);
+  auto *z = builder.create_arg_load(/*arg_id=*/3, PrimitiveType::i32, false);
+  auto *sum = builder.create_add(builder.create_cast(x, PrimitiveType::i32), z);
+  builder.create_global_store(
+      builder.create_external_ptr(arr, {builder.get_int32(0)}), sum);
+  builder.create_global_store(
+      builder.create_external_ptr(arr, {builder.get_int32(1)}),
+      builder.create_cast(y, PrimitiveType::i32));
+  auto ker = std::make_unique<Kernel>(*test_prog.prog(), builder.extract_ir());
+  ker->insert_arg(PrimitiveType::i8, /*is_array=*/false);
+  ker->insert_arg(PrimitiveType::f64, /*is_array=*/false);
+  ker->insert_arg(PrimitiveType::i32, /*is_array=*/true);
+  ker->insert_arg(PrimitiveType::i32, /*is_array=*/false);
+
+  EXPECT_EQ(ker->get_packed_arg_offset(0), 0);
+  EXPECT_EQ(ker->get_packed_arg_offset(1), 8);
+  EXPECT_EQ(ker->get_packed_arg_offset(2), -1);
+  EXPECT_EQ(ker->get_packed_arg_offset(3), 16);
+  EXPECT_EQ(ker->get_packed_args_size(), 20);
+
+  struct {
+    int8 x;
+    float64 y;
+    int32 z;
+  } packed_args = {-3, 40.0, 5};
+  int32 array[2] = {0, 0};
+  auto launch_ctx = ker->make_launch_context();
+  launch_ctx.set_arg_external_array(/*arg_id=*/2, (uint64)array, sizeof(array),
+                                    /*is_device_allocation=*/false);
+  auto &ctx = launch_ctx.get_context();
+  ker->launch_prepared(ctx, &packed_args);
+  EXPECT_EQ(array[0], 2);
+  EXPECT_EQ(array[1], 40);
+
+  packed_args.z = 10;
+  ker->launch_prepared(ctx, &packed_args);
+  EXPECT_EQ(array[0], 7);
+  EXPECT_EQ(array[1], 40);
+}
+
+}  // namespace lang
+}  // namespace taichi
@@ -1,3 +1,6 @@
+#include <atomic>
+#include <thread>
+
 #include "gtest/gtest.h"
 
 #include "taichi/util/testing.h"
@@ -24,5 +27,27 @@ TEST(ParallelExecutor, ParallelPrint) {
   }
 }
 
+TEST(ParallelExecutor, MultipleProducers) {
+  constexpr int kNumProducers = 4;
+  // More than the queue capacity, so that producers have to wait.
+  constexpr int kNumTasksPerProducer = 5000;
+  std::atomic<int> sum{0};
+  ParallelExecutor exec("test", 4);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kNumProducers; p++) {
+    producers.emplace_back([&]() {
+      for (int i = 0; i < kNumTasksPerProducer; i++) {
+        exec.enqueue([&sum, i]() { sum += i; });
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  exec.flush();
+  EXPECT_EQ(sum, kNumProducers * (kNumTasksPerProducer *
+                                  (kNumTasksPerProducer - 1) / 2));
+}
+
 }  // namespace lang
 }  // namespace taichi
@@ -0,0 +1,67 @@
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/transforms/check_out_of_bound.h"
+#include "tests/cpp/struct/fake_struct_compiler.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+constexpr int kSize = 8;
+
+class CheckOutOfBoundTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_snode_ = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+    auto &dense = root_snode_->dense(Axis{0}, kSize, false);
+    leaf_snode_ = &dense.insert_children(SNodeType::place);
+    leaf_snode_->dt = PrimitiveType::f32;
+    FakeStructCompiler sc;
+    sc.run(*root_snode_);
+  }
+
+  // for i in range(begin, end): x[i + offset] = 0
+  int count_asserts_in_loop(int begin, int end, int offset) {
+    IRBuilder builder;
+    auto *loop = builder.create_range_for(builder.get_int32(begin),
+                                          builder.get_int32(end));
+    {
+      auto _ = builder.get_loop_guard(loop);
+      auto *index = builder.create_add(builder.get_loop_index(loop),
+                                       builder.get_int32(offset));
+      builder.create_global_store(
+          builder.create_global_ptr(leaf_snode_, {index}),
+          builder.get_float32(0));
+    }
+    auto block = builder.extract_ir();
+    CompileConfig config;
+    irpass::type_check(block.get(), config);
+    irpass::check_out_of_bound(block.get(), config, {"kernel"});
+    return irpass::analysis::gather_statements(block.get(), [](Stmt *s) {
+             return s->is<AssertStmt>();
+           }).size();
+  }
+
+  std::unique_ptr<SNode> root_snode_;
+  SNode *leaf_snode_{nullptr};
+};
+
+TEST_F(CheckOutOfBoundTest, InBoundAccessIsNotChecked) {
+  EXPECT_EQ(count_asserts_in_loop(0, kSize, 0), 0);
+  EXPECT_EQ(count_asserts_in_loop(1, kSize, -1), 0);
+}
+
+TEST_F(CheckOutOfBoundTest, PossiblyOutOfBoundAccessIsChecked) {
+  EXPECT_EQ(count_asserts_in_loop(0, kSize, 1), 1);
+  EXPECT_EQ(count_asserts_in_loop(0, kSize, -1), 1);
+}
+
+}  // namespace
+}  // namespace lang
+}  // namespace taichi
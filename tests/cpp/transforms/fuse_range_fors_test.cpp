@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/struct/fake_struct_compiler.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+constexpr int kSize = 64;
+
+class FuseRangeForsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_snode_ = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+    const std::vector<Axis> axes = {Axis{0}};
+    auto &dense = root_snode_->dense(axes, kSize, false);
+    a_snode_ = &dense.insert_children(SNodeType::place);
+    a_snode_->dt = PrimitiveType::i32;
+    b_snode_ = &dense.insert_children(SNodeType::place);
+    b_snode_->dt = PrimitiveType::i32;
+    FakeStructCompiler sc;
+    sc.run(*root_snode_);
+    root_ = std::make_unique<Block>();
+  }
+
+  OffloadedStmt *add_range_for() {
+    auto offload = Stmt::make_typed<OffloadedStmt>(
+        OffloadedStmt::TaskType::range_for, Arch::x64);
+    offload->const_begin = true;
+    offload->const_end = true;
+    offload->begin_value = 0;
+    offload->end_value = kSize;
+    auto result = offload.get();
+    root_->insert(std::move(offload));
+    return result;
+  }
+
+  // Builds a[i] = i; b[i] = a[i + |offset|] as two tasks.
+  void build_tasks(int offset) {
+    IRBuilder builder;
+    auto first = add_range_for();
+    builder.set_insertion_point({first->body.get(), 0});
+    auto i = builder.get_loop_index(first);
+    builder.create_global_store(builder.create_global_ptr(a_snode_, {i}), i);
+
+    auto second = add_range_for();
+    builder.set_insertion_point({second->body.get(), 0});
+    auto j = builder.get_loop_index(second);
+    Stmt *src_index = j;
+    if (offset != 0)
+      src_index = builder.create_add(j, builder.get_int32(offset));
+    auto src = builder.create_global_ptr(a_snode_, {src_index});
+    builder.create_global_store(builder.create_global_ptr(b_snode_, {j}),
+                                builder.create_global_load(src));
+  }
+
+  std::unique_ptr<SNode> root_snode_;
+  SNode *a_snode_{nullptr};
+  SNode *b_snode_{nullptr};
+  std::unique_ptr<Block> root_;
+};
+
+TEST_F(FuseRangeForsTest, SameIndexDependencyIsFused) {
+  build_tasks(/*offset=*/0);
+  CompileConfig config;
+  irpass::type_check(root_.get(), config);
+
+  EXPECT_TRUE(irpass::fuse_range_fors(root_.get(), config));
+  irpass::analysis::verify(root_.get());
+  ASSERT_EQ(root_->size(), 1);
+  auto task = root_->statements[0]->as<OffloadedStmt>();
+  auto loop_indices = irpass::analysis::gather_statements(
+      task, [](Stmt *s) { return s->is<LoopIndexStmt>(); });
+  ASSERT_EQ(loop_indices.size(), 2);
+  for (auto loop_index : loop_indices)
+    EXPECT_EQ(loop_index->as<LoopIndexStmt>()->loop, task);
+}
+
+TEST_F(FuseRangeForsTest, ShiftedIndexDependencyIsNotFused) {
+  build_tasks(/*offset=*/1);
+  CompileConfig config;
+  irpass::type_check(root_.get(), config);
+
+  EXPECT_FALSE(irpass::fuse_range_fors(root_.get(), config));
+  EXPECT_EQ(root_->size(), 2);
+}
+
+TEST_F(FuseRangeForsTest, WrittenSNodeIsNotReadOnlyAfterFusion) {
+  // if i > 3: a[i] = i
+  // b[i] = a[i]
+  IRBuilder builder;
+  auto first = add_range_for();
+  builder.set_insertion_point({first->body.get(), 0});
+  auto i = builder.get_loop_index(first);
+  auto if_stmt =
+      builder.create_if(builder.create_cmp_gt(i, builder.get_int32(3)));
+  {
+    auto _ = builder.get_if_guard(if_stmt, true);
+    builder.create_global_store(builder.create_global_ptr(a_snode_, {i}), i);
+  }
+  auto second = add_range_for();
+  builder.set_insertion_point({second->body.get(), 0});
+  auto j = builder.get_loop_index(second);
+  builder.create_global_store(
+      builder.create_global_ptr(b_snode_, {j}),
+      builder.create_global_load(builder.create_global_ptr(a_snode_, {j})));
+  CompileConfig config;
+  irpass::type_check(root_.get(), config);
+  irpass::detect_read_only(root_.get());
+  ASSERT_TRUE(
+      second->mem_access_opt.has_flag(a_snode_, SNodeAccessFlag::read_only));
+
+  EXPECT_TRUE(irpass::fuse_range_fors(root_.get(), config));
+  ASSERT_EQ(root_->size(), 1);
+  auto task = root_->statements[0]->as<OffloadedStmt>();
+  EXPECT_FALSE(
+      task->mem_access_opt.has_flag(a_snode_, SNodeAccessFlag::read_only));
+}
+
+}  // namespace
+}  // namespace lang
+}  // namespace taichi
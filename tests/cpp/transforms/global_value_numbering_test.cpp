@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+
+namespace taichi {
+namespace lang {
+
+TEST(GlobalValueNumbering, DominatedRedundancy) {
+  IRBuilder builder;
+  auto *arg = builder.create_arg_load(0, PrimitiveType::i32, false);
+  auto *array = builder.create_arg_load(1, PrimitiveType::i32, true);
+  auto *sum = builder.create_add(arg, builder.get_int32(1));
+  auto *ptr = builder.create_external_ptr(array, {builder.get_int32(0)});
+  auto *if_stmt = builder.create_if(builder.create_cmp_lt(sum, arg));
+  {
+    auto _ = builder.get_if_guard(if_stmt, true);
+    // Dominated by |sum|, so it is the same value.
+    auto *sum2 = builder.create_add(arg, builder.get_int32(1));
+    builder.create_global_store(ptr, sum2);
+  }
+  auto block = builder.extract_ir();
+
+  EXPECT_TRUE(irpass::global_value_numbering(block.get()));
+  ASSERT_EQ(if_stmt->true_statements->size(), 1);
+  auto *store = (*if_stmt->true_statements)[0]->as<GlobalStoreStmt>();
+  EXPECT_EQ(store->val, sum);
+  // The constants 0 and 1 are distinct values.
+  EXPECT_EQ(block->size(), 8);
+
+  EXPECT_FALSE(irpass::global_value_numbering(block.get()));
+}
+
+TEST(GlobalValueNumbering, GlobalLoads) {
+  IRBuilder builder;
+  auto *array = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *ptr0 = builder.create_external_ptr(array, {builder.get_int32(0)});
+  auto *ptr1 = builder.create_external_ptr(array, {builder.get_int32(1)});
+  auto *a = builder.create_global_load(ptr0);
+  // Does not alias |ptr0|.
+  builder.create_global_store(ptr1, a);
+  auto *b = builder.create_global_load(ptr0);
+  builder.create_global_store(ptr0, builder.create_add(a, b));
+  // Killed by the store above.
+  auto *c = builder.create_global_load(ptr0);
+  builder.create_global_store(ptr1, c);
+  auto block = builder.extract_ir();
+
+  EXPECT_TRUE(irpass::global_value_numbering(block.get()));
+  auto *add = block->statements[7]->as<BinaryOpStmt>();
+  EXPECT_EQ(add->lhs, a);
+  EXPECT_EQ(add->rhs, a);
+  auto *store = block->statements.back()->as<GlobalStoreStmt>();
+  EXPECT_EQ(store->val, c);
+}
+
+}  // namespace lang
+}  // namespace taichi
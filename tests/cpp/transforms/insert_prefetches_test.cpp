@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/transforms/serial_task.h"
+
+namespace taichi {
+namespace lang {
+
+TEST(InsertPrefetches, IndirectLoad) {
+  // for i in range(n): y[i] = x[idx[i]]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *idx = builder.create_arg_load(2, PrimitiveType::i32, true);
+  auto *n = builder.create_arg_load(3, PrimitiveType::i32, false);
+  auto *loop = builder.create_range_for(builder.get_int32(0), n);
+  ExternalPtrStmt *x_ptr;
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *i = builder.get_loop_index(loop);
+    auto *p = builder.create_global_load(builder.create_external_ptr(idx, {i}));
+    x_ptr = builder.create_external_ptr(x, {p});
+    builder.create_global_store(builder.create_external_ptr(y, {i}),
+                                builder.create_global_load(x_ptr));
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  config.prefetch_distance = 4;
+  EXPECT_TRUE(irpass::insert_prefetches(root.get(), config));
+  irpass::analysis::verify(root.get());
+
+  // Only x[idx[i]] is prefetched, as the hardware prefetcher handles idx[i]
+  // and y[i].
+  auto prefetches = irpass::analysis::gather_statements(
+      root.get(), [](Stmt *s) { return s->is<PrefetchStmt>(); });
+  ASSERT_EQ(prefetches.size(), 1);
+  EXPECT_EQ(prefetches[0]->parent, loop->body.get());
+  auto *ptr = prefetches[0]->as<PrefetchStmt>()->ptr->as<ExternalPtrStmt>();
+  EXPECT_EQ(ptr->base_ptrs[0], x);
+  // x[idx[max(min(i + 4, idx.shape[0] - 1), 0)]]
+  auto *load = ptr->indices[0]->as<GlobalLoadStmt>();
+  auto *idx_ptr = load->src->as<ExternalPtrStmt>();
+  EXPECT_EQ(idx_ptr->base_ptrs[0], idx);
+  auto *clamped = idx_ptr->indices[0]->as<BinaryOpStmt>();
+  EXPECT_EQ(clamped->op_type, BinaryOpType::max);
+  auto *upper = clamped->lhs->as<BinaryOpStmt>();
+  EXPECT_EQ(upper->op_type, BinaryOpType::min);
+  auto *shifted = upper->lhs->as<BinaryOpStmt>();
+  EXPECT_EQ(shifted->op_type, BinaryOpType::add);
+  EXPECT_TRUE(shifted->lhs->is<LoopIndexStmt>());
+  EXPECT_EQ(shifted->rhs->as<ConstStmt>()->val[0].val_i32, 4);
+  // The prefetch comes before the original access.
+  EXPECT_LT(loop->body->locate(prefetches[0]), loop->body->locate(x_ptr));
+}
+
+TEST(InsertPrefetches, IntegerDivisionIsNotShifted) {
+  // for i in range(n):
+  //   if cnt[i] > 0: y[i] = x[tot[i] // cnt[i]]
+  // The prefetch of iteration i + d would divide by zero when cnt[i + d] == 0.
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *tot = builder.create_arg_load(2, PrimitiveType::i32, true);
+  auto *cnt = builder.create_arg_load(3, PrimitiveType::i32, true);
+  auto *n = builder.create_arg_load(4, PrimitiveType::i32, false);
+  auto *loop = builder.create_range_for(builder.get_int32(0), n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *i = builder.get_loop_index(loop);
+    auto *c = builder.create_global_load(builder.create_external_ptr(cnt, {i}));
+    auto *if_stmt =
+        builder.create_if(builder.create_cmp_gt(c, builder.get_int32(0)));
+    auto _if = builder.get_if_guard(if_stmt, true);
+    auto *t = builder.create_global_load(builder.create_external_ptr(tot, {i}));
+    auto *x_ptr =
+        builder.create_external_ptr(x, {builder.create_floordiv(t, c)});
+    builder.create_global_store(builder.create_external_ptr(y, {i}),
+                                builder.create_global_load(x_ptr));
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  config.prefetch_distance = 4;
+  irpass::insert_prefetches(root.get(), config);
+  EXPECT_TRUE(irpass::analysis::gather_statements(root.get(), [](Stmt *s) {
+                return s->is<PrefetchStmt>();
+              }).empty());
+}
+
+TEST(InsertPrefetches, NoIndirection) {
+  // for i in range(n): y[i] = x[i + 1]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(2, PrimitiveType::i32, false);
+  auto *loop = builder.create_range_for(builder.get_int32(0), n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *i = builder.get_loop_index(loop);
+    auto *next = builder.create_add(i, builder.get_int32(1));
+    auto *x_ptr = builder.create_external_ptr(x, {next});
+    builder.create_global_store(builder.create_external_ptr(y, {i}),
+                                builder.create_global_load(x_ptr));
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  EXPECT_FALSE(irpass::insert_prefetches(root.get(), config));
+}
+
+}  // namespace lang
+}  // namespace taichi
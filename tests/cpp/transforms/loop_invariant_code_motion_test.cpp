@@ -0,0 +1,200 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/transforms/serial_task.h"
+
+namespace taichi {
+namespace lang {
+
+namespace {
+
+int count_statements(IRNode *root, const std::function<bool(Stmt *)> &test) {
+  return irpass::analysis::gather_statements(root, test).size();
+}
+
+}  // namespace
+
+TEST(LoopInvariantCodeMotion, PromoteAccumulation) {
+  // for j in range(n): x[0] += y[j]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(2, PrimitiveType::i32, false);
+  auto *zero = builder.get_int32(0);
+  auto *loop = builder.create_range_for(zero, n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *j = builder.get_loop_index(loop);
+    auto *val = builder.create_global_load(builder.create_external_ptr(y, {j}));
+    auto *ptr = builder.create_external_ptr(x, {zero});
+    builder.create_atomic_add(ptr, val);
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  EXPECT_TRUE(irpass::loop_invariant_code_motion(root.get(), config));
+  irpass::analysis::verify(root.get());
+  // The only atomic is the one after the loop, guarded by n > 0.
+  auto atomics = irpass::analysis::gather_statements(
+      root.get(), [](Stmt *s) { return s->is<AtomicOpStmt>(); });
+  ASSERT_EQ(atomics.size(), 1);
+  auto guard = atomics[0]->parent->parent_stmt;
+  ASSERT_TRUE(guard && guard->is<IfStmt>());
+  EXPECT_EQ(guard->parent, loop->parent);
+  EXPECT_GT(guard->parent->locate(guard), loop->parent->locate(loop));
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<LocalStoreStmt>(); }),
+            1);
+
+  EXPECT_FALSE(irpass::loop_invariant_code_motion(root.get(), config));
+}
+
+TEST(LoopInvariantCodeMotion, PromoteLoadStore) {
+  // for j in range(n): x[0] = x[0] * y[j]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(2, PrimitiveType::i32, false);
+  auto *zero = builder.get_int32(0);
+  auto *loop = builder.create_range_for(zero, n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *j = builder.get_loop_index(loop);
+    auto *ptr = builder.create_external_ptr(x, {zero});
+    auto *val = builder.create_global_load(builder.create_external_ptr(y, {j}));
+    builder.create_global_store(
+        ptr, builder.create_mul(builder.create_global_load(ptr), val));
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  EXPECT_TRUE(irpass::loop_invariant_code_motion(root.get(), config));
+  irpass::analysis::verify(root.get());
+  // Only the load of y[j] is left in the loop.
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<GlobalLoadStmt>(); }),
+            1);
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<GlobalStoreStmt>(); }),
+            0);
+  // Both the load before the loop and the store after it are guarded by
+  // n > 0.
+  EXPECT_EQ(count_statements(root.get(),
+                             [](Stmt *s) { return s->is<GlobalStoreStmt>(); }),
+            1);
+  EXPECT_EQ(count_statements(root.get(),
+                             [](Stmt *s) { return s->is<GlobalLoadStmt>(); }),
+            2);
+  // So are the pointers, which might activate the cell they point to.
+  auto ptrs = irpass::analysis::gather_statements(
+      root.get(), [](Stmt *s) { return s->is<ExternalPtrStmt>(); });
+  for (auto ptr : ptrs) {
+    if (ptr->parent != loop->body.get())
+      EXPECT_TRUE(ptr->parent->parent_stmt->is<IfStmt>());
+  }
+}
+
+TEST(LoopInvariantCodeMotion, AliasingAccessBlocksPromotion) {
+  // for j in range(n): x[0] += x[j]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(1, PrimitiveType::i32, false);
+  auto *zero = builder.get_int32(0);
+  auto *loop = builder.create_range_for(zero, n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *j = builder.get_loop_index(loop);
+    auto *val = builder.create_global_load(builder.create_external_ptr(x, {j}));
+    auto *ptr = builder.create_external_ptr(x, {zero});
+    builder.create_atomic_add(ptr, val);
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  irpass::loop_invariant_code_motion(root.get(), config);
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<AtomicOpStmt>(); }),
+            1);
+}
+
+TEST(LoopInvariantCodeMotion, ConditionalAccessesStayInLoop) {
+  // for j in range(n):
+  //   if k >= 0:
+  //     x[k] += y[j]
+  //     s[0] = s[0] + z[k]
+  // x[k] and z[k] are invalid addresses when k == -1, so neither the atomic
+  // nor the loads may move out of the loop.
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *s = builder.create_arg_load(2, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(3, PrimitiveType::i32, false);
+  auto *k = builder.create_arg_load(4, PrimitiveType::i32, false);
+  auto *z = builder.create_arg_load(5, PrimitiveType::f32, true);
+  auto *zero = builder.get_int32(0);
+  auto *loop = builder.create_range_for(zero, n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *j = builder.get_loop_index(loop);
+    auto *if_stmt = builder.create_if(builder.create_cmp_ge(k, zero));
+    auto _if = builder.get_if_guard(if_stmt, true);
+    auto *val = builder.create_global_load(builder.create_external_ptr(y, {j}));
+    builder.create_atomic_add(builder.create_external_ptr(x, {k}), val);
+    auto *next =
+        builder.create_global_load(builder.create_external_ptr(z, {k}));
+    auto *s_ptr = builder.create_external_ptr(s, {zero});
+    auto *sum = builder.create_add(builder.create_global_load(s_ptr), next);
+    builder.create_global_store(s_ptr, sum);
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  irpass::loop_invariant_code_motion(root.get(), config);
+  irpass::analysis::verify(root.get());
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<AtomicOpStmt>(); }),
+            1);
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<GlobalLoadStmt>(); }),
+            3);
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<GlobalStoreStmt>(); }),
+            1);
+}
+
+TEST(LoopInvariantCodeMotion, AccessAfterContinueStaysInLoop) {
+  // for j in range(n):
+  //   if y[j] < 0: continue
+  //   x[0] += y[j]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *y = builder.create_arg_load(1, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(2, PrimitiveType::i32, false);
+  auto *zero = builder.get_int32(0);
+  auto *loop = builder.create_range_for(zero, n);
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *j = builder.get_loop_index(loop);
+    auto *val = builder.create_global_load(builder.create_external_ptr(y, {j}));
+    auto *if_stmt =
+        builder.create_if(builder.create_cmp_lt(val, builder.get_float32(0)));
+    {
+      auto _if = builder.get_if_guard(if_stmt, true);
+      builder.create_continue();
+    }
+    builder.create_atomic_add(builder.create_external_ptr(x, {zero}), val);
+  }
+  auto root = make_serial_task(builder.extract_ir());
+
+  CompileConfig config;
+  irpass::loop_invariant_code_motion(root.get(), config);
+  EXPECT_EQ(count_statements(loop->body.get(),
+                             [](Stmt *s) { return s->is<AtomicOpStmt>(); }),
+            1);
+}
+
+}  // namespace lang
+}  // namespace taichi
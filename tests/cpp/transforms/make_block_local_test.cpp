@@ -191,6 +191,47 @@ TEST_F(MakeBlockLocalTest, Basic) {
   }
 }
 
+TEST_F(MakeBlockLocalTest, CpuPrologueIsSerialLoopNest) {
+  initialize(/*pointer_size=*/2, /*block_size=*/4);
+
+  // Same accesses as in the Basic test, so the BLS pad size at ti.i = 5,
+  // ti.j = 7.
+  auto *loop_idx0_ = builder_.get_loop_index(for_stmt_.get(), /*index=*/0);
+  auto *loop_idx1_ = builder_.get_loop_index(for_stmt_.get(), /*index=*/1);
+  auto *idx0 = builder_.create_mul(
+      loop_idx0_, builder_.get_int32(/*value=*/get_block_size(0)));
+  auto *idx1 = builder_.create_mul(
+      loop_idx1_, builder_.get_int32(/*value=*/get_block_size(1)));
+  builder_.create_global_load(builder_.create_global_ptr(
+      bls_place_snode_,
+      /*indices=*/{builder_.create_sub(idx0, builder_.get_int32(1)),
+                   builder_.create_sub(idx1, builder_.get_int32(3))}));
+  builder_.create_global_load(
+      builder_.create_global_ptr(bls_place_snode_, /*indices=*/{idx0, idx1}));
+  CompileConfig config;
+  config.arch = Arch::x64;
+  irpass::make_block_local(for_stmt_.get(), config,
+                           MakeBlockLocalPass::Args{});
+
+  ASSERT_NE(for_stmt_->bls_prologue, nullptr);
+  EXPECT_EQ(for_stmt_->bls_size, 5 * 7 * sizeof(float));
+  std::vector<int> loop_extents;
+  Block *block = for_stmt_->bls_prologue.get();
+  while (block != nullptr) {
+    Block *next = nullptr;
+    for (auto &stmt : block->statements) {
+      EXPECT_FALSE(stmt->is<LoopLinearIndexStmt>());
+      if (auto loop = stmt->cast<RangeForStmt>()) {
+        loop_extents.push_back(
+            loop->end->as<ConstStmt>()->val[0].val_int32());
+        next = loop->body.get();
+      }
+    }
+    block = next;
+  }
+  EXPECT_EQ(loop_extents, (std::vector<int>{5, 7}));
+}
+
 }  // namespace
 }  // namespace lang
 }  // namespace taichi
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+
+namespace taichi {
+namespace lang {
+
+TEST(NarrowIndices, LoopIndexArithmetic) {
+  // for i in range(16): x[i64(i) * 3 + 1] = 0
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *loop = builder.create_range_for(builder.get_int32(0),
+                                        builder.get_int32(16));
+  ExternalPtrStmt *ptr;
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *index = builder.create_cast(builder.get_loop_index(loop),
+                                      PrimitiveType::i64);
+    auto *offset = builder.create_add(
+        builder.create_mul(index, builder.get_int64(3)), builder.get_int64(1));
+    ptr = builder.create_external_ptr(x, {offset});
+    builder.create_global_store(ptr, builder.get_float32(0));
+  }
+  auto block = builder.extract_ir();
+  CompileConfig config;
+  irpass::type_check(block.get(), config);
+
+  EXPECT_TRUE(irpass::narrow_indices(block.get(), config));
+  irpass::die(block.get());
+  irpass::analysis::verify(block.get());
+  EXPECT_EQ(ptr->indices[0]->ret_type, PrimitiveType::i32);
+  // No 64-bit operation is left.
+  auto wide = irpass::analysis::gather_statements(block.get(), [](Stmt *s) {
+    return s->ret_type == PrimitiveType::i64;
+  });
+  EXPECT_TRUE(wide.empty());
+}
+
+TEST(NarrowIndices, UnboundedIndexIsUnchanged) {
+  // x[i64(n) * 3]
+  IRBuilder builder;
+  auto *x = builder.create_arg_load(0, PrimitiveType::f32, true);
+  auto *n = builder.create_arg_load(1, PrimitiveType::i32, false);
+  auto *index = builder.create_mul(builder.create_cast(n, PrimitiveType::i64),
+                                   builder.get_int64(3));
+  auto *ptr = builder.create_external_ptr(x, {index});
+  builder.create_global_store(ptr, builder.get_float32(0));
+  auto block = builder.extract_ir();
+  CompileConfig config;
+  irpass::type_check(block.get(), config);
+
+  EXPECT_FALSE(irpass::narrow_indices(block.get(), config));
+  EXPECT_EQ(ptr->indices[0], index);
+}
+
+}  // namespace lang
+}  // namespace taichi
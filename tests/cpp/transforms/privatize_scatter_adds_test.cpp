@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/struct/fake_struct_compiler.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+constexpr int kNumBins = 16;
+constexpr int kNumThreads = 4;
+constexpr int kNumIterations = 4096;
+
+class PrivatizeScatterAddsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_snode_ = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+    const std::vector<Axis> axes = {Axis{0}};
+    hist_snode_ = &(root_snode_->dense(axes, kNumBins, false)
+                        .insert_children(SNodeType::place));
+    hist_snode_->dt = PrimitiveType::i32;
+    FakeStructCompiler sc;
+    sc.run(*root_snode_);
+
+    root_ = std::make_unique<Block>();
+    auto offload = Stmt::make_typed<OffloadedStmt>(
+        OffloadedStmt::TaskType::range_for, Arch::x64);
+    offload->const_begin = true;
+    offload->const_end = true;
+    offload->begin_value = 0;
+    offload->end_value = kNumIterations;
+    offload->block_dim = 512;
+    offload->num_cpu_threads = kNumThreads;
+    loop_ = offload.get();
+    root_->insert(std::move(offload));
+  }
+
+  // Builds hist[i % kNumBins] += 1 into the loop body.
+  AtomicOpStmt *add_to_bin() {
+    IRBuilder builder;
+    builder.set_insertion_point({loop_->body.get(), (int)loop_->body->size()});
+    auto bin = builder.create_mod(builder.get_loop_index(loop_),
+                                  builder.get_int32(kNumBins));
+    auto ptr = builder.create_global_ptr(hist_snode_, {bin});
+    return builder.create_atomic_add(ptr, builder.get_int32(1));
+  }
+
+  std::unique_ptr<SNode> root_snode_;
+  SNode *hist_snode_{nullptr};
+  std::unique_ptr<Block> root_;
+  OffloadedStmt *loop_{nullptr};
+};
+
+TEST_F(PrivatizeScatterAddsTest, AddsToSmallFieldArePrivatized) {
+  add_to_bin();
+  CompileConfig config;
+  irpass::type_check(root_.get(), config);
+
+  EXPECT_TRUE(irpass::privatize_scatter_adds(root_.get(), config));
+  irpass::analysis::verify(root_.get());
+  ASSERT_EQ(root_->size(), 3);
+  auto zero_fill = root_->statements[0]->as<OffloadedStmt>();
+  auto merge = root_->statements[2]->as<OffloadedStmt>();
+  EXPECT_EQ(root_->statements[1].get(), loop_);
+  EXPECT_EQ(zero_fill->end_value, kNumThreads * kNumBins);
+  EXPECT_EQ(merge->end_value, kNumBins);
+  auto is_atomic = [](Stmt *s) { return s->is<AtomicOpStmt>(); };
+  EXPECT_TRUE(irpass::analysis::gather_statements(root_.get(), is_atomic)
+                  .empty());
+}
+
+TEST_F(PrivatizeScatterAddsTest, UsedOldValueIsNotPrivatized) {
+  auto atomic = add_to_bin();
+  IRBuilder builder;
+  builder.set_insertion_point({loop_->body.get(), (int)loop_->body->size()});
+  builder.create_global_store(
+      builder.create_global_ptr(hist_snode_, {builder.get_int32(0)}), atomic);
+  CompileConfig config;
+  irpass::type_check(root_.get(), config);
+
+  EXPECT_FALSE(irpass::privatize_scatter_adds(root_.get(), config));
+  EXPECT_EQ(root_->size(), 1);
+}
+
+}  // namespace
+}  // namespace lang
+}  // namespace taichi
@@ -64,7 +64,8 @@ TEST_F(ScalarPointerLowererTest, Basic) {
                           SNodeOpType::undefined,
                           /*is_bit_vectorized=*/false,
                           &lowered,
-                          /*packed=*/false};
+                          /*packed=*/false,
+                          /*assume_in_bounds=*/true};
       lowerer.run();
       // There are three linearized stmts:
       // 0: for root
@@ -104,6 +105,35 @@ TEST_F(ScalarPointerLowererTest, Basic) {
   }
 }
 
+TEST(ScalarPointerLowerer, FullAxisIndexIsNotExtracted) {
+  auto root_snode = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+  const std::vector<Axis> axes = {Axis{0}, Axis{1}};
+  auto &dense_snode =
+      root_snode->dense(axes, {kPointerSize, kDenseSize}, false);
+  auto &leaf_snode = dense_snode.insert_children(SNodeType::place);
+  leaf_snode.dt = PrimitiveType::f32;
+  FakeStructCompiler sc;
+  sc.run(*root_snode);
+
+  for (const bool packed : {false, true}) {
+    IRBuilder builder;
+    auto *i = builder.create_arg_load(0, PrimitiveType::i32, false);
+    auto *j = builder.create_arg_load(1, PrimitiveType::i32, false);
+    VecStatement lowered;
+    LowererImpl lowerer{&leaf_snode,
+                        std::vector<Stmt *>{i, j},
+                        SNodeOpType::undefined,
+                        /*is_bit_vectorized=*/false,
+                        &lowered,
+                        packed,
+                        /*assume_in_bounds=*/true};
+    lowerer.run();
+    ASSERT_EQ(lowerer.linears.size(), 2);
+    // The dense SNode takes both indices as they are.
+    EXPECT_EQ(lowerer.linears[1]->inputs, (std::vector<Stmt *>{i, j}));
+  }
+}
+
 }  // namespace
 }  // namespace lang
 }  // namespace taichi
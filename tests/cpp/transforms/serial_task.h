@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+
+namespace taichi {
+namespace lang {
+
+// Wraps |body| in a serial offloaded task, so that its loops are serial.
+inline std::unique_ptr<Block> make_serial_task(std::unique_ptr<Block> body) {
+  auto root = std::make_unique<Block>();
+  auto offload = std::make_unique<OffloadedStmt>(
+      OffloadedStmt::TaskType::serial, Arch::x64);
+  offload->body = std::move(body);
+  offload->body->parent_stmt = offload.get();
+  root->insert(std::move(offload));
+  CompileConfig config;
+  irpass::type_check(root.get(), config);
+  return root;
+}
+
+}  // namespace lang
+}  // namespace taichi
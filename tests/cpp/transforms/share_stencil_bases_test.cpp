@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/snode.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/struct/fake_struct_compiler.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+constexpr int kSize = 8;
+
+class ShareStencilBasesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_snode_ = std::make_unique<SNode>(/*depth=*/0, SNodeType::root);
+    const std::vector<Axis> axes = {Axis{0}, Axis{1}};
+    dense_snode_ = &(root_snode_->dense(axes, kSize, false));
+    dense_snode_->insert_children(SNodeType::place).dt = PrimitiveType::f32;
+    FakeStructCompiler sc;
+    sc.run(*root_snode_);
+
+    i_ = builder_.create_arg_load(0, PrimitiveType::i32, false);
+    j_ = builder_.create_arg_load(1, PrimitiveType::i32, false);
+    block_ = builder_.extract_ir();
+    auto root = block_->push_back<GetRootStmt>();
+    auto zero = block_->push_back<ConstStmt>(TypedConstant(0));
+    root_ptr_ = block_->push_back<SNodeLookupStmt>(root_snode_.get(), root,
+                                                   zero, false);
+  }
+
+  // Looks up x[i + di, j + dj].
+  SNodeLookupStmt *lookup(int di, int dj) {
+    auto index = [&](Stmt *base, int offset) -> Stmt * {
+      if (offset == 0)
+        return base;
+      auto constant = block_->push_back<ConstStmt>(TypedConstant(offset));
+      return block_->push_back<BinaryOpStmt>(BinaryOpType::add, base,
+                                             constant);
+    };
+    std::vector<Stmt *> inputs = {index(i_, di), index(j_, dj)};
+    auto linearized = block_->push_back<LinearizeStmt>(
+        inputs, std::vector<int>{kSize, kSize});
+    return block_
+        ->push_back<SNodeLookupStmt>(dense_snode_, root_ptr_, linearized, false)
+        ->as<SNodeLookupStmt>();
+  }
+
+  IRBuilder builder_;
+  std::unique_ptr<SNode> root_snode_;
+  SNode *dense_snode_{nullptr};
+  std::unique_ptr<Block> block_;
+  Stmt *i_{nullptr};
+  Stmt *j_{nullptr};
+  Stmt *root_ptr_{nullptr};
+};
+
+TEST_F(ShareStencilBasesTest, NeighborsAreConstantOffsets) {
+  auto center = lookup(0, 0);
+  auto up = lookup(1, 0);
+  auto left = lookup(0, -1);
+  CompileConfig config;
+  irpass::type_check(block_.get(), config);
+
+  EXPECT_TRUE(irpass::share_stencil_bases(block_.get(), config));
+  irpass::analysis::verify(block_.get());
+  auto base = center->input_index->as<LinearizeStmt>();
+  for (auto [neighbor, offset] : {std::make_pair(up, kSize),
+                                  std::make_pair(left, -1)}) {
+    auto index = neighbor->input_index->cast<BinaryOpStmt>();
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->op_type, BinaryOpType::add);
+    auto linearized = index->lhs->as<LinearizeStmt>();
+    EXPECT_EQ(linearized->inputs, base->inputs);
+    EXPECT_EQ(index->rhs->as<ConstStmt>()->val[0].val_int(), offset);
+  }
+
+  EXPECT_FALSE(irpass::share_stencil_bases(block_.get(), config));
+}
+
+TEST_F(ShareStencilBasesTest, SingleAccessIsUnchanged) {
+  auto up = lookup(1, 0);
+  CompileConfig config;
+  irpass::type_check(block_.get(), config);
+
+  EXPECT_FALSE(irpass::share_stencil_bases(block_.get(), config));
+  EXPECT_TRUE(up->input_index->is<LinearizeStmt>());
+}
+
+}  // namespace
+}  // namespace lang
+}  // namespace taichi
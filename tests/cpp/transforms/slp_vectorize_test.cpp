@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/program/test_program.h"
+
+namespace taichi {
+namespace lang {
+
+class SLPVectorizeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tp_.setup();
+    auto func = []() {};
+    kernel_ = std::make_unique<Kernel>(*tp_.prog(), func, "fake_kernel");
+    block_ = std::make_unique<Block>();
+    block_->kernel = kernel_.get();
+
+    // Two dense fields of 3D vectors, like ti.Vector.field(3, ti.f32).
+    root_ = std::make_unique<SNode>(0, SNodeType::root);
+    for (int i = 0; i < 2; i++) {
+      auto &dense = root_->insert_children(SNodeType::dense);
+      for (int j = 0; j < 3; j++) {
+        dense.insert_children(SNodeType::place).dt = PrimitiveType::f32;
+      }
+    }
+    auto get_root = block_->push_back<GetRootStmt>();
+    auto index = block_->push_back<ConstStmt>(TypedConstant(0));
+    for (int i = 0; i < 2; i++) {
+      auto root_ptr = block_->push_back<SNodeLookupStmt>(root_.get(), get_root,
+                                                         index, false);
+      auto dense_ptr = block_->push_back<GetChStmt>(root_ptr, i);
+      cells_[i] = block_->push_back<SNodeLookupStmt>(root_->ch[i].get(),
+                                                     dense_ptr, index, false);
+    }
+  }
+
+  Stmt *component(int cell, int chid) {
+    return block_->push_back<GetChStmt>(cells_[cell], chid);
+  }
+
+  TestProgram tp_;
+  std::unique_ptr<Kernel> kernel_;
+  std::unique_ptr<SNode> root_;
+  std::unique_ptr<Block> block_;
+  Stmt *cells_[2];
+};
+
+TEST_F(SLPVectorizeTest, VectorAdd) {
+  // b[0] = a[0] + b[0], scalarized like the frontend does.
+  Stmt *b_ptrs[3], *sums[3];
+  for (int j = 0; j < 3; j++) {
+    auto a = block_->push_back<GlobalLoadStmt>(component(0, j));
+    b_ptrs[j] = component(1, j);
+    auto b = block_->push_back<GlobalLoadStmt>(b_ptrs[j]);
+    sums[j] = block_->push_back<BinaryOpStmt>(BinaryOpType::add, a, b);
+  }
+  for (int j = 0; j < 3; j++) {
+    block_->push_back<GlobalStoreStmt>(b_ptrs[j], sums[j]);
+  }
+  CompileConfig config;
+  irpass::type_check(block_.get(), config);
+
+  EXPECT_TRUE(irpass::slp_vectorize(block_.get(), config));
+  irpass::die(block_.get());
+  irpass::analysis::verify(block_.get());
+
+  auto stores = irpass::analysis::gather_statements(
+      block_.get(), [](Stmt *s) { return s->is<GlobalStoreStmt>(); });
+  ASSERT_EQ(stores.size(), 1);
+  auto sum = stores[0]->as<GlobalStoreStmt>()->val;
+  ASSERT_TRUE(sum->is<BinaryOpStmt>());
+  EXPECT_EQ(sum->ret_type,
+            TypeFactory::create_tensor_type({3}, PrimitiveType::f32));
+  EXPECT_TRUE(sum->as<BinaryOpStmt>()->lhs->is<GlobalLoadStmt>());
+  EXPECT_TRUE(sum->as<BinaryOpStmt>()->rhs->is<GlobalLoadStmt>());
+}
+
+TEST_F(SLPVectorizeTest, AliasingStoreBlocksPacking) {
+  // a[0][1] is overwritten between the loads of a[0][0] and a[0][1], so the
+  // loads cannot be packed, and gathering them costs more than it saves.
+  auto a0 = block_->push_back<GlobalLoadStmt>(component(0, 0));
+  auto a1_ptr = component(0, 1);
+  block_->push_back<GlobalStoreStmt>(a1_ptr, a0);
+  auto a1 = block_->push_back<GlobalLoadStmt>(a1_ptr);
+  block_->push_back<GlobalStoreStmt>(component(1, 0), a0);
+  block_->push_back<GlobalStoreStmt>(component(1, 1), a1);
+  CompileConfig config;
+  irpass::type_check(block_.get(), config);
+
+  EXPECT_FALSE(irpass::slp_vectorize(block_.get(), config));
+}
+
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "tests/cpp/program/test_program.h"
+
+namespace taichi {
+namespace lang {
+
+class WorklistSimplifyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tp_.setup();
+    auto func = []() {};
+    kernel_ = std::make_unique<Kernel>(*tp_.prog(), func, "fake_kernel");
+  }
+
+  // x = load(0); store(4, x + ((2 + 3) - 5) * 1)
+  std::unique_ptr<Block> build_chain() {
+    auto block = std::make_unique<Block>();
+    block->kernel = kernel_.get();
+
+    auto load_addr = block->push_back<GlobalTemporaryStmt>(
+        0, TypeFactory::create_vector_or_scalar_type(1, PrimitiveType::i32));
+    auto x = block->push_back<GlobalLoadStmt>(load_addr);
+    auto two = block->push_back<ConstStmt>(TypedConstant(2));
+    auto three = block->push_back<ConstStmt>(TypedConstant(3));
+    auto five = block->push_back<ConstStmt>(TypedConstant(5));
+    auto one = block->push_back<ConstStmt>(TypedConstant(1));
+    auto sum = block->push_back<BinaryOpStmt>(BinaryOpType::add, two, three);
+    auto diff = block->push_back<BinaryOpStmt>(BinaryOpType::sub, sum, five);
+    auto prod = block->push_back<BinaryOpStmt>(BinaryOpType::mul, diff, one);
+    auto result = block->push_back<BinaryOpStmt>(BinaryOpType::add, x, prod);
+    auto store_addr = block->push_back<GlobalTemporaryStmt>(
+        4, TypeFactory::create_vector_or_scalar_type(1, PrimitiveType::i32));
+    block->push_back<GlobalStoreStmt>(store_addr, result);
+
+    irpass::type_check(block.get(), CompileConfig());
+    return block;
+  }
+
+  TestProgram tp_;
+  std::unique_ptr<Kernel> kernel_;
+};
+
+TEST_F(WorklistSimplifyTest, SimplifyChainInOneRun) {
+  auto block = build_chain();
+  EXPECT_EQ(block->size(), 12);
+
+  // Each rewrite enqueues the users of the rewritten statement, so the whole
+  // chain collapses without rerunning the pass.
+  EXPECT_TRUE(irpass::worklist_simplify(block.get(), CompileConfig()));
+  EXPECT_EQ(block->size(), 4);  // two addresses, one load, one store
+  auto *store = (*block)[3]->cast<GlobalStoreStmt>();
+  ASSERT_NE(store, nullptr);
+  EXPECT_EQ(store->val, (*block)[1].get());
+
+  EXPECT_FALSE(irpass::worklist_simplify(block.get(), CompileConfig()));
+}
+
+TEST_F(WorklistSimplifyTest, MatchFixpointDriver) {
+  auto block = build_chain();
+  auto reference = block->clone();
+
+  CompileConfig config;
+  config.worklist_simplify = true;
+  irpass::full_simplify(block.get(), config, {false, tp_.prog()});
+
+  config.worklist_simplify = false;
+  irpass::full_simplify(reference.get(), config, {false, tp_.prog()});
+
+  EXPECT_TRUE(irpass::analysis::same_statements(block.get(), reference.get()));
+}
+
+TEST_F(WorklistSimplifyTest, ReachesFixpoint) {
+  auto block = build_chain();
+  PassInstrumentation instrumentation;
+  AnalysisManager amgr(&instrumentation);
+  CompileConfig config;
+  config.worklist_simplify = true;
+  irpass::full_simplify(block.get(), config, {false, tp_.prog(), &amgr});
+  auto records = instrumentation.get_records();
+
+  // The whole-IR passes ran until none of them modified the IR, so calling
+  // full_simplify() again runs no pass at all.
+  irpass::full_simplify(block.get(), config, {false, tp_.prog(), &amgr});
+  for (auto const &[id, rec] : instrumentation.get_records()) {
+    EXPECT_EQ(rec.num_runs, records[id].num_runs) << id;
+    EXPECT_EQ(rec.num_skipped, records[id].num_skipped) << id;
+  }
+}
+
+}  // namespace lang
+}  // namespace taichi
@@ -81,6 +81,53 @@ def test_assert_ok():
     func()
 
 
+@ti.test(arch=[ti.cpu, ti.cuda],
+         debug=True,
+         lazy_runtime_error_check=True,
+         gdb_trigger=False)
+def test_assert_checked_lazily():
+    x = ti.field(dtype=int, shape=16)
+
+    @ti.kernel
+    def check_zero():
+        for i in x:
+            assert x[i] == 0, 'x[%d] = %d' % (i, x[i])
+
+    @ti.kernel
+    def fill_one():
+        for i in x:
+            x[i] = 1
+
+    check_zero()
+    x[3] = 5
+    # The failure is only reported at the next sync point, with the launch
+    # that raised it.
+    check_zero()
+    fill_one()
+    with pytest.raises(RuntimeError, match=r'check_zero.*x\[3\] = 5'):
+        ti.sync()
+    ti.sync()
+    assert x[0] == 1
+
+
+@ti.test(arch=[ti.cpu, ti.cuda],
+         debug=True,
+         lazy_runtime_error_check=True,
+         gdb_trigger=False)
+def test_assert_pending_at_reset_does_not_raise():
+    x = ti.field(dtype=int, shape=16)
+
+    @ti.kernel
+    def check_zero():
+        for i in x:
+            assert x[i] == 0
+
+    x[3] = 5
+    check_zero()
+    # Tearing down the program only warns about the pending failure.
+    ti.reset()
+
+
 @ti.test(arch=get_host_arch_list())
 def test_static_assert_is_static():
     @ti.kernel
@@ -53,3 +53,63 @@ def test_listgen_opt_with_offsets():
 
     ti.sync()
     assert ti.get_kernel_stats().get_counters()['launched_tasks_list_gen'] <= 2
+
+
+# Fusion would merge the independent tasks.
+@ti.test(arch=ti.cpu, async_mode=True, async_opt_fusion=False)
+def test_concurrent_launch_of_independent_tasks():
+    n = 16
+    fields = [ti.field(ti.i32, shape=n) for _ in range(4)]
+
+    @ti.kernel
+    def fill(x: ti.template(), v: ti.i32):
+        for i in x:
+            x[i] = v + i
+
+    @ti.kernel
+    def add(x: ti.template(), y: ti.template()):
+        for i in x:
+            x[i] += y[i]
+
+    for k in range(4):
+        fill(fields[k], k)
+    add(fields[0], fields[1])
+    add(fields[2], fields[3])
+    add(fields[0], fields[2])
+
+    ti.sync()
+    counters = ti.get_kernel_stats().get_counters()
+    assert counters['async_launched_tasks'] > counters['async_launch_groups']
+    for i in range(n):
+        assert fields[0][i] == 6 + 4 * i
+
+
+# Fusion would merge the independent tasks.
+@ti.test(arch=ti.cpu, async_mode=True, async_opt_fusion=False)
+def test_concurrent_launch_of_dynamic_range_fors():
+    n = 64
+    x = ti.field(ti.i32, shape=n)
+    y = ti.field(ti.i32, shape=n)
+    bounds = ti.field(ti.i32, shape=2)
+
+    # The bounds of both range-fors go through the global temporaries, which
+    # all kernels share.
+    @ti.kernel
+    def fill_x():
+        for i in range(bounds[0]):
+            x[i] = 1
+
+    @ti.kernel
+    def fill_y():
+        for i in range(bounds[1]):
+            y[i] = 2
+
+    bounds[0] = 16
+    bounds[1] = n
+    for _ in range(8):
+        fill_x()
+        fill_y()
+    ti.sync()
+    for i in range(n):
+        assert x[i] == (1 if i < 16 else 0)
+        assert y[i] == 2
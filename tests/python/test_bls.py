@@ -170,6 +170,5 @@ def test_bls_large_block():
     foo()
 
 
-# TODO: BLS on CPU
 # TODO: BLS boundary out of bound
 # TODO: BLS with TLS
@@ -75,6 +75,22 @@ def test_not_out_of_bound():
     func()
 
 
+@ti.test(require=ti.extension.assertion, debug=True)
+def test_out_of_bound_in_loop():
+    ti.set_gdb_trigger(False)
+    x = ti.field(ti.i32, shape=(8, 16))
+
+    @ti.kernel
+    def func():
+        for i, j in ti.ndrange(8, (1, 16)):
+            x[i, j] = 1
+        for i, j in ti.ndrange(8, 16):
+            x[i, j + 1] = 1
+
+    with pytest.raises(RuntimeError):
+        func()
+
+
 @ti.test(require=ti.extension.assertion, debug=True)
 def test_out_of_bound_dynamic():
     ti.set_gdb_trigger(False)
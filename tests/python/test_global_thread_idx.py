@@ -16,3 +16,19 @@ def test_global_thread_idx():
 
     func()
     assert np.arange(n).sum() == x.to_numpy().sum()
+
+
+@ti.test(arch=ti.cpu, cpu_max_num_threads=4)
+def test_global_thread_idx_cpu():
+    n = 4096
+    x = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def func():
+        for i in range(n):
+            x[i] = ti.global_thread_idx()
+
+    func()
+    ids = x.to_numpy()
+    # Each task reads the id of its worker thread.
+    assert ids.min() >= 0 and ids.max() < 4
@@ -0,0 +1,105 @@
+import pytest
+
+import taichi as ti
+
+
+@ti.test(arch=[ti.cpu, ti.cuda])
+def test_kernel_future():
+    n = 1024
+    x = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def fill(k: ti.i32):
+        for i in x:
+            x[i] = i + k
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            s += x[i]
+        return s
+
+    @ti.kernel
+    def mean() -> ti.f32:
+        s = 0.0
+        for i in x:
+            s += x[i]
+        return s / n
+
+    fill(0)
+    f0 = total.launch_async()
+    g0 = mean.launch_async()
+    fill(1)
+    f1 = total.launch_async()
+    # The futures do not overwrite each other's values.
+    assert f1.result() == n * (n - 1) // 2 + n
+    assert f0.result() == n * (n - 1) // 2
+    assert g0.result() == pytest.approx((n - 1) / 2)
+    assert f0.done() and f1.done()
+
+
+@ti.test(arch=[ti.cpu, ti.cuda])
+def test_kernel_future_of_class_kernel():
+    @ti.data_oriented
+    class Counter:
+        def __init__(self):
+            self.x = ti.field(ti.i32, shape=())
+
+        @ti.kernel
+        def inc(self) -> ti.i32:
+            self.x[None] += 1
+            return self.x[None]
+
+    c = Counter()
+    futures = [c.inc.launch_async() for _ in range(3)]
+    assert [f.result() for f in futures] == [1, 2, 3]
+
+
+@ti.test(arch=[ti.cpu, ti.cuda])
+def test_kernel_future_without_return_value():
+    @ti.kernel
+    def foo():
+        pass
+
+    with pytest.raises(ti.TaichiRuntimeError):
+        foo.launch_async()
+
+
+@ti.test(arch=[ti.cpu, ti.cuda],
+         require=ti.extension.async_mode,
+         async_mode=True)
+def test_dropped_kernel_future_in_async_mode():
+    x = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def inc() -> ti.i32:
+        x[None] += 1
+        return x[None]
+
+    # The slots of the dropped futures are not reused by the later launches
+    # until the engine has run the launches that write them.
+    for _ in range(8):
+        inc.launch_async()
+    futures = [inc.launch_async() for _ in range(8)]
+    assert [f.result() for f in futures] == list(range(9, 17))
+
+
+@ti.test(arch=[ti.cpu, ti.cuda],
+         require=ti.extension.async_mode,
+         async_mode=True)
+def test_kernel_future_done_after_sync_in_async_mode():
+    x = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def inc() -> ti.i32:
+        x[None] += 1
+        return x[None]
+
+    f = inc.launch_async()
+    ti.sync()
+    assert f.done()
+    assert f.result() == 1
+    g = inc.launch_async()
+    assert g.result() == 2
+    assert g.done()
@@ -0,0 +1,115 @@
+import taichi as ti
+
+
+def _num_skipped_launches():
+    return ti.get_kernel_stats().get_counters().get(
+        'memoized_launches_skipped', 0)
+
+
+@ti.test(arch=[ti.cpu, ti.cuda])
+def test_memoized_kernel_skips_unchanged_launches():
+    n = 16
+    x = ti.field(ti.i32, shape=n)
+    y = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def fill(k: ti.i32):
+        for i in x:
+            x[i] = i + k
+
+    @ti.memoized_kernel
+    def square(k: ti.i32):
+        for i in x:
+            y[i] = x[i] * x[i] + k
+
+    fill(0)
+    skipped = _num_skipped_launches()
+    square(1)
+    square(1)
+    assert _num_skipped_launches() == skipped + 1
+    for i in range(n):
+        assert y[i] == i * i + 1
+
+    # A different arg, a write to the input, and a write to the output all
+    # invalidate the last launch.
+    square(2)
+    for i in range(n):
+        assert y[i] == i * i + 2
+    fill(1)
+    square(2)
+    for i in range(n):
+        assert y[i] == (i + 1) * (i + 1) + 2
+    y[0] = 0
+    square(2)
+    assert y[0] == 3
+    assert _num_skipped_launches() == skipped + 1
+
+
+@ti.test(arch=[ti.cpu, ti.cuda])
+def test_memoized_kernel_reading_its_output_always_runs():
+    x = ti.field(ti.i32, shape=())
+
+    @ti.memoized_kernel
+    def inc():
+        x[None] += 1
+
+    skipped = _num_skipped_launches()
+    for _ in range(3):
+        inc()
+    assert x[None] == 3
+    assert _num_skipped_launches() == skipped
+
+
+@ti.test(arch=[ti.x64, ti.cuda])
+def test_memoized_kernel_with_ndarrays():
+    n = 8
+    a = ti.ndarray(ti.i32, shape=(n, ))
+    b = ti.ndarray(ti.i32, shape=(n, ))
+
+    @ti.memoized_kernel
+    def double(x: ti.any_arr(), y: ti.any_arr()):
+        for i in range(n):
+            y[i] = x[i] * 2
+
+    for i in range(n):
+        a[i] = i
+    skipped = _num_skipped_launches()
+    double(a, b)
+    double(a, b)
+    assert _num_skipped_launches() == skipped + 1
+    a.fill(3)
+    double(a, b)
+    for i in range(n):
+        assert b[i] == 6
+    assert _num_skipped_launches() == skipped + 1
+
+
+@ti.test(require=ti.extension.quant_basic, arch=[ti.cpu, ti.cuda])
+def test_memoized_kernel_reading_quantized_field():
+    n = 8
+    ci16 = ti.quant.int(16, True)
+    x = ti.field(dtype=ci16)
+    y = ti.field(dtype=ci16)
+    z = ti.field(ti.i32, shape=n)
+    ti.root.dense(ti.i, n).bit_struct(num_bits=32).place(x, y)
+
+    @ti.kernel
+    def fill(k: ti.i32):
+        for i in range(n):
+            x[i] = i + k
+            y[i] = k
+
+    @ti.memoized_kernel
+    def copy():
+        for i in range(n):
+            z[i] = x[i]
+
+    fill(0)
+    copy()
+    # The bit struct store of fill() writes x.
+    fill(1)
+    skipped = _num_skipped_launches()
+    copy()
+    assert _num_skipped_launches() == skipped
+    for i in range(n):
+        assert z[i] == i + 1
@@ -0,0 +1,85 @@
+import numpy as np
+import pytest
+
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu)
+def test_launch_graph_replay():
+    x = ti.field(ti.f32, shape=16)
+    n = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def add(k: ti.f32):
+        for i in x:
+            x[i] += k
+
+    @ti.kernel
+    def count():
+        n[None] += 1
+
+    graph = ti.LaunchGraph()
+    with graph:
+        add_id = add(1.0)
+        count()
+    assert len(graph) == 2
+    # Recording does not launch anything.
+    assert n[None] == 0
+
+    for _ in range(3):
+        graph.replay()
+    assert n[None] == 3
+    assert np.allclose(x.to_numpy(), 3.0)
+
+    graph.set_arg(add_id, 0, 0.5)
+    graph.replay()
+    graph.set_arg(add_id, 0, 2)
+    graph.replay()
+    assert n[None] == 5
+    assert np.allclose(x.to_numpy(), 5.5)
+
+
+@ti.test(arch=ti.cpu)
+def test_launch_graph_external_array():
+    a = np.arange(8, dtype=np.int32)
+
+    @ti.kernel
+    def inc(arr: ti.ext_arr(), k: ti.i32):
+        for i in range(8):
+            arr[i] += k
+
+    graph = ti.LaunchGraph()
+    with graph:
+        inc_id = inc(a, 1)
+    graph.replay()
+    graph.set_arg(inc_id, 1, 10)
+    graph.replay()
+    assert np.array_equal(a, np.arange(8) + 11)
+    with pytest.raises(RuntimeError, match='cannot be patched'):
+        graph.set_arg(inc_id, 0, 0)
+
+
+@ti.test(arch=ti.x64)
+def test_launch_graph_ndarray_outlives_recording():
+    @ti.kernel
+    def fill(arr: ti.any_arr(), k: ti.i32):
+        for i in range(8):
+            arr[i] = k
+
+    graph = ti.LaunchGraph()
+    with graph:
+        fill(ti.ndarray(ti.i32, shape=(8, )), 1)
+    # The ndarray is only referenced by the graph now.
+    for _ in range(3):
+        graph.replay()
+
+
+@ti.test(arch=ti.cpu)
+def test_launch_graph_rejects_return_values():
+    @ti.kernel
+    def one() -> ti.i32:
+        return 1
+
+    with ti.LaunchGraph():
+        with pytest.raises(ti.TaichiRuntimeError):
+            one()
@@ -59,3 +59,46 @@ def test_nested_3d():
     for _ in range(1000):
         i, j, k = randrange(n), randrange(n), randrange(n)
         assert x[i, j, k] == (i * n + j) * n + k
+
+
+@ti.test(require=ti.extension.sparse)
+def test_reused_element_lists_follow_activation():
+    x = ti.field(ti.i32)
+    y = ti.field(ti.i32)
+    ptr = ti.root.pointer(ti.i, 8)
+    ptr.bitmasked(ti.i, 4).place(x)
+    ti.root.dynamic(ti.i, 64, chunk_size=8).place(y)
+    count = ti.field(ti.i32, shape=2)
+
+    @ti.kernel
+    def count_active():
+        count[0] = 0
+        count[1] = 0
+        for i in x:
+            count[0] += 1
+        for i in y:
+            count[1] += 1
+
+    @ti.kernel
+    def deactivate_block(b: ti.i32):
+        ti.deactivate(ptr, b)
+
+    @ti.kernel
+    def append(v: ti.i32):
+        ti.append(y.parent(), [], v)
+
+    expected_x = set()
+    for step in range(4):
+        # Launching twice without any activation reuses the lists.
+        for _ in range(2):
+            count_active()
+            assert count[0] == len(expected_x)
+            assert count[1] == step
+        x[step * 5] = 1
+        expected_x.add(step * 5)
+        append(step)
+    deactivate_block(0)
+    expected_x = {i for i in expected_x if i >= 4}
+    count_active()
+    assert count[0] == len(expected_x)
+    assert count[1] == 4
@@ -1,3 +1,4 @@
+from taichi._testing import approx
 from taichi.lang.misc import serialize
 
 import taichi as ti
@@ -144,3 +145,154 @@ def test_parallel_assignment():
     for i in range(3):
         for j in range(4):
             assert mat[i, j] == i + 1
+
+
+@ti.test()
+def test_promote_global_accesses_in_serial_loops():
+    x = ti.field(ti.f32, shape=4)
+    y = ti.field(ti.f32, shape=4)
+    w = ti.field(ti.f32, shape=8)
+
+    @ti.kernel
+    def func(n: ti.i32):
+        for i in x:
+            for j in range(n):
+                x[i] += w[j] * i
+            for j in range(n):
+                y[i] = y[i] * 0.5 + w[j]
+
+    for j in range(8):
+        w[j] = j + 1
+    func(8)
+    for i in range(4):
+        assert x[i] == approx(36 * i)
+        expected = 0.0
+        for j in range(8):
+            expected = expected * 0.5 + j + 1
+        assert y[i] == approx(expected)
+    # Nothing is stored back if the loops don't run.
+    func(0)
+    assert x[1] == approx(36)
+
+
+
+def _test_stencil_with_shared_bases():
+    n = 6
+    x = ti.field(ti.i32, shape=(n, n, n))
+    y = ti.field(ti.i32, shape=(n, n, n))
+
+    @ti.kernel
+    def stencil():
+        for i, j, k in ti.ndrange((1, n - 1), (1, n - 1), (1, n - 1)):
+            s = 0
+            for d in ti.static(ti.grouped(ti.ndrange(3, 3, 3))):
+                s += x[i + d[0] - 1, j + d[1] - 1, k + d[2] - 1] * (
+                    d[0] * 9 + d[1] * 3 + d[2])
+            y[i, j, k] = s
+
+    for i in range(n):
+        for j in range(n):
+            for k in range(n):
+                x[i, j, k] = i * 100 + j * 10 + k
+    stencil()
+    for i in range(1, n - 1):
+        for j in range(1, n - 1):
+            for k in range(1, n - 1):
+                expected = 0
+                for di in range(3):
+                    for dj in range(3):
+                        for dk in range(3):
+                            expected += x[i + di - 1, j + dj - 1,
+                                          k + dk - 1] * (di * 9 + dj * 3 + dk)
+                assert y[i, j, k] == expected
+
+
+@ti.test()
+def test_stencil_with_shared_bases():
+    _test_stencil_with_shared_bases()
+
+
+@ti.test(require=ti.extension.packed, packed=True)
+def test_stencil_with_shared_bases_packed():
+    _test_stencil_with_shared_bases()
+
+
+@ti.test(arch=ti.cpu)
+def test_privatized_histogram():
+    n = 10000
+    num_bins = 13
+    hist = ti.field(ti.i32, shape=num_bins)
+    weights = ti.field(ti.f32, shape=(2, num_bins))
+
+    @ti.kernel
+    def count():
+        for i in range(n):
+            b = i * 7 % num_bins
+            hist[b] += 1
+            weights[i % 2, b] += 0.5
+            weights[i % 2, b] -= 0.25
+
+    hist[3] = 100
+    count()
+    for b in range(num_bins):
+        expected = sum(1 for i in range(n) if i * 7 % num_bins == b)
+        assert hist[b] == expected + (100 if b == 3 else 0)
+        for p in range(2):
+            expected = sum(1 for i in range(n)
+                           if i * 7 % num_bins == b and i % 2 == p)
+            assert weights[p, b] == approx(expected * 0.25)
+
+
+@ti.test(arch=ti.cpu)
+def test_concurrent_small_tasks():
+    n = 64
+    a = ti.field(ti.i32, shape=n)
+    b = ti.field(ti.i32, shape=n)
+    c = ti.field(ti.i32, shape=n)
+    total = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def step():
+        for i in a:
+            a[i] = i
+        for i in b:
+            b[i] = i * 2
+        for i in range(n):
+            c[i] = a[i] + b[i]
+        total[None] = 0
+        for i in range(n):
+            a[i] = c[n - 1 - i]
+
+    for _ in range(10):
+        step()
+    for i in range(n):
+        assert c[i] == i * 3
+        assert a[i] == (n - 1 - i) * 3
+
+
+@ti.test()
+def test_fuse_elementwise_range_fors():
+    n, m = 32, 24
+    x = ti.field(ti.f32, shape=(n, m))
+    y = ti.field(ti.f32, shape=(n, m))
+    z = ti.field(ti.f32, shape=(n, m))
+
+    @ti.kernel
+    def chain():
+        for i, j in x:
+            x[i, j] = i * m + j
+        for i, j in y:
+            y[i, j] = x[i, j] * 2
+        for i, j in z:
+            z[i, j] = y[i, j] + x[i, j]
+        # Reads a neighbor of the previous task's output, so must not be
+        # fused with it.
+        for i, j in x:
+            x[i, j] = z[(i + 1) % n, j]
+
+    chain()
+    for i in range(n):
+        for j in range(m):
+            assert y[i, j] == (i * m + j) * 2
+            assert z[i, j] == (i * m + j) * 3
+            assert x[i, j] == (((i + 1) % n) * m + j) * 3
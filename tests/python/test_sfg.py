@@ -122,3 +122,35 @@ def test_global_tmp_value_state():
     x.from_numpy(np.arange(0, n, dtype=np.float32))
     mean = compute_mean_of_boundary_edges()
     assert ti._testing.approx(mean) == 33
+
+
+@ti.test(require=ti.extension.async_mode,
+         async_mode=True,
+         async_flush_every=256)
+def test_sfg_fuse_many_pending_tasks():
+    n = 16
+    x = ti.field(ti.i32, shape=n)
+    y = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def inc_x():
+        for i in x:
+            x[i] += 1
+
+    @ti.kernel
+    def add_to_y():
+        for i in y:
+            y[i] += x[i]
+
+    stats = ti.get_kernel_stats()
+    stats.clear()
+    for _ in range(100):
+        inc_x()
+        add_to_y()
+    ti.sync()
+
+    counters = stats.get_counters()
+    assert counters['num_fused_tasks'] > 0
+    for i in range(n):
+        assert x[i] == 100
+        assert y[i] == 5050
@@ -0,0 +1,77 @@
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu, software_prefetch=True)
+def test_particle_to_grid():
+    n = 1000
+    grid = ti.field(ti.f32, shape=(64, 64))
+    px = ti.Vector.field(2, ti.i32, shape=n)
+    cell = ti.field(ti.i32, shape=n)
+    mass = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def fill():
+        for p in range(n):
+            px[p] = [(p * 17) % 64, (p * 31) % 64]
+            cell[p] = (p * 7) % 64
+            mass[p] = p % 5 + 1
+
+    @ti.kernel
+    def p2g():
+        for p in range(n):
+            # The last particles look up the grid beyond the loop bounds.
+            grid[px[p][0], px[p][1]] += mass[p]
+            grid[cell[p], 0] += 1
+
+    fill()
+    p2g()
+    expected = {}
+    for p in range(n):
+        key = ((p * 17) % 64, (p * 31) % 64)
+        expected[key] = expected.get(key, 0) + p % 5 + 1
+        key = ((p * 7) % 64, 0)
+        expected[key] = expected.get(key, 0) + 1
+    for (i, j), val in expected.items():
+        assert grid[i, j] == val
+
+
+@ti.test(arch=ti.cpu, software_prefetch=True, prefetch_distance=3)
+def test_external_gather():
+    n = 257
+    x = ti.ndarray(ti.f32, shape=n)
+    idx = ti.ndarray(ti.i32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def gather(x: ti.any_arr(), idx: ti.any_arr()):
+        for i in range(n):
+            y[i] = x[idx[i]] * 2
+
+    for i in range(n):
+        x[i] = i
+        idx[i] = (i * 5) % n
+    gather(x, idx)
+    for i in range(n):
+        assert y[i] == (i * 5) % n * 2
+
+
+@ti.test(arch=ti.cpu, software_prefetch=True)
+def test_struct_for_over_pointer():
+    x = ti.field(ti.i32)
+    block = ti.root.pointer(ti.i, 32)
+    block.dense(ti.i, 16).place(x)
+    total = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def activate():
+        for i in range(0, 512, 3):
+            x[i] = i
+
+    @ti.kernel
+    def reduce():
+        for i in x:
+            total[None] += x[i]
+
+    activate()
+    reduce()
+    assert total[None] == sum(range(0, 512, 3))
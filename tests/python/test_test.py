@@ -63,7 +63,7 @@ def test_require_extensions_2():
     assert ti.cfg.arch in [ti.cpu]
 
 
-@ti.test(arch=[ti.cpu, ti.opengl],
+@ti.test(arch=[ti.metal, ti.opengl],
          require=[ti.extension.sparse, ti.extension.bls])
 def test_require_extensions_2():
     assert ti.cfg.arch in [ti.cuda]
@@ -0,0 +1,104 @@
+import re
+
+import numpy as np
+import pytest
+
+import taichi as ti
+
+
+def _llvm_major_version():
+    return int(ti._lib.core.get_llvm_version_string().split('.')[0])
+
+
+# Calls are only replaced by the vector variants in vectorized loops, which
+# needs x64 and LLVM 11+.
+def _configure_vectorization(vectorize, fast):
+    if vectorize and (ti.cfg.arch != ti.x64 or _llvm_major_version() < 11):
+        pytest.skip('Vector variants are not called')
+    ti.cfg.vectorize_range_for = vectorize
+    ti.cfg.fast_vector_math = fast
+
+
+@pytest.mark.parametrize('taichi_op,np_op,low,high,has_f64', [
+    (ti.exp, np.exp, -80, 80, True),
+    (ti.log, np.log, 1e-30, 1e30, True),
+    (ti.sin, np.sin, -1e4, 1e4, True),
+    (ti.cos, np.cos, -1e4, 1e4, True),
+    (ti.tanh, np.tanh, -10, 10, False),
+])
+@pytest.mark.parametrize('dtype', [ti.f32, ti.f64])
+@pytest.mark.parametrize('fast', [False, True])
+@pytest.mark.parametrize('vectorize', [False, True])
+@ti.test(arch=ti.cpu, vector_math=True)
+def test_vector_math(taichi_op, np_op, low, high, has_f64, dtype, fast,
+                     vectorize):
+    if dtype == ti.f64 and not has_f64:
+        pytest.skip('No f64 vector variant')
+    _configure_vectorization(vectorize, fast)
+    n = 1000
+    x = ti.field(dtype, shape=n)
+    y = ti.field(dtype, shape=n)
+
+    @ti.kernel
+    def compute():
+        for i in range(n):
+            y[i] = taichi_op(x[i])
+
+    np_dtype = np.float32 if dtype == ti.f32 else np.float64
+    if low > 0:
+        xs = np.geomspace(low, high, n, dtype=np_dtype)
+    else:
+        xs = np.linspace(low, high, n, dtype=np_dtype)
+    x.from_numpy(xs)
+    compute()
+    tol = 1e-6 if dtype == ti.f32 else 1e-12
+    np.testing.assert_allclose(y.to_numpy(),
+                               np_op(xs.astype(np.float64)),
+                               rtol=tol,
+                               atol=tol)
+
+
+@pytest.mark.parametrize('fast', [False, True])
+@pytest.mark.parametrize('vectorize', [False, True])
+@ti.test(arch=ti.cpu, vector_math=True)
+def test_vector_pow(fast, vectorize):
+    _configure_vectorization(vectorize, fast)
+    n = 1000
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def compute():
+        for i in range(n):
+            y[i] = x[i]**2.5
+
+    xs = np.linspace(-10, 10, n, dtype=np.float32)
+    x.from_numpy(xs)
+    compute()
+    expected = np.power(xs.astype(np.float64), 2.5)
+    np.testing.assert_allclose(y.to_numpy(), expected, rtol=1e-6)
+
+
+@pytest.mark.skipif(_llvm_major_version() < 11,
+                    reason='The loop vectorizer ignores vector variants')
+@pytest.mark.parametrize('dtype', [ti.f32, ti.f64])
+@ti.test(arch=ti.x64,
+         vector_math=True,
+         vectorize_range_for=True,
+         print_kernel_llvm_ir_optimized=True)
+def test_vector_math_variants_are_called(dtype, tmp_path, monkeypatch):
+    # The optimized LLVM IR is written to the working directory.
+    monkeypatch.chdir(tmp_path)
+    n = 1024
+    x = ti.field(dtype, shape=n)
+    y = ti.field(dtype, shape=n)
+
+    @ti.kernel
+    def compute():
+        for i in range(n):
+            y[i] = ti.exp(x[i])
+
+    compute()
+    ir = ''.join(f.read_text() for f in tmp_path.glob('*.ll'))
+    type_name = 'f32' if dtype == ti.f32 else 'f64'
+    assert re.search(rf'call .*@exp_{type_name}_x\d+(_fast)?_vec\(', ir)
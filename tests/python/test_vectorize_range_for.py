@@ -0,0 +1,66 @@
+import re
+
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu, vectorize_range_for=True)
+def test_gather_scatter():
+    n = 1003
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+    idx = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def fill():
+        for i in range(n):
+            x[i] = i * 0.5
+            idx[i] = (i * 7) % n
+
+    @ti.kernel
+    def permute():
+        for i in range(n):
+            y[idx[i]] = x[i] + 1
+
+    fill()
+    permute()
+    for i in range(n):
+        assert y[(i * 7) % n] == i * 0.5 + 1
+
+
+@ti.test(arch=ti.cpu, vectorize_range_for=True)
+def test_reduction_and_continue():
+    n = 1003
+    x = ti.field(ti.i32, shape=n)
+    total = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def reduce():
+        for i in range(n):
+            x[i] = i
+            if i % 3 == 0:
+                continue
+            total[None] += i
+
+    reduce()
+    assert total[None] == sum(i for i in range(n) if i % 3 != 0)
+    assert x[n - 1] == n - 1
+
+
+@ti.test(arch=ti.x64,
+         vectorize_range_for=True,
+         print_kernel_llvm_ir_optimized=True)
+def test_elementwise_loop_is_vectorized(tmp_path, monkeypatch):
+    # The optimized LLVM IR is written to the working directory.
+    monkeypatch.chdir(tmp_path)
+    n = 1024
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def saxpy():
+        for i in range(n):
+            y[i] = 2 * x[i] + y[i]
+
+    saxpy()
+    ir = ''.join(f.read_text() for f in tmp_path.glob('*.ll'))
+    assert re.search(r'fmul [a-z ]*<\d+ x float>', ir)